@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -42,7 +43,7 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -173,10 +174,14 @@ private:
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _lockHolders(0), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _rateConverterQuality(kRateConverterLinear) {
 
 	assert(sampleRate > 0);
 
+	if (ConfMan.get("resampler") == "sinc")
+		_rateConverterQuality = kRateConverterSinc;
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = 0;
 }
@@ -215,10 +220,20 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 
 	chan->setHandle(chanHandle);
 	_handleSeed++;
+
+	_snapshots[index].volume = chan->getVolume();
+	_snapshots[index].balance = chan->getBalance();
+	_snapshots[index].handle = chanHandle._val;
 	if (handle)
 		*handle = chanHandle;
 }
 
+void MixerImpl::deleteChannel(int index) {
+	_snapshots[index].handle = 0xFFFFFFFF;
+	delete _channels[index];
+	_channels[index] = 0;
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -227,7 +242,7 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 
 	if (stream == 0) {
 		warning("stream is 0");
@@ -258,7 +273,7 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _rateConverterQuality);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -267,8 +282,18 @@ void MixerImpl::playStream(
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
+	// Only engine threads change _lockHolders, and only while they
+	// hold _mutex, so a non-zero value means we are about to wait.
+	if (_lockHolders)
+		_stats.lockWaits++;
 	Common::StackLock lock(_mutex);
 
+	const uint depth = _commands.size();
+	_stats.lastDepth = depth;
+	if (depth > _stats.maxDepth)
+		_stats.maxDepth = depth;
+	processCommands();
+
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
@@ -285,8 +310,7 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
+				deleteChannel(i);
 			} else if (!_channels[i]->isPaused()) {
 				tmp = _channels[i]->mix(buf, len);
 
@@ -298,36 +322,82 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	return res;
 }
 
+void MixerImpl::queueCommand(Command::Type type, SoundHandle handle, int value) {
+	Command cmd;
+	cmd.type = type;
+	cmd.handle = handle;
+	cmd.value = value;
+
+	{
+		Common::StackLock commandLock(_commandMutex);
+		if (_commands.push(cmd)) {
+			_stats.queued++;
+			return;
+		}
+	}
+
+	// The queue is full (or this platform lacks the memory barriers it
+	// needs), so apply the command directly, after all queued ones.
+	// _commandMutex must be released first: the threads holding _mutex
+	// may be queuing commands themselves.
+	EngineLock lock(*this);
+	processCommands();
+	applyCommand(cmd);
+	_stats.direct++;
+}
+
+void MixerImpl::processCommands() {
+	Command cmd;
+	while (_commands.pop(cmd)) {
+		applyCommand(cmd);
+		_stats.applied++;
+	}
+}
+
+void MixerImpl::applyCommand(const Command &cmd) {
+	// Simply ignore commands for handles of sounds that already terminated
+	const int index = cmd.handle._val % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != cmd.handle._val)
+		return;
+
+	switch (cmd.type) {
+	case Command::kSetVolume:
+		_channels[index]->setVolume((byte)cmd.value);
+		break;
+	case Command::kSetBalance:
+		_channels[index]->setBalance((int8)cmd.value);
+		break;
+	case Command::kPause:
+		_channels[index]->pause(cmd.value != 0);
+		break;
+	}
+}
+
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && !_channels[i]->isPermanent())
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && _channels[i]->getId() == id)
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 
 	// Simply ignore stop requests for handles of sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	deleteChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
@@ -346,39 +416,37 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
-
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	if (_snapshots[index].handle == handle._val)
+		_snapshots[index].volume = volume;
 
-	_channels[index]->setVolume(volume);
+	queueCommand(Command::kSetVolume, handle, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const byte volume = _snapshots[index].volume;
+	if (_snapshots[index].handle != handle._val)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
-
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	if (_snapshots[index].handle == handle._val)
+		_snapshots[index].balance = balance;
 
-	_channels[index]->setBalance(balance);
+	queueCommand(Command::kSetBalance, handle, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int8 balance = _snapshots[index].balance;
+	if (_snapshots[index].handle != handle._val)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return balance;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -386,7 +454,8 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
+	processCommands();
 
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
@@ -396,7 +465,8 @@ Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 }
 
 void MixerImpl::pauseAll(bool paused) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0) {
 			_channels[i]->pause(paused);
@@ -405,7 +475,8 @@ void MixerImpl::pauseAll(bool paused) {
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
@@ -415,18 +486,11 @@ void MixerImpl::pauseID(int id, bool paused) {
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
-	Common::StackLock lock(_mutex);
-
-	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-
-	_channels[index]->pause(paused);
+	queueCommand(Command::kPause, handle, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getId() == id)
 			return true;
@@ -434,7 +498,7 @@ bool MixerImpl::isSoundIDActive(int id) {
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	const int index = handle._val % NUM_CHANNELS;
 	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
 		return _channels[index]->getId();
@@ -442,13 +506,13 @@ int MixerImpl::getSoundID(SoundHandle handle) {
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	const int index = handle._val % NUM_CHANNELS;
 	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getType() == type)
 			return true;
@@ -467,7 +531,7 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
+	EngineLock lock(*this);
 	_soundTypeSettings[type].volume = volume;
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
@@ -488,7 +552,7 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
@@ -497,7 +561,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
@@ -25,7 +25,9 @@
 
 #include "common/scummsys.h"
 #include "common/mutex.h"
+#include "common/spscqueue.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -49,12 +51,104 @@ namespace Audio {
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
+public:
+	/**
+	 * Counters describing how the engine threads and the mixer thread
+	 * interacted. See getCommandQueueStats().
+	 */
+	struct CommandQueueStats {
+		CommandQueueStats() : queued(0), direct(0), applied(0), lastDepth(0), maxDepth(0), lockWaits(0) {}
+
+		/** Channel commands queued without taking the mixer lock. */
+		uint32 queued;
+		/** Channel commands applied under the mixer lock, as the queue was full. */
+		uint32 direct;
+		/** Queued channel commands applied so far. */
+		uint32 applied;
+		/** Number of commands found in the queue by the last mixCallback. */
+		uint32 lastDepth;
+		/** Highest number of commands found in the queue by mixCallback. */
+		uint32 maxDepth;
+		/**
+		 * Number of mixCallback calls which found the mixer lock held by
+		 * another thread, and thus had to wait for it. OSystem has no
+		 * clock finer than milliseconds, so the waits are counted rather
+		 * than timed.
+		 */
+		uint32 lockWaits;
+	};
+
 private:
 	enum {
-		NUM_CHANNELS = 16
+		NUM_CHANNELS = 16,
+		COMMAND_QUEUE_SIZE = 256
+	};
+
+	/**
+	 * A change to a single channel, queued by an engine thread and applied
+	 * by the next function holding _mutex, usually mixCallback().
+	 */
+	struct Command {
+		enum Type {
+			kSetVolume,
+			kSetBalance,
+			kPause
+		};
+
+		Type type;
+		SoundHandle handle;
+		int value;
 	};
 
 	Common::Mutex _mutex;
+	/** Number of EngineLock instances currently holding _mutex. */
+	volatile int _lockHolders;
+
+	/**
+	 * Takes _mutex outside of mixCallback(), letting mixCallback() see
+	 * that it will have to wait for the lock.
+	 */
+	class EngineLock {
+	public:
+		EngineLock(MixerImpl &mixer) : _lock(mixer._mutex), _holders(mixer._lockHolders) { _holders++; }
+		~EngineLock() { _holders--; }
+
+	private:
+		Common::StackLock _lock;
+		volatile int &_holders;
+	};
+
+	/**
+	 * The volume and balance of a channel, as last set by the engine.
+	 * getChannelVolume() and getChannelBalance() read these without
+	 * taking _mutex, so they never wait for a mixing period to finish.
+	 */
+	struct ChannelSnapshot {
+		ChannelSnapshot() : handle(0xFFFFFFFF), volume(0), balance(0) {}
+
+		volatile uint32 handle;
+		volatile byte volume;
+		volatile int8 balance;
+	};
+
+	ChannelSnapshot _snapshots[NUM_CHANNELS];
+
+	/**
+	 * Frequent channel changes (volume, balance, pausing a handle) do not
+	 * take _mutex, so that they neither wait for a mixing period to finish
+	 * nor make the mixer thread wait for them. They are queued here instead.
+	 *
+	 * All other calls still take _mutex, so mixCallback() can wait for
+	 * them: starting a sound has to hand out its handle right away, and a
+	 * stopped sound must no longer be mixed once the call returns, as the
+	 * caller may free the sound data right after. The queries take it to
+	 * see a consistent set of channels. These calls are infrequent and
+	 * short; lockWaits in getCommandQueueStats() counts their contention.
+	 */
+	Common::SPSCQueue<Command, COMMAND_QUEUE_SIZE> _commands;
+	/** Serializes the threads queuing commands. Never taken by mixCallback(). */
+	Common::Mutex _commandMutex;
+	CommandQueueStats _stats;
 
 	const uint _sampleRate;
 	bool _mixerReady;
@@ -70,6 +164,9 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/** Interpolation used for streams not matching the output rate. */
+	RateConverterQuality _rateConverterQuality;
+
 
 public:
 
@@ -118,9 +215,34 @@ public:
 
 	virtual uint getOutputRate() const;
 
+	/**
+	 * Return the command queue and lock contention counters.
+	 */
+	CommandQueueStats getCommandQueueStats() const { return _stats; }
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	/**
+	 * Delete the channel in the given slot. Must be called with _mutex held.
+	 */
+	void deleteChannel(int index);
+
+	/**
+	 * Queue a channel command, or apply it right away if the queue is full.
+	 * Must not be called with _mutex held. _commandMutex is never held
+	 * while waiting for _mutex.
+	 */
+	void queueCommand(Command::Type type, SoundHandle handle, int value);
+
+	/**
+	 * Apply all queued channel commands. Must be called with _mutex held,
+	 * before accessing any channel state.
+	 */
+	void processCommands();
+
+	void applyCommand(const Command &cmd);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
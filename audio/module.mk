@@ -13,6 +13,8 @@ MODULE_OBJS := \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	rate_mix.o \
+	rate_sinc.o \
 	timestamp.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
@@ -30,6 +30,8 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_mix.h"
+#include "audio/rate_sinc.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
@@ -46,6 +48,12 @@ namespace Audio {
  */
 #define INTERMEDIATE_BUFFER_SIZE 512
 
+/**
+ * The number of output frames the resampling converters collect before
+ * handing them to the mix kernel in one go.
+ */
+#define MIX_BLOCK_SIZE 256
+
 
 /**
  * Audio rate converter based on simple resampling. Used when no
@@ -67,6 +75,8 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	MixFunc _mix;
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -95,6 +105,8 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 	opos_inc = inrate / outrate;
 
 	inLen = 0;
+
+	_mix = getMixFunc(true, reverseStereo);
 }
 
 /*
@@ -104,42 +116,50 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 template<bool stereo, bool reverseStereo>
 int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 	st_sample_t *ostart, *oend;
+	st_sample_t frames[MIX_BLOCK_SIZE * 2];
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
 	while (obuf < oend) {
+		st_sample_t *fptr = frames;
+		st_sample_t *fend = frames + MIN<int>(oend - obuf, ARRAYSIZE(frames));
+
+		while (fptr < fend) {
+
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+						obuf += fptr - frames;
+						return (obuf - ostart) / 2;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
 
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
-
-		// Increment output position
-		opos += opos_inc;
+			st_sample_t out0, out1;
+			out0 = *inPtr++;
+			out1 = (stereo ? *inPtr++ : out0);
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			*fptr++ = out0;
+			*fptr++ = out1;
+		}
 
-		obuf += 2;
+		// Apply the volume and mix the block into the output buffer
+		_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+		obuf += fptr - frames;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -151,8 +171,6 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
  * avoid the problems at the end of the buffer we had with the old
  * method which stored a possibly big buffer of size
  * lcm(in_rate,out_rate).
- *
- * Limited to sampling frequency <= 65535 Hz.
  */
 
 template<bool stereo, bool reverseStereo>
@@ -173,6 +191,8 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	MixFunc _mix;
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -187,23 +207,24 @@ public:
  */
 template<bool stereo, bool reverseStereo>
 LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate, st_rate_t outrate) {
-	if (inrate >= 65536 || outrate >= 65536) {
-		error("rate effect can only handle rates < 65536");
+	// The increment is a 16.16 fixed point value, so the ratio of the two
+	// rates must stay below 2^15.
+	if (inrate / outrate >= (1 << (31 - FRAC_BITS))) {
+		error("rate effect can only handle rate ratios < %d", 1 << (31 - FRAC_BITS));
 	}
 
 	opos = FRAC_ONE;
 
-	// Compute the linear interpolation increment.
-	// This will overflow if inrate >= 2^16, and underflow if outrate >= 2^16.
-	// Also, if the quotient of the two rate becomes too small / too big, that
-	// would cause problems, but since we rarely scale from 1 to 65536 Hz or vice
-	// versa, I think we can live with that limitation ;-).
-	opos_inc = (inrate << FRAC_BITS) / outrate;
+	// Compute the linear interpolation increment. The intermediate value is
+	// computed in 64 bits, as it would overflow for inrate >= 2^16 otherwise.
+	opos_inc = (frac_t)(((uint64)inrate << FRAC_BITS) / outrate);
 
 	ilast0 = ilast1 = 0;
 	icur0 = icur1 = 0;
 
 	inLen = 0;
+
+	_mix = getMixFunc(true, reverseStereo);
 }
 
 /*
@@ -213,52 +234,60 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 template<bool stereo, bool reverseStereo>
 int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 	st_sample_t *ostart, *oend;
+	st_sample_t frames[MIX_BLOCK_SIZE * 2];
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
 	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+		st_sample_t *fptr = frames;
+		st_sample_t *fend = frames + MIN<int>(oend - obuf, ARRAYSIZE(frames));
+
+		while (fptr < fend) {
+
+			// read enough input samples so that opos < 0
+			while ((frac_t)FRAC_ONE <= opos) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+						obuf += fptr - frames;
+						return (obuf - ostart) / 2;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				ilast0 = icur0;
+				icur0 = *inPtr++;
+				if (stereo) {
+					ilast1 = icur1;
+					icur1 = *inPtr++;
+				}
+				opos -= FRAC_ONE;
 			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
+
+			// Loop as long as the outpos trails behind, and as long as there is
+			// still space in the block.
+			while (opos < (frac_t)FRAC_ONE && fptr < fend) {
+				// interpolate
+				st_sample_t out0, out1;
+				out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
+				out1 = (stereo ?
+							  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
+							  out0);
+
+				*fptr++ = out0;
+				*fptr++ = out1;
+
+				// Increment output position
+				opos += opos_inc;
 			}
-			opos -= FRAC_ONE;
 		}
 
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-
-			// Increment output position
-			opos += opos_inc;
-		}
+		// Apply the volume and mix the block into the output buffer
+		_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+		obuf += fptr - frames;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -274,8 +303,9 @@ template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
+	MixFunc _mix;
 public:
-	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
+	CopyRateConverter() : _buffer(0), _bufferSize(0), _mix(getMixFunc(stereo, reverseStereo)) {}
 	~CopyRateConverter() {
 		free(_buffer);
 	}
@@ -283,11 +313,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -303,23 +330,13 @@ public:
 
 		// Read up to 'osamp' samples into our temporary buffer
 		len = input.readBuffer(_buffer, osamp);
+		if ((int)len <= 0)
+			return 0;
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t numFrames = (stereo ? len / 2 : len);
+		_mix(obuf, _buffer, numFrames, vol_l, vol_r);
+		return numFrames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -331,9 +348,11 @@ public:
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0) {
+		if (quality == kRateConverterSinc) {
+			return makeSincRateConverter(inrate, outrate, stereo, reverseStereo);
+		} else if ((inrate % outrate) == 0) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -346,14 +365,14 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
@@ -78,7 +78,17 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * The interpolation used by converters between differing sample rates.
+ */
+enum RateConverterQuality {
+	/** Sample picking or linear interpolation; cheap, but prone to aliasing. */
+	kRateConverterLinear,
+	/** Band-limited polyphase windowed-sinc interpolation. */
+	kRateConverterSinc
+};
+
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, RateConverterQuality quality = kRateConverterLinear);
 
 } // End of namespace Audio
 
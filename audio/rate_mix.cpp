@@ -0,0 +1,269 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/rate_mix.h"
+#include "audio/mixer.h"
+#include "common/cpudetect.h"
+
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace Audio {
+
+/**
+ * Reference implementation, used for the tail of every block and on CPUs
+ * without any supported vector extension.
+ */
+template<bool stereo, bool reverseStereo>
+static void mixScalar(st_sample_t *obuf, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; numFrames > 0; --numFrames) {
+		st_sample_t out0, out1;
+		out0 = *src++;
+		out1 = (stereo ? *src++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+#ifndef OUTPUT_UNSIGNED_AUDIO
+
+/**
+ * The vector kernels multiply in 16 bit lanes and emulate the division by
+ * kMaxMixerVolume with a shift, so they can only take over when the volumes
+ * fit into a signed 16 bit value and the mixer volume range is unchanged.
+ */
+enum {
+	kMaxVectorVolume = 0x7FFF
+};
+
+static inline bool canMixVector(st_volume_t vol_l, st_volume_t vol_r) {
+	return Audio::Mixer::kMaxMixerVolume == 256 && vol_l <= kMaxVectorVolume && vol_r <= kMaxVectorVolume;
+}
+
+#ifdef SCUMMVM_SIMD_X86
+
+/**
+ * Mix 8 input samples into 8 output samples. The products are divided by
+ * 256 rounding towards zero, exactly like the C division in mixScalar, and
+ * the saturating pack takes care of the clamping.
+ */
+SCUMMVM_TARGET_SSE2 static inline __m128i mixVectorSSE2(__m128i out, __m128i in, __m128i vol) {
+	const __m128i bias = _mm_set1_epi32(255);
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), 8);
+	p0 = _mm_add_epi32(p0, _mm_srai_epi32(_mm_unpacklo_epi16(out, out), 16));
+	p1 = _mm_add_epi32(p1, _mm_srai_epi32(_mm_unpackhi_epi16(out, out), 16));
+	return _mm_packs_epi32(p0, p1);
+}
+
+template<bool stereo, bool reverseStereo>
+SCUMMVM_TARGET_SSE2 static void mixSSE2(st_sample_t *obuf, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!canMixVector(vol_l, vol_r)) {
+		mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+		return;
+	}
+
+	// With reversed stereo the input pairs get swapped before mixing, so
+	// the right input sample ends up in the left lane.
+	const __m128i vol = reverseStereo ?
+		_mm_setr_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l) :
+		_mm_setr_epi16(vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r);
+
+	if (stereo) {
+		for (; numFrames >= 4; numFrames -= 4) {
+			__m128i in = _mm_loadu_si128((const __m128i *)src);
+			if (reverseStereo)
+				in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			const __m128i out = _mm_loadu_si128((const __m128i *)obuf);
+			_mm_storeu_si128((__m128i *)obuf, mixVectorSSE2(out, in, vol));
+			src += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; numFrames >= 8; numFrames -= 8) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)src);
+			const __m128i out0 = _mm_loadu_si128((const __m128i *)obuf);
+			const __m128i out1 = _mm_loadu_si128((const __m128i *)(obuf + 8));
+			_mm_storeu_si128((__m128i *)obuf, mixVectorSSE2(out0, _mm_unpacklo_epi16(in, in), vol));
+			_mm_storeu_si128((__m128i *)(obuf + 8), mixVectorSSE2(out1, _mm_unpackhi_epi16(in, in), vol));
+			src += 8;
+			obuf += 16;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+}
+
+/**
+ * AVX2 variant of mixVectorSSE2, working on 16 samples. Unpacking and packing
+ * both operate per 128 bit lane, so the sample order is preserved.
+ */
+SCUMMVM_TARGET_AVX2 static inline __m256i mixVectorAVX2(__m256i out, __m256i in, __m256i vol) {
+	const __m256i bias = _mm256_set1_epi32(255);
+	const __m256i lo = _mm256_mullo_epi16(in, vol);
+	const __m256i hi = _mm256_mulhi_epi16(in, vol);
+	__m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+	__m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+	p0 = _mm256_srai_epi32(_mm256_add_epi32(p0, _mm256_and_si256(_mm256_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm256_srai_epi32(_mm256_add_epi32(p1, _mm256_and_si256(_mm256_srai_epi32(p1, 31), bias)), 8);
+	p0 = _mm256_add_epi32(p0, _mm256_srai_epi32(_mm256_unpacklo_epi16(out, out), 16));
+	p1 = _mm256_add_epi32(p1, _mm256_srai_epi32(_mm256_unpackhi_epi16(out, out), 16));
+	return _mm256_packs_epi32(p0, p1);
+}
+
+template<bool stereo, bool reverseStereo>
+SCUMMVM_TARGET_AVX2 static void mixAVX2(st_sample_t *obuf, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!canMixVector(vol_l, vol_r)) {
+		mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+		return;
+	}
+
+	const __m256i vol = reverseStereo ?
+		_mm256_set1_epi32((int)(((uint32)vol_l << 16) | vol_r)) :
+		_mm256_set1_epi32((int)(((uint32)vol_r << 16) | vol_l));
+
+	if (stereo) {
+		for (; numFrames >= 8; numFrames -= 8) {
+			__m256i in = _mm256_loadu_si256((const __m256i *)src);
+			if (reverseStereo)
+				in = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			const __m256i out = _mm256_loadu_si256((const __m256i *)obuf);
+			_mm256_storeu_si256((__m256i *)obuf, mixVectorAVX2(out, in, vol));
+			src += 16;
+			obuf += 16;
+		}
+	} else {
+		for (; numFrames >= 8; numFrames -= 8) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)src);
+			const __m256i dup = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(in, in)), _mm_unpackhi_epi16(in, in), 1);
+			const __m256i out = _mm256_loadu_si256((const __m256i *)obuf);
+			_mm256_storeu_si256((__m256i *)obuf, mixVectorAVX2(out, dup, vol));
+			src += 8;
+			obuf += 16;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+}
+
+#endif // SCUMMVM_SIMD_X86
+
+#ifdef SCUMMVM_SIMD_NEON
+
+/**
+ * NEON variant of mixVectorSSE2. The widening multiply gives the 32 bit
+ * products directly and vqmovn_s32 does the clamping.
+ */
+static inline int16x8_t mixVectorNEON(int16x8_t out, int16x8_t in, int16x8_t vol) {
+	const int32x4_t bias = vdupq_n_s32(255);
+	int32x4_t p0 = vmull_s16(vget_low_s16(in), vget_low_s16(vol));
+	int32x4_t p1 = vmull_s16(vget_high_s16(in), vget_high_s16(vol));
+	p0 = vshrq_n_s32(vaddq_s32(p0, vandq_s32(vshrq_n_s32(p0, 31), bias)), 8);
+	p1 = vshrq_n_s32(vaddq_s32(p1, vandq_s32(vshrq_n_s32(p1, 31), bias)), 8);
+	p0 = vaddw_s16(p0, vget_low_s16(out));
+	p1 = vaddw_s16(p1, vget_high_s16(out));
+	return vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixNEON(st_sample_t *obuf, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!canMixVector(vol_l, vol_r)) {
+		mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+		return;
+	}
+
+	const int16 volLane0 = reverseStereo ? vol_r : vol_l;
+	const int16 volLane1 = reverseStereo ? vol_l : vol_r;
+	const int16 volLanes[8] = { volLane0, volLane1, volLane0, volLane1, volLane0, volLane1, volLane0, volLane1 };
+	const int16x8_t vol = vld1q_s16(volLanes);
+
+	if (stereo) {
+		for (; numFrames >= 4; numFrames -= 4) {
+			int16x8_t in = vld1q_s16(src);
+			if (reverseStereo)
+				in = vrev32q_s16(in);
+			vst1q_s16(obuf, mixVectorNEON(vld1q_s16(obuf), in, vol));
+			src += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; numFrames >= 8; numFrames -= 8) {
+			const int16x8_t in = vld1q_s16(src);
+			const int16x8x2_t dup = vzipq_s16(in, in);
+			vst1q_s16(obuf, mixVectorNEON(vld1q_s16(obuf), dup.val[0], vol));
+			vst1q_s16(obuf + 8, mixVectorNEON(vld1q_s16(obuf + 8), dup.val[1], vol));
+			src += 8;
+			obuf += 16;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, src, numFrames, vol_l, vol_r);
+}
+
+#endif // SCUMMVM_SIMD_NEON
+
+#endif // OUTPUT_UNSIGNED_AUDIO
+
+template<bool stereo, bool reverseStereo>
+static MixFunc selectMixFunc() {
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#ifdef SCUMMVM_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		return &mixAVX2<stereo, reverseStereo>;
+	if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		return &mixSSE2<stereo, reverseStereo>;
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		return &mixNEON<stereo, reverseStereo>;
+#endif
+#endif
+	return &mixScalar<stereo, reverseStereo>;
+}
+
+MixFunc getMixFunc(bool stereo, bool reverseStereo) {
+	if (stereo) {
+		if (reverseStereo)
+			return selectMixFunc<true, true>();
+		else
+			return selectMixFunc<true, false>();
+	} else
+		return selectMixFunc<false, false>();
+}
+
+} // End of namespace Audio
@@ -0,0 +1,52 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_MIX_H
+#define AUDIO_RATE_MIX_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Scale a block of frames by the channel volumes and add them, with clamping,
+ * to an interleaved stereo output buffer. This is the final stage of every
+ * RateConverter::flow() implementation.
+ *
+ * @param obuf		stereo output buffer, receives 2 * numFrames samples
+ * @param src		input frames; one sample per frame for mono kernels,
+ *					two interleaved samples per frame for stereo kernels
+ * @param numFrames	number of frames to mix
+ * @param vol_l		volume applied to the left input channel
+ * @param vol_r		volume applied to the right input channel
+ */
+typedef void (*MixFunc)(st_sample_t *obuf, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Return the fastest mix kernel the host CPU supports for the given input
+ * layout. All kernels produce exactly the same output as the plain C one.
+ */
+MixFunc getMixFunc(bool stereo, bool reverseStereo);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,401 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate_sinc.h"
+#include "audio/rate_mix.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "common/math.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+enum {
+	/** Taps per phase when upsampling. Downsampling widens the filter. */
+	kSincBaseTaps = 16,
+	kSincMaxTaps = 64,
+	/** Upper limit for the number of filter phases of one bank. */
+	kSincMaxPhases = 1024,
+	/** Coefficients are stored as signed 1.15 fixed point values. */
+	kSincCoefBits = 15,
+	/** Input samples kept per channel, including the filter history. */
+	kSincWindowSize = 512 + kSincMaxTaps,
+	/** Number of frames collected before handing them to the mix kernel. */
+	kSincBlockSize = 256
+};
+
+/** Cutoff frequency, relative to the lower of the two Nyquist frequencies. */
+static const double kSincCutoff = 0.90;
+/** Kaiser window shape parameter, trading transition width for stopband. */
+static const double kSincKaiserBeta = 8.0;
+
+/**
+ * A set of windowed-sinc FIR filters, one per fractional input position
+ * ("phase"), for one pair of input and output rates.
+ */
+struct SincFilterBank {
+	st_rate_t inRate;
+	st_rate_t outRate;
+	int refCount;
+
+	/** Number of coefficients per phase, always a multiple of 8. */
+	uint taps;
+	uint numPhases;
+	/** numPhases * taps coefficients, each phase summing up to 1.0. */
+	int16 *coefs;
+
+	SincFilterBank(st_rate_t in, st_rate_t out, uint phases);
+	~SincFilterBank() { delete[] coefs; }
+};
+
+/** Zeroth order modified Bessel function of the first kind. */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	const double halfX = x / 2.0;
+
+	for (int k = 1; k < 32; ++k) {
+		term *= (halfX / k) * (halfX / k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+
+	return sum;
+}
+
+SincFilterBank::SincFilterBank(st_rate_t in, st_rate_t out, uint phases)
+	: inRate(in), outRate(out), refCount(0), numPhases(phases) {
+	// When downsampling, the cutoff drops below the input Nyquist frequency,
+	// and the filter has to span more input samples for the same quality.
+	const double ratio = (in > out) ? (double)out / in : 1.0;
+	taps = (uint)ceil(kSincBaseTaps / ratio);
+	taps = MIN<uint>((taps + 7) & ~7, kSincMaxTaps);
+
+	const double cutoff = kSincCutoff * ratio;
+	const double halfWidth = taps / 2.0;
+	const double windowNorm = besselI0(kSincKaiserBeta);
+
+	coefs = new int16[numPhases * taps];
+
+	double *h = new double[taps];
+	for (uint phase = 0; phase < numPhases; ++phase) {
+		const double frac = (double)phase / numPhases;
+		double sum = 0.0;
+
+		for (uint k = 0; k < taps; ++k) {
+			// Distance of tap k from the output position, in input samples
+			const double t = (double)k - taps / 2 - frac;
+			const double x = t / halfWidth;
+
+			if (x <= -1.0 || x >= 1.0) {
+				h[k] = 0.0;
+			} else {
+				const double window = besselI0(kSincKaiserBeta * sqrt(1.0 - x * x)) / windowNorm;
+				const double sinc = (t == 0.0) ? 1.0 : sin(M_PI * cutoff * t) / (M_PI * cutoff * t);
+				h[k] = cutoff * sinc * window;
+			}
+			sum += h[k];
+		}
+
+		// Normalize for unity DC gain, and fold the rounding error into the
+		// largest tap so that every phase sums up to exactly 1.0.
+		int16 *dst = coefs + phase * taps;
+		int total = 0;
+		uint largest = 0;
+		for (uint k = 0; k < taps; ++k) {
+			dst[k] = (int16)floor(h[k] / sum * (1 << kSincCoefBits) + 0.5);
+			total += dst[k];
+			if (ABS<int>(dst[k]) > ABS<int>(dst[largest]))
+				largest = k;
+		}
+		dst[largest] += (1 << kSincCoefBits) - total;
+	}
+	delete[] h;
+}
+
+/**
+ * The filter banks currently in use. There are rarely more than a handful of
+ * different rate pairs in use at once, so a plain array is good enough.
+ */
+static Common::Array<SincFilterBank *> s_sincBanks;
+
+static SincFilterBank *acquireSincFilterBank(st_rate_t inrate, st_rate_t outrate) {
+	for (uint i = 0; i < s_sincBanks.size(); ++i) {
+		if (s_sincBanks[i]->inRate == inrate && s_sincBanks[i]->outRate == outrate) {
+			s_sincBanks[i]->refCount++;
+			return s_sincBanks[i];
+		}
+	}
+
+	// One phase per distinct fractional position, if the reduced ratio
+	// allows for it; otherwise the positions are rounded to kSincMaxPhases.
+	const st_rate_t gcd = Common::gcd(inrate, outrate);
+	const uint phases = MIN<uint>(outrate / gcd, kSincMaxPhases);
+
+	SincFilterBank *bank = new SincFilterBank(inrate, outrate, phases);
+	bank->refCount = 1;
+	s_sincBanks.push_back(bank);
+	return bank;
+}
+
+static void releaseSincFilterBank(SincFilterBank *bank) {
+	if (--bank->refCount > 0)
+		return;
+
+	for (uint i = 0; i < s_sincBanks.size(); ++i) {
+		if (s_sincBanks[i] == bank) {
+			s_sincBanks.remove_at(i);
+			break;
+		}
+	}
+	delete bank;
+}
+
+#pragma mark -
+
+typedef int32 (*SincDotFunc)(const int16 *samples, const int16 *coefs, uint taps);
+
+static int32 sincDotScalar(const int16 *samples, const int16 *coefs, uint taps) {
+	int32 acc = 0;
+	for (uint k = 0; k < taps; ++k)
+		acc += samples[k] * coefs[k];
+	return acc;
+}
+
+#ifdef SCUMMVM_SIMD_X86
+SCUMMVM_TARGET_SSE2 static int32 sincDotSSE2(const int16 *samples, const int16 *coefs, uint taps) {
+	__m128i acc = _mm_setzero_si128();
+	for (uint k = 0; k < taps; k += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(samples + k));
+		const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + k));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s, c));
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(acc);
+}
+#endif
+
+#ifdef SCUMMVM_SIMD_NEON
+static int32 sincDotNEON(const int16 *samples, const int16 *coefs, uint taps) {
+	int32x4_t acc = vdupq_n_s32(0);
+	for (uint k = 0; k < taps; k += 8) {
+		const int16x8_t s = vld1q_s16(samples + k);
+		const int16x8_t c = vld1q_s16(coefs + k);
+		acc = vmlal_s16(acc, vget_low_s16(s), vget_low_s16(c));
+		acc = vmlal_s16(acc, vget_high_s16(s), vget_high_s16(c));
+	}
+	const int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+	return vget_lane_s32(vpadd_s32(sum, sum), 0);
+}
+#endif
+
+static SincDotFunc getSincDotFunc() {
+#ifdef SCUMMVM_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		return &sincDotSSE2;
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		return &sincDotNEON;
+#endif
+	return &sincDotScalar;
+}
+
+static inline st_sample_t sincRound(int32 acc) {
+	acc = (acc + (1 << (kSincCoefBits - 1))) >> kSincCoefBits;
+	return (st_sample_t)CLIP<int32>(acc, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+}
+
+#pragma mark -
+
+/**
+ * Audio rate converter based on band-limited interpolation with a polyphase
+ * windowed-sinc filter. Considerably more expensive than LinearRateConverter,
+ * but free of the aliasing and high frequency loss of linear interpolation.
+ *
+ * The input is kept deinterleaved per channel in a sliding window, so that
+ * each output sample is a single contiguous dot product.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[kSincWindowSize * 2];
+
+	/** Deinterleaved input, _fill samples per channel are valid. */
+	st_sample_t _window[2][kSincWindowSize];
+	uint _fill;
+
+	/** Integer position of the current output sample in the window. */
+	uint _pos;
+	/** Fractional position, in units of 1 / _den input samples. */
+	uint32 _phase;
+	uint32 _den;
+	/** Position increment per output sample, split like the position. */
+	uint _incInt;
+	uint32 _incFrac;
+
+	SincFilterBank *_bank;
+	SincDotFunc _dot;
+	MixFunc _mix;
+
+	bool refill(AudioStream &input);
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~SincRateConverter();
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate) {
+	_bank = acquireSincFilterBank(inrate, outrate);
+	_dot = getSincDotFunc();
+	_mix = getMixFunc(true, reverseStereo);
+
+	const st_rate_t gcd = Common::gcd(inrate, outrate);
+	_den = outrate / gcd;
+	_incInt = (inrate / gcd) / _den;
+	_incFrac = (inrate / gcd) % _den;
+	_phase = 0;
+	_pos = 0;
+
+	// Start with half a filter of silence, so that the first output sample
+	// is centered on the first input sample.
+	_fill = _bank->taps / 2;
+	memset(_window, 0, sizeof(_window));
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	releaseSincFilterBank(_bank);
+}
+
+/*
+ * Drop the consumed part of the window and append new input to it.
+ * Returns false once the input stream has run dry.
+ */
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::refill(AudioStream &input) {
+	const uint drop = MIN(_pos, _fill);
+	if (drop > 0) {
+		memmove(_window[0], _window[0] + drop, (_fill - drop) * sizeof(st_sample_t));
+		if (stereo)
+			memmove(_window[1], _window[1] + drop, (_fill - drop) * sizeof(st_sample_t));
+		_fill -= drop;
+		_pos -= drop;
+	}
+
+	const int want = (kSincWindowSize - _fill) * (stereo ? 2 : 1);
+	const int len = input.readBuffer(inBuf, want);
+	if (len <= 0)
+		return false;
+
+	const st_sample_t *src = inBuf;
+	if (stereo) {
+		for (int i = 0; i < len / 2; ++i) {
+			_window[0][_fill] = *src++;
+			_window[1][_fill] = *src++;
+			++_fill;
+		}
+	} else {
+		memcpy(_window[0] + _fill, src, len * sizeof(st_sample_t));
+		_fill += len;
+	}
+
+	return true;
+}
+
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+	st_sample_t frames[kSincBlockSize * 2];
+
+	const uint taps = _bank->taps;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+		st_sample_t *fptr = frames;
+		st_sample_t *fend = frames + MIN<int>(oend - obuf, ARRAYSIZE(frames));
+
+		while (fptr < fend) {
+			// Make sure the whole filter span is available
+			while (_pos + taps > _fill) {
+				if (!refill(input)) {
+					_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+					obuf += fptr - frames;
+					return (obuf - ostart) / 2;
+				}
+			}
+
+			const uint phaseIndex = (_bank->numPhases == _den) ? _phase : (uint)(((uint64)_phase * _bank->numPhases) / _den);
+			const int16 *coefs = _bank->coefs + phaseIndex * taps;
+
+			st_sample_t out0, out1;
+			out0 = sincRound(_dot(_window[0] + _pos, coefs, taps));
+			out1 = (stereo ? sincRound(_dot(_window[1] + _pos, coefs, taps)) : out0);
+
+			*fptr++ = out0;
+			*fptr++ = out1;
+
+			// Increment output position
+			_pos += _incInt;
+			_phase += _incFrac;
+			if (_phase >= _den) {
+				_phase -= _den;
+				_pos++;
+			}
+		}
+
+		// Apply the volume and mix the block into the output buffer
+		_mix(obuf, frames, (fptr - frames) / 2, vol_l, vol_r);
+		obuf += fptr - frames;
+	}
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	if (stereo) {
+		if (reverseStereo)
+			return new SincRateConverter<true, true>(inrate, outrate);
+		else
+			return new SincRateConverter<true, false>(inrate, outrate);
+	} else
+		return new SincRateConverter<false, false>(inrate, outrate);
+}
+
+} // End of namespace Audio
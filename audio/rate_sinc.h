@@ -0,0 +1,43 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_SINC_H
+#define AUDIO_RATE_SINC_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Create a band-limited polyphase resampler for the specified input and
+ * output rates. The windowed-sinc filter tables are shared by all converters
+ * using the same pair of rates.
+ *
+ * Like all rate converters, these must only be created and destroyed from
+ * the mixer thread or with the mixer lock held, since the table cache is
+ * not locked itself.
+ */
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo);
+
+} // End of namespace Audio
+
+#endif
@@ -405,7 +405,7 @@ void DINGUXSdlGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
-	_numDirtyRects = 0;
+	clearDirtyRects();
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
 }
@@ -436,7 +436,7 @@ void GPHGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
-	_numDirtyRects = 0;
+	clearDirtyRects();
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
 }
@@ -32,10 +32,49 @@
 #include "common/util.h"
 #include "common/tokenizer.h"
 
+#if defined(SDL_BACKEND) && !defined(USE_GLES)
+#include "backends/platform/sdl/sdl-sys.h"
+
+// Pixel buffer objects are only used where we can look up the entry points
+// of GL_ARB_pixel_buffer_object, which are no part of OpenGL 1.1.
+#define GLTEXTURE_PIXEL_BUFFERS
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
 // Supported GL extensions
 static bool npot_supported = false;
+static bool pbo_supported = false;
 static bool glext_inited = false;
 
+#ifdef GLTEXTURE_PIXEL_BUFFERS
+#define GL_PIXEL_UNPACK_BUFFER_ARB 0x88EC
+#define GL_STREAM_DRAW_ARB         0x88E0
+#define GL_WRITE_ONLY_ARB          0x88B9
+
+typedef void (APIENTRY *GenBuffersProc)(GLsizei n, GLuint *buffers);
+typedef void (APIENTRY *DeleteBuffersProc)(GLsizei n, const GLuint *buffers);
+typedef void (APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+typedef void (APIENTRY *BufferDataProc)(GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage);
+typedef GLvoid *(APIENTRY *MapBufferProc)(GLenum target, GLenum access);
+typedef GLboolean (APIENTRY *UnmapBufferProc)(GLenum target);
+
+static GenBuffersProc glGenBuffersARB_ = 0;
+static DeleteBuffersProc glDeleteBuffersARB_ = 0;
+static BindBufferProc glBindBufferARB_ = 0;
+static BufferDataProc glBufferDataARB_ = 0;
+static MapBufferProc glMapBufferARB_ = 0;
+static UnmapBufferProc glUnmapBufferARB_ = 0;
+#endif
+
+uint32 GLTexture::_uploadedBytes = 0;
+
 /*static inline GLint xdiv(int numerator, int denominator) {
 	assert(numerator < (1 << 16));
 	return (numerator << 16) / denominator;
@@ -68,8 +107,34 @@ void GLTexture::initGLExtensions() {
 		Common::String token = tokenizer.nextToken();
 		if (token == "GL_ARB_texture_non_power_of_two")
 			npot_supported = true;
+		else if (token == "GL_ARB_pixel_buffer_object")
+			pbo_supported = true;
 	}
 
+	// Software renderers upload synchronously anyway, a pixel buffer only
+	// adds a copy. With llvmpipe, uploads through it took about three times
+	// as long as straight from the surface.
+	const Common::String renderer = (const char *)glGetString(GL_RENDERER);
+	CHECK_GL_ERROR();
+	if (renderer.contains("llvmpipe") || renderer.contains("softpipe") || renderer.contains("Software Rasterizer"))
+		pbo_supported = false;
+
+#ifdef GLTEXTURE_PIXEL_BUFFERS
+	if (pbo_supported) {
+		glGenBuffersARB_ = (GenBuffersProc)SDL_GL_GetProcAddress("glGenBuffersARB");
+		glDeleteBuffersARB_ = (DeleteBuffersProc)SDL_GL_GetProcAddress("glDeleteBuffersARB");
+		glBindBufferARB_ = (BindBufferProc)SDL_GL_GetProcAddress("glBindBufferARB");
+		glBufferDataARB_ = (BufferDataProc)SDL_GL_GetProcAddress("glBufferDataARB");
+		glMapBufferARB_ = (MapBufferProc)SDL_GL_GetProcAddress("glMapBufferARB");
+		glUnmapBufferARB_ = (UnmapBufferProc)SDL_GL_GetProcAddress("glUnmapBufferARB");
+
+		pbo_supported = glGenBuffersARB_ && glDeleteBuffersARB_ && glBindBufferARB_ &&
+		                glBufferDataARB_ && glMapBufferARB_ && glUnmapBufferARB_;
+	}
+#else
+	pbo_supported = false;
+#endif
+
 	glext_inited = true;
 }
 
@@ -84,7 +149,8 @@ GLTexture::GLTexture(byte bpp, GLenum internalFormat, GLenum format, GLenum type
 	_realWidth(0),
 	_realHeight(0),
 	_refresh(false),
-	_filter(GL_NEAREST) {
+	_filter(GL_NEAREST),
+	_pixelBuffer(0) {
 
 	// Generate the texture ID
 	glGenTextures(1, &_textureName); CHECK_GL_ERROR();
@@ -93,11 +159,28 @@ GLTexture::GLTexture(byte bpp, GLenum internalFormat, GLenum format, GLenum type
 GLTexture::~GLTexture() {
 	// Delete the texture
 	glDeleteTextures(1, &_textureName); CHECK_GL_ERROR();
+	freePixelBuffer();
+}
+
+void GLTexture::freePixelBuffer() {
+#ifdef GLTEXTURE_PIXEL_BUFFERS
+	if (_pixelBuffer) {
+		glDeleteBuffersARB_(1, &_pixelBuffer); CHECK_GL_ERROR();
+		_pixelBuffer = 0;
+	}
+#endif
+}
+
+uint32 GLTexture::takeUploadedBytes() {
+	const uint32 bytes = _uploadedBytes;
+	_uploadedBytes = 0;
+	return bytes;
 }
 
 void GLTexture::refresh() {
 	// Delete previous texture
 	glDeleteTextures(1, &_textureName); CHECK_GL_ERROR();
+	freePixelBuffer();
 
 	// Generate the texture ID
 	glGenTextures(1, &_textureName); CHECK_GL_ERROR();
@@ -153,10 +236,56 @@ void GLTexture::updateBuffer(const void *buf, int pitch, GLuint x, GLuint y, GLu
 	// Select this OpenGL texture
 	glBindTexture(GL_TEXTURE_2D, _textureName); CHECK_GL_ERROR();
 
+	_uploadedBytes += w * h * _bytesPerPixel;
+
+#ifdef GLTEXTURE_PIXEL_BUFFERS
+	if (pbo_supported) {
+		if (!_pixelBuffer) {
+			glGenBuffersARB_(1, &_pixelBuffer); CHECK_GL_ERROR();
+		}
+
+		// Discard the old contents of the buffer when (re)specifying it, so
+		// that the driver does not need to wait for a pending upload from it.
+		const uint rowSize = w * _bytesPerPixel;
+		glBindBufferARB_(GL_PIXEL_UNPACK_BUFFER_ARB, _pixelBuffer); CHECK_GL_ERROR();
+		glBufferDataARB_(GL_PIXEL_UNPACK_BUFFER_ARB, rowSize * h, NULL, GL_STREAM_DRAW_ARB); CHECK_GL_ERROR();
+		byte *dst = (byte *)glMapBufferARB_(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB); CHECK_GL_ERROR();
+
+		if (dst) {
+			const byte *src = (const byte *)buf;
+			for (GLuint i = 0; i < h; i++) {
+				memcpy(dst, src, rowSize);
+				dst += rowSize;
+				src += pitch;
+			}
+			glUnmapBufferARB_(GL_PIXEL_UNPACK_BUFFER_ARB); CHECK_GL_ERROR();
+
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h,
+			                _glFormat, _glType, NULL); CHECK_GL_ERROR();
+		}
+
+		glBindBufferARB_(GL_PIXEL_UNPACK_BUFFER_ARB, 0); CHECK_GL_ERROR();
+
+		if (dst) {
+			updateLinearFilterBorder(buf, pitch, x, y, w, h);
+			return;
+		}
+	}
+#endif
+
 	// Check if the buffer has its data contiguously
 	if ((int)w * _bytesPerPixel == pitch) {
 		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h,
 		                _glFormat, _glType, buf); CHECK_GL_ERROR();
+#ifndef USE_GLES
+	} else if (pitch % _bytesPerPixel == 0) {
+		// Upload the rect straight out of the larger buffer, instead of
+		// uploading it row by row
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / _bytesPerPixel); CHECK_GL_ERROR();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h,
+		                _glFormat, _glType, buf); CHECK_GL_ERROR();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0); CHECK_GL_ERROR();
+#endif
 	} else {
 		// Update the texture row by row
 		const byte *src = (const byte *)buf;
@@ -170,6 +299,10 @@ void GLTexture::updateBuffer(const void *buf, int pitch, GLuint x, GLuint y, GLu
 		} while (--height);
 	}
 
+	updateLinearFilterBorder(buf, pitch, x, y, w, h);
+}
+
+void GLTexture::updateLinearFilterBorder(const void *buf, int pitch, GLuint x, GLuint y, GLuint w, GLuint h) {
 	// If we're in linear filter mode, repeat the last row/column if the real dimensions
 	// doesn't match the texture dimensions.
 	if (_filter == GL_LINEAR) {
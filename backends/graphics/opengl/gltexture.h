@@ -82,7 +82,8 @@ public:
 	void allocBuffer(GLuint width, GLuint height);
 
 	/**
-	 * Updates the texture pixels.
+	 * Updates the texture pixels. Only the given rect is uploaded, straight
+	 * from the buffer or through a pixel buffer object when available.
 	 */
 	void updateBuffer(const void *buf, int pitch, GLuint x, GLuint y,
 		GLuint w, GLuint h);
@@ -113,7 +114,19 @@ public:
 	 */
 	void setFilter(GLint filter) { _filter = filter; }
 
+	/**
+	 * Get the number of bytes passed to OpenGL by updateBuffer calls of
+	 * all textures since the last call, and reset it.
+	 */
+	static uint32 takeUploadedBytes();
+
 private:
+	void freePixelBuffer();
+	void updateLinearFilterBorder(const void *buf, int pitch, GLuint x, GLuint y,
+		GLuint w, GLuint h);
+
+	static uint32 _uploadedBytes;
+
 	const byte _bytesPerPixel;
 	const GLenum _internalFormat;
 	const GLenum _glFormat;
@@ -126,6 +139,11 @@ private:
 	GLuint _textureHeight;
 	GLint _filter;
 	bool _refresh;
+
+	// Pixel buffer object the updates are streamed through. Its storage is
+	// orphaned for each update, so that filling it does not wait for the
+	// upload from it before.
+	GLuint _pixelBuffer;
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include "backends/graphics/opengl/opengl-graphics.h"
 #include "backends/graphics/opengl/glerrorcheck.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/file.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
@@ -50,9 +51,10 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 	_cursorNeedsRedraw(false), _cursorPaletteDisabled(true),
 	_cursorVisible(false), _cursorKeyColor(0),
 	_cursorDontScale(false),
-	_formatBGR(false),
+	_formatBGR(false), _showUploadStats(false),
 	_displayX(0), _displayY(0), _displayWidth(0), _displayHeight(0) {
 
+	memset(&_uploadStats, 0, sizeof(_uploadStats));
 	memset(&_oldVideoMode, 0, sizeof(_oldVideoMode));
 	memset(&_videoMode, 0, sizeof(_videoMode));
 	memset(&_transactionDetails, 0, sizeof(_transactionDetails));
@@ -64,6 +66,13 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 
 	_gamePalette = (byte *)calloc(sizeof(byte) * 3, 256);
 	_cursorPalette = (byte *)calloc(sizeof(byte) * 3, 256);
+
+	// Paletted pixels are expanded to RGBA bytes, as GL_UNSIGNED_BYTE wants them
+#ifdef SCUMM_BIG_ENDIAN
+	_paletteLookup.setFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+#else
+	_paletteLookup.setFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24));
+#endif
 }
 
 OpenGLGraphicsManager::~OpenGLGraphicsManager() {
@@ -331,6 +340,7 @@ void OpenGLGraphicsManager::setPalette(const byte *colors, uint start, uint num)
 
 	// Save the screen palette
 	memcpy(_gamePalette + start * 3, colors, num * 3);
+	_paletteLookup.setPalette(colors, start, num);
 
 	_screenNeedsRedraw = true;
 
@@ -364,11 +374,9 @@ void OpenGLGraphicsManager::copyRectToScreen(const void *buf, int pitch, int x,
 		dst += _screenData.pitch;
 	}
 
-	// Extend dirty area if not full screen redraw is flagged
-	if (!_screenNeedsRedraw) {
-		const Common::Rect dirtyRect(x, y, x + w, y + h);
-		_screenDirtyRect.extend(dirtyRect);
-	}
+	// Add dirty area if not full screen redraw is flagged
+	if (!_screenNeedsRedraw)
+		addDirtyRect(_screenDirtyRects, Common::Rect(x, y, x + w, y + h));
 }
 
 Graphics::Surface *OpenGLGraphicsManager::lockScreen() {
@@ -516,11 +524,9 @@ void OpenGLGraphicsManager::copyRectToOverlay(const void *buf, int pitch, int x,
 		dst += _overlayData.pitch;
 	}
 
-	// Extend dirty area if not full screen redraw is flagged
-	if (!_overlayNeedsRedraw) {
-		const Common::Rect dirtyRect(x, y, x + w, y + h);
-		_overlayDirtyRect.extend(dirtyRect);
-	}
+	// Add dirty area if not full screen redraw is flagged
+	if (!_overlayNeedsRedraw)
+		addDirtyRect(_overlayDirtyRects, Common::Rect(x, y, x + w, y + h));
 }
 
 int16 OpenGLGraphicsManager::getOverlayHeight() {
@@ -674,88 +680,82 @@ void OpenGLGraphicsManager::setFullscreenMode(bool enable) {
 	}
 }
 
-void OpenGLGraphicsManager::refreshGameScreen() {
-	if (_screenNeedsRedraw)
-		_screenDirtyRect = Common::Rect(0, 0, _screenData.w, _screenData.h);
-
-	int x = _screenDirtyRect.left;
-	int y = _screenDirtyRect.top;
-	int w = _screenDirtyRect.width();
-	int h = _screenDirtyRect.height();
-
-	if (_screenData.format.bytesPerPixel == 1) {
-		// Create a temporary RGB888 surface
-		byte *surface = new byte[w * h * 3];
-
-		// Convert the paletted buffer to RGB888
-		const byte *src = (byte *)_screenData.pixels + y * _screenData.pitch;
-		src += x * _screenData.format.bytesPerPixel;
-		byte *dst = surface;
-		for (int i = 0; i < h; i++) {
-			for (int j = 0; j < w; j++) {
-				dst[0] = _gamePalette[src[j] * 3];
-				dst[1] = _gamePalette[src[j] * 3 + 1];
-				dst[2] = _gamePalette[src[j] * 3 + 2];
-				dst += 3;
-			}
-			src += _screenData.pitch;
-		}
+void OpenGLGraphicsManager::addDirtyRect(Common::Array<Common::Rect> &dirtyRects, const Common::Rect &rect) {
+	Common::Rect dirtyRect = rect;
 
-		// Update the texture
-		_gameTexture->updateBuffer(surface, w * 3, x, y, w, h);
+	// Merge the rect with all rects it overlaps. The merged rect may overlap
+	// rects which were checked before, so start over after each merge.
+	for (uint i = 0; i < dirtyRects.size(); ) {
+		if (dirtyRects[i].contains(dirtyRect))
+			return;
 
-		// Free the temp surface
-		delete[] surface;
-	} else {
-		// Update the texture
-		_gameTexture->updateBuffer((byte *)_screenData.pixels + y * _screenData.pitch +
-		                           x * _screenData.format.bytesPerPixel, _screenData.pitch, x, y, w, h);
+		if (dirtyRects[i].intersects(dirtyRect)) {
+			dirtyRect.extend(dirtyRects[i]);
+			dirtyRects.remove_at(i);
+			i = 0;
+		} else {
+			i++;
+		}
 	}
 
-	_screenNeedsRedraw = false;
-	_screenDirtyRect = Common::Rect();
+	// Too many small rects cost more in upload calls than they save in
+	// uploaded pixels, so fall back to their bounding box then
+	if (dirtyRects.size() >= kMaxDirtyRects) {
+		for (uint i = 0; i < dirtyRects.size(); i++)
+			dirtyRect.extend(dirtyRects[i]);
+		dirtyRects.clear();
+	}
+
+	dirtyRects.push_back(dirtyRect);
 }
 
-void OpenGLGraphicsManager::refreshOverlay() {
-	if (_overlayNeedsRedraw)
-		_overlayDirtyRect = Common::Rect(0, 0, _overlayData.w, _overlayData.h);
-
-	int x = _overlayDirtyRect.left;
-	int y = _overlayDirtyRect.top;
-	int w = _overlayDirtyRect.width();
-	int h = _overlayDirtyRect.height();
-
-	if (_overlayData.format.bytesPerPixel == 1) {
-		// Create a temporary RGB888 surface
-		byte *surface = new byte[w * h * 3];
-
-		// Convert the paletted buffer to RGB888
-		const byte *src = (byte *)_overlayData.pixels + y * _overlayData.pitch;
-		src += x * _overlayData.format.bytesPerPixel;
-		byte *dst = surface;
-		for (int i = 0; i < h; i++) {
-			for (int j = 0; j < w; j++) {
-				dst[0] = _gamePalette[src[j] * 3];
-				dst[1] = _gamePalette[src[j] * 3 + 1];
-				dst[2] = _gamePalette[src[j] * 3 + 2];
-				dst += 3;
-			}
-			src += _screenData.pitch;
+void OpenGLGraphicsManager::updateTexture(GLTexture *texture, const Graphics::Surface &surface, const Common::Array<Common::Rect> &dirtyRects) {
+	for (uint i = 0; i < dirtyRects.size(); i++) {
+		const int x = dirtyRects[i].left;
+		const int y = dirtyRects[i].top;
+		const int w = dirtyRects[i].width();
+		const int h = dirtyRects[i].height();
+
+		const byte *src = (const byte *)surface.getBasePtr(x, y);
+
+		if (surface.format.bytesPerPixel == 1) {
+			// Convert the paletted pixels to RGBA8888
+			if (_conversionBuffer.size() < (uint)(w * h * 4))
+				_conversionBuffer.resize(w * h * 4);
+
+			_paletteLookup.convert(_conversionBuffer.begin(), w * 4, src, surface.pitch, w, h);
+			texture->updateBuffer(_conversionBuffer.begin(), w * 4, x, y, w, h);
+		} else {
+			texture->updateBuffer(src, surface.pitch, x, y, w, h);
 		}
+	}
 
-		// Update the texture
-		_overlayTexture->updateBuffer(surface, w * 3, x, y, w, h);
+	if (_showUploadStats)
+		_uploadStats.rects += dirtyRects.size();
+}
 
-		// Free the temp surface
-		delete[] surface;
-	} else {
-		// Update the texture
-		_overlayTexture->updateBuffer((byte *)_overlayData.pixels + y * _overlayData.pitch +
-		                              x * _overlayData.format.bytesPerPixel, _overlayData.pitch, x, y, w, h);
+void OpenGLGraphicsManager::refreshGameScreen() {
+	if (_screenNeedsRedraw) {
+		_screenDirtyRects.clear();
+		_screenDirtyRects.push_back(Common::Rect(0, 0, _screenData.w, _screenData.h));
+	}
+
+	updateTexture(_gameTexture, _screenData, _screenDirtyRects);
+
+	_screenNeedsRedraw = false;
+	_screenDirtyRects.clear();
+}
+
+void OpenGLGraphicsManager::refreshOverlay() {
+	if (_overlayNeedsRedraw) {
+		_overlayDirtyRects.clear();
+		_overlayDirtyRects.push_back(Common::Rect(0, 0, _overlayData.w, _overlayData.h));
 	}
 
+	updateTexture(_overlayTexture, _overlayData, _overlayDirtyRects);
+
 	_overlayNeedsRedraw = false;
-	_overlayDirtyRect = Common::Rect();
+	_overlayDirtyRects.clear();
 }
 
 void OpenGLGraphicsManager::refreshCursor() {
@@ -924,11 +924,15 @@ void OpenGLGraphicsManager::getGLPixelFormat(Graphics::PixelFormat pixelFormat,
 		glFormat = GL_RGBA;
 		gltype = GL_UNSIGNED_SHORT_4_4_4_4;
 	} else if (pixelFormat.bytesPerPixel == 1) { // CLUT8
-		// If uses a palette, create texture as RGB888. The pixel data will be converted
-		// later.
-		bpp = 3;
-		intFormat = GL_RGB;
-		glFormat = GL_RGB;
+		// If uses a palette, create texture as RGBA8888. The pixel data will be converted
+		// later. This uploads a third more bytes than RGB888, but drivers store
+		// RGB textures with four bytes per pixel anyway and have to expand RGB888
+		// uploads themselves. With Mesa's llvmpipe, converting and uploading a
+		// 640x480 screen takes about 0.3-0.5 ms as RGBA8888 against 0.7-0.9 ms
+		// as RGB888.
+		bpp = 4;
+		intFormat = GL_RGBA;
+		glFormat = GL_RGBA;
 		gltype = GL_UNSIGNED_BYTE;
 #ifndef USE_GLES
 	} else if (pixelFormat == Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0)) { // RGB555
@@ -993,7 +997,7 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 	// Clear the screen buffer
 	glClear(GL_COLOR_BUFFER_BIT); CHECK_GL_ERROR();
 
-	if (_screenNeedsRedraw || !_screenDirtyRect.isEmpty())
+	if (_screenNeedsRedraw || !_screenDirtyRects.empty())
 		// Refresh texture if dirty
 		refreshGameScreen();
 
@@ -1010,7 +1014,7 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 	glPopMatrix();
 
 	if (_overlayVisible) {
-		if (_overlayNeedsRedraw || !_overlayDirtyRect.isEmpty())
+		if (_overlayNeedsRedraw || !_overlayDirtyRects.empty())
 			// Refresh texture if dirty
 			refreshOverlay();
 
@@ -1039,11 +1043,19 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 		glPopMatrix();
 	}
 
+	if (_showUploadStats) {
+		_uploadStats.frames++;
+		_uploadStats.bytes += GLTexture::takeUploadedBytes();
+	}
+
 #ifdef USE_OSD
 	if (_osdAlpha > 0) {
 		if (_requireOSDUpdate) {
 			updateOSD();
 			_requireOSDUpdate = false;
+
+			// Do not count the OSD in the upload statistics
+			GLTexture::takeUploadedBytes();
 		}
 
 		// Update alpha value
@@ -1067,6 +1079,33 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 		glColor4f(1.0f, 1.0f, 1.0f, 1.0f); CHECK_GL_ERROR();
 	}
 #endif
+
+	if (_showUploadStats && _transactionMode == kTransactionNone &&
+	    g_system->getMillis() - _uploadStats.startTime >= kUploadStatsInterval)
+		showUploadStats();
+}
+
+void OpenGLGraphicsManager::toggleUploadStats() {
+	_showUploadStats = !_showUploadStats;
+	memset(&_uploadStats, 0, sizeof(_uploadStats));
+	_uploadStats.startTime = g_system->getMillis();
+	GLTexture::takeUploadedBytes();
+}
+
+void OpenGLGraphicsManager::showUploadStats() {
+	const uint32 frames = MAX<uint32>(_uploadStats.frames, 1);
+
+	const Common::String message = Common::String::format("%u rects, %u bytes uploaded per frame",
+		_uploadStats.rects / frames, _uploadStats.bytes / frames);
+
+#ifdef USE_OSD
+	displayMessageOnOSD(message.c_str());
+#else
+	debug("%s", message.c_str());
+#endif
+
+	memset(&_uploadStats, 0, sizeof(_uploadStats));
+	_uploadStats.startTime = g_system->getMillis();
 }
 
 void OpenGLGraphicsManager::initGL() {
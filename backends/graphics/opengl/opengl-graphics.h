@@ -28,6 +28,7 @@
 #include "common/array.h"
 #include "common/rect.h"
 #include "graphics/font.h"
+#include "graphics/palette_lookup.h"
 #include "graphics/pixelformat.h"
 
 // Uncomment this to enable the 'on screen display' code.
@@ -220,6 +221,45 @@ protected:
 	void setFormatIsBGR(bool isBGR) { _formatBGR = isBGR; }
 	bool _formatBGR;
 
+	//
+	// Texture updates
+	//
+	enum {
+		kMaxDirtyRects = 16,		/** < More dirty rects get merged into their bounding box */
+		kUploadStatsInterval = 1000	/** < Time between updates of the upload statistics (in milliseconds) */
+	};
+
+	/**
+	 * Add a rect to a list of dirty rects. Overlapping rects are merged, so
+	 * that no pixel is uploaded twice.
+	 */
+	void addDirtyRect(Common::Array<Common::Rect> &dirtyRects, const Common::Rect &rect);
+
+	/**
+	 * Upload the dirty rects of a surface to its texture. Paletted surfaces
+	 * are converted to RGBA8888 with the game palette on the way.
+	 */
+	void updateTexture(GLTexture *texture, const Graphics::Surface &surface, const Common::Array<Common::Rect> &dirtyRects);
+
+	// Expands paletted pixels with the game palette
+	Graphics::PaletteLookup _paletteLookup;
+
+	// Buffer for the conversion of paletted pixels, kept between updates
+	Common::Array<byte> _conversionBuffer;
+
+	// Statistics about texture updates, shown on the OSD every second if enabled
+	struct UploadStats {
+		uint32 startTime;
+		uint32 frames;
+		uint32 rects;
+		uint32 bytes;	///< bytes passed to OpenGL for all textures
+	};
+	bool _showUploadStats;
+	UploadStats _uploadStats;
+
+	void toggleUploadStats();
+	void showUploadStats();
+
 	//
 	// Game screen
 	//
@@ -227,7 +267,7 @@ protected:
 	Graphics::Surface _screenData;
 	int _screenChangeCount;
 	bool _screenNeedsRedraw;
-	Common::Rect _screenDirtyRect;
+	Common::Array<Common::Rect> _screenDirtyRects;
 
 #ifdef USE_RGB_COLOR
 	Graphics::PixelFormat _screenFormat;
@@ -247,7 +287,7 @@ protected:
 	Graphics::PixelFormat _overlayFormat;
 	bool _overlayVisible;
 	bool _overlayNeedsRedraw;
-	Common::Rect _overlayDirtyRect;
+	Common::Array<Common::Rect> _overlayDirtyRects;
 
 	virtual void refreshOverlay();
 
@@ -438,7 +438,7 @@ bool OpenGLSdlGraphicsManager::isHotkey(const Common::Event &event) {
 	if ((event.kbd.flags & (Common::KBD_CTRL|Common::KBD_ALT)) == (Common::KBD_CTRL|Common::KBD_ALT)) {
 		if (event.kbd.keycode == Common::KEYCODE_PLUS || event.kbd.keycode == Common::KEYCODE_MINUS ||
 			event.kbd.keycode == Common::KEYCODE_KP_PLUS || event.kbd.keycode == Common::KEYCODE_KP_MINUS ||
-			event.kbd.keycode == 'a' || event.kbd.keycode == 'f')
+			event.kbd.keycode == 'a' || event.kbd.keycode == 'f' || event.kbd.keycode == 'd')
 			return true;
 	} else if ((event.kbd.flags & (Common::KBD_CTRL|Common::KBD_SHIFT)) == (Common::KBD_CTRL|Common::KBD_SHIFT)) {
 		if (event.kbd.keycode == 'a' || event.kbd.keycode == 'f')
@@ -566,6 +566,12 @@ bool OpenGLSdlGraphicsManager::notifyEvent(const Common::Event &event) {
 				return true;
 			}
 
+			// Ctrl-Alt-d toggles the texture upload statistics
+			if (event.kbd.keycode == 'd') {
+				toggleUploadStats();
+				return true;
+			}
+
 			SDLKey sdlKey = (SDLKey)event.kbd.keycode;
 
 			// Ctrl+Alt+Plus/Minus Increase/decrease the scale factor
@@ -32,6 +32,7 @@
 #include "common/textconsole.h"
 #include "common/translation.h"
 #include "common/util.h"
+#include "common/workerpool.h"
 #ifdef USE_RGB_COLOR
 #include "common/list.h"
 #endif
@@ -84,7 +85,39 @@ static const int s_gfxModeSwitchTable[][4] = {
 	};
 
 #ifdef USE_SCALERS
-static int cursorStretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, int srcY, int origSrcY);
+static int cursorStretch200To240(uint8 *buf, uint32 pitch, int bytesPerPixel, int width, int height, int srcX, int srcY, int origSrcY);
+#endif
+
+static inline void writeCursorPixel(byte *dst, int bytesPerPixel, uint32 color) {
+	if (bytesPerPixel == 2)
+		*(uint16 *)dst = color;
+	else
+		*(uint32 *)dst = color;
+}
+
+#ifdef USE_RGB_COLOR
+/**
+ * Whether the scaler of a graphics mode can handle 32 bit pixels, so that
+ * 32 bit games do not have to be converted down to 16 bit.
+ */
+static bool isTrueColorGraphicsMode(int mode) {
+	switch (mode) {
+	case GFX_NORMAL:
+#ifdef USE_SCALERS
+	case GFX_DOUBLESIZE:
+	case GFX_TRIPLESIZE:
+	case GFX_ADVMAME2X:
+	case GFX_ADVMAME3X:
+#if defined(USE_HQ_SCALERS) && !defined(USE_NASM)
+	case GFX_HQ2X:
+	case GFX_HQ3X:
+#endif
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
 #endif
 
 AspectRatio::AspectRatio(int w, int h) {
@@ -134,6 +167,8 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_currentShakePos(0), _newShakePos(0),
 	_paletteDirtyStart(0), _paletteDirtyEnd(0),
 	_screenIsLocked(false),
+	_dirtyRects(NUM_DIRTY_RECT), _numDirtyRects(0),
+	_scalerThreads(false), _scalerPool(0), _showScalerStats(false),
 	_graphicsMutex(0),
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
@@ -158,6 +193,11 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 
 	_graphicsMutex = g_system->createMutex();
 
+	memset(&_scalerStats, 0, sizeof(_scalerStats));
+
+	if (ConfMan.hasKey("scaler_threads"))
+		_scalerThreads = ConfMan.getBool("scaler_threads");
+
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	if (ConfMan.hasKey("use_sdl_debug_focusrect"))
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
@@ -202,6 +242,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	if (_mouseOrigSurface)
 		SDL_FreeSurface(_mouseOrigSurface);
 	_mouseOrigSurface = 0;
+	delete _scalerPool;
 	g_system->deleteMutex(_graphicsMutex);
 
 	free(_currentPalette);
@@ -546,6 +587,12 @@ bool SurfaceSdlGraphicsManager::setGraphicsMode(int mode) {
 	_transactionDetails.normal1xScaler = (mode == GFX_NORMAL);
 	if (_oldVideoMode.setup && _oldVideoMode.scaleFactor != newScaleFactor)
 		_transactionDetails.needHotswap = true;
+#ifdef USE_RGB_COLOR
+	// The depth of the hardware screen depends on the scaler for 32 bit games
+	if (_oldVideoMode.setup && _screenFormat.bytesPerPixel == 4 &&
+	    isTrueColorGraphicsMode(_oldVideoMode.mode) != isTrueColorGraphicsMode(mode))
+		_transactionDetails.needHotswap = true;
+#endif
 
 	_transactionDetails.needUpdatescreen = true;
 
@@ -765,9 +812,25 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 		fixupResolutionForAspectRatio(_videoMode.desiredAspectRatio, _videoMode.hardwareWidth, _videoMode.hardwareHeight);
 	}
 
-	_hwscreen = SDL_SetVideoMode(_videoMode.hardwareWidth, _videoMode.hardwareHeight, 16,
+	// Use a 32 bit screen for 32 bit games if the scaler can handle it,
+	// instead of converting their graphics down to 16 bit
+	int hwDepth = 16;
+#ifdef USE_RGB_COLOR
+	if (_screenFormat.bytesPerPixel == 4 && isTrueColorGraphicsMode(_videoMode.mode))
+		hwDepth = 32;
+#endif
+
+	_hwscreen = SDL_SetVideoMode(_videoMode.hardwareWidth, _videoMode.hardwareHeight, hwDepth,
 		_videoMode.fullscreen ? (SDL_FULLSCREEN|SDL_SWSURFACE) : SDL_SWSURFACE
 	);
+
+	// The 32 bit scalers need green in the second byte
+	if (_hwscreen && _hwscreen->format->BytesPerPixel != 2 &&
+	    (_hwscreen->format->BytesPerPixel != 4 || _hwscreen->format->Gmask != 0x0000FF00)) {
+		_hwscreen = SDL_SetVideoMode(_videoMode.hardwareWidth, _videoMode.hardwareHeight, 16,
+			_videoMode.fullscreen ? (SDL_FULLSCREEN|SDL_SWSURFACE) : SDL_SWSURFACE
+		);
+	}
 #ifdef USE_RGB_COLOR
 	detectSupportedFormats();
 #endif
@@ -785,12 +848,13 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	}
 
 	//
-	// Create the surface used for the graphics in 16 bit before scaling, and also the overlay
+	// Create the surface used for the graphics in the depth of the hardware
+	// screen before scaling, and also the overlay
 	//
 
 	// Need some extra bytes around when using 2xSaI
 	_tmpscreen = SDL_CreateRGBSurface(SDL_SWSURFACE, _videoMode.screenWidth + 3, _videoMode.screenHeight + 3,
-						16,
+						_hwscreen->format->BitsPerPixel,
 						_hwscreen->format->Rmask,
 						_hwscreen->format->Gmask,
 						_hwscreen->format->Bmask,
@@ -799,12 +863,24 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	if (_tmpscreen == NULL)
 		error("allocating _tmpscreen failed");
 
-	_overlayscreen = SDL_CreateRGBSurface(SDL_SWSURFACE, _videoMode.overlayWidth, _videoMode.overlayHeight,
-						16,
-						_hwscreen->format->Rmask,
-						_hwscreen->format->Gmask,
-						_hwscreen->format->Bmask,
-						_hwscreen->format->Amask);
+	_paletteLookup.setFormat(Graphics::PixelFormat(_tmpscreen->format->BytesPerPixel,
+		8 - _tmpscreen->format->Rloss, 8 - _tmpscreen->format->Gloss,
+		8 - _tmpscreen->format->Bloss, 8 - _tmpscreen->format->Aloss,
+		_tmpscreen->format->Rshift, _tmpscreen->format->Gshift,
+		_tmpscreen->format->Bshift, _tmpscreen->format->Ashift));
+
+	// The overlay always is 16 bit, the GUI does not handle other depths
+	if (_hwscreen->format->BytesPerPixel == 2) {
+		_overlayscreen = SDL_CreateRGBSurface(SDL_SWSURFACE, _videoMode.overlayWidth, _videoMode.overlayHeight,
+							16,
+							_hwscreen->format->Rmask,
+							_hwscreen->format->Gmask,
+							_hwscreen->format->Bmask,
+							_hwscreen->format->Amask);
+	} else {
+		_overlayscreen = SDL_CreateRGBSurface(SDL_SWSURFACE, _videoMode.overlayWidth, _videoMode.overlayHeight,
+							16, 0xF800, 0x07E0, 0x001F, 0);
+	}
 
 	if (_overlayscreen == NULL)
 		error("allocating _overlayscreen failed");
@@ -822,7 +898,7 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	_overlayFormat.aShift = _overlayscreen->format->Ashift;
 
 	_tmpscreen2 = SDL_CreateRGBSurface(SDL_SWSURFACE, _videoMode.overlayWidth + 3, _videoMode.overlayHeight + 3,
-						16,
+						_hwscreen->format->BitsPerPixel,
 						_hwscreen->format->Rmask,
 						_hwscreen->format->Gmask,
 						_hwscreen->format->Bmask,
@@ -835,7 +911,7 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	_osdSurface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_RLEACCEL | SDL_SRCCOLORKEY | SDL_SRCALPHA,
 						_hwscreen->w,
 						_hwscreen->h,
-						16,
+						_hwscreen->format->BitsPerPixel,
 						_hwscreen->format->Rmask,
 						_hwscreen->format->Gmask,
 						_hwscreen->format->Bmask,
@@ -849,8 +925,10 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 		_videoMode.screenWidth * _videoMode.scaleFactor - 1,
 		effectiveScreenHeight() - 1);
 
-	// Distinguish 555 and 565 mode
-	if (_hwscreen->format->Rmask == 0x7C00)
+	// Distinguish 8888, 555 and 565 mode
+	if (_hwscreen->format->BytesPerPixel == 4)
+		InitScalers(8888);
+	else if (_hwscreen->format->Rmask == 0x7C00)
 		InitScalers(555);
 	else
 		InitScalers(565);
@@ -1050,13 +1128,29 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		uint32 srcPitch, dstPitch;
 		SDL_Rect *lastRect = _dirtyRectList + _numDirtyRects;
 
-		for (r = _dirtyRectList; r != lastRect; ++r) {
-			dst = *r;
-			dst.x++;	// Shift rect by one since 2xSai needs to access the data around
-			dst.y++;	// any pixel to scale it, and we want to avoid mem access crashes.
+		if (origSurf->format->BytesPerPixel == 1) {
+			// Expand paletted pixels ourselves, which is a lot faster than
+			// the palette lookup of SDL_BlitSurface
+			SDL_LockSurface(origSurf);
+			SDL_LockSurface(srcSurf);
+
+			// Shift rects by one since 2xSai needs to access the data around
+			// any pixel to scale it, and we want to avoid mem access crashes.
+			for (r = _dirtyRectList; r != lastRect; ++r)
+				_paletteLookup.convert((byte *)srcSurf->pixels + (r->y + 1) * srcSurf->pitch + (r->x + 1) * srcSurf->format->BytesPerPixel,
+					srcSurf->pitch, (const byte *)origSurf->pixels + r->y * origSurf->pitch + r->x, origSurf->pitch, r->w, r->h);
 
-			if (SDL_BlitSurface(origSurf, r, srcSurf, &dst) != 0)
-				error("SDL_BlitSurface failed: %s", SDL_GetError());
+			SDL_UnlockSurface(srcSurf);
+			SDL_UnlockSurface(origSurf);
+		} else {
+			for (r = _dirtyRectList; r != lastRect; ++r) {
+				dst = *r;
+				dst.x++;	// Shift rect by one since 2xSai needs to access the data around
+				dst.y++;	// any pixel to scale it, and we want to avoid mem access crashes.
+
+				if (SDL_BlitSurface(origSurf, r, srcSurf, &dst) != 0)
+					error("SDL_BlitSurface failed: %s", SDL_GetError());
+			}
 		}
 
 		SDL_LockSurface(srcSurf);
@@ -1065,6 +1159,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		const uint32 scalerStartTime = _showScalerStats ? SDL_GetTicks() : 0;
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1083,8 +1179,13 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				scaleRect(scalerProc, (byte *)srcSurf->pixels + (r->x + 1) * srcSurf->format->BytesPerPixel + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * _hwscreen->format->BytesPerPixel + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
+
+				if (_showScalerStats) {
+					_scalerStats.rects++;
+					_scalerStats.pixels += r->w * dst_h;
+				}
 			}
 
 			r->x = rx1;
@@ -1100,6 +1201,11 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
+		if (_showScalerStats) {
+			_scalerStats.frames++;
+			_scalerStats.scalerTime += SDL_GetTicks() - scalerStartTime;
+		}
+
 		// Readjust the dirty rect list in case we are doing a full update.
 		// This is necessary if shaking is active.
 		if (_forceFull) {
@@ -1191,9 +1297,81 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
-	_numDirtyRects = 0;
+	clearDirtyRects();
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
+
+	// The screen may also be updated while switching modes
+	if (_showScalerStats && _transactionMode == kTransactionNone &&
+		SDL_GetTicks() - _scalerStats.startTime >= kScalerStatsInterval)
+		showScalerStats();
+}
+
+void SurfaceSdlGraphicsManager::scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale) {
+	bool useThreads = _scalerThreads && scale > 1 && width * height >= kMinThreadedScalerPixels;
+
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+	// The assembler versions of the HQ scalers keep their state in globals
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		useThreads = false;
+#endif
+
+	if (useThreads && !_scalerPool)
+		_scalerPool = new Common::WorkerPool();
+
+	const int bandCount = useThreads ? MIN<int>(_scalerPool->getThreadCount() + 1, height / kMinScalerBandHeight) : 1;
+	if (bandCount <= 1) {
+		scalerProc(src, srcPitch, dst, dstPitch, width, height);
+		return;
+	}
+
+	// Bands start on even rows, so that the pattern of DotMatrix stays the same
+	const int bandHeight = ((height + bandCount - 1) / bandCount + 1) & ~1;
+
+	_scalerJobs.resize(bandCount);
+	int bands = 0;
+
+	for (int y = 0; y < height; y += bandHeight) {
+		ScalerJob &job = _scalerJobs[bands++];
+		job.scalerProc = scalerProc;
+		job.src = src + y * srcPitch;
+		job.srcPitch = srcPitch;
+		job.dst = dst + y * scale * dstPitch;
+		job.dstPitch = dstPitch;
+		job.width = width;
+		job.height = MIN(bandHeight, height - y);
+	}
+
+	// The last band is scaled by this thread, while waiting for the others
+	for (int i = 0; i < bands - 1; i++)
+		_scalerPool->addJob(&runScalerJob, &_scalerJobs[i]);
+
+	runScalerJob(&_scalerJobs[bands - 1]);
+	_scalerPool->wait();
+}
+
+void SurfaceSdlGraphicsManager::runScalerJob(void *job) {
+	const ScalerJob *j = (const ScalerJob *)job;
+	j->scalerProc(j->src, j->srcPitch, j->dst, j->dstPitch, j->width, j->height);
+}
+
+void SurfaceSdlGraphicsManager::showScalerStats() {
+	const uint32 frames = MAX<uint32>(_scalerStats.frames, 1);
+
+	char buffer[128];
+	sprintf(buffer, "%u rects, %u pixels scaled per frame\n%u.%02u ms per frame in scaler, %u threads",
+		_scalerStats.rects / frames, _scalerStats.pixels / frames,
+		_scalerStats.scalerTime / frames, _scalerStats.scalerTime * 100 / frames % 100,
+		_scalerPool ? _scalerPool->getThreadCount() + 1 : 1);
+
+#ifdef USE_OSD
+	displayMessageOnOSD(buffer);
+#else
+	debug("%s", buffer);
+#endif
+
+	memset(&_scalerStats, 0, sizeof(_scalerStats));
+	_scalerStats.startTime = SDL_GetTicks();
 }
 
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
@@ -1334,11 +1512,6 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceFull = true;
-		return;
-	}
-
 	int height, width;
 
 	if (!_overlayVisible && !realCoordinates) {
@@ -1389,15 +1562,24 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	}
 
 	if (w > 0 && h > 0) {
-		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
-
-		r->x = x;
-		r->y = y;
-		r->w = w;
-		r->h = h;
+		_dirtyRects.addMerging(Common::Rect(x, y, x + w, y + h));
+
+		_numDirtyRects = _dirtyRects.size();
+		for (int i = 0; i < _numDirtyRects; ++i) {
+			const Common::Rect &r = _dirtyRects[i];
+			_dirtyRectList[i].x = r.left;
+			_dirtyRectList[i].y = r.top;
+			_dirtyRectList[i].w = r.width();
+			_dirtyRectList[i].h = r.height();
+		}
 	}
 }
 
+void SurfaceSdlGraphicsManager::clearDirtyRects() {
+	_dirtyRects.clear();
+	_numDirtyRects = 0;
+}
+
 int16 SurfaceSdlGraphicsManager::getHeight() {
 	return _videoMode.screenHeight;
 }
@@ -1435,6 +1617,8 @@ void SurfaceSdlGraphicsManager::setPalette(const byte *colors, uint start, uint
 	if (start + num > _paletteDirtyEnd)
 		_paletteDirtyEnd = start + num;
 
+	_paletteLookup.setPalette(colors, start, num);
+
 	// Some games blink cursors with palette
 	if (_cursorPaletteDisabled)
 		blitCursor();
@@ -1581,18 +1765,32 @@ void SurfaceSdlGraphicsManager::clearOverlay() {
 	if (SDL_BlitSurface(_screen, &src, _tmpscreen, &dst) != 0)
 		error("SDL_BlitSurface failed: %s", SDL_GetError());
 
+	// The scalers can only write pixels of the depth of the hardware screen,
+	// so a 32 bit screen is scaled into _tmpscreen2 and converted from there.
+	SDL_Surface *scaled = _overlayscreen;
+	if (_tmpscreen->format->BytesPerPixel != _overlayscreen->format->BytesPerPixel)
+		scaled = _tmpscreen2;
+
 	SDL_LockSurface(_tmpscreen);
-	SDL_LockSurface(_overlayscreen);
-	_scalerProc((byte *)(_tmpscreen->pixels) + _tmpscreen->pitch + 2, _tmpscreen->pitch,
-	(byte *)_overlayscreen->pixels, _overlayscreen->pitch, _videoMode.screenWidth, _videoMode.screenHeight);
+	SDL_LockSurface(scaled);
+	_scalerProc((byte *)(_tmpscreen->pixels) + _tmpscreen->pitch + _tmpscreen->format->BytesPerPixel, _tmpscreen->pitch,
+	(byte *)scaled->pixels, scaled->pitch, _videoMode.screenWidth, _videoMode.screenHeight);
 
 #ifdef USE_SCALERS
 	if (_videoMode.aspectRatioCorrection)
-		stretch200To240((uint8 *)_overlayscreen->pixels, _overlayscreen->pitch,
+		stretch200To240((uint8 *)scaled->pixels, scaled->pitch,
 						_videoMode.overlayWidth, _videoMode.screenHeight * _videoMode.scaleFactor, 0, 0, 0);
 #endif
 	SDL_UnlockSurface(_tmpscreen);
-	SDL_UnlockSurface(_overlayscreen);
+	SDL_UnlockSurface(scaled);
+
+	if (scaled != _overlayscreen) {
+		src.w = dst.w = _videoMode.overlayWidth;
+		src.h = dst.h = _videoMode.overlayHeight;
+		src.x = src.y = dst.x = dst.y = 0;
+		if (SDL_BlitSurface(scaled, &src, _overlayscreen, &dst) != 0)
+			error("SDL_BlitSurface failed: %s", SDL_GetError());
+	}
 
 	_forceFull = true;
 }
@@ -1753,7 +1951,7 @@ void SurfaceSdlGraphicsManager::setMouseCursor(const void *buf, uint w, uint h,
 		_mouseOrigSurface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_RLEACCEL | SDL_SRCCOLORKEY | SDL_SRCALPHA,
 						_mouseCurState.w + 2,
 						_mouseCurState.h + 2,
-						16,
+						_hwscreen->format->BitsPerPixel,
 						_hwscreen->format->Rmask,
 						_hwscreen->format->Gmask,
 						_hwscreen->format->Bmask,
@@ -1789,6 +1987,8 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 	if (!_mouseOrigSurface || !_mouseData)
 		return;
 
+	const int bpp = _mouseOrigSurface->format->BytesPerPixel;
+
 	_mouseNeedsRedraw = true;
 
 	w = _mouseCurState.w;
@@ -1800,13 +2000,13 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 	for (i = 0; i < h + 2; i++) {
 		dstPtr = (byte *)_mouseOrigSurface->pixels + _mouseOrigSurface->pitch * i;
 		for (j = 0; j < w + 2; j++) {
-			*(uint16 *)dstPtr = kMouseColorKey;
-			dstPtr += 2;
+			writeCursorPixel(dstPtr, bpp, kMouseColorKey);
+			dstPtr += bpp;
 		}
 	}
 
 	// Draw from [1,1] since AdvMame2x adds artefact at 0,0
-	dstPtr = (byte *)_mouseOrigSurface->pixels + _mouseOrigSurface->pitch + 2;
+	dstPtr = (byte *)_mouseOrigSurface->pixels + _mouseOrigSurface->pitch + bpp;
 
 	SDL_Color *palette;
 
@@ -1826,25 +2026,25 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 				if (color != _mouseKeyColor) {	// transparent, don't draw
 					uint8 r, g, b;
 					_cursorFormat.colorToRGB(color, r, g, b);
-					*(uint16 *)dstPtr = SDL_MapRGB(_mouseOrigSurface->format,
-						r, g, b);
+					writeCursorPixel(dstPtr, bpp, SDL_MapRGB(_mouseOrigSurface->format,
+						r, g, b));
 				}
-				dstPtr += 2;
+				dstPtr += bpp;
 				srcPtr += _cursorFormat.bytesPerPixel;
 			} else {
 #endif
 				color = *srcPtr;
 				if (color != _mouseKeyColor) {	// transparent, don't draw
-					*(uint16 *)dstPtr = SDL_MapRGB(_mouseOrigSurface->format,
-						palette[color].r, palette[color].g, palette[color].b);
+					writeCursorPixel(dstPtr, bpp, SDL_MapRGB(_mouseOrigSurface->format,
+						palette[color].r, palette[color].g, palette[color].b));
 				}
-				dstPtr += 2;
+				dstPtr += bpp;
 				srcPtr++;
 #ifdef USE_RGB_COLOR
 			}
 #endif
 		}
-		dstPtr += _mouseOrigSurface->pitch - w * 2;
+		dstPtr += _mouseOrigSurface->pitch - w * bpp;
 	}
 
 	int rW, rH;
@@ -1890,7 +2090,7 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 		_mouseSurface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_RLEACCEL | SDL_SRCCOLORKEY | SDL_SRCALPHA,
 						_mouseCurState.rW,
 						_mouseCurState.rH,
-						16,
+						_hwscreen->format->BitsPerPixel,
 						_hwscreen->format->Rmask,
 						_hwscreen->format->Gmask,
 						_hwscreen->format->Bmask,
@@ -1919,13 +2119,13 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 		scalerProc = Normal1x;
 	}
 
-	scalerProc((byte *)_mouseOrigSurface->pixels + _mouseOrigSurface->pitch + 2,
+	scalerProc((byte *)_mouseOrigSurface->pixels + _mouseOrigSurface->pitch + bpp,
 		_mouseOrigSurface->pitch, (byte *)_mouseSurface->pixels, _mouseSurface->pitch,
 		_mouseCurState.w, _mouseCurState.h);
 
 #ifdef USE_SCALERS
 	if (!_cursorDontScale && _videoMode.aspectRatioCorrection)
-		cursorStretch200To240((uint8 *)_mouseSurface->pixels, _mouseSurface->pitch, rW, rH1, 0, 0, 0);
+		cursorStretch200To240((uint8 *)_mouseSurface->pixels, _mouseSurface->pitch, bpp, rW, rH1, 0, 0, 0);
 #endif
 
 	SDL_UnlockSurface(_mouseSurface);
@@ -1935,18 +2135,18 @@ void SurfaceSdlGraphicsManager::blitCursor() {
 #ifdef USE_SCALERS
 // Basically it is kVeryFastAndUglyAspectMode of stretch200To240 from
 // common/scale/aspect.cpp
-static int cursorStretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, int srcY, int origSrcY) {
+static int cursorStretch200To240(uint8 *buf, uint32 pitch, int bytesPerPixel, int width, int height, int srcX, int srcY, int origSrcY) {
 	int maxDstY = real2Aspect(origSrcY + height - 1);
 	int y;
-	const uint8 *startSrcPtr = buf + srcX * 2 + (srcY - origSrcY) * pitch;
-	uint8 *dstPtr = buf + srcX * 2 + maxDstY * pitch;
+	const uint8 *startSrcPtr = buf + srcX * bytesPerPixel + (srcY - origSrcY) * pitch;
+	uint8 *dstPtr = buf + srcX * bytesPerPixel + maxDstY * pitch;
 
 	for (y = maxDstY; y >= srcY; y--) {
 		const uint8 *srcPtr = startSrcPtr + aspect2Real(y) * pitch;
 
 		if (srcPtr == dstPtr)
 			break;
-		memcpy(dstPtr, srcPtr, width * 2);
+		memcpy(dstPtr, srcPtr, width * bytesPerPixel);
 		dstPtr -= pitch;
 	}
 
@@ -2148,6 +2348,14 @@ bool SurfaceSdlGraphicsManager::handleScalerHotkeys(Common::KeyCode key) {
 		return true;
 	}
 
+	// Ctrl-Alt-d toggles the scaler statistics
+	if (key == 'd') {
+		_showScalerStats = !_showScalerStats;
+		memset(&_scalerStats, 0, sizeof(_scalerStats));
+		_scalerStats.startTime = SDL_GetTicks();
+		return true;
+	}
+
 	int newMode = -1;
 	int factor = _videoMode.scaleFactor - 1;
 	SDLKey sdlKey = (SDLKey)key;
@@ -2222,7 +2430,7 @@ bool SurfaceSdlGraphicsManager::isScalerHotkey(const Common::Event &event) {
 			if (keyValue >= ARRAYSIZE(s_gfxModeSwitchTable))
 				return false;
 		}
-		return (isScaleKey || event.kbd.keycode == 'a');
+		return (isScaleKey || event.kbd.keycode == 'a' || event.kbd.keycode == 'd');
 	}
 	return false;
 }
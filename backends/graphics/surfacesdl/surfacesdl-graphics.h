@@ -25,8 +25,11 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyrects.h"
+#include "graphics/palette_lookup.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/array.h"
 #include "common/events.h"
 #include "common/system.h"
 
@@ -44,6 +47,10 @@
 #define USE_OSD	1
 #endif
 
+namespace Common {
+class WorkerPool;
+}
+
 enum {
 	GFX_NORMAL = 0,
 	GFX_DOUBLESIZE = 1,
@@ -239,13 +246,43 @@ protected:
 
 	enum {
 		NUM_DIRTY_RECT = 100,
-		MAX_SCALING = 3
+		MAX_SCALING = 3,
+		kMinThreadedScalerPixels = 128 * 128,	/** < Smallest rect scaled by several threads, in source pixels */
+		kMinScalerBandHeight = 16,		/** < Smallest number of rows scaled by a single thread */
+		kScalerStatsInterval = 1000		/** < Time between updates of the scaler statistics (in milliseconds) */
 	};
 
-	// Dirty rect management
+	// Dirty rect management. The rects in the list never overlap.
+	Graphics::DirtyRectList _dirtyRects;
+	// A copy of _dirtyRects, for SDL_UpdateRects()
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	// Scaling large dirty rects in several threads, if enabled
+	bool _scalerThreads;
+	Common::WorkerPool *_scalerPool;
+
+	struct ScalerJob {
+		ScalerProc *scalerProc;
+		const byte *src;
+		uint32 srcPitch;
+		byte *dst;
+		uint32 dstPitch;
+		int width, height;
+	};
+	Common::Array<ScalerJob> _scalerJobs;
+
+	// Statistics about scaling, shown on the OSD every second if enabled
+	struct ScalerStats {
+		uint32 startTime;
+		uint32 frames;
+		uint32 rects;
+		uint32 pixels;		///< source pixels scaled
+		uint32 scalerTime;	///< time spent scaling, in milliseconds
+	};
+	bool _showScalerStats;
+	ScalerStats _scalerStats;
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -297,6 +334,9 @@ protected:
 	SDL_Color *_currentPalette;
 	uint _paletteDirtyStart, _paletteDirtyEnd;
 
+	// Expands the paletted game screen to the format of _tmpscreen
+	Graphics::PaletteLookup _paletteLookup;
+
 	// Cursor palette data
 	SDL_Color *_cursorPalette;
 
@@ -314,6 +354,17 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/** Empty the dirty rect list, once the rects have been drawn. */
+	void clearDirtyRects();
+
+	/**
+	 * Scale a rect, splitting it into bands of rows for the worker threads
+	 * if it is large enough.
+	 */
+	void scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale);
+	static void runScalerJob(void *job);
+	void showScalerStats();
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
@@ -79,6 +79,15 @@ bool OSystem_POSIX::hasFeature(Feature f) {
 	return OSystem_SDL::hasFeature(f);
 }
 
+uint OSystem_POSIX::getCPUCount() {
+#ifdef _SC_NPROCESSORS_ONLN
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (count > 1)
+		return count;
+#endif
+	return 1;
+}
+
 Common::String OSystem_POSIX::getDefaultConfigFileName() {
 	char configFile[MAXPATHLEN];
 
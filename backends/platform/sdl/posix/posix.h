@@ -35,6 +35,8 @@ public:
 
 	virtual bool displayLogFile();
 
+	virtual uint getCPUCount();
+
 	virtual void init();
 	virtual void initBackend();
 
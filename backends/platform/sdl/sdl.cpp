@@ -32,6 +32,7 @@
 #include "common/config-manager.h"
 #include "common/EventRecorder.h"
 #include "common/taskbar.h"
+#include "common/slaballocator.h"
 #include "common/textconsole.h"
 
 #include "backends/saves/default/default-saves.h"
@@ -477,6 +478,57 @@ void OSystem_SDL::delayMillis(uint msecs) {
 		SDL_Delay(msecs);
 }
 
+namespace {
+
+struct ThreadStart {
+	OSystem::ThreadProc proc;
+	void *param;
+};
+
+int runThread(void *data) {
+	ThreadStart start = *(ThreadStart *)data;
+	delete (ThreadStart *)data;
+
+	start.proc(start.param);
+
+	Common::SlabAllocator::releaseThreadCaches();
+	return 0;
+}
+
+} // End of anonymous namespace
+
+OSystem::ThreadRef OSystem_SDL::createThread(ThreadProc proc, void *param) {
+	ThreadStart *start = new ThreadStart;
+	start->proc = proc;
+	start->param = param;
+
+	SDL_Thread *thread = SDL_CreateThread(runThread, start);
+	if (!thread)
+		delete start;
+
+	return (ThreadRef)thread;
+}
+
+void OSystem_SDL::waitThread(ThreadRef thread) {
+	SDL_WaitThread((SDL_Thread *)thread, 0);
+}
+
+OSystem::SemaphoreRef OSystem_SDL::createSemaphore(uint value) {
+	return (SemaphoreRef)SDL_CreateSemaphore(value);
+}
+
+void OSystem_SDL::postSemaphore(SemaphoreRef semaphore) {
+	SDL_SemPost((SDL_sem *)semaphore);
+}
+
+void OSystem_SDL::waitSemaphore(SemaphoreRef semaphore) {
+	SDL_SemWait((SDL_sem *)semaphore);
+}
+
+void OSystem_SDL::deleteSemaphore(SemaphoreRef semaphore) {
+	SDL_DestroySemaphore((SDL_sem *)semaphore);
+}
+
 void OSystem_SDL::getTimeAndDate(TimeDate &td) const {
 	time_t curTime = time(0);
 	struct tm t = *localtime(&curTime);
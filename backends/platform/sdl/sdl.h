@@ -70,6 +70,12 @@ public:
 	virtual void addSysArchivesToSearchSet(Common::SearchSet &s, int priority = 0);
 	virtual uint32 getMillis();
 	virtual void delayMillis(uint msecs);
+	virtual ThreadRef createThread(ThreadProc proc, void *param);
+	virtual void waitThread(ThreadRef thread);
+	virtual SemaphoreRef createSemaphore(uint value);
+	virtual void postSemaphore(SemaphoreRef semaphore);
+	virtual void waitSemaphore(SemaphoreRef semaphore);
+	virtual void deleteSemaphore(SemaphoreRef semaphore);
 	virtual void getTimeAndDate(TimeDate &td) const;
 	virtual Audio::Mixer *getMixer();
 
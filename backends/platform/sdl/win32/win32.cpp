@@ -91,6 +91,13 @@ bool OSystem_Win32::hasFeature(Feature f) {
 	return OSystem_SDL::hasFeature(f);
 }
 
+uint OSystem_Win32::getCPUCount() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	return (info.dwNumberOfProcessors > 1) ? info.dwNumberOfProcessors : 1;
+}
+
 bool OSystem_Win32::displayLogFile() {
 	if (_logFilePath.empty())
 		return false;
@@ -36,6 +36,8 @@ public:
 
 	virtual bool displayLogFile();
 
+	virtual uint getCPUCount();
+
 protected:
 	/**
 	 * The path of the currently open log file, if any.
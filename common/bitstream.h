@@ -28,6 +28,9 @@
 #include "common/scummsys.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/memstream.h"
+#include "common/endian.h"
+#include "common/util.h"
 
 namespace Common {
 
@@ -67,6 +70,12 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/**
+	 * Are multi-bit values read with the first bit as their most
+	 * significant one (MSB2LSB), instead of as the least significant one?
+	 */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -81,67 +90,138 @@ protected:
  * For example, a bit stream with the layout parameters 32, true, false
  * for valueBits, isLE and isMSB2LSB, reads 32bit little-endian values
  * from the data stream and hands out the bits in the order of LSB to MSB.
+ *
+ * Internally, as many whole values as fit are kept in a 64 bit buffer, so
+ * that reading, peeking and skipping several bits at once takes about as
+ * long as doing so for a single bit. When created on a MemoryReadStream,
+ * the values are taken straight from its memory, without going through
+ * the stream at all. Otherwise, the data stream may be read up to 8 bytes
+ * ahead of the bit stream's position.
  */
 template<int valueBits, bool isLE, bool isMSB2LSB>
 class BitStreamImpl : public BitStream {
 private:
+	enum {
+		kValueBytes = valueBits / 8
+	};
+
 	SeekableReadStream *_stream; ///< The input stream.
 	bool _disposeAfterUse;       ///< Should we delete the stream on destruction?
 
-	uint32 _value;   ///< Current value.
-	uint8  _inValue; ///< Position within the current value.
-
-	/** Read a data value. */
-	inline uint32 readData() {
-		if (isLE) {
-			if (valueBits ==  8)
-				return _stream->readByte();
-			if (valueBits == 16)
-				return _stream->readUint16LE();
-			if (valueBits == 32)
-				return _stream->readUint32LE();
+	const byte *_data;  ///< The stream's memory, if it's a MemoryReadStream.
+	uint32 _dataPos;    ///< Byte position of the next value to be buffered.
+	uint32 _dataSize;   ///< Number of bytes that make up whole values.
+
+	/**
+	 * Buffered bits. With MSB2LSB, the next bit is the most significant
+	 * one, otherwise the least significant one.
+	 */
+	uint64 _buffer;
+	uint8  _bufferBits; ///< Number of bits in the buffer.
+
+	void init(SeekableReadStream *stream, const byte *data) {
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
+			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+
+		_stream = stream;
+		_data = data;
+		_dataSize = stream->size() & ~((uint32) (kValueBytes - 1));
+		_dataPos = stream->pos();
+		_buffer = 0;
+		_bufferBits = 0;
+	}
+
+	/** Decode a data value. */
+	static inline uint32 readData(const byte *data) {
+		if (valueBits == 8)
+			return *data;
+		if (isLE)
+			return (valueBits == 16) ? READ_LE_UINT16(data) : READ_LE_UINT32(data);
+		else
+			return (valueBits == 16) ? READ_BE_UINT16(data) : READ_BE_UINT32(data);
+	}
+
+	/** Add a data value to the buffer, which needs to have room for it. */
+	inline void addValue(uint32 value) {
+		if (isMSB2LSB)
+			_buffer |= ((uint64) value) << (64 - valueBits - _bufferBits);
+		else
+			_buffer |= ((uint64) value) << _bufferBits;
+
+		_bufferBits += valueBits;
+	}
+
+	/** Add as many data values to the buffer as fit in. */
+	void refill() {
+		uint32 count = MIN<uint32>((64 - _bufferBits) / valueBits, (_dataSize - _dataPos) / kValueBytes);
+		if (count == 0)
+			return;
+
+		if (_data) {
+			for (uint32 i = 0; i < count; i++)
+				addValue(readData(_data + _dataPos + i * kValueBytes));
 		} else {
-			if (valueBits ==  8)
-				return _stream->readByte();
-			if (valueBits == 16)
-				return _stream->readUint16BE();
-			if (valueBits == 32)
-				return _stream->readUint32BE();
+			byte values[8];
+			if (_stream->read(values, count * kValueBytes) != count * kValueBytes || _stream->err())
+				error("BitStreamImpl::refill(): Read error");
+
+			for (uint32 i = 0; i < count; i++)
+				addValue(readData(values + i * kValueBytes));
 		}
 
-		assert(false);
-		return 0;
+		_dataPos += count * kValueBytes;
 	}
 
-	/** Read the next data value. */
-	inline void readValue() {
-		if ((size() - pos()) < valueBits)
-			error("BitStreamImpl::readValue(): End of bit stream reached");
+	/** Make sure the buffer contains at least n bits. */
+	inline void ensureBits(uint8 n) {
+		if (_bufferBits >= n)
+			return;
 
-		_value = readData();
-		if (_stream->err() || _stream->eos())
-			error("BitStreamImpl::readValue(): Read error");
+		refill();
+		if (_bufferBits < n)
+			error("BitStreamImpl::refill(): End of bit stream reached");
+	}
 
-		// If we're reading the bits MSB first, we need to shift the value to that position
+	/** Return the next n bits of the buffer, which need to be there. */
+	inline uint32 peekBuffer(uint8 n) const {
 		if (isMSB2LSB)
-			_value <<= 32 - valueBits;
-		}
+			return (uint32) (_buffer >> (64 - n));
+		else
+			return (uint32) (_buffer & ((((uint64) 1) << n) - 1));
+	}
+
+	/** Remove n bits from the buffer. */
+	inline void consumeBuffer(uint8 n) {
+		if (isMSB2LSB)
+			_buffer <<= n;
+		else
+			_buffer >>= n;
+
+		_bufferBits -= n;
+	}
 
 public:
 	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
-	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
-		_stream(stream), _disposeAfterUse(disposeAfterUse), _value(0), _inValue(0) {
-
-		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) : _disposeAfterUse(disposeAfterUse) {
+		init(stream, 0);
 	}
 
 	/** Create a bit stream using this input data stream. */
-	BitStreamImpl(SeekableReadStream &stream) :
-		_stream(&stream), _disposeAfterUse(false), _value(0), _inValue(0) {
+	BitStreamImpl(SeekableReadStream &stream) : _disposeAfterUse(false) {
+		init(&stream, 0);
+	}
 
-		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	/**
+	 * Create a bit stream reading directly from the memory of this
+	 * stream and optionally delete the stream on destruction.
+	 */
+	BitStreamImpl(MemoryReadStream *stream, bool disposeAfterUse = false) : _disposeAfterUse(disposeAfterUse) {
+		init(stream, stream->getData());
+	}
+
+	/** Create a bit stream reading directly from the memory of this stream. */
+	BitStreamImpl(MemoryReadStream &stream) : _disposeAfterUse(false) {
+		init(&stream, stream.getData());
 	}
 
 	~BitStreamImpl() {
@@ -151,26 +231,10 @@ public:
 
 	/** Read a bit from the bit stream. */
 	uint32 getBit() {
-		// Check if we need the next value
-		if (_inValue == 0)
-			readValue();
-
-		// Get the current bit
-		int b = 0;
-		if (isMSB2LSB)
-			b = ((_value & 0x80000000) == 0) ? 0 : 1;
-		else
-			b = ((_value & 1) == 0) ? 0 : 1;
-
-		// Shift to the next bit
-		if (isMSB2LSB)
-			_value <<= 1;
-		else
-			_value >>= 1;
-
-		// Increase the position within the current value
-		_inValue = (_inValue + 1) % valueBits;
+		ensureBits(1);
 
+		uint32 b = peekBuffer(1);
+		consumeBuffer(1);
 		return b;
 	}
 
@@ -191,35 +255,18 @@ public:
 		if (n > 32)
 			error("BitStreamImpl::getBits(): Too many bits requested to be read");
 
-		// Read the number of bits
-		uint32 v = 0;
-
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
-
-			v >>= (32 - n);
-		}
+		ensureBits(n);
 
+		uint32 v = peekBuffer(n);
+		consumeBuffer(n);
 		return v;
 	}
 
 	/** Read a bit from the bit stream, without changing the stream's position. */
 	uint32 peekBit() {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		ensureBits(1);
 
-		uint32 v = getBit();
-
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
-
-		return v;
+		return peekBuffer(1);
 	}
 
 	/**
@@ -228,17 +275,15 @@ public:
 	 * The bit order is the same as in getBits().
 	 */
 	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamImpl::peekBits(): Too many bits requested to be read");
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		ensureBits(n);
 
-		return v;
+		return peekBuffer(n);
 	}
 
 	/**
@@ -262,36 +307,61 @@ public:
 			x = (x & ~(1 << n)) | (getBit() << n);
 	}
 
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
-		_stream->seek(0);
+		if (!_data)
+			_stream->seek(0);
 
-		_value   = 0;
-		_inValue = 0;
+		_dataPos    = 0;
+		_buffer     = 0;
+		_bufferBits = 0;
 	}
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		// Consuming all 64 buffered bits would shift the buffer by 64, which
+		// is undefined, so that case drops the buffer below
+		if (n < _bufferBits) {
+			consumeBuffer(n);
+			return;
+		}
+
+		// Drop the buffer and jump over whole values directly
+		n -= _bufferBits;
+		_buffer     = 0;
+		_bufferBits = 0;
+
+		uint32 skipBytes = (n / valueBits) * kValueBytes;
+		if (skipBytes > _dataSize - _dataPos)
+			error("BitStreamImpl::skip(): End of bit stream reached");
+
+		_dataPos += skipBytes;
+		if (!_data)
+			_stream->seek(_dataPos);
+
+		n %= valueBits;
+		if (n > 0) {
+			ensureBits(n);
+			consumeBuffer(n);
+		}
 	}
 
 	/** Return the stream position in bits. */
 	uint32 pos() const {
-		if (_stream->pos() == 0)
-			return 0;
-
-		uint32 p = (_inValue == 0) ? _stream->pos() : ((_stream->pos() - 1) & ~((uint32) ((valueBits >> 3) - 1)));
-		return p * 8 + _inValue;
+		return _dataPos * 8 - _bufferBits;
 	}
 
 	/** Return the stream size in bits. */
 	uint32 size() const {
-		return (_stream->size() & ~((uint32) ((valueBits >> 3) - 1))) * 8;
+		return _dataSize * 8;
 	}
 
 	bool eos() const {
-		return _stream->eos() || (pos() >= size());
+		return pos() >= size();
 	}
 };
 
@@ -0,0 +1,82 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace Common {
+
+static bool s_detected = false;
+static uint32 s_features = 0;
+static uint32 s_disabled = 0;
+
+#ifdef SCUMMVM_SIMD_X86
+static uint32 detectX86Features() {
+	uint32 features = 0;
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	if (edx & bit_SSE2)
+		features |= kCPUFeatureSSE2;
+
+	// AVX2 additionally requires the OS to save the YMM registers on
+	// context switches, which is reported through XCR0.
+	const bool osxsave = (ecx & bit_OSXSAVE) != 0;
+	const bool avx = (ecx & bit_AVX) != 0;
+	if (osxsave && avx && __get_cpuid_max(0, 0) >= 7) {
+		unsigned int xcr0Lo, xcr0Hi;
+		__asm__ ("xgetbv" : "=a" (xcr0Lo), "=d" (xcr0Hi) : "c" (0));
+		if ((xcr0Lo & 6) == 6) {
+			__cpuid_count(7, 0, eax, ebx, ecx, edx);
+			if (ebx & bit_AVX2)
+				features |= kCPUFeatureAVX2;
+		}
+	}
+
+	return features;
+}
+#endif
+
+uint32 getCPUFeatures() {
+	if (!s_detected) {
+#ifdef SCUMMVM_SIMD_X86
+		s_features |= detectX86Features();
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+		s_features |= kCPUFeatureNEON;
+#endif
+		s_detected = true;
+	}
+
+	return s_features & ~s_disabled;
+}
+
+void disableCPUFeatures(uint32 features) {
+	s_disabled = features;
+}
+
+} // End of namespace Common
@@ -0,0 +1,88 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_CPUDETECT_H
+#define COMMON_CPUDETECT_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Runtime detection of the vector instruction sets available on the host CPU.
+ *
+ * Code providing SIMD kernels should compile them only when the matching
+ * SCUMMVM_SIMD_* define is set, and pick them at runtime through
+ * Common::hasCPUFeature(), always keeping a plain C++ fallback around.
+ */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+	(__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+/**
+ * SSE2 and AVX2 kernels can be compiled, independently of the flags the
+ * rest of the code is compiled with, by tagging the functions containing
+ * them with SCUMMVM_TARGET_SSE2 resp. SCUMMVM_TARGET_AVX2.
+ */
+#define SCUMMVM_SIMD_X86
+#define SCUMMVM_TARGET_SSE2 __attribute__((target("sse2")))
+#define SCUMMVM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+/**
+ * NEON kernels can only be compiled when the compiler targets NEON anyway,
+ * so they are always usable when this is set.
+ */
+#define SCUMMVM_SIMD_NEON
+#endif
+
+namespace Common {
+
+enum CPUFeature {
+	kCPUFeatureSSE2 = 1 << 0,
+	kCPUFeatureAVX2 = 1 << 1,
+	kCPUFeatureNEON = 1 << 2
+};
+
+/**
+ * Return a mask of the CPUFeature flags supported by the host.
+ * Detection is only done once, on the first call.
+ */
+uint32 getCPUFeatures();
+
+/**
+ * Check whether the host supports the given CPU feature, and the feature
+ * was not disabled via disableCPUFeatures().
+ */
+inline bool hasCPUFeature(CPUFeature feature) {
+	return (getCPUFeatures() & feature) != 0;
+}
+
+/**
+ * Mask out the given CPUFeature flags, so that hasCPUFeature() reports
+ * them as unavailable. Passing 0 restores the detected features.
+ * This is mainly useful for comparing SIMD code against the C fallbacks.
+ */
+void disableCPUFeatures(uint32 features);
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,621 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in alternative to HashMap<Key,Val>, with the
+ * same interface and the same requirements on the hash and equality functors.
+ *
+ * Unlike HashMap, it stores the key/value pairs directly in its table instead
+ * of allocating a node for each of them, next to a separate array with one
+ * control byte per slot. A control byte tells whether its slot is empty,
+ * deleted or in use, and for used slots it contains 7 bits of the hash of the
+ * key. Lookups compare 16 control bytes at a time (using SSE2 where it is
+ * available) and only look at the keys whose hash bits match, which usually
+ * means a single key comparison and a single cache miss for the slot.
+ *
+ * Erasing an element only leaves a "deleted" marker behind if the probe
+ * sequence of another key may already run past it; otherwise the slot becomes
+ * empty again. Any markers that remain are dropped the next time the table is
+ * rehashed, which happens in place if it mostly contains deleted slots.
+ *
+ * The control bytes and the group probing are modelled on the "SwissTable"
+ * design of Abseil's flat_hash_map.
+ *
+ * FlatHashMap is not faster for every key type. Matching the control bytes
+ * is extra work which only pays off if comparing keys is expensive, as for
+ * strings. For keys which are cheap to hash and compare, such as integers,
+ * lookups can be noticeably slower than with HashMap. Run the benchmark in
+ * test/common/hashmapbenchmark.h before switching a map in hot code.
+ *
+ * @note Since elements live inside the table, inserting a new key may move
+ *       all elements and thus invalidates references to values and
+ *       iterators. HashMap keeps its nodes in place, so do not blindly
+ *       replace it in code which holds on to such references.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+		Node(const Node &node) : _key(node._key), _value(node._value) {}
+	};
+
+	enum {
+		FLATHASHMAP_GROUP_SIZE = 16,
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// At most 7/8 of the slots may be in use or deleted before the
+		// table gets rehashed.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Control byte values. Used slots contain the low 7 bits of the hash. */
+	enum {
+		kCtrlEmpty = 0x80,
+		kCtrlDeleted = 0xFE
+	};
+
+	/**
+	 * Bit masks over the 16 control bytes of a group, bit i standing for
+	 * slot i of the group.
+	 */
+	class Group {
+	public:
+		explicit Group(const byte *ctrl) {
+#ifdef FLATHASHMAP_USE_SSE2
+			_ctrl = _mm_loadu_si128((const __m128i *)ctrl);
+#else
+			_ctrl = ctrl;
+#endif
+		}
+
+		/** Slots in use whose control byte equals the given hash bits. */
+		uint32 match(byte h2) const {
+#ifdef FLATHASHMAP_USE_SSE2
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8((char)h2)));
+#else
+			uint32 mask = 0;
+			for (int i = 0; i < FLATHASHMAP_GROUP_SIZE; ++i)
+				mask |= (uint32)(_ctrl[i] == h2) << i;
+			return mask;
+#endif
+		}
+
+		/** Empty slots. */
+		uint32 matchEmpty() const {
+			return match(kCtrlEmpty);
+		}
+
+		/** Empty or deleted slots, i.e. all slots with the top bit set. */
+		uint32 matchFree() const {
+#ifdef FLATHASHMAP_USE_SSE2
+			return _mm_movemask_epi8(_ctrl);
+#else
+			uint32 mask = 0;
+			for (int i = 0; i < FLATHASHMAP_GROUP_SIZE; ++i)
+				mask |= (uint32)(_ctrl[i] >> 7) << i;
+			return mask;
+#endif
+		}
+
+	private:
+#ifdef FLATHASHMAP_USE_SSE2
+		__m128i _ctrl;
+#else
+		const byte *_ctrl;
+#endif
+	};
+
+	static int lowestBit(uint32 mask) {
+#if defined(__GNUC__)
+		return __builtin_ctz(mask);
+#else
+		int bit = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			bit++;
+		}
+		return bit;
+#endif
+	}
+
+	byte *_ctrl;		///< control bytes, one per slot
+	Node *_slots;		///< uninitialized storage for _mask+1 nodes
+	size_type _mask;	///< Capacity of the FlatHashMap minus one; capacity is a power of two >= 16
+	size_type _size;
+	size_type _deleted;	///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Spread the bits of the user supplied hash over the whole word. Many of
+	 * our hash functions (e.g. the one for integers) are trivial, but the
+	 * table needs good low bits for the control bytes and good high bits
+	 * for picking the first group.
+	 */
+	static size_type mixHash(size_type hash) {
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	size_type numGroups() const { return (_mask + 1) / FLATHASHMAP_GROUP_SIZE; }
+
+	size_type growthLimit() const {
+		return (_mask + 1) / FLATHASHMAP_LOADFACTOR_DENOMINATOR * FLATHASHMAP_LOADFACTOR_NUMERATOR;
+	}
+
+	void setCtrl(size_type idx, byte ctrl) { _ctrl[idx] = ctrl; }
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const { return lookup(key, mixHash(_hash(key))); }
+	size_type lookup(const Key &key, size_type hash) const;
+	size_type findFreeSlot(size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type idx);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(!(_hashmap->_ctrl[_idx] & 0x80));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsed(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Index of the first used slot at or after idx, or (size_type)-1. */
+	size_type nextUsed(size_type idx) const {
+		for (; idx <= _mask; ++idx) {
+			if (!(_ctrl[idx] & 0x80))
+				return idx;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		return iterator(nextUsed(0), this);
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		return const_iterator(nextUsed(0), this);
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		return iterator(lookup(key), this);
+	}
+
+	const_iterator	find(const Key &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating an empty table of the given capacity.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= FLATHASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_mask = capacity - 1;
+	_ctrl = (byte *)malloc(capacity);
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	assert(_ctrl != NULL && _slots != NULL);
+	memset(_ctrl, kCtrlEmpty, capacity);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			_slots[ctr].~Node();
+	}
+
+	free(_ctrl);
+	free(_slots);
+	_ctrl = NULL;
+	_slots = NULL;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Simply clone the map given to us, slot by slot.
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask + 1 > FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (!(_ctrl[ctr] & 0x80))
+			_slots[ctr].~Node();
+	}
+	memset(_ctrl, kCtrlEmpty, _mask + 1);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Move all elements into a fresh table of the given capacity, dropping all
+ * deleted markers on the way.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	assert(newCapacity >= _size);
+
+#ifndef NDEBUG
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	byte *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] & 0x80)
+			continue;
+
+		// Since we know that no key exists twice in the old table, we
+		// don't need to compare any keys here.
+		const size_type hash = mixHash(_hash(old_slots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+		setCtrl(idx, hash & 0x7F);
+		new ((void *)&_slots[idx]) Node(old_slots[ctr]);
+		old_slots[ctr].~Node();
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	free(old_ctrl);
+	free(old_slots);
+}
+
+/**
+ * Return the slot containing the given key, or (size_type)-1 if there is
+ * none. The hash must have been passed through mixHash() already.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
+	const byte h2 = hash & 0x7F;
+	const size_type groupMask = numGroups() - 1;
+
+	// Probe the groups in triangular order, which visits every group once
+	// when their number is a power of two.
+	size_type group = (hash >> 7) & groupMask;
+	for (size_type step = 1; ; ++step) {
+		const size_type base = group * FLATHASHMAP_GROUP_SIZE;
+		const Group g(_ctrl + base);
+
+		for (uint32 candidates = g.match(h2); candidates; candidates &= candidates - 1) {
+			const size_type ctr = base + lowestBit(candidates);
+			if (_equal(_slots[ctr]._key, key))
+				return ctr;
+		}
+
+		// An empty slot means the key would have been stored in this group
+		if (g.matchEmpty() || step > groupMask)
+			return (size_type)-1;
+
+		group = (group + step) & groupMask;
+	}
+}
+
+/**
+ * Return the first empty or deleted slot in the probe sequence of the given
+ * (mixed) hash. The table must contain at least one such slot.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(size_type hash) const {
+	const size_type groupMask = numGroups() - 1;
+
+	size_type group = (hash >> 7) & groupMask;
+	for (size_type step = 1; ; ++step) {
+		const size_type base = group * FLATHASHMAP_GROUP_SIZE;
+		const uint32 freeSlots = Group(_ctrl + base).matchFree();
+		if (freeSlots)
+			return base + lowestBit(freeSlots);
+
+		assert(step <= groupMask);
+		group = (group + step) & groupMask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = mixHash(_hash(key));
+	size_type ctr = lookup(key, hash);
+	if (ctr != (size_type)-1)
+		return ctr;
+
+	ctr = findFreeSlot(hash);
+
+	// Reusing a deleted slot does not change the load of the table, but
+	// taking an empty one might require growing it first.
+	if (_ctrl[ctr] == kCtrlEmpty && _size + _deleted + 1 > growthLimit()) {
+		// If much of the table is taken up by deleted markers, simply
+		// clean them out; otherwise grow.
+		size_type capacity = _mask + 1;
+		if ((_size + 1) * 2 > growthLimit())
+			capacity = capacity < 512 ? (capacity * 4) : (capacity * 2);
+		rehash(capacity);
+		ctr = findFreeSlot(hash);
+	}
+
+	if (_ctrl[ctr] == kCtrlDeleted)
+		_deleted--;
+	setCtrl(ctr, hash & 0x7F);
+	new ((void *)&_slots[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	assert(idx <= _mask);
+	assert(!(_ctrl[idx] & 0x80));
+
+	_slots[idx].~Node();
+	_size--;
+
+	// Lookups stop at the first group with an empty slot. A group which
+	// has one now has never been full, so no probe sequence ever continued
+	// past it and the slot can simply become empty again.
+	const size_type base = idx & ~(size_type)(FLATHASHMAP_GROUP_SIZE - 1);
+	if (Group(_ctrl + base).matchEmpty()) {
+		setCtrl(idx, kCtrlEmpty);
+	} else {
+		setCtrl(idx, kCtrlDeleted);
+		_deleted++;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != (size_type)-1;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr != (size_type)-1)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	eraseSlot(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != (size_type)-1)
+		eraseSlot(ctr);
+}
+
+} // End of namespace Common
+
+#endif
@@ -29,7 +29,17 @@
 
 namespace Common {
 
-Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
+/** Reverse the order of the lowest n bits of value. */
+static uint32 reverseBits(uint32 value, uint8 n) {
+	uint32 result = 0;
+
+	for (uint8 i = 0; i < n; i++, value >>= 1)
+		result = (result << 1) | (value & 1);
+
+	return result;
+}
+
+Huffman::Symbol::Symbol(uint32 c, uint32 s, uint8 l) : code(c), symbol(s), length(l) {
 }
 
 
@@ -45,38 +55,143 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 	assert(maxLength <= 32);
 
-	_codes.resize(maxLength);
-	_symbols.resize(codeCount);
+	_maxLength = maxLength;
+
+	// Sort the codes by their length, keeping the order of codes with the same length
+	_lengthStart.resize(maxLength + 1);
+	for (uint32 i = 0; i < codeCount; i++) {
+		assert(lengths[i] > 0 && lengths[i] <= maxLength);
+		_lengthStart[lengths[i]]++;
+	}
+
+	for (uint32 i = 1; i <= maxLength; i++)
+		_lengthStart[i] += _lengthStart[i - 1];
+
+	Array<uint32> next(_lengthStart);
+
+	_codes.resize(codeCount);
+	_codeOrder.resize(codeCount);
 
 	for (uint32 i = 0; i < codeCount; i++) {
 		// The symbol. If none were specified, just assume it's identical to the code index
 		uint32 symbol = symbols ? symbols[i] : i;
 
-		// Put the code and symbol into the correct list
-		_codes[lengths[i] - 1].push_back(Symbol(codes[i], symbol));
-
-		// And put the pointer to the symbol/code struct into the symbol list.
-		_symbols[i] = &_codes[lengths[i] - 1].back();
+		_codeOrder[i] = next[lengths[i] - 1]++;
+		_codes[_codeOrder[i]] = Symbol(codes[i], symbol, lengths[i]);
 	}
+
+	buildTables();
 }
 
 Huffman::~Huffman() {
 }
 
 void Huffman::setSymbols(const uint32 *symbols) {
-	for (uint32 i = 0; i < _symbols.size(); i++)
-		_symbols[i]->symbol = symbols ? *symbols++ : i;
+	for (uint32 i = 0; i < _codes.size(); i++)
+		_codes[_codeOrder[i]].symbol = symbols ? *symbols++ : i;
+
+	buildTables();
+}
+
+void Huffman::buildTables() {
+	_firstTableBits = MIN<uint8>(_maxLength, kTableBits);
+
+	for (int msbFirst = 0; msbFirst < 2; msbFirst++) {
+		Table &table = _tables[msbFirst];
+
+		table.clear();
+		table.resize(1 << _firstTableBits);
+
+		buildTable(table, msbFirst != 0, 0, _firstTableBits, 0, 0);
+	}
+}
+
+void Huffman::buildTable(Table &table, bool msbFirst, uint32 offset, uint8 tableBits, uint8 prefixLength, uint32 prefix) {
+	// Number of bits the codes continuing in a sub table still need after this table
+	Array<uint8> subTableLengths;
+	subTableLengths.resize(1 << tableBits);
+
+	// Shorter codes come first, so they win over any longer ones they are a prefix of
+	for (uint32 i = _lengthStart[prefixLength]; i < _codes.size(); i++) {
+		const Symbol &code = _codes[i];
+
+		// The bits of the code, in the order they are read from the stream, first bit highest
+		const uint32 sequence = msbFirst ? code.code : reverseBits(code.code, code.length);
+
+		const uint8 length = code.length - prefixLength;
+		if (prefixLength > 0 && (sequence >> length) != prefix)
+			continue;
+
+		const uint32 rest = (length == 32) ? sequence : (sequence & ((1u << length) - 1));
+
+		if (length <= tableBits) {
+			// The code ends in this table, fill all entries starting with it
+			const uint32 first = rest << (tableBits - length);
+			const uint32 count = 1 << (tableBits - length);
+
+			for (uint32 j = first; j < first + count; j++) {
+				TableEntry &entry = table[offset + (msbFirst ? j : reverseBits(j, tableBits))];
+
+				if (entry.length == 0) {
+					entry.value  = code.symbol;
+					entry.length = length;
+				}
+			}
+		} else {
+			const uint32 index = rest >> (length - tableBits);
+
+			if (table[offset + (msbFirst ? index : reverseBits(index, tableBits))].length == 0)
+				subTableLengths[index] = MAX<uint8>(subTableLengths[index], length - tableBits);
+		}
+	}
+
+	for (uint32 index = 0; index < subTableLengths.size(); index++) {
+		if (subTableLengths[index] == 0)
+			continue;
+
+		const uint8 subBits = MIN<uint8>(subTableLengths[index], kTableBits);
+		const uint32 subOffset = table.size();
+
+		table.resize(subOffset + (1 << subBits));
+
+		TableEntry &entry = table[offset + (msbFirst ? index : reverseBits(index, tableBits))];
+		entry.value   = subOffset;
+		entry.length  = tableBits;
+		entry.subBits = subBits;
+
+		buildTable(table, msbFirst, subOffset, subBits, prefixLength + tableBits, (prefix << tableBits) | index);
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
+	// Near the end of the stream, there might not be enough bits left to fill the table index
+	if (bits.size() - bits.pos() < _maxLength)
+		return getSymbolByBits(bits);
+
+	const TableEntry *tables = _tables[bits.isMSBFirst() ? 1 : 0].begin();
+	const TableEntry *entry = &tables[bits.peekBits(_firstTableBits)];
+
+	while (entry->subBits != 0) {
+		bits.skip(entry->length);
+		entry = &tables[entry->value + bits.peekBits(entry->subBits)];
+	}
+
+	if (entry->length == 0)
+		error("Unknown Huffman code");
+
+	bits.skip(entry->length);
+	return entry->value;
+}
+
+uint32 Huffman::getSymbolByBits(BitStream &bits) const {
 	uint32 code = 0;
 
-	for (uint32 i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+	for (uint8 length = 1; length <= _maxLength; length++) {
+		bits.addBit(code, length - 1);
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+		for (uint32 i = _lengthStart[length - 1]; i < _lengthStart[length]; i++)
+			if (code == _codes[i].code)
+				return _codes[i].symbol;
 	}
 
 	error("Unknown Huffman code");
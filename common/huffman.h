@@ -26,7 +26,6 @@
 #define COMMON_HUFFMAN_H
 
 #include "common/array.h"
-#include "common/list.h"
 #include "common/types.h"
 
 namespace Common {
@@ -36,6 +35,11 @@ class BitStream;
 /**
  * Huffman bitstream decoding
  *
+ * Symbols are decoded with lookup tables, which are indexed by the next
+ * kTableBits bits of the stream. Longer codes continue in sub tables,
+ * so that most symbols are decoded with a single peek and skip on the
+ * bit stream.
+ *
  * Used in engines:
  *  - scumm
  */
@@ -59,22 +63,51 @@ public:
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
+	enum {
+		kTableBits = 9 ///< Index width of the first level table and the largest one of the sub tables.
+	};
+
 	struct Symbol {
 		uint32 code;
 		uint32 symbol;
+		uint8 length;
 
-		Symbol(uint32 c, uint32 s);
+		Symbol(uint32 c = 0, uint32 s = 0, uint8 l = 0);
 	};
 
-	typedef List<Symbol> CodeList;
-	typedef Array<CodeList> CodeLists;
-	typedef Array<Symbol *> SymbolList;
+	struct TableEntry {
+		uint32 value;   ///< The symbol, or the offset of the sub table.
+		uint8 length;   ///< Number of bits to skip, 0 if there is no valid code.
+		uint8 subBits;  ///< Index width of the sub table, 0 if value is a symbol.
+	};
+
+	typedef Array<Symbol> SymbolList;
+	typedef Array<TableEntry> Table;
+
+	uint8 _maxLength;
+
+	/** The codes and their symbols, sorted by code length. */
+	SymbolList _codes;
+
+	/** Position of each code in _codes, by the index passed to the constructor. */
+	Array<uint32> _codeOrder;
+
+	/** Start of the codes of each length in _codes, and the end of the list as the last element. */
+	Array<uint32> _lengthStart;
+
+	/**
+	 * The lookup tables, for bit streams handing out the bits LSB first
+	 * and MSB first. The first level table is at the start, followed by
+	 * all sub tables.
+	 */
+	Table _tables[2];
+	uint8 _firstTableBits;
 
-	/** Lists of codes and their symbols, sorted by code length. */
-	CodeLists _codes;
+	void buildTables();
+	void buildTable(Table &table, bool msbFirst, uint32 offset, uint8 tableBits, uint8 prefixLength, uint32 prefix);
 
-	/** Sorted list of pointers to the symbols. */
-	SymbolList _symbols;
+	/** Decode a symbol bit by bit, which only needs as many bits as the code is long. */
+	uint32 getSymbolByBits(BitStream &bits) const;
 };
 
 } // End of namespace Common
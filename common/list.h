@@ -77,6 +77,25 @@ public:
 			insert(pos, *first);
 	}
 
+	/**
+	 * Moves the element at location it of list to before pos, without
+	 * copying it. list may be this list, iterators to the element stay valid.
+	 */
+	void splice(iterator pos, List<t_T> &list, iterator it) {
+		assert(it != list.end());
+		NodeBase *node = it._node;
+		if (node == pos._node || node->_next == pos._node)
+			return;
+
+		node->_prev->_next = node->_next;
+		node->_next->_prev = node->_prev;
+
+		node->_next = pos._node;
+		node->_prev = pos._node->_prev;
+		node->_prev->_next = node;
+		node->_next->_prev = node;
+	}
+
 	/**
 	 * Deletes the element at location pos and returns an iterator pointing
 	 * to the element after the one which was deleted.
@@ -24,6 +24,17 @@
 
 #include "common/scummsys.h"
 
+/**
+ * @def USE_LIST_SLAB_ALLOCATOR
+ * Enable the following define to let Lists allocate their nodes from the
+ * default SlabAllocator.
+ */
+//#define USE_LIST_SLAB_ALLOCATOR
+
+#ifdef USE_LIST_SLAB_ALLOCATOR
+#include "common/slaballocator.h"
+#endif
+
 namespace Common {
 
 template<typename T> class List;
@@ -36,7 +47,11 @@ namespace ListInternal {
 	};
 
 	template<typename T>
-	struct Node : public NodeBase {
+	struct Node : public NodeBase
+#ifdef USE_LIST_SLAB_ALLOCATOR
+	            , public SlabAllocated
+#endif
+	{
 		T _data;
 
 		Node(const T &x) : _data(x) {}
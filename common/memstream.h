@@ -70,6 +70,9 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	/** Return the memory block the stream reads from. */
+	const byte *getData() const { return _ptrOrig; }
 };
 
 
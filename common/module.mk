@@ -5,6 +5,7 @@ MODULE_OBJS := \
 	config-file.o \
 	config-manager.o \
 	coroutines.o \
+	cpudetect.o \
 	dcl.o \
 	debug.o \
 	error.o \
@@ -21,6 +22,7 @@ MODULE_OBJS := \
 	localization.o \
 	macresman.o \
 	memorypool.o \
+	slaballocator.o \
 	md5.o \
 	mutex.o \
 	platform.o \
@@ -37,6 +39,7 @@ MODULE_OBJS := \
 	unarj.o \
 	unzip.o \
 	util.o \
+	workerpool.o \
 	winexe.o \
 	winexe_ne.o \
 	winexe_pe.o \
@@ -65,14 +65,16 @@ void StackLock::lock() {
 	if (_mutexName != NULL)
 		debug(6, "Locking mutex %s", _mutexName);
 
-	g_system->lockMutex(_mutex);
+	if (_mutex)
+		g_system->lockMutex(_mutex);
 }
 
 void StackLock::unlock() {
 	if (_mutexName != NULL)
 		debug(6, "Unlocking mutex %s", _mutexName);
 
-	g_system->unlockMutex(_mutex);
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
 }
 
 } // End of namespace Common
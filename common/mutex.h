@@ -38,6 +38,8 @@ typedef OSystem::MutexRef MutexRef;
 
 /**
  * Auxillary class to (un)lock a mutex on the stack.
+ * A null MutexRef is accepted and not locked, for code which only creates
+ * its mutex when there is an OSystem.
  */
 class StackLock {
 	MutexRef _mutex;
@@ -305,6 +305,17 @@
 	#endif
 #endif
 
+// Marks variables which exist once per thread. Left undefined on compilers
+// and toolchains without support for thread local storage.
+#ifndef SCUMMVM_THREAD_LOCAL
+	#if defined(_MSC_VER)
+		#define SCUMMVM_THREAD_LOCAL __declspec(thread)
+	#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1)) && \
+	      !defined(__PSP__) && !defined(__DS__) && !defined(__N64__) && !defined(__PLAYSTATION2__) && !defined(GEKKO) && !defined(__DC__)
+		#define SCUMMVM_THREAD_LOCAL __thread
+	#endif
+#endif
+
 #ifndef STRINGBUFLEN
   #if defined(__N64__) || defined(__DS__)
     #define STRINGBUFLEN 256
@@ -0,0 +1,550 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// winnt.h defines ARRAYSIZE, but we want our own one... - this is needed before including util.h
+#undef ARRAYSIZE
+#elif defined(POSIX)
+#include <sched.h>
+#endif
+
+#include "common/slaballocator.h"
+#include "common/util.h"
+
+/**
+ * SLAB_ATOMIC_* provide the few atomic operations the allocator needs for
+ * its lock. Without them, SLAB_FORWARD_TO_MALLOC is set and the allocator
+ * only passes requests on to malloc and free.
+ *
+ * SLAB_THREAD_LOCAL marks thread local variables. Without it, there are no
+ * thread caches and every request takes the lock.
+ *
+ * SLAB_YIELD gives up the rest of the time slice of the calling thread, so
+ * that a thread waiting for the lock lets the thread holding it run.
+ */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define SLAB_ATOMIC_EXCHANGE(ptr, val) __sync_lock_test_and_set(ptr, val)
+#define SLAB_ATOMIC_RELEASE(ptr) __sync_lock_release(ptr)
+#define SLAB_ATOMIC_CAS(ptr, oldVal, newVal) __sync_bool_compare_and_swap(ptr, oldVal, newVal)
+#define SLAB_ATOMIC_INCREMENT(ptr) __sync_add_and_fetch(ptr, 1)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define SLAB_ATOMIC_EXCHANGE(ptr, val) _InterlockedExchange((volatile long *)(ptr), val)
+#define SLAB_ATOMIC_RELEASE(ptr) _InterlockedExchange((volatile long *)(ptr), 0)
+#define SLAB_ATOMIC_CAS(ptr, oldVal, newVal) (_InterlockedCompareExchangePointer((void *volatile *)(ptr), newVal, oldVal) == (oldVal))
+#define SLAB_ATOMIC_INCREMENT(ptr) _InterlockedIncrement((volatile long *)(ptr))
+#else
+#define SLAB_FORWARD_TO_MALLOC
+#endif
+
+#if defined(SCUMMVM_THREAD_LOCAL) && !defined(SLAB_FORWARD_TO_MALLOC)
+#define SLAB_THREAD_LOCAL SCUMMVM_THREAD_LOCAL
+#endif
+
+#if defined(WIN32)
+#define SLAB_YIELD() SwitchToThread()
+#elif defined(POSIX)
+#define SLAB_YIELD() sched_yield()
+#else
+#define SLAB_YIELD()
+#endif
+
+namespace Common {
+
+enum {
+	kPageSize = 8192,	///< must be a power of two
+	kArenaPages = 8,
+
+	/** Chunks start this far into a page, which keeps them aligned. */
+	kPageHeaderSize = 64,
+
+	kThreadCacheSlots = 4,
+	/** Number of chunks moved between a thread cache and the pages at once. */
+	kCacheBatch = 16,
+
+	/** Number of attempts to take the lock before yielding to other threads. */
+	kLockSpins = 64
+};
+
+struct SlabAllocator::Arena {
+	void *mem;			///< block obtained from malloc
+	byte *pages;		///< first page, aligned to kPageSize
+	Arena *prev;
+	Arena *next;
+	Page *freePages;
+	uint usedPages;
+};
+
+struct SlabAllocator::Page {
+	Arena *arena;
+	Page *prev;			///< in the partial list of the size class, or unused
+	Page *next;			///< in the partial list, or in the free list of the arena
+	void *freeChunks;	///< singly linked through the first word of each chunk
+	uint16 sizeClass;
+	uint16 usedChunks;
+	uint16 numChunks;
+	bool inPartialList;
+};
+
+struct SlabAllocator::ThreadCache {
+	uint32 serial;		///< of the allocator these chunks belong to
+	uint32 allocations;	///< not yet added to the stats of the allocator
+	void *chunks[kNumSizeClasses];
+	uint16 count[kNumSizeClasses];
+};
+
+#ifdef SLAB_THREAD_LOCAL
+// Each allocator with thread caches claims one of these slots, which selects
+// the cache it uses in every thread.
+static SlabAllocator *volatile g_cacheSlotOwners[kThreadCacheSlots];
+#endif
+
+#ifndef SLAB_FORWARD_TO_MALLOC
+static volatile int32 g_nextSerial = 0;
+#endif
+
+SlabAllocator::SlabAllocator() : _arenas(0), _spareArena(0), _lock(0), _cacheSlot(-1) {
+	assert(sizeof(Page) <= kPageHeaderSize);
+
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		_partialPages[i] = 0;
+	memset(&_stats, 0, sizeof(_stats));
+
+#ifndef SLAB_FORWARD_TO_MALLOC
+	_serial = SLAB_ATOMIC_INCREMENT(&g_nextSerial);
+#else
+	_serial = 0;
+#endif
+
+#ifdef SLAB_THREAD_LOCAL
+	for (int i = 0; i < kThreadCacheSlots; ++i) {
+		if (SLAB_ATOMIC_CAS(&g_cacheSlotOwners[i], (SlabAllocator *)0, this)) {
+			_cacheSlot = i;
+			break;
+		}
+	}
+#endif
+}
+
+SlabAllocator::~SlabAllocator() {
+	releaseAll();
+
+#ifdef SLAB_THREAD_LOCAL
+	if (_cacheSlot >= 0)
+		g_cacheSlotOwners[_cacheSlot] = 0;
+#endif
+}
+
+void SlabAllocator::lock() const {
+#ifndef SLAB_FORWARD_TO_MALLOC
+	// The lock is only ever held for a few list operations, so spin for a
+	// while first. If that is not enough, the holder has most likely been
+	// preempted; yield until it had a chance to release the lock.
+	for (int spins = 0; SLAB_ATOMIC_EXCHANGE(&_lock, 1); ++spins) {
+		if (spins >= kLockSpins)
+			SLAB_YIELD();
+	}
+#endif
+}
+
+void SlabAllocator::unlock() const {
+#ifndef SLAB_FORWARD_TO_MALLOC
+	SLAB_ATOMIC_RELEASE(&_lock);
+#endif
+}
+
+int SlabAllocator::getSizeClass(size_t size) {
+	if (size > kMaxChunkSize)
+		return -1;
+
+	int sizeClass = 0;
+	while (getClassChunkSize(sizeClass) < size)
+		sizeClass++;
+	return sizeClass;
+}
+
+size_t SlabAllocator::getClassChunkSize(int sizeClass) {
+	return (size_t)kMinChunkSize << sizeClass;
+}
+
+size_t SlabAllocator::getChunkSize(size_t size) {
+	const int sizeClass = getSizeClass(size);
+	return sizeClass < 0 ? 0 : getClassChunkSize(sizeClass);
+}
+
+SlabAllocator::Page *SlabAllocator::allocPage(int sizeClass) {
+	// Only take pages from the spare arena if no other arena has any, so
+	// that it has a chance to stay empty
+	Arena *arena = 0;
+	for (Arena *cur = _arenas; cur; cur = cur->next) {
+		if (cur->freePages && cur != _spareArena) {
+			arena = cur;
+			break;
+		}
+	}
+	if (!arena)
+		arena = _spareArena;
+
+	if (!arena) {
+		arena = new Arena;
+		// One extra page makes room for aligning the pages
+		arena->mem = malloc((kArenaPages + 1) * kPageSize);
+		if (!arena->mem) {
+			delete arena;
+			return 0;
+		}
+		arena->pages = (byte *)(((size_t)arena->mem + kPageSize - 1) & ~(size_t)(kPageSize - 1));
+		arena->freePages = 0;
+		arena->usedPages = 0;
+		for (int i = kArenaPages - 1; i >= 0; --i) {
+			Page *page = (Page *)(arena->pages + i * kPageSize);
+			page->arena = arena;
+			page->next = arena->freePages;
+			arena->freePages = page;
+		}
+
+		arena->prev = 0;
+		arena->next = _arenas;
+		if (_arenas)
+			_arenas->prev = arena;
+		_arenas = arena;
+
+		_stats.reservedBytes += (kArenaPages + 1) * kPageSize;
+		_stats.peakReservedBytes = MAX(_stats.peakReservedBytes, _stats.reservedBytes);
+	}
+
+	if (arena == _spareArena)
+		_spareArena = 0;
+
+	Page *page = arena->freePages;
+	arena->freePages = page->next;
+	arena->usedPages++;
+	_stats.usedPages++;
+
+	const size_t chunkSize = getClassChunkSize(sizeClass);
+	page->sizeClass = sizeClass;
+	page->usedChunks = 0;
+	page->numChunks = (kPageSize - kPageHeaderSize) / chunkSize;
+	page->freeChunks = 0;
+	byte *chunks = (byte *)page + kPageHeaderSize;
+	for (int i = page->numChunks - 1; i >= 0; --i) {
+		void **chunk = (void **)(chunks + i * chunkSize);
+		*chunk = page->freeChunks;
+		page->freeChunks = chunk;
+	}
+
+	// Link it into the partial list
+	page->prev = 0;
+	page->next = _partialPages[sizeClass];
+	if (page->next)
+		page->next->prev = page;
+	_partialPages[sizeClass] = page;
+	page->inPartialList = true;
+
+	return page;
+}
+
+void SlabAllocator::freePage(Page *page) {
+	assert(page->usedChunks == 0);
+
+	if (page->inPartialList) {
+		if (page->prev)
+			page->prev->next = page->next;
+		else
+			_partialPages[page->sizeClass] = page->next;
+		if (page->next)
+			page->next->prev = page->prev;
+	}
+
+	Arena *arena = page->arena;
+	page->next = arena->freePages;
+	arena->freePages = page;
+	arena->usedPages--;
+	_stats.usedPages--;
+
+	if (arena->usedPages == 0) {
+		// Keep a single empty arena, so that a page which is repeatedly
+		// emptied and refilled does not cause a malloc every time.
+		if (!_spareArena)
+			_spareArena = arena;
+		else if (_spareArena != arena)
+			freeArena(arena);
+	}
+}
+
+void SlabAllocator::freeArena(Arena *arena) {
+	if (arena->prev)
+		arena->prev->next = arena->next;
+	else
+		_arenas = arena->next;
+	if (arena->next)
+		arena->next->prev = arena->prev;
+
+	if (arena == _spareArena)
+		_spareArena = 0;
+
+	_stats.reservedBytes -= (kArenaPages + 1) * kPageSize;
+	free(arena->mem);
+	delete arena;
+}
+
+void *SlabAllocator::allocChunk(int sizeClass) {
+	Page *page = _partialPages[sizeClass];
+	if (!page) {
+		page = allocPage(sizeClass);
+		if (!page)
+			return 0;
+	}
+
+	void **chunk = (void **)page->freeChunks;
+	page->freeChunks = *chunk;
+	page->usedChunks++;
+	_stats.chunksInUse[sizeClass]++;
+
+	if (!page->freeChunks) {
+		// The page is full now, drop it from the partial list
+		_partialPages[sizeClass] = page->next;
+		if (page->next)
+			page->next->prev = 0;
+		page->inPartialList = false;
+	}
+
+	return chunk;
+}
+
+void SlabAllocator::freeChunk(void *ptr, int sizeClass) {
+	Page *page = (Page *)((size_t)ptr & ~(size_t)(kPageSize - 1));
+	assert(page->sizeClass == sizeClass && page->usedChunks > 0);
+
+	*(void **)ptr = page->freeChunks;
+	page->freeChunks = ptr;
+	page->usedChunks--;
+	_stats.chunksInUse[sizeClass]--;
+
+	if (page->usedChunks == 0) {
+		freePage(page);
+	} else if (!page->inPartialList) {
+		page->prev = 0;
+		page->next = _partialPages[sizeClass];
+		if (page->next)
+			page->next->prev = page;
+		_partialPages[sizeClass] = page;
+		page->inPartialList = true;
+	}
+}
+
+SlabAllocator::ThreadCache *SlabAllocator::getThreadCaches() {
+#ifdef SLAB_THREAD_LOCAL
+	static SLAB_THREAD_LOCAL ThreadCache threadCaches[kThreadCacheSlots];
+	return threadCaches;
+#else
+	return 0;
+#endif
+}
+
+SlabAllocator::ThreadCache *SlabAllocator::getThreadCache() const {
+#ifdef SLAB_THREAD_LOCAL
+	if (_cacheSlot < 0)
+		return 0;
+
+	// Entries whose serial does not match are stale: the allocator which
+	// used the slot before is gone, or this one has been reset since. Their
+	// chunks are not ours, or have been freed, so simply drop them.
+	ThreadCache *cache = &getThreadCaches()[_cacheSlot];
+	if (cache->serial != _serial) {
+		memset(cache, 0, sizeof(*cache));
+		cache->serial = _serial;
+	}
+	return cache;
+#else
+	return 0;
+#endif
+}
+
+void SlabAllocator::refillCache(ThreadCache *cache, int sizeClass) {
+	lock();
+	_stats.allocations += cache->allocations;
+	cache->allocations = 0;
+	for (int i = 0; i < kCacheBatch; ++i) {
+		void **chunk = (void **)allocChunk(sizeClass);
+		if (!chunk)
+			break;
+		*chunk = cache->chunks[sizeClass];
+		cache->chunks[sizeClass] = chunk;
+		cache->count[sizeClass]++;
+	}
+	unlock();
+}
+
+void SlabAllocator::flushCache(ThreadCache *cache, int sizeClass, uint count) {
+	lock();
+	_stats.allocations += cache->allocations;
+	cache->allocations = 0;
+	for (uint i = 0; i < count && cache->chunks[sizeClass]; ++i) {
+		void **chunk = (void **)cache->chunks[sizeClass];
+		cache->chunks[sizeClass] = *chunk;
+		cache->count[sizeClass]--;
+		freeChunk(chunk, sizeClass);
+	}
+	unlock();
+}
+
+void SlabAllocator::releaseThreadCaches() {
+#ifdef SLAB_THREAD_LOCAL
+	for (int i = 0; i < kThreadCacheSlots; ++i) {
+		SlabAllocator *owner = g_cacheSlotOwners[i];
+		ThreadCache *cache = &getThreadCaches()[i];
+		if (owner && cache->serial == owner->_serial) {
+			for (int sizeClass = 0; sizeClass < kNumSizeClasses; ++sizeClass)
+				owner->flushCache(cache, sizeClass, cache->count[sizeClass]);
+		}
+		memset(cache, 0, sizeof(*cache));
+	}
+#endif
+}
+
+void *SlabAllocator::allocate(size_t size) {
+#ifndef SLAB_FORWARD_TO_MALLOC
+	const int sizeClass = getSizeClass(size);
+	if (sizeClass >= 0) {
+		ThreadCache *cache = getThreadCache();
+		if (!cache) {
+			lock();
+			_stats.allocations++;
+			void *chunk = allocChunk(sizeClass);
+			unlock();
+			return chunk;
+		}
+
+		if (!cache->chunks[sizeClass]) {
+			refillCache(cache, sizeClass);
+			if (!cache->chunks[sizeClass])
+				return 0;
+		}
+
+		void **chunk = (void **)cache->chunks[sizeClass];
+		cache->chunks[sizeClass] = *chunk;
+		cache->count[sizeClass]--;
+		cache->allocations++;
+		return chunk;
+	}
+
+	lock();
+	_stats.allocations++;
+	_stats.largeAllocations++;
+	unlock();
+#endif
+
+	return malloc(size);
+}
+
+void SlabAllocator::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+#ifndef SLAB_FORWARD_TO_MALLOC
+	const int sizeClass = getSizeClass(size);
+	if (sizeClass >= 0) {
+		ThreadCache *cache = getThreadCache();
+		if (!cache) {
+			lock();
+			freeChunk(ptr, sizeClass);
+			unlock();
+			return;
+		}
+
+		*(void **)ptr = cache->chunks[sizeClass];
+		cache->chunks[sizeClass] = ptr;
+		cache->count[sizeClass]++;
+
+		// Keep at most two batches, so that alternating allocations and
+		// frees around the limit do not take the lock every time
+		if (cache->count[sizeClass] > 2 * kCacheBatch)
+			flushCache(cache, sizeClass, kCacheBatch);
+		return;
+	}
+
+	lock();
+	_stats.largeAllocations--;
+	unlock();
+#endif
+
+	free(ptr);
+}
+
+void SlabAllocator::releaseAll() {
+	lock();
+	while (_arenas)
+		freeArena(_arenas);
+	for (int i = 0; i < kNumSizeClasses; ++i) {
+		_partialPages[i] = 0;
+		_stats.chunksInUse[i] = 0;
+	}
+	_stats.usedPages = 0;
+
+#ifndef SLAB_FORWARD_TO_MALLOC
+	// All thread caches refer to freed pages now, invalidate them
+	_serial = SLAB_ATOMIC_INCREMENT(&g_nextSerial);
+#endif
+	unlock();
+}
+
+void SlabAllocator::freeUnusedArenas() {
+	lock();
+	if (_spareArena)
+		freeArena(_spareArena);
+	unlock();
+}
+
+SlabAllocator::Stats SlabAllocator::getStats() const {
+	lock();
+	Stats stats = _stats;
+	unlock();
+
+	// Include the allocations of the calling thread, which are exact
+	ThreadCache *cache = getThreadCache();
+	if (cache)
+		stats.allocations += cache->allocations;
+	return stats;
+}
+
+SlabAllocator &getSlabAllocator() {
+	static SlabAllocator *volatile allocator = 0;
+	if (!allocator) {
+		// Created on first use, which may happen in several threads at once.
+		// Only the first allocator published is kept.
+		SlabAllocator *created = new SlabAllocator();
+#ifndef SLAB_FORWARD_TO_MALLOC
+		if (!SLAB_ATOMIC_CAS(&allocator, (SlabAllocator *)0, created))
+			delete created;
+#else
+		// Without atomic operations, the first use must happen before any
+		// threads are started.
+		allocator = created;
+#endif
+	}
+	return *allocator;
+}
+
+} // End of namespace Common
@@ -0,0 +1,193 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SLABALLOCATOR_H
+#define COMMON_SLABALLOCATOR_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A general purpose allocator for small memory blocks.
+ *
+ * Requests are rounded up to one of a few power-of-two size classes, from
+ * kMinChunkSize to kMaxChunkSize bytes, and served from pages which only
+ * contain chunks of a single class. Larger requests are passed on to malloc.
+ * Compared to malloc this has no per-block overhead and keeps blocks of
+ * similar size together, which reduces fragmentation in long sessions.
+ *
+ * Pages are taken from bigger arenas obtained from malloc. Empty pages go
+ * back to their arena, where they can be reused by any size class, and
+ * arenas without any used pages are returned to the system again.
+ *
+ * The allocator may be used from several threads at once. Where the
+ * compiler supports it, each thread additionally keeps a small cache of
+ * free chunks per size class, so that most allocations do not need to take
+ * the lock at all. On compilers without atomic operations, all requests are
+ * simply forwarded to malloc and free.
+ *
+ * Unlike with malloc, the size of a block must be passed again when freeing
+ * it. Classes can derive from SlabAllocated to have their instances
+ * allocated from the default allocator returned by getSlabAllocator().
+ */
+class SlabAllocator : NonCopyable {
+public:
+	enum {
+		kMinChunkSize = 8,
+		kMaxChunkSize = 1024,
+		kNumSizeClasses = 8
+	};
+
+	struct Stats {
+		/**
+		 * Number of allocate() calls so far. Allocations served by the
+		 * caches of other threads may only be counted after a while.
+		 */
+		uint32 allocations;
+		/** Number of chunks handed out per size class, including those held in thread caches. */
+		uint32 chunksInUse[kNumSizeClasses];
+		/** Number of requests above kMaxChunkSize which are currently allocated. */
+		uint32 largeAllocations;
+		/** Number of pages used by any size class. */
+		uint32 usedPages;
+		/** Memory currently obtained from the system for pages, in bytes. */
+		uint32 reservedBytes;
+		/** Highest value of reservedBytes so far. */
+		uint32 peakReservedBytes;
+	};
+
+	SlabAllocator();
+
+	/**
+	 * Frees all pages of this allocator, regardless of whether they are
+	 * still in use. See releaseAll().
+	 */
+	~SlabAllocator();
+
+	/**
+	 * Allocate a block of at least the given size. Blocks of up to
+	 * kMaxChunkSize bytes are aligned to their size class, up to 64 bytes.
+	 */
+	void *allocate(size_t size);
+
+	/**
+	 * Return a block to the allocator. The size must be the one passed to
+	 * the allocate() call which returned the block.
+	 */
+	void deallocate(void *ptr, size_t size);
+
+	/**
+	 * Free all blocks of up to kMaxChunkSize bytes at once, e.g. when the
+	 * engine which used this allocator quits. Pointers to them become
+	 * invalid; larger blocks are not affected and still need to be freed.
+	 * This must not be called while other threads use this allocator.
+	 */
+	void releaseAll();
+
+	/**
+	 * Return all arenas which do not contain any used page to the system.
+	 * Usually an empty arena is kept around as spare, this frees it too.
+	 */
+	void freeUnusedArenas();
+
+	/**
+	 * Return the free chunks cached by the calling thread to the allocators
+	 * they belong to. Threads other than the main thread must call this
+	 * before they exit, or the chunks in their caches are lost.
+	 * OSystem::createThread() implementations take care of this.
+	 */
+	static void releaseThreadCaches();
+
+	/**
+	 * Return the chunk size which a request of the given size is rounded
+	 * up to, or 0 if it is passed on to malloc.
+	 */
+	static size_t getChunkSize(size_t size);
+
+	Stats getStats() const;
+
+private:
+	struct Arena;
+	struct Page;
+	struct ThreadCache;
+
+	Page *_partialPages[kNumSizeClasses];	///< pages with at least one free chunk, per class
+	Arena *_arenas;
+	Arena *_spareArena;		///< an empty arena kept for reuse, if any
+
+	Stats _stats;
+
+	mutable volatile int32 _lock;
+	uint32 _serial;			///< identifies this allocator in the thread caches
+	int _cacheSlot;			///< thread cache slot claimed by this allocator, or -1
+
+	void lock() const;
+	void unlock() const;
+
+	static int getSizeClass(size_t size);
+	static size_t getClassChunkSize(int sizeClass);
+
+	Page *allocPage(int sizeClass);
+	void freePage(Page *page);
+	void freeArena(Arena *arena);
+
+	void *allocChunk(int sizeClass);
+	void freeChunk(void *ptr, int sizeClass);
+
+	static ThreadCache *getThreadCaches();
+	ThreadCache *getThreadCache() const;
+	void refillCache(ThreadCache *cache, int sizeClass);
+	void flushCache(ThreadCache *cache, int sizeClass, uint count);
+};
+
+/**
+ * Return the process wide allocator used by SlabAllocated and other code
+ * which opts into slab allocation. It is created on first use and never
+ * destroyed, so blocks may still be freed during static destruction.
+ */
+SlabAllocator &getSlabAllocator();
+
+/**
+ * Deriving from this class makes new and delete allocate instances of the
+ * derived class from the default SlabAllocator.
+ *
+ * @note Deleting an object through a pointer to a base class is only
+ *       supported if that base class has a virtual destructor, since the
+ *       size of the object needs to be known.
+ */
+class SlabAllocated {
+public:
+	static void *operator new(size_t size) {
+		return getSlabAllocator().allocate(size);
+	}
+
+	static void operator delete(void *ptr, size_t size) {
+		if (ptr)
+			getSlabAllocator().deallocate(ptr, size);
+	}
+};
+
+} // End of namespace Common
+
+#endif
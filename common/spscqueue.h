@@ -0,0 +1,139 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SPSCQUEUE_H
+#define COMMON_SPSCQUEUE_H
+
+#include "common/scummsys.h"
+
+/**
+ * @def COMMON_MEMORY_BARRIER()
+ * Full hardware and compiler memory barrier. Only defined on compilers where
+ * we know how to emit one; code relying on it has to provide a fallback
+ * (see SPSCQueue::isLockFree()).
+ */
+#if defined(__GNUC__)
+#define COMMON_MEMORY_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define COMMON_MEMORY_BARRIER() _mm_mfence()
+#endif
+
+namespace Common {
+
+/**
+ * Fixed size, lock-free FIFO queue for exactly one producer thread and one
+ * consumer thread. The producer only ever modifies the write index and the
+ * consumer only the read index, so neither side has to wait for the other.
+ *
+ * If several threads may produce (or consume), they have to be serialized
+ * among themselves, e.g. by a mutex which is only taken by that side.
+ *
+ * SIZE has to be a power of two; the queue holds at most SIZE - 1 elements.
+ */
+template<class T, uint SIZE>
+class SPSCQueue {
+public:
+	SPSCQueue() : _read(0), _write(0) {
+		assert((SIZE & (SIZE - 1)) == 0);
+	}
+
+	/**
+	 * Return whether the queue can be used on this platform at all. If not,
+	 * push() always fails and callers have to use a locked code path.
+	 */
+	static bool isLockFree() {
+#ifdef COMMON_MEMORY_BARRIER
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * Append an element. Must only be called by the producer.
+	 * @return false if the queue is full (or not lock-free)
+	 */
+	bool push(const T &x) {
+#ifdef COMMON_MEMORY_BARRIER
+		const uint write = _write;
+		const uint next = (write + 1) & (SIZE - 1);
+		if (next == _read)
+			return false;
+
+		_storage[write] = x;
+		// Publish the element before publishing the new write index
+		COMMON_MEMORY_BARRIER();
+		_write = next;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * Remove the oldest element. Must only be called by the consumer.
+	 * @return false if the queue is empty
+	 */
+	bool pop(T &x) {
+		const uint read = _read;
+		if (read == _write)
+			return false;
+
+#ifdef COMMON_MEMORY_BARRIER
+		// Do not read the element before seeing the write index
+		COMMON_MEMORY_BARRIER();
+#endif
+		x = _storage[read];
+#ifdef COMMON_MEMORY_BARRIER
+		// Finish reading before handing the slot back to the producer
+		COMMON_MEMORY_BARRIER();
+#endif
+		_read = (read + 1) & (SIZE - 1);
+		return true;
+	}
+
+	/**
+	 * Number of elements currently queued. Only a snapshot when called
+	 * while the other side is active.
+	 */
+	uint size() const {
+		return (_write - _read) & (SIZE - 1);
+	}
+
+	bool empty() const {
+		return _read == _write;
+	}
+
+	static uint capacity() {
+		return SIZE - 1;
+	}
+
+private:
+	T _storage[SIZE];
+	volatile uint _read;
+	volatile uint _write;
+};
+
+} // End of namespace Common
+
+#endif
@@ -25,15 +25,54 @@
 #include "common/str.h"
 #include "common/util.h"
 
+/**
+ * @def USE_STRING_SLAB_ALLOCATOR
+ * Enable the following define to allocate the heap storage of strings from
+ * the default SlabAllocator instead of using new[]. Storage of up to
+ * SlabAllocator::kMaxChunkSize bytes then has no malloc overhead, and the
+ * capacity of such strings is rounded up to the chunk size.
+ */
+//#define USE_STRING_SLAB_ALLOCATOR
+
+#ifdef USE_STRING_SLAB_ALLOCATOR
+#include "common/slaballocator.h"
+#endif
+
 namespace Common {
 
 MemoryPool *g_refCountPool = 0; // FIXME: This is never freed right now
 
+static uint32 s_allocationCount = 0;
+
 static uint32 computeCapacity(uint32 len) {
 	// By default, for the capacity we use the next multiple of 32
 	return ((len + 32 - 1) & ~0x1F);
 }
 
+/**
+ * Allocate heap storage for a string, of at least the given capacity.
+ * The capacity is updated to the size of the storage actually allocated.
+ */
+static char *allocStorage(uint32 &capacity) {
+	s_allocationCount++;
+#ifdef USE_STRING_SLAB_ALLOCATOR
+	const size_t chunkSize = SlabAllocator::getChunkSize(capacity);
+	if (chunkSize)
+		capacity = chunkSize;
+	return (char *)getSlabAllocator().allocate(capacity);
+#else
+	return new char[capacity];
+#endif
+}
+
+static void freeStorage(char *storage, uint32 capacity) {
+#ifdef USE_STRING_SLAB_ALLOCATOR
+	getSlabAllocator().deallocate(storage, capacity);
+#else
+	delete[] storage;
+#endif
+}
+
 String::String(const char *str) : _size(0), _str(_storage) {
 	if (str == 0) {
 		_storage[0] = 0;
@@ -64,7 +103,7 @@ void String::initWithCStr(const char *str, uint32 len) {
 		// Not enough internal storage, so allocate more
 		_extern._capacity = computeCapacity(len+1);
 		_extern._refCount = 0;
-		_str = new char[_extern._capacity];
+		_str = allocStorage(_extern._capacity);
 		assert(_str != 0);
 	}
 
@@ -106,6 +145,40 @@ void String::makeUnique() {
 	ensureCapacity(_size, true);
 }
 
+/**
+ * Take over the storage of the given string, leaving it empty. Any storage
+ * of this string must have been released before.
+ */
+void String::takeStorage(String &str) {
+	_size = str._size;
+	if (str.isStorageIntern()) {
+		memcpy(_storage, str._storage, _builtinCapacity);
+		_str = _storage;
+	} else {
+		_extern._refCount = str._extern._refCount;
+		_extern._capacity = str._extern._capacity;
+		_str = str._str;
+	}
+
+	str._size = 0;
+	str._str = str._storage;
+	str._storage[0] = 0;
+}
+
+void String::swap(String &str) {
+	if (&str == this)
+		return;
+
+	String temp;
+	temp.takeStorage(str);
+	str.takeStorage(*this);
+	takeStorage(temp);
+}
+
+void String::reserve(uint32 capacity) {
+	ensureCapacity(MAX(capacity, _size), true);
+}
+
 /**
  * Ensure that enough storage is available to store at least new_size
  * characters plus a null byte. In addition, if we currently share
@@ -146,7 +219,7 @@ void String::ensureCapacity(uint32 new_size, bool keep_old) {
 			newCapacity = MAX(curCapacity * 2, computeCapacity(new_size+1));
 
 		// Allocate new storage
-		newStorage = new char[newCapacity];
+		newStorage = allocStorage(newCapacity);
 		assert(newStorage);
 	}
 
@@ -203,7 +276,7 @@ void String::decRefCount(int *oldRefCount) {
 			assert(g_refCountPool);
 			g_refCountPool->freeChunk(oldRefCount);
 		}
-		delete[] _str;
+		freeStorage(_str, _extern._capacity);
 
 		// Even though _str points to a freed memory block now,
 		// we do not change its value, because any code that calls
@@ -488,6 +561,10 @@ String String::vformat(const char *fmt, va_list args) {
 	return output;
 }
 
+uint32 String::getAllocationCount() {
+	return s_allocationCount;
+}
+
 
 #pragma mark -
 
@@ -575,36 +652,154 @@ int String::compareToIgnoreCase(const char *x) const {
 
 #pragma mark -
 
+// The operators below reserve the combined size up front, so that at most
+// one buffer is allocated for the result.
+
 String operator+(const String &x, const String &y) {
-	String temp(x);
+	if (y.empty())
+		return x;
+
+	String temp;
+	temp.reserve(x.size() + y.size());
+	temp += x;
 	temp += y;
 	return temp;
 }
 
 String operator+(const char *x, const String &y) {
-	String temp(x);
+	const uint32 len = strlen(x);
+	String temp;
+	temp.reserve(len + y.size());
+	temp += x;
 	temp += y;
 	return temp;
 }
 
 String operator+(const String &x, const char *y) {
-	String temp(x);
+	if (!*y)
+		return x;
+
+	String temp;
+	temp.reserve(x.size() + strlen(y));
+	temp += x;
 	temp += y;
 	return temp;
 }
 
 String operator+(char x, const String &y) {
 	String temp(x);
+	temp.reserve(temp.size() + y.size());
 	temp += y;
 	return temp;
 }
 
 String operator+(const String &x, char y) {
-	String temp(x);
+	String temp;
+	temp.reserve(x.size() + 1);
+	temp += x;
 	temp += y;
 	return temp;
 }
 
+#pragma mark -
+
+StringBuilder::StringBuilder() : _str(_storage), _size(0), _capacity(kBuiltinCapacity) {
+	_storage[0] = 0;
+}
+
+StringBuilder::~StringBuilder() {
+	if (_str != _storage)
+		freeStorage(_str, _capacity);
+}
+
+/**
+ * Ensure that the buffer can hold size characters plus the terminating
+ * zero, growing it to at least twice its current size if needed.
+ */
+void StringBuilder::ensureCapacity(uint32 size) {
+	if (size < _capacity)
+		return;
+
+	uint32 newCapacity = MAX(_capacity * 2, computeCapacity(size + 1));
+	char *newStr = allocStorage(newCapacity);
+	assert(newStr);
+	memcpy(newStr, _str, _size + 1);
+
+	if (_str != _storage)
+		freeStorage(_str, _capacity);
+	_str = newStr;
+	_capacity = newCapacity;
+}
+
+void StringBuilder::reserve(uint32 capacity) {
+	ensureCapacity(capacity);
+}
+
+StringBuilder &StringBuilder::append(const char *str, uint32 len) {
+	ensureCapacity(_size + len);
+	memcpy(_str + _size, str, len);
+	_size += len;
+	_str[_size] = 0;
+	return *this;
+}
+
+StringBuilder &StringBuilder::append(const char *str) {
+	return append(str, strlen(str));
+}
+
+StringBuilder &StringBuilder::append(const String &str) {
+	return append(str.c_str(), str.size());
+}
+
+StringBuilder &StringBuilder::append(char c) {
+	ensureCapacity(_size + 1);
+	_str[_size++] = c;
+	_str[_size] = 0;
+	return *this;
+}
+
+StringBuilder &StringBuilder::appendFormat(const char *fmt, ...) {
+	va_list va;
+	va_start(va, fmt);
+	vappendFormat(fmt, va);
+	va_end(va);
+	return *this;
+}
+
+StringBuilder &StringBuilder::vappendFormat(const char *fmt, va_list args) {
+	for (;;) {
+		const uint32 available = _capacity - _size;
+
+		va_list va;
+		scumm_va_copy(va, args);
+		int len = vsnprintf(_str + _size, available, fmt, va);
+		va_end(va);
+
+		// See String::vformat: MSVC returns -1 if the output does not fit,
+		// and IRIX the number of characters written. So a result which
+		// fills the buffer completely is not trusted either.
+		if (len >= 0 && (uint32)len + 1 < available) {
+			_size += len;
+			break;
+		}
+
+		if (len >= 0 && (uint32)len >= available)
+			ensureCapacity(_size + len);
+		else
+			ensureCapacity(_capacity);
+		_str[_size] = 0;
+	}
+
+	return *this;
+}
+
+void StringBuilder::clear() {
+	_size = 0;
+	_str[0] = 0;
+}
+
+#pragma mark -
+
 char *ltrim(char *t) {
 	while (isSpace(*t))
 		t++;
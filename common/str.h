@@ -200,6 +200,19 @@ public:
 	/** Clears the string, making it empty. */
 	void clear();
 
+	/**
+	 * Make sure the string can hold at least the given number of characters
+	 * without allocating any more storage, e.g. before appending to it in a
+	 * loop. This also unshares the storage of the string.
+	 */
+	void reserve(uint32 capacity);
+
+	/**
+	 * Exchange the contents of this string with the given one. This is
+	 * cheap and never allocates, so it can be used to move strings.
+	 */
+	void swap(String &str);
+
 	/** Convert all characters in the string to lowercase. */
 	void toLowercase();
 
@@ -228,6 +241,13 @@ public:
 	 */
 	static String vformat(const char *fmt, va_list args);
 
+	/**
+	 * Return how often heap storage was allocated for a String or a
+	 * StringBuilder so far, e.g. to compare string building code in
+	 * benchmarks. The count is not synchronized between threads.
+	 */
+	static uint32 getAllocationCount();
+
 public:
 	typedef char *        iterator;
 	typedef const char *  const_iterator;
@@ -260,6 +280,59 @@ protected:
 	void incRefCount() const;
 	void decRefCount(int *oldRefCount);
 	void initWithCStr(const char *str, uint32 len);
+	void takeStorage(String &str);
+};
+
+/**
+ * Helper for composing a String out of many pieces, e.g. once per frame.
+ *
+ * Everything appended goes into a single buffer, which only ever grows, and
+ * formatted output is written straight into that buffer. Hence a builder
+ * which is cleared and reused does not allocate anything once its buffer
+ * is large enough, and toString() only allocates if the result does not fit
+ * into the internal storage of String.
+ */
+class StringBuilder {
+public:
+	StringBuilder();
+	~StringBuilder();
+
+	/** Make room for at least the given number of characters. */
+	void reserve(uint32 capacity);
+
+	StringBuilder &append(const char *str);
+	StringBuilder &append(const char *str, uint32 len);
+	StringBuilder &append(const String &str);
+	StringBuilder &append(char c);
+
+	/** Append formatted data, like String::format. */
+	StringBuilder &appendFormat(const char *fmt, ...) GCC_PRINTF(2,3);
+	StringBuilder &vappendFormat(const char *fmt, va_list args);
+
+	/** Remove all characters, keeping the buffer for reuse. */
+	void clear();
+
+	uint32 size() const       { return _size; }
+	bool empty() const        { return _size == 0; }
+	const char *c_str() const { return _str; }
+
+	/** Return a String with the current contents. */
+	String toString() const { return String(_str, _size); }
+
+private:
+	StringBuilder(const StringBuilder &);
+	StringBuilder &operator=(const StringBuilder &);
+
+	enum {
+		kBuiltinCapacity = 128
+	};
+
+	char *_str;			///< points to _storage or to a buffer on the heap
+	uint32 _size;
+	uint32 _capacity;	///< size of the buffer, including the terminating zero
+	char _storage[kBuiltinCapacity];
+
+	void ensureCapacity(uint32 size);
 };
 
 // Append two strings to form a new (temp) string
@@ -1014,6 +1014,76 @@ public:
 
 
 
+	/**
+	 * @name Worker threads
+	 * Backends may optionally allow starting threads, which can then be
+	 * used to spread CPU heavy work, like decoding videos, over several
+	 * cores. This is not a general threading API: code running in such a
+	 * thread must not call any OSystem methods other than the mutex and
+	 * semaphore ones, and must not use any other engine or backend state
+	 * without proper locking.
+	 *
+	 * All callers must be prepared for createThread() to fail, in which
+	 * case the work has to be done on the calling thread instead. This is
+	 * the default behavior, see Common::WorkerPool for a convenient way of
+	 * handling this.
+	 */
+	//@{
+
+	typedef struct OpaqueThread *ThreadRef;
+	typedef struct OpaqueSemaphore *SemaphoreRef;
+	typedef void (*ThreadProc)(void *param);
+
+	/**
+	 * Start a new thread running proc(param).
+	 * @return the new thread, or 0 if threads are not supported.
+	 */
+	virtual ThreadRef createThread(ThreadProc proc, void *param) { return 0; }
+
+	/**
+	 * Wait until the given thread has finished and free it.
+	 * @param thread	the thread to wait for.
+	 */
+	virtual void waitThread(ThreadRef thread) {}
+
+	/**
+	 * Create a new semaphore. Only needs to be supported if createThread()
+	 * is, too.
+	 * @param value	the initial value of the semaphore.
+	 * @return the newly created semaphore, or 0 if an error occurred.
+	 */
+	virtual SemaphoreRef createSemaphore(uint value) { return 0; }
+
+	/**
+	 * Increment the value of the given semaphore, waking up a thread
+	 * waiting for it, if any.
+	 * @param semaphore	the semaphore to post.
+	 */
+	virtual void postSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Wait until the value of the given semaphore is above zero, then
+	 * decrement it.
+	 * @param semaphore	the semaphore to wait for.
+	 */
+	virtual void waitSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Delete the given semaphore. No thread may be waiting for it.
+	 * @param semaphore	the semaphore to delete.
+	 */
+	virtual void deleteSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Return the number of CPU cores available to ScummVM, or 1 if
+	 * unknown. Useful for deciding how many worker threads to start.
+	 */
+	virtual uint getCPUCount() { return 1; }
+
+	//@}
+
+
+
 	/** @name Sound */
 	//@{
 
@@ -39,6 +39,14 @@ void setErrorHandler(ErrorHandler handler) {
 	s_errorHandler = handler;
 }
 
+#ifdef SCUMMVM_THREAD_LOCAL
+static SCUMMVM_THREAD_LOCAL ThreadMessageHandler *s_threadMessageHandler = 0;
+
+void setThreadMessageHandler(ThreadMessageHandler *handler) {
+	s_threadMessageHandler = handler;
+}
+#endif
+
 
 } // End of namespace Common
 
@@ -53,6 +61,13 @@ void warning(const char *s, ...) {
 	output = Common::String::vformat(s, va);
 	va_end(va);
 
+#ifdef SCUMMVM_THREAD_LOCAL
+	if (Common::s_threadMessageHandler) {
+		Common::s_threadMessageHandler->threadWarning(output.c_str());
+		return;
+	}
+#endif
+
 	output = "WARNING: " + output + "!\n";
 
 	if (g_system)
@@ -76,6 +91,11 @@ void NORETURN_PRE error(const char *s, ...) {
 	vsnprintf(buf_input, STRINGBUFLEN, s, va);
 	va_end(va);
 
+#ifdef SCUMMVM_THREAD_LOCAL
+	// Worker threads leave the rest to the main thread
+	if (Common::s_threadMessageHandler)
+		Common::s_threadMessageHandler->threadError(buf_input);
+#endif
 
 	// Next, give the active engine (if any) a chance to augment the message
 	if (Common::s_errorOutputFormatter) {
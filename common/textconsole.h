@@ -56,6 +56,39 @@ typedef void (*ErrorHandler)(const char *msg);
  */
 void setErrorHandler(ErrorHandler handler);
 
+/**
+ * Receives the messages of warning() and error() calls made in a worker
+ * thread, which must not log them or abort the program by itself, see
+ * OSystem::createThread(). The messages are passed on before the
+ * "WARNING: " prefix, the output formatter or the trailing "!\n" are
+ * applied, so that the main thread can simply pass them on to warning()
+ * or error() in turn.
+ */
+class ThreadMessageHandler {
+public:
+	virtual ~ThreadMessageHandler() {}
+
+	/** Invoked by warning(). */
+	virtual void threadWarning(const char *msg) = 0;
+
+	/**
+	 * Invoked by error(). This must not return: usually it hands the
+	 * message to the main thread, which then calls error() with it, and
+	 * ends the calling thread, e.g. with longjmp() to the start of the
+	 * thread function.
+	 */
+	virtual void threadError(const char *msg) = 0;
+};
+
+#ifdef SCUMMVM_THREAD_LOCAL
+/**
+ * Set the handler for the warnings and errors of the calling thread, or 0
+ * to log them directly again. This needs thread local storage, so it is
+ * only available if SCUMMVM_THREAD_LOCAL is defined.
+ */
+void setThreadMessageHandler(ThreadMessageHandler *handler);
+#endif
+
 } // End of namespace Common
 
 
@@ -102,9 +102,13 @@ typedef struct {
 
 #endif  // !USE_ZLIB
 
+#include "common/array.h"
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/system.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -379,6 +383,8 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owns _stream, shared with member streams */
+	Common::SharedPtr<Common::Mutex> _streamMutex;	/* serializes seeking and reading _stream, if there is an OSystem */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -597,6 +603,13 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		return NULL;
 	}
 
+	// From here on, the stream is owned by _streamRef, since streams of
+	// the members may keep using it after the archive has been closed.
+	us->_streamRef = Common::SharedPtr<Common::SeekableReadStream>(us->_stream);
+	// Member streams may be read in other threads, e.g. by a video decoder
+	if (g_system)
+		us->_streamMutex = Common::SharedPtr<Common::Mutex>(new Common::Mutex());
+
 	us->byte_before_the_zipfile = central_pos -
 		                    (us->offset_central_dir+us->size_central_dir);
 	us->central_pos = central_pos;
@@ -641,7 +654,7 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The stream itself is released by _streamRef
 	delete s;
 	return UNZ_OK;
 }
@@ -1450,6 +1463,348 @@ public:
 };
 */
 
+/**
+ * Members up to this size are inflated into memory in one go when they are
+ * opened. Anything larger is decompressed on demand by a ZipMemberStream, so
+ * that opening e.g. a video packed into an archive does not need the whole
+ * uncompressed file in RAM.
+ */
+#define ZIP_STREAMING_THRESHOLD (256 * 1024)
+
+/**
+ * Holds the mutex of an archive stream, if it has one, so that the stream
+ * is not seeked by one thread while another one reads from it.
+ */
+class ZipStreamLock {
+public:
+	ZipStreamLock(const SharedPtr<Mutex> &mutex) : _mutex(mutex.get()) {
+		if (_mutex)
+			_mutex->lock();
+	}
+
+	~ZipStreamLock() {
+		if (_mutex)
+			_mutex->unlock();
+	}
+
+private:
+	Mutex *_mutex;
+};
+
+/**
+ * Read stream for a single member of a zip archive, which reads the member
+ * data directly from the archive stream.
+ *
+ * Stored members are read straight from the archive into the buffer of the
+ * caller. Deflated members are inflated incrementally; copies of the inflate
+ * state are taken at regular intervals while reading forward, so seeking
+ * backwards only needs to decompress from the nearest checkpoint instead of
+ * from the start of the member.
+ *
+ * Each instance seeks the archive stream before every read, so any number of
+ * members may be open and used independently at the same time. The seek and
+ * the read are done under the lock of the archive stream, so the members may
+ * also be used in different threads.
+ */
+class ZipMemberStream : public SeekableReadStream {
+public:
+	ZipMemberStream(const SharedPtr<SeekableReadStream> &parent, const SharedPtr<Mutex> &parentMutex,
+	                uint32 dataOffset, uint32 compressedSize, uint32 size, bool deflated);
+	~ZipMemberStream();
+
+	/** Returns true if the stream was set up successfully. */
+	bool init();
+
+	bool err() const { return _err; }
+	void clearErr() { _err = false; _eos = false; }
+	bool eos() const { return _eos; }
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+
+	uint32 read(void *dataPtr, uint32 dataSize);
+
+private:
+	SharedPtr<SeekableReadStream> _parent;
+	SharedPtr<Mutex> _parentMutex;
+	const uint32 _dataOffset;
+	const uint32 _compressedSize;
+	const uint32 _size;
+	const bool _deflated;
+
+	uint32 _pos;
+	bool _err;
+	bool _eos;
+
+#ifdef USE_ZLIB
+	struct Checkpoint {
+		z_stream *stream;     ///< copy of the inflate state at pos
+		uint32 pos;           ///< uncompressed position of the checkpoint
+		uint32 compressedPos; ///< compressed bytes consumed at pos
+	};
+
+	z_stream _stream;
+	bool _streamInitialized;
+	byte *_inBuffer;
+	uint32 _compressedPos;  ///< compressed bytes fetched into _inBuffer so far
+
+	Array<Checkpoint> _checkpoints;
+	uint32 _checkpointInterval;
+	uint32 _nextCheckpoint;
+
+	uint32 inflateData(byte *dst, uint32 len);
+	uint32 decompress(byte *dst, uint32 len);
+	void addCheckpoint();
+	bool restart(uint32 target);
+#endif
+};
+
+ZipMemberStream::ZipMemberStream(const SharedPtr<SeekableReadStream> &parent, const SharedPtr<Mutex> &parentMutex,
+                                 uint32 dataOffset, uint32 compressedSize, uint32 size, bool deflated)
+	: _parent(parent), _parentMutex(parentMutex), _dataOffset(dataOffset), _compressedSize(compressedSize), _size(size),
+	  _deflated(deflated), _pos(0), _err(false), _eos(false) {
+#ifdef USE_ZLIB
+	_streamInitialized = false;
+	_inBuffer = 0;
+	_compressedPos = 0;
+	// Keep at most 64 checkpoints; each one costs about 40KB of memory,
+	// mostly for the copy of the inflate window.
+	_checkpointInterval = MAX<uint32>(1024 * 1024, _size / 64);
+	_nextCheckpoint = _checkpointInterval;
+#endif
+}
+
+ZipMemberStream::~ZipMemberStream() {
+#ifdef USE_ZLIB
+	for (uint i = 0; i < _checkpoints.size(); ++i) {
+		inflateEnd(_checkpoints[i].stream);
+		delete _checkpoints[i].stream;
+	}
+	if (_streamInitialized)
+		inflateEnd(&_stream);
+	free(_inBuffer);
+#endif
+}
+
+bool ZipMemberStream::init() {
+	if (!_deflated)
+		return _compressedSize == _size;
+
+#ifdef USE_ZLIB
+	_inBuffer = (byte *)malloc(UNZ_BUFSIZE);
+	if (!_inBuffer)
+		return false;
+
+	memset(&_stream, 0, sizeof(_stream));
+	// Negative MAX_WBITS tells zlib there's no zlib header
+	if (inflateInit2(&_stream, -MAX_WBITS) != Z_OK)
+		return false;
+	_streamInitialized = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool ZipMemberStream::seek(int32 offset, int whence) {
+	int32 newPos = 0;
+	switch (whence) {
+	case SEEK_END:
+		newPos = _size + offset;
+		break;
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offset;
+		break;
+	}
+
+	assert((newPos >= 0) && (newPos <= (int32)_size));
+
+	_eos = false;
+
+#ifdef USE_ZLIB
+	if (_deflated && (uint32)newPos != _pos) {
+		if (!restart(newPos))
+			return false;
+
+		// Inflate and drop everything up to the requested position
+		byte skipBuffer[4096];
+		while (_pos < (uint32)newPos && !_err)
+			decompress(skipBuffer, MIN<uint32>(sizeof(skipBuffer), newPos - _pos));
+
+		return !_err;
+	}
+#endif
+
+	_pos = newPos;
+	return true;
+}
+
+uint32 ZipMemberStream::read(void *dataPtr, uint32 dataSize) {
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+	if (dataSize == 0 || _err)
+		return 0;
+
+#ifdef USE_ZLIB
+	if (_deflated)
+		return decompress((byte *)dataPtr, dataSize);
+#endif
+
+	uint32 bytesRead;
+	{
+		ZipStreamLock lock(_parentMutex);
+		_parent->seek(_dataOffset + _pos, SEEK_SET);
+		bytesRead = _parent->read(dataPtr, dataSize);
+	}
+
+	if (bytesRead != dataSize)
+		_err = true;
+	_pos += bytesRead;
+	return bytesRead;
+}
+
+#ifdef USE_ZLIB
+
+uint32 ZipMemberStream::inflateData(byte *dst, uint32 len) {
+	_stream.next_out = dst;
+	_stream.avail_out = len;
+
+	while (_stream.avail_out > 0) {
+		// Once all input has been fetched, zlib may still hold back output
+		// from it, so keep inflating until it reports the end
+		const uint32 chunk = MIN<uint32>(UNZ_BUFSIZE, _compressedSize - _compressedPos);
+		if (_stream.avail_in == 0 && chunk > 0) {
+			uint32 bytesRead;
+			{
+				ZipStreamLock lock(_parentMutex);
+				_parent->seek(_dataOffset + _compressedPos, SEEK_SET);
+				bytesRead = _parent->read(_inBuffer, chunk);
+			}
+
+			if (bytesRead != chunk) {
+				_err = true;
+				break;
+			}
+
+			_compressedPos += chunk;
+			_stream.next_in = _inBuffer;
+			_stream.avail_in = chunk;
+		}
+
+		int zerr = inflate(&_stream, Z_SYNC_FLUSH);
+		if (zerr == Z_STREAM_END)
+			break;
+		// Z_BUF_ERROR without any input left means the member ended
+		// before its uncompressed size was reached
+		if (zerr != Z_OK) {
+			_err = true;
+			break;
+		}
+	}
+
+	return len - _stream.avail_out;
+}
+
+uint32 ZipMemberStream::decompress(byte *dst, uint32 len) {
+	uint32 total = 0;
+
+	while (total < len && !_err) {
+		// Stop at the next checkpoint, so that the inflate state can be
+		// copied at exactly that position
+		uint32 chunk = len - total;
+		if (_pos < _nextCheckpoint)
+			chunk = MIN<uint32>(chunk, _nextCheckpoint - _pos);
+
+		uint32 bytesInflated = inflateData(dst + total, chunk);
+		total += bytesInflated;
+		_pos += bytesInflated;
+
+		if (_pos == _nextCheckpoint)
+			addCheckpoint();
+
+		if (bytesInflated < chunk) {
+			// Z_STREAM_END before the expected size
+			_err = true;
+			break;
+		}
+	}
+
+	return total;
+}
+
+void ZipMemberStream::addCheckpoint() {
+	_nextCheckpoint += _checkpointInterval;
+
+	// Checkpoints near the end of the member are not worth the memory
+	if (_pos >= _size - MIN<uint32>(_size, _checkpointInterval / 2))
+		return;
+
+	// zlib ties the inflate state to the address of its z_stream, so the
+	// copy has to live on the heap rather than inside the array.
+	Checkpoint checkpoint;
+	checkpoint.stream = new z_stream;
+	memset(checkpoint.stream, 0, sizeof(z_stream));
+	if (inflateCopy(checkpoint.stream, &_stream) != Z_OK) {
+		delete checkpoint.stream;
+		return;
+	}
+
+	// The copy points into the input buffer, which will have been refilled
+	// by the time the checkpoint is used, so remember how much input has
+	// actually been consumed and refetch from there.
+	checkpoint.stream->next_in = Z_NULL;
+	checkpoint.stream->avail_in = 0;
+	checkpoint.pos = _pos;
+	checkpoint.compressedPos = _compressedPos - _stream.avail_in;
+	_checkpoints.push_back(checkpoint);
+}
+
+bool ZipMemberStream::restart(uint32 target) {
+	// Find the last checkpoint before the target position
+	const Checkpoint *best = 0;
+	for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].pos <= target; ++i)
+		best = &_checkpoints[i];
+
+	if (best) {
+		// Keep inflating from the current position if that is closer
+		if (target >= _pos && _pos >= best->pos)
+			return true;
+
+		inflateEnd(&_stream);
+		_streamInitialized = false;
+		if (inflateCopy(&_stream, best->stream) != Z_OK) {
+			_err = true;
+			return false;
+		}
+		_streamInitialized = true;
+		_pos = best->pos;
+		_compressedPos = best->compressedPos;
+	} else {
+		if (target >= _pos)
+			return true;
+
+		if (inflateReset(&_stream) != Z_OK) {
+			_err = true;
+			return false;
+		}
+		_pos = 0;
+		_compressedPos = 0;
+	}
+
+	_stream.next_in = Z_NULL;
+	_stream.avail_in = 0;
+	_err = false;
+	return true;
+}
+
+#endif // USE_ZLIB
+
 ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
 	assert(_zipFile);
 }
@@ -1483,6 +1838,9 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	// Streamed members may be in use in other threads
+	ZipStreamLock lock(((const unz_s *)_zipFile)->_streamMutex);
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
@@ -1493,6 +1851,25 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
+	if (fileInfo.uncompressed_size > ZIP_STREAMING_THRESHOLD) {
+		const unz_s *const archive = (const unz_s *)_zipFile;
+		const file_in_zip_read_info_s *const info = archive->pfile_in_zip_read;
+
+		ZipMemberStream *stream = new ZipMemberStream(archive->_streamRef, archive->_streamMutex,
+			info->pos_in_zipfile + info->byte_before_the_zipfile,
+			fileInfo.compressed_size, fileInfo.uncompressed_size,
+			fileInfo.compression_method != 0);
+		unzCloseCurrentFile(_zipFile);
+
+		// Streamed members are not CRC checked, since that would mean
+		// reading them completely up front.
+		if (!stream->init()) {
+			delete stream;
+			return 0;
+		}
+		return stream;
+	}
+
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
 	assert(buffer);
 
@@ -1507,11 +1884,6 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -53,6 +53,11 @@ Archive *makeZipArchive(const FSNode &node);
  * ZipArchive is deleted.
  *
  * May return 0 in case of a failure. In this case stream will still be deleted.
+ *
+ * Members of more than 256KB are not inflated into memory when they are
+ * opened; the returned streams read and inflate them from the archive stream
+ * as needed. Unlike the smaller ones, such members are not CRC checked, since
+ * that would mean reading them completely up front.
  */
 Archive *makeZipArchive(SeekableReadStream *stream);
 
@@ -0,0 +1,120 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/workerpool.h"
+
+namespace Common {
+
+WorkerPool::WorkerPool(uint threadCount) : _jobsQueued(0), _jobsFinished(0), _mutex(0), _pending(0) {
+	if (!g_system)
+		return;
+
+	if (threadCount == 0)
+		threadCount = g_system->getCPUCount() - 1;
+
+	if (threadCount == 0)
+		return;
+
+	_jobsQueued = g_system->createSemaphore(0);
+	_jobsFinished = g_system->createSemaphore(0);
+
+	if (!_jobsQueued || !_jobsFinished)
+		return;
+
+	_mutex = new Mutex();
+
+	for (uint i = 0; i < threadCount; i++) {
+		OSystem::ThreadRef thread = g_system->createThread(runWorker, this);
+		if (!thread)
+			break;
+
+		_threads.push_back(thread);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	wait();
+
+	// A job without a function tells the worker picking it up to quit
+	for (uint i = 0; i < _threads.size(); i++)
+		queueJob(0, 0);
+
+	for (uint i = 0; i < _threads.size(); i++)
+		g_system->waitThread(_threads[i]);
+
+	delete _mutex;
+
+	if (_jobsQueued)
+		g_system->deleteSemaphore(_jobsQueued);
+	if (_jobsFinished)
+		g_system->deleteSemaphore(_jobsFinished);
+}
+
+void WorkerPool::addJob(JobProc proc, void *param) {
+	assert(proc);
+
+	if (_threads.empty()) {
+		proc(param);
+		return;
+	}
+
+	queueJob(proc, param);
+	_pending++;
+}
+
+void WorkerPool::wait() {
+	for (; _pending > 0; _pending--)
+		g_system->waitSemaphore(_jobsFinished);
+}
+
+void WorkerPool::queueJob(JobProc proc, void *param) {
+	Job job;
+	job.proc = proc;
+	job.param = param;
+
+	_mutex->lock();
+	_jobs.push(job);
+	_mutex->unlock();
+
+	g_system->postSemaphore(_jobsQueued);
+}
+
+void WorkerPool::runWorker(void *param) {
+	WorkerPool *pool = (WorkerPool *)param;
+
+	while (true) {
+		g_system->waitSemaphore(pool->_jobsQueued);
+
+		pool->_mutex->lock();
+		Job job = pool->_jobs.pop();
+		pool->_mutex->unlock();
+
+		if (!job.proc)
+			break;
+
+		job.proc(job.param);
+
+		g_system->postSemaphore(pool->_jobsFinished);
+	}
+}
+
+} // End of namespace Common
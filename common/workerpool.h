@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_WORKERPOOL_H
+#define COMMON_WORKERPOOL_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/queue.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * A small set of worker threads running jobs queued by a single owner
+ * thread, built on the optional OSystem thread API.
+ *
+ * If the backend can not start threads, or no threads were requested,
+ * addJob() simply runs each job right away on the calling thread. Code
+ * using a pool thus behaves the same everywhere, it just does not run
+ * anything in parallel on such systems.
+ *
+ * Jobs must follow the restrictions for code running in worker threads,
+ * see OSystem::createThread().
+ */
+class WorkerPool : NonCopyable {
+public:
+	typedef void (*JobProc)(void *param);
+
+	/**
+	 * Start the worker threads.
+	 *
+	 * @param threadCount	Number of threads to start. If 0, one thread
+	 *                      less than the number of CPU cores is used,
+	 *                      since the owner thread is usually busy as well.
+	 */
+	explicit WorkerPool(uint threadCount = 0);
+
+	/** Wait for all queued jobs, then stop the threads. */
+	~WorkerPool();
+
+	/**
+	 * Return the number of running worker threads, or 0 if jobs are run
+	 * by addJob() directly.
+	 */
+	uint getThreadCount() const { return _threads.size(); }
+
+	/** Queue a job calling proc(param). */
+	void addJob(JobProc proc, void *param);
+
+	/** Wait until all jobs queued so far have finished. */
+	void wait();
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+	};
+
+	Array<OSystem::ThreadRef> _threads;
+	OSystem::SemaphoreRef _jobsQueued;   ///< posted once per queued job
+	OSystem::SemaphoreRef _jobsFinished; ///< posted once per finished job
+
+	Mutex *_mutex;     ///< protects _jobs
+	Queue<Job> _jobs;
+	uint _pending;     ///< jobs queued but not yet waited for, only used by the owner
+
+	void queueJob(JobProc proc, void *param);
+	static void runWorker(void *pool);
+};
+
+} // End of namespace Common
+
+#endif
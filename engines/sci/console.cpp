@@ -92,6 +92,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("opcodes",			WRAP_METHOD(Console, cmdOpcodes));
 	DCmd_Register("selector",			WRAP_METHOD(Console, cmdSelector));
 	DCmd_Register("selectors",			WRAP_METHOD(Console, cmdSelectors));
+	DCmd_Register("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	DCmd_Register("functions",			WRAP_METHOD(Console, cmdKernelFunctions));
 	DCmd_Register("class_table",		WRAP_METHOD(Console, cmdClassTable));
 	// Parser
@@ -138,6 +139,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("pi",                 WRAP_METHOD(Console, cmdPlaneItemList));	// alias
 	DCmd_Register("saved_bits",         WRAP_METHOD(Console, cmdSavedBits));
 	DCmd_Register("show_saved_bits",    WRAP_METHOD(Console, cmdShowSavedBits));
+	DCmd_Register("gfx_cache",          WRAP_METHOD(Console, cmdGfxCache));
+	DCmd_Register("dirty_rects",        WRAP_METHOD(Console, cmdDirtyRects));
 	// Segments
 	DCmd_Register("segment_table",		WRAP_METHOD(Console, cmdPrintSegmentTable));
 	DCmd_Register("segtable",			WRAP_METHOD(Console, cmdPrintSegmentTable));	// alias
@@ -329,6 +332,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" opcodes - Lists the opcode names\n");
 	DebugPrintf(" selectors - Lists the selector names\n");
 	DebugPrintf(" selector - Attempts to find the requested selector by name\n");
+	DebugPrintf(" selector_cache - Shows the statistics of the selector lookup cache\n");
 	DebugPrintf(" functions - Lists the kernel functions\n");
 	DebugPrintf(" class_table - Shows the available classes\n");
 	DebugPrintf("\n");
@@ -375,6 +379,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" plane_items / pi - Shows a list of all items for a plane (SCI2+)\n");
 	DebugPrintf(" saved_bits - List saved bits on the hunk\n");
 	DebugPrintf(" show_saved_bits - Display saved bits\n");
+	DebugPrintf(" gfx_cache - Shows the statistics of the view and font cache\n");
+	DebugPrintf(" dirty_rects - Shows the statistics of the redrawn screen areas, and shows them on screen (SCI2+)\n");
 	DebugPrintf("\n");
 	DebugPrintf("Segments:\n");
 	DebugPrintf(" segment_table / segtable - Lists all segments\n");
@@ -583,6 +589,28 @@ bool Console::cmdSelectors(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows the statistics of the selector lookup cache.\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		DebugPrintf("With 'reset', the counters are reset afterwards\n");
+		return true;
+	}
+
+	SelectorLookupCache &cache = _engine->_gamestate->_segMan->getSelectorLookupCache();
+	const uint32 lookups = cache.getHits() + cache.getMisses();
+
+	DebugPrintf("Entries: %d\n", cache.getSize());
+	DebugPrintf("Lookups: %d, hits: %d (%d%%), misses: %d\n", lookups, cache.getHits(),
+				lookups ? (int)((uint64)cache.getHits() * 100 / lookups) : 0, cache.getMisses());
+	DebugPrintf("Invalidations: %d\n", cache.getInvalidations());
+
+	if (argc == 2)
+		cache.resetCounters();
+
+	return true;
+}
+
 bool Console::cmdKernelFunctions(int argc, const char **argv) {
 	DebugPrintf("Kernel function names in numeric order:\n");
 	for (uint seeker = 0; seeker <  _engine->getKernel()->getKernelNamesSize(); seeker++) {
@@ -1850,6 +1878,75 @@ bool Console::cmdParseGrammar(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGfxCache(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows the statistics of the view and font cache.\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		DebugPrintf("With 'reset', the counters are reset afterwards\n");
+		return true;
+	}
+
+	GfxCache *cache = _engine->_gfxCache;
+	const uint32 lookups = cache->getHits() + cache->getMisses();
+
+	DebugPrintf("Views: %d, fonts: %d\n", cache->getViewCount(), cache->getFontCount());
+	DebugPrintf("Memory: %d of %d KB\n", cache->getMemoryUsage() / 1024, cache->getBudget() / 1024);
+	DebugPrintf("Lookups: %d, hits: %d (%d%%), misses: %d\n", lookups, cache->getHits(),
+				lookups ? (int)((uint64)cache->getHits() * 100 / lookups) : 0, cache->getMisses());
+	DebugPrintf("Evictions: %d\n", cache->getEvictions());
+
+	if (argc == 2)
+		cache->resetCounters();
+
+	return true;
+}
+
+bool Console::cmdDirtyRects(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "on") && strcmp(argv[1], "off") && strcmp(argv[1], "reset") &&
+					 strcmp(argv[1], "full") && strcmp(argv[1], "partial"))) {
+		DebugPrintf("Shows the statistics of the screen areas redrawn by kFrameOut.\n");
+		DebugPrintf("Usage: %s [on | off | reset | full | partial]\n", argv[0]);
+		DebugPrintf("With 'on' or 'off', an outline of the redrawn areas is shown or hidden\n");
+		DebugPrintf("With 'reset', the counters are reset afterwards\n");
+		DebugPrintf("With 'full', the whole screen is redrawn in every frame, 'partial' switches back\n");
+		DebugPrintf("to redrawing the changed areas only. The default is set by the sci_full_redraw\n");
+		DebugPrintf("config key.\n");
+		return true;
+	}
+
+#ifdef ENABLE_SCI32
+	GfxFrameout *frameout = _engine->_gfxFrameout;
+
+	if (!frameout) {
+		DebugPrintf("This SCI version does not have a list of planes\n");
+		return true;
+	}
+
+	const uint32 frames = frameout->getFramesDrawn() + frameout->getFramesSkipped();
+
+	DebugPrintf("Frames: %d, drawn: %d, skipped: %d (%d%%)\n", frames, frameout->getFramesDrawn(),
+				frameout->getFramesSkipped(), frames ? (int)((uint64)frameout->getFramesSkipped() * 100 / frames) : 0);
+	DebugPrintf("Full redraws: %d\n", frameout->getFullRedraws());
+	DebugPrintf("Pixels copied: %d, per drawn frame: %d\n", frameout->getPixelsCopied(),
+				frameout->getFramesDrawn() ? frameout->getPixelsCopied() / frameout->getFramesDrawn() : 0);
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "reset"))
+			frameout->resetCounters();
+		else if (!strcmp(argv[1], "full") || !strcmp(argv[1], "partial"))
+			frameout->setAlwaysFullRedraw(!strcmp(argv[1], "full"));
+		else
+			frameout->showDirtyRects(!strcmp(argv[1], "on"));
+	}
+
+	DebugPrintf("Overlay: %s\n", frameout->isShowingDirtyRects() ? "on" : "off");
+	DebugPrintf("Redrawing: %s\n", frameout->isAlwaysFullRedraw() ? "full screen" : "changed areas");
+#else
+	DebugPrintf("SCI32 isn't included in this compiled executable\n");
+#endif
+	return true;
+}
+
 bool Console::cmdPrintSegmentTable(int argc, const char **argv) {
 	DebugPrintf("Segment table:\n");
 
@@ -55,6 +55,7 @@ private:
 	bool cmdOpcodes(int argc, const char **argv);
 	bool cmdSelector(int argc, const char **argv);
 	bool cmdSelectors(int argc, const char **argv);
+	bool cmdSelectorCache(int argc, const char **argv);
 	bool cmdKernelFunctions(int argc, const char **argv);
 	bool cmdClassTable(int argc, const char **argv);
 	// Parser
@@ -98,6 +99,8 @@ private:
 	bool cmdPlaneItemList(int argc, const char **argv);
 	bool cmdSavedBits(int argc, const char **argv);
 	bool cmdShowSavedBits(int argc, const char **argv);
+	bool cmdGfxCache(int argc, const char **argv);
+	bool cmdDirtyRects(int argc, const char **argv);
 	// Segments
 	bool cmdPrintSegmentTable(int argc, const char **argv);
 	bool cmdSegmentInfo(int argc, const char **argv);
@@ -768,6 +768,9 @@ reg_t kPalCycle(EngineState *s, int argc, reg_t *argv) {
 reg_t kRemapColors32(EngineState *s, int argc, reg_t *argv) {
 	uint16 operation = argv[0].toUint16();
 
+	// Remapping changes the colors of views that are already on screen
+	g_sci->_gfxFrameout->invalidate();
+
 	switch (operation) {
 	case 0:	{ // turn remapping off
 		// WORKAROUND: Game scripts in QFG4 erroneously turn remapping off in room
@@ -110,8 +110,10 @@ reg_t kStrAt(EngineState *s, int argc, reg_t *argv) {
 	// FIXME: Move this to segman
 	if (dest_r.isRaw) {
 		value = dest_r.raw[offset];
-		if (argc > 2) /* Request to modify this char */
+		if (argc > 2) { /* Request to modify this char */
 			dest_r.raw[offset] = newvalue;
+			s->_segMan->invalidateInstructions(make_reg(argv[0].getSegment(), argv[0].getOffset() + offset), 1);
+		}
 	} else {
 		if (dest_r.skipByte)
 			offset++;
@@ -598,6 +600,7 @@ reg_t kMessage(EngineState *s, int argc, reg_t *argv) {
 				WRITE_LE_UINT16(buffer + 4, msg.verb);
 				WRITE_LE_UINT16(buffer + 6, msg.cond);
 				WRITE_LE_UINT16(buffer + 8, msg.seq);
+				s->_segMan->invalidateInstructions(argv[1], 10);
 			}
 		} else {
 			reg_t *buffer = s->_segMan->derefRegPtr(argv[1], 5);
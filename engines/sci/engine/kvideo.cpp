@@ -41,6 +41,7 @@
 #include "sci/video/seq_decoder.h"
 #ifdef ENABLE_SCI32
 #include "video/coktel_decoder.h"
+#include "sci/graphics/frameout.h"
 #include "sci/video/robot_decoder.h"
 #endif
 
@@ -129,6 +130,12 @@ void playVideo(Video::VideoDecoder *videoDecoder, VideoState videoState) {
 
 	delete[] scaleBuffer;
 	delete videoDecoder;
+
+#ifdef ENABLE_SCI32
+	// The video was drawn over the last frame of kFrameOut
+	if (g_sci->_gfxFrameout)
+		g_sci->_gfxFrameout->invalidate();
+#endif
 }
 
 reg_t kShowMovie(EngineState *s, int argc, reg_t *argv) {
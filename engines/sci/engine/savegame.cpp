@@ -478,6 +478,9 @@ void Script::syncStringHeap(Common::Serializer &s) {
 	} else if (getSciVersion() == SCI_VERSION_3) {
 		warning("TODO: syncStringHeap(): Implement SCI3 variant");
 	}
+
+	if (s.isLoading())
+		invalidateInstructionCache();
 }
 
 void Script::saveLoadWithSerializer(Common::Serializer &s) {
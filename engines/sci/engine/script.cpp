@@ -63,6 +63,56 @@ void Script::freeScript() {
 	_lockers = 1;
 	_markedAsDeleted = false;
 	_objects.clear();
+
+	invalidateInstructionCache();
+}
+
+const PMachineInstruction &Script::getInstruction(uint32 offset) {
+	assert(offset < _bufSize);
+
+	if (_instructionIndex.empty())
+		_instructionIndex.resize(_bufSize);
+
+	const uint16 index = _instructionIndex[offset];
+	if (index)
+		return _instructions[index - 1];
+
+	PMachineInstruction instruction;
+	instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.params);
+
+	// Every instruction takes at least one byte, so this only happens with
+	// scripts larger than 64KB
+	if (_instructions.size() == 0xFFFF) {
+		_uncachedInstruction = instruction;
+		return _uncachedInstruction;
+	}
+
+	_instructions.push_back(instruction);
+	_instructionIndex[offset] = _instructions.size();
+	return _instructions.back();
+}
+
+void Script::invalidateInstructionCache() {
+	_instructions.clear();
+	_instructionIndex.clear();
+}
+
+void Script::invalidateInstructionCache(uint32 offset, uint32 size) {
+	if (_instructionIndex.empty() || offset >= _bufSize)
+		return;
+
+	// Data written to a script is mostly a string or a variable, not code.
+	// Only drop the cache if the range overlaps a decoded instruction,
+	// which may start up to the size of the longest instruction earlier.
+	const uint32 end = MIN<uint32>(_bufSize, offset + MIN<uint32>(size, _bufSize));
+	const uint32 start = offset >= kMaxInstructionSize ? offset - kMaxInstructionSize + 1 : 0;
+	for (uint32 i = start; i < end; i++) {
+		const uint16 index = _instructionIndex[i];
+		if (index && i + _instructions[index - 1].size > offset) {
+			invalidateInstructionCache();
+			return;
+		}
+	}
 }
 
 void Script::load(int script_nr, ResourceManager *resMan) {
@@ -463,6 +513,7 @@ void Script::mcpyInOut(int dst, const void *src, size_t n) {
 	if (_buf) {
 		assert(dst + n <= _bufSize);
 		memcpy(_buf + dst, src, n);
+		invalidateInstructionCache(dst, n);
 	}
 }
 
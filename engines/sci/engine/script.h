@@ -74,6 +74,14 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	enum {
+		kMaxInstructionSize = 9 /**< An opcode and up to four word parameters */
+	};
+
+	Common::Array<PMachineInstruction> _instructions; /**< Instructions decoded so far */
+	Common::Array<uint16> _instructionIndex; /**< Per offset, index + 1 into _instructions, or 0 if not decoded yet */
+	PMachineInstruction _uncachedInstruction; /**< Used once _instructions is full */
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -98,6 +106,30 @@ public:
 	void freeScript();
 	void load(int script_nr, ResourceManager *resMan);
 
+	/**
+	 * Returns the instruction at the specified offset. Every instruction is
+	 * decoded only once, when it is executed for the first time, and kept
+	 * until the script is unloaded or modified.
+	 * @param offset	script-relative offset of the instruction
+	 * @return			the decoded instruction; the reference is only valid
+	 *					until the next call
+	 */
+	const PMachineInstruction &getInstruction(uint32 offset);
+
+	/**
+	 * Drops all decoded instructions. Must be called whenever the script
+	 * buffer is modified.
+	 */
+	void invalidateInstructionCache();
+
+	/**
+	 * Drops all decoded instructions if any of them was decoded from the
+	 * given range of the script buffer, which has been written to.
+	 * @param offset	script-relative offset of the written bytes
+	 * @param size		number of written bytes
+	 */
+	void invalidateInstructionCache(uint32 offset, uint32 size);
+
 	void matchSignatureAndPatch(uint16 scriptNr, byte *scriptData, const uint32 scriptSize);
 	int32 findSignature(const SciScriptSignature *signature, const byte *scriptData, const uint32 scriptSize);
 	void applyPatch(const uint16 *patch, byte *scriptData, const uint32 scriptSize, int32 signatureOffset);
@@ -156,6 +156,7 @@ void SegManager::deallocate(SegmentId seg) {
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
 		_scriptSegMap.erase(scr->getScriptNumber());
+		_selectorLookupCache.invalidate();
 		if (scr->getLocalsSegment()) {
 			// Check if the locals segment has already been deallocated.
 			// If the locals block has been stored in a segment with an ID
@@ -513,6 +514,12 @@ SegmentRef SegManager::dereference(reg_t pointer) {
 	return mobj->dereference(pointer);
 }
 
+void SegManager::invalidateInstructions(reg_t dest, uint32 size) {
+	Script *script = (Script *)getSegment(dest.getSegment(), SEG_TYPE_SCRIPT);
+	if (script)
+		script->invalidateInstructionCache(dest.getOffset(), size);
+}
+
 static void *derefPtr(SegManager *segMan, reg_t pointer, int entries, bool wantRaw) {
 	SegmentRef ret = segMan->dereference(pointer);
 
@@ -608,6 +615,7 @@ void SegManager::strncpy(reg_t dest, const char* src, size_t n) {
 			::strcpy((char *)dest_r.raw, src);
 		else
 			::strncpy((char *)dest_r.raw, src, n);
+		invalidateInstructions(dest, MIN<size_t>(::strlen(src) + 1, n));
 	} else {
 		// raw -> non-raw
 		for (uint i = 0; i < n; i++) {
@@ -652,12 +660,14 @@ void SegManager::strncpy(reg_t dest, reg_t src, size_t n) {
 		strncpy(dest, (const char*)src_r.raw, n);
 	} else if (dest_r.isRaw && !src_r.isRaw) {
 		// non-raw -> raw
-		for (uint i = 0; i < n; i++) {
+		uint i;
+		for (i = 0; i < n; i++) {
 			char c = getChar(src_r, i);
 			dest_r.raw[i] = c;
 			if (!c)
 				break;
 		}
+		invalidateInstructions(dest, i + 1);
 	} else {
 		// non-raw -> non-raw
 		for (uint i = 0; i < n; i++) {
@@ -691,6 +701,7 @@ void SegManager::memcpy(reg_t dest, const byte* src, size_t n) {
 	if (dest_r.isRaw) {
 		// raw -> raw
 		::memcpy((char *)dest_r.raw, src, n);
+		invalidateInstructions(dest, n);
 	} else {
 		// raw -> non-raw
 		for (uint i = 0; i < n; i++)
@@ -724,6 +735,7 @@ void SegManager::memcpy(reg_t dest, reg_t src, size_t n) {
 	} else if (dest_r.isRaw) {
 		// * -> raw
 		memcpy(dest_r.raw, src, n);
+		invalidateInstructions(dest, n);
 	} else {
 		// non-raw -> non-raw
 		for (uint i = 0; i < n; i++) {
@@ -981,6 +993,7 @@ int SegManager::instantiateScript(int scriptNum) {
 	scr->initializeLocals(this);
 	scr->initializeClasses(this);
 	scr->initializeObjects(this, segmentId);
+	_selectorLookupCache.invalidate();
 
 	return segmentId;
 }
@@ -269,6 +269,16 @@ public:
 	 */
 	SegmentRef dereference(reg_t pointer);
 
+	/**
+	 * Drops the decoded instructions of a script if raw data written to it
+	 * overlaps them. Must be called by everything which writes to memory
+	 * obtained with dereference() or derefBulkPtr(), except via the string
+	 * and memory functions below, which already do so.
+	 * @param[in] dest	Address of the first written byte
+	 * @param[in] size	Number of written bytes
+	 */
+	void invalidateInstructions(reg_t dest, uint32 size);
+
 	/**
 	 * Dereferences a heap pointer pointing to raw memory.
 	 * @param pointer The pointer to dereference
@@ -441,6 +451,9 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/** Returns the cache used by lookupSelector(). */
+	SelectorLookupCache &getSelectorLookupCache() { return _selectorLookupCache; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -449,6 +462,8 @@ private:
 
 	ResourceManager *_resMan;
 
+	SelectorLookupCache _selectorLookupCache;
+
 	SegmentId _clonesSegId; ///< ID of the (a) clones segment
 	SegmentId _listsSegId; ///< ID of the (a) list segment
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
@@ -250,6 +250,45 @@ void invokeSelector(EngineState *s, reg_t object, int selectorId,
 	run_vm(s); // Start a new vm
 }
 
+bool SelectorLookupCache::makeKey(const Object *obj, Selector selectorId, Key &key) const {
+	key.baseObj = obj->getBaseObject();
+	key.superClass = obj->getSuperClassSelector();
+	key.selectorId = selectorId;
+	return key.baseObj != NULL;
+}
+
+const SelectorLookupCache::Entry *SelectorLookupCache::find(const Object *obj, Selector selectorId) {
+	Key key;
+	if (makeKey(obj, selectorId, key)) {
+		EntryMap::const_iterator it = _entries.find(key);
+		if (it != _entries.end()) {
+			_hits++;
+			return &it->_value;
+		}
+	}
+
+	_misses++;
+	return NULL;
+}
+
+void SelectorLookupCache::add(const Object *obj, Selector selectorId, const Entry &entry) {
+	Key key;
+	if (!makeKey(obj, selectorId, key))
+		return;
+
+	if (_entries.size() >= kMaxEntries)
+		invalidate();
+	_entries[key] = entry;
+}
+
+void SelectorLookupCache::invalidate() {
+	if (_entries.empty())
+		return;
+
+	_entries.clear();
+	_invalidations++;
+}
+
 SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr) {
 	const Object *obj = segMan->getObject(obj_location);
 	int index;
@@ -265,34 +304,46 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				PRINT_REG(obj_location));
 	}
 
-	index = obj->locateVarSelector(segMan, selectorId);
+	SelectorLookupCache &cache = segMan->getSelectorLookupCache();
+	const SelectorLookupCache::Entry *cached = cache.find(obj, selectorId);
+	SelectorLookupCache::Entry entry;
 
-	if (index >= 0) {
-		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
-		}
-		return kSelectorVariable;
+	if (cached) {
+		entry = *cached;
 	} else {
-		// Check if it's a method, with recursive lookup in superclasses
-		while (obj) {
-			index = obj->funcSelectorPosition(selectorId);
-			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
-
-				return kSelectorMethod;
-			} else {
-				obj = segMan->getObject(obj->getSuperClassSelector());
+		entry.type = kSelectorNone;
+		entry.varIndex = obj->locateVarSelector(segMan, selectorId);
+		entry.function = NULL_REG;
+
+		if (entry.varIndex >= 0) {
+			// Found it as a variable
+			entry.type = kSelectorVariable;
+		} else {
+			// Check if it's a method, with recursive lookup in superclasses
+			const Object *owner = obj;
+			while (owner) {
+				index = owner->funcSelectorPosition(selectorId);
+				if (index >= 0) {
+					entry.type = kSelectorMethod;
+					entry.function = owner->getFunction(index);
+					break;
+				} else {
+					owner = segMan->getObject(owner->getSuperClassSelector());
+				}
 			}
 		}
 
-		return kSelectorNone;
+		cache.add(obj, selectorId, entry);
 	}
 
+	if (entry.type == kSelectorVariable && varp) {
+		varp->obj = obj_location;
+		varp->varindex = entry.varIndex;
+	} else if (entry.type == kSelectorMethod && fptr) {
+		*fptr = entry.function;
+	}
 
-//	return _lookupSelector_function(segMan, obj, selectorId, fptr);
+	return entry.type;
 }
 
 } // End of namespace Sci
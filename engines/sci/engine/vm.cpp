@@ -22,6 +22,7 @@
 
 #include "common/debug.h"
 #include "common/debug-channels.h"
+#include "common/system.h"
 
 #include "sci/sci.h"
 #include "sci/console.h"
@@ -528,13 +529,67 @@ int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4])
 	return offset;
 }
 
+/**
+ * Statistics of the VM, reported through the VMStats debug channel. Playing
+ * back a recording with the event recorder and this channel enabled gives
+ * a repeatable benchmark of the VM.
+ */
+static struct {
+	uint32 instructions;	///< Instructions executed since the last report
+	uint32 time;			///< Milliseconds spent in run_vm() since the last report
+	uint32 lastReport;		///< Time of the last report
+	int depth;				///< Nesting level of run_vm()
+} vmStats = { 0, 0, 0, 0 };
+
+enum {
+	kVMStatsInterval = 1000
+};
+
+/**
+ * Measures the time spent in the outermost call of run_vm(), and reports
+ * the instructions per second of it in regular intervals.
+ */
+class VMStatsTimer {
+public:
+	VMStatsTimer() : _start(0) {
+		if (vmStats.depth++ != 0)
+			return;
+
+		if (DebugMan.isDebugChannelEnabled(kDebugLevelVMStats))
+			_start = g_system->getMillis();
+		else
+			vmStats.instructions = 0;
+	}
+
+	~VMStatsTimer() {
+		if (--vmStats.depth != 0 || !_start)
+			return;
+
+		const uint32 now = g_system->getMillis();
+		vmStats.time += now - _start;
+		if (now - vmStats.lastReport < kVMStatsInterval)
+			return;
+
+		debugC(kDebugLevelVMStats, "VM: %d instructions in %d ms (%d instructions per second)",
+				vmStats.instructions, vmStats.time,
+				vmStats.time ? (uint32)((uint64)vmStats.instructions * 1000 / vmStats.time) : 0);
+		vmStats.instructions = 0;
+		vmStats.time = 0;
+		vmStats.lastReport = now;
+	}
+
+private:
+	uint32 _start;
+};
+
 void run_vm(EngineState *s) {
 	assert(s);
 
+	VMStatsTimer statsTimer;
+
 	int temp;
 	reg_t r_temp; // Temporary register
 	StackPtr s_temp; // Temporary stack pointer
-	int16 opparams[4]; // opcode parameters
 
 	s->r_rest = 0;	// &rest adjusts the parameter count by this value
 	// Current execution data:
@@ -614,10 +669,14 @@ void run_vm(EngineState *s) {
 			error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
 			s->xs->addr.pc.getOffset(), scr->getBufSize());
 
-		// Get opcode
-		byte extOpcode;
-		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		// Get opcode. The instruction is copied, as executing it may load
+		// scripts or decode further instructions of this one.
+		const PMachineInstruction instruction = scr->getInstruction(s->xs->addr.pc.getOffset());
+		const int16 *opparams = instruction.params; // opcode parameters
+		const byte extOpcode = instruction.extOpcode;
 		const byte opcode = extOpcode >> 1;
+		s->xs->addr.pc.incOffset(instruction.size);
+		vmStats.instructions++;
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
 #ifdef ABORT_ON_INFINITE_LOOP
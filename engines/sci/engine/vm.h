@@ -28,6 +28,7 @@
 #include "sci/engine/vm_types.h"	// for reg_t
 #include "sci/resource.h"	// for SciVersion
 
+#include "common/hashmap.h"
 #include "common/util.h"
 
 namespace Sci {
@@ -348,6 +349,69 @@ void script_debug(EngineState *s);
 SelectorType lookupSelector(SegManager *segMan, reg_t obj, Selector selectorid,
 		ObjVarRef *varp, reg_t *fptr);
 
+/**
+ * Cache for the results of lookupSelector(). Objects which share their
+ * definition in the script buffer and their superclass also share the
+ * layout of their variables and methods, so the results are cached per
+ * definition, superclass and selector. The cache must be invalidated
+ * whenever scripts are loaded or unloaded.
+ */
+class SelectorLookupCache {
+public:
+	struct Entry {
+		SelectorType type;
+		int varIndex;		///< Index of the variable, for kSelectorVariable
+		reg_t function;		///< Address of the method, for kSelectorMethod
+	};
+
+	SelectorLookupCache() : _hits(0), _misses(0), _invalidations(0) {}
+
+	/** Returns the cached result for a lookup, or NULL if there is none. */
+	const Entry *find(const Object *obj, Selector selectorId);
+
+	/** Stores the result of a lookup. */
+	void add(const Object *obj, Selector selectorId, const Entry &entry);
+
+	/** Drops all cached results. */
+	void invalidate();
+
+	uint getSize() const { return _entries.size(); }
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+	uint32 getInvalidations() const { return _invalidations; }
+	void resetCounters() { _hits = _misses = _invalidations = 0; }
+
+private:
+	enum {
+		kMaxEntries = 8192	///< The cache is cleared when it grows beyond this
+	};
+
+	struct Key {
+		const byte *baseObj;
+		reg_t superClass;
+		Selector selectorId;
+
+		bool operator==(const Key &other) const {
+			return baseObj == other.baseObj && superClass == other.superClass && selectorId == other.selectorId;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const {
+			return (uint)(size_t)key.baseObj ^ (key.superClass.getOffset() << 7) ^ (key.superClass.getSegment() << 23) ^ (key.selectorId * 2654435761U);
+		}
+	};
+
+	bool makeKey(const Object *obj, Selector selectorId, Key &key) const;
+
+	typedef Common::HashMap<Key, Entry, KeyHash> EntryMap;
+	EntryMap _entries;
+
+	uint32 _hits;
+	uint32 _misses;
+	uint32 _invalidations;
+};
+
 /**
  * Read a PMachine instruction from a memory buffer and return its length.
  *
@@ -366,6 +430,15 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj, Selector selectorid,
  */
 int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4]);
 
+/**
+ * A decoded PMachine instruction, as cached by Script::getInstruction().
+ */
+struct PMachineInstruction {
+	byte extOpcode;		///< "extended" opcode, as returned by readPMachineInstruction()
+	byte size;			///< length of the instruction in bytes
+	int16 params[4];	///< parameters of the instruction
+};
+
 } // End of namespace Sci
 
 #endif // SCI_ENGINE_VM_H
@@ -328,12 +328,18 @@ void SciEngine::sleep(uint32 msecs) {
 	uint32 time;
 	const uint32 wakeup_time = g_system->getMillis() + msecs;
 
+	// Rooms get changed by the game scripts, so look out for room changes
+	// here, where the resource manager may use the idle time for prefetching
+	if (_gamestate && _gamestate->variables[VAR_GLOBAL])
+		_resMan->setCurrentRoom(_gamestate->currentRoomNumber());
+
 	while (true) {
 		// let backend process events and update the screen
 		_eventMan->getSciEvent(SCI_EVENT_PEEK);
 		time = g_system->getMillis();
 		if (time + 10 < wakeup_time) {
-			g_system->delayMillis(10);
+			if (!_resMan->prefetchNext(wakeup_time - time))
+				g_system->delayMillis(10);
 		} else {
 			if (time < wakeup_time)
 				g_system->delayMillis(wakeup_time - time);
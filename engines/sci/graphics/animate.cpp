@@ -588,6 +588,9 @@ void GfxAnimate::animateShowPic() {
 void GfxAnimate::kernelAnimate(reg_t listReference, bool cycle, int argc, reg_t *argv) {
 	byte old_picNotValid = _screen->_picNotValid;
 
+	// Views used in the previous frame may be evicted from now on
+	_cache->startFrame();
+
 	if (getSciVersion() >= SCI_VERSION_1_1)
 		_palette->palVaryUpdate();
 
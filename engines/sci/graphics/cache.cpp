@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/stack.h"
 #include "graphics/primitives.h"
@@ -35,7 +36,11 @@
 namespace Sci {
 
 GfxCache::GfxCache(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette)
-	: _resMan(resMan), _screen(screen), _palette(palette) {
+	: _resMan(resMan), _screen(screen), _palette(palette),
+	  _budget(kDefaultBudget), _memoryUsage(0), _useCounter(0), _frame(0), _hits(0), _misses(0), _evictions(0) {
+
+	if (ConfMan.hasKey("sci_gfx_cache_size"))
+		_budget = MAX(ConfMan.getInt("sci_gfx_cache_size"), 0) * 1024;
 }
 
 GfxCache::~GfxCache() {
@@ -45,8 +50,8 @@ GfxCache::~GfxCache() {
 
 void GfxCache::purgeFontCache() {
 	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.font;
+		iter->_value.font = 0;
 	}
 
 	_cachedFonts.clear();
@@ -54,36 +59,111 @@ void GfxCache::purgeFontCache() {
 
 void GfxCache::purgeViewCache() {
 	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.view;
+		iter->_value.view = 0;
 	}
 
 	_cachedViews.clear();
 }
 
+void GfxCache::evict() {
+	while (_memoryUsage > _budget) {
+		FontCache::iterator oldestFont = _cachedFonts.end();
+		ViewCache::iterator oldestView = _cachedViews.end();
+		uint32 oldestUse = _useCounter;
+
+		for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
+			if (iter->_value.lastFrame != _frame && iter->_value.lastUse < oldestUse) {
+				oldestFont = iter;
+				oldestUse = iter->_value.lastUse;
+			}
+		}
+		for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+			if (iter->_value.lastFrame != _frame && iter->_value.lastUse < oldestUse) {
+				oldestView = iter;
+				oldestUse = iter->_value.lastUse;
+			}
+		}
+
+		if (oldestView != _cachedViews.end()) {
+			debugC(kDebugLevelGraphics, "GfxCache: evicting view %d", oldestView->_key);
+			_memoryUsage -= oldestView->_value.size;
+			delete oldestView->_value.view;
+			_cachedViews.erase(oldestView);
+		} else if (oldestFont != _cachedFonts.end()) {
+			debugC(kDebugLevelGraphics, "GfxCache: evicting font %d", oldestFont->_key);
+			_memoryUsage -= oldestFont->_value.size;
+			delete oldestFont->_value.font;
+			_cachedFonts.erase(oldestFont);
+		} else {
+			// Everything left is pinned
+			break;
+		}
+
+		_evictions++;
+	}
+}
+
 GfxFont *GfxCache::getFont(GuiResourceId fontId) {
-	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
-		purgeFontCache();
-
-	if (!_cachedFonts.contains(fontId)) {
-		// Create special SJIS font in japanese games, when font 900 is selected
-		if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
-			_cachedFonts[fontId] = new GfxFontSjis(_screen, fontId);
-		else
-			_cachedFonts[fontId] = new GfxFontFromResource(_resMan, _screen, fontId);
+	FontCache::iterator iter = _cachedFonts.find(fontId);
+
+	if (iter != _cachedFonts.end()) {
+		_hits++;
+		iter->_value.lastUse = ++_useCounter;
+		iter->_value.lastFrame = _frame;
+		return iter->_value.font;
 	}
 
-	return _cachedFonts[fontId];
+	_misses++;
+
+	FontEntry entry;
+	// Create special SJIS font in japanese games, when font 900 is selected
+	if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN)) {
+		entry.font = new GfxFontSjis(_screen, fontId);
+		entry.size = 0;
+	} else {
+		entry.font = new GfxFontFromResource(_resMan, _screen, fontId);
+		Resource *resource = _resMan->testResource(ResourceId(kResourceTypeFont, fontId));
+		entry.size = resource ? resource->size : 0;
+	}
+	entry.lastUse = ++_useCounter;
+	entry.lastFrame = _frame;
+	_cachedFonts[fontId] = entry;
+	_memoryUsage += entry.size;
+
+	// The new font is pinned, so it is never evicted right away
+	evict();
+
+	return entry.font;
 }
 
 GfxView *GfxCache::getView(GuiResourceId viewId) {
-	if (_cachedViews.size() >= MAX_CACHED_VIEWS)
-		purgeViewCache();
+	ViewCache::iterator iter = _cachedViews.find(viewId);
+
+	if (iter != _cachedViews.end()) {
+		_hits++;
+		iter->_value.lastUse = ++_useCounter;
+		iter->_value.lastFrame = _frame;
+		// Pick up the cels which were unpacked since the last lookup
+		_memoryUsage += iter->_value.view->getMemoryUsage() - iter->_value.size;
+		iter->_value.size = iter->_value.view->getMemoryUsage();
+		return iter->_value.view;
+	}
+
+	_misses++;
+
+	ViewEntry entry;
+	entry.view = new GfxView(_resMan, _screen, _palette, viewId);
+	entry.size = entry.view->getMemoryUsage();
+	entry.lastUse = ++_useCounter;
+	entry.lastFrame = _frame;
+	_cachedViews[viewId] = entry;
+	_memoryUsage += entry.size;
 
-	if (!_cachedViews.contains(viewId))
-		_cachedViews[viewId] = new GfxView(_resMan, _screen, _palette, viewId);
+	// The new view is pinned, so it is never evicted right away
+	evict();
 
-	return _cachedViews[viewId];
+	return entry.view;
 }
 
 int16 GfxCache::kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo) {
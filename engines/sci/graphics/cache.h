@@ -30,11 +30,16 @@ namespace Sci {
 class GfxFont;
 class GfxView;
 
-typedef Common::HashMap<int, GfxFont *> FontCache;
-typedef Common::HashMap<int, GfxView *> ViewCache;
-
 /**
- * Cache class, handles caching of views/fonts
+ * Cache class, handles caching of views/fonts. Views are also used for
+ * cursors.
+ *
+ * The cache holds up to a configurable number of bytes (the
+ * "sci_gfx_cache_size" config key, in KB). Once it grows beyond that, the
+ * least recently used entries are evicted one at a time. Entries used since
+ * the last call of startFrame() are pinned, as the callers may still hold
+ * pointers to them. Long-lived holders, like GfxText16, must fetch their font
+ * again by id instead of keeping the pointer across frames.
  */
 class GfxCache {
 public:
@@ -44,6 +49,25 @@ public:
 	GfxFont *getFont(GuiResourceId fontId);
 	GfxView *getView(GuiResourceId viewId);
 
+	/**
+	 * Starts a new frame, which unpins all entries used so far. Must only be
+	 * called when no views or fonts are in use.
+	 */
+	void startFrame() { _frame++; }
+
+	uint32 getBudget() const { return _budget; }
+	/**
+	 * Returns the memory used by the cache. Cels unpacked since the last
+	 * lookup of their view are not counted yet.
+	 */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+	uint getViewCount() const { return _cachedViews.size(); }
+	uint getFontCount() const { return _cachedFonts.size(); }
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+	uint32 getEvictions() const { return _evictions; }
+	void resetCounters() { _hits = _misses = _evictions = 0; }
+
 	int16 kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetCelHeight(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetLoopCount(GuiResourceId viewId);
@@ -52,15 +76,48 @@ public:
 	byte kernelViewGetColorAtCoordinate(GuiResourceId viewId, int16 loopNo, int16 celNo, int16 x, int16 y);
 
 private:
+	enum {
+		kDefaultBudget = 8 * 1024 * 1024
+	};
+
+	struct FontEntry {
+		GfxFont *font;
+		uint32 size;		///< Size of the font resource
+		uint32 lastUse;		///< Value of _useCounter at the last use
+		uint32 lastFrame;	///< Frame of the last use
+	};
+
+	struct ViewEntry {
+		GfxView *view;
+		uint32 size;		///< Size of the view at the last lookup
+		uint32 lastUse;
+		uint32 lastFrame;
+	};
+
+	typedef Common::HashMap<GuiResourceId, FontEntry> FontCache;
+	typedef Common::HashMap<GuiResourceId, ViewEntry> ViewCache;
+
 	void purgeFontCache();
 	void purgeViewCache();
 
+	/** Evicts the least recently used entries until the cache fits into its budget. */
+	void evict();
+
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
 	GfxPalette *_palette;
 
 	FontCache _cachedFonts;
 	ViewCache _cachedViews;
+
+	uint32 _budget;
+	uint32 _memoryUsage;
+	uint32 _useCounter;
+	uint32 _frame;
+
+	uint32 _hits;
+	uint32 _misses;
+	uint32 _evictions;
 };
 
 } // End of namespace Sci
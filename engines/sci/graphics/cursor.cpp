@@ -33,6 +33,7 @@
 #include "sci/engine/state.h"
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
+#include "sci/graphics/cache.h"
 #include "sci/graphics/coordadjuster.h"
 #include "sci/graphics/view.h"
 #include "sci/graphics/cursor.h"
@@ -40,8 +41,8 @@
 
 namespace Sci {
 
-GfxCursor::GfxCursor(ResourceManager *resMan, GfxPalette *palette, GfxScreen *screen)
-	: _resMan(resMan), _palette(palette), _screen(screen) {
+GfxCursor::GfxCursor(ResourceManager *resMan, GfxPalette *palette, GfxScreen *screen, GfxCache *cache)
+	: _resMan(resMan), _palette(palette), _screen(screen), _cache(cache) {
 
 	_upscaledHires = _screen->getUpscaledHires();
 	_isVisible = true;
@@ -76,7 +77,6 @@ GfxCursor::GfxCursor(ResourceManager *resMan, GfxPalette *palette, GfxScreen *sc
 }
 
 GfxCursor::~GfxCursor() {
-	purgeCache();
 	kernelClearZoomZone();
 }
 
@@ -99,15 +99,6 @@ bool GfxCursor::isVisible() {
 	return _isVisible;
 }
 
-void GfxCursor::purgeCache() {
-	for (CursorCache::iterator iter = _cachedCursors.begin(); iter != _cachedCursors.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
-	}
-
-	_cachedCursors.clear();
-}
-
 void GfxCursor::kernelSetShape(GuiResourceId resourceId) {
 	Resource *resource;
 	byte *resourceData;
@@ -199,9 +190,6 @@ void GfxCursor::kernelSetShape(GuiResourceId resourceId) {
 }
 
 void GfxCursor::kernelSetView(GuiResourceId viewNum, int loopNum, int celNum, Common::Point *hotspot) {
-	if (_cachedCursors.size() >= MAX_CACHED_CURSORS)
-		purgeCache();
-
 	// Use the original Windows cursors in KQ6, if requested
 	if (_useOriginalKQ6WinCursors)
 		viewNum += 2000;		// Windows cursors
@@ -238,10 +226,7 @@ void GfxCursor::kernelSetView(GuiResourceId viewNum, int loopNum, int celNum, Co
 		}
 	}
 
-	if (!_cachedCursors.contains(viewNum))
-		_cachedCursors[viewNum] = new GfxView(_resMan, _screen, _palette, viewNum);
-
-	GfxView *cursorView = _cachedCursors[viewNum];
+	GfxView *cursorView = _cache->getView(viewNum);
 
 	const CelInfo *celInfo = cursorView->getCelInfo(loopNum, celNum);
 	int16 width = celInfo->width;
@@ -33,11 +33,10 @@ namespace Sci {
 
 #define SCI_CURSOR_SCI0_TRANSPARENCYCOLOR 1
 
+class GfxCache;
 class GfxView;
 class GfxPalette;
 
-typedef Common::HashMap<int, GfxView *> CursorCache;
-
 struct SciCursorSetPositionWorkarounds {
 	SciGameId gameId;
 	int16 newPositionY;
@@ -50,7 +49,7 @@ struct SciCursorSetPositionWorkarounds {
 
 class GfxCursor {
 public:
-	GfxCursor(ResourceManager *resMan, GfxPalette *palette, GfxScreen *screen);
+	GfxCursor(ResourceManager *resMan, GfxPalette *palette, GfxScreen *screen, GfxCache *cache);
 	~GfxCursor();
 
 	void init(GfxCoordAdjuster *coordAdjuster, EventManager *event);
@@ -86,11 +85,10 @@ public:
 	void setMacCursorRemapList(int cursorCount, reg_t *cursors);
 
 private:
-	void purgeCache();
-
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
 	GfxPalette *_palette;
+	GfxCache *_cache;
 	GfxCoordAdjuster *_coordAdjuster;
 	EventManager *_event;
 
@@ -109,8 +107,6 @@ private:
 	byte _zoomMultiplier;
 	byte *_cursorSurface;
 
-	CursorCache _cachedCursors;
-
 	bool _isVisible;
 
 	// KQ6 Windows has different black and white cursors. If this is true (set
@@ -21,6 +21,7 @@
  */
 
 #include "common/algorithm.h"
+#include "common/config-manager.h"
 #include "common/events.h"
 #include "common/keyboard.h"
 #include "common/list_intern.h"
@@ -59,13 +60,22 @@ enum SciSpeciaPlanelPictureCodes {
 	kPlanePlainColored = 0xffff		// -1
 };
 
+enum {
+	kMaxDirtyRects = 32	// above this, the whole screen is redrawn
+};
+
 GfxFrameout::GfxFrameout(SegManager *segMan, ResourceManager *resMan, GfxCoordAdjuster *coordAdjuster, GfxCache *cache, GfxScreen *screen, GfxPalette *palette, GfxPaint32 *paint32)
-	: _segMan(segMan), _resMan(resMan), _cache(cache), _screen(screen), _palette(palette), _paint32(paint32) {
+	: _segMan(segMan), _resMan(resMan), _cache(cache), _screen(screen), _palette(palette), _paint32(paint32),
+	  _dirtyRects(kMaxDirtyRects) {
 
 	_coordAdjuster = (GfxCoordAdjuster32 *)coordAdjuster;
 	_curScrollText = -1;
 	_showScrollText = false;
 	_maxScrollTexts = 0;
+	_fullRedraw = true;
+	_alwaysFullRedraw = ConfMan.hasKey("sci_full_redraw") && ConfMan.getBool("sci_full_redraw");
+	_showDirtyRects = false;
+	resetCounters();
 }
 
 GfxFrameout::~GfxFrameout() {
@@ -77,6 +87,31 @@ void GfxFrameout::clear() {
 	_planes.clear();
 	deletePlanePictures(NULL_REG);
 	clearScrollTexts();
+	_dirtyRects.clear();
+	_overlayRects.clear();
+	_fullRedraw = true;
+}
+
+void GfxFrameout::resetCounters() {
+	_framesDrawn = 0;
+	_framesSkipped = 0;
+	_fullRedraws = 0;
+	_pixelsCopied = 0;
+}
+
+void GfxFrameout::addDirtyRect(const Common::Rect &rect) {
+	if (rect.isEmpty() || _fullRedraw)
+		return;
+
+	Common::Rect dirtyRect = rect;
+	dirtyRect.clip(_screen->getWidth(), _screen->getHeight());
+	if (dirtyRect.isEmpty())
+		return;
+
+	if (!_dirtyRects.add(dirtyRect)) {
+		_dirtyRects.clear();
+		_fullRedraw = true;
+	}
 }
 
 void GfxFrameout::clearScrollTexts() {
@@ -182,6 +217,7 @@ void GfxFrameout::kernelUpdatePlane(reg_t object) {
 						addPlanePicture(object, it->pictureId, 0);
 				}
 			}
+			addDirtyRect(it->planeRect);
 			it->planeRect.top = readSelectorValue(_segMan, object, SELECTOR(top));
 			it->planeRect.left = readSelectorValue(_segMan, object, SELECTOR(left));
 			it->planeRect.bottom = readSelectorValue(_segMan, object, SELECTOR(bottom));
@@ -223,6 +259,7 @@ void GfxFrameout::kernelUpdatePlane(reg_t object) {
 
 			it->planePictureMirrored = readSelectorValue(_segMan, object, SELECTOR(mirrored));
 			it->planeBack = readSelectorValue(_segMan, object, SELECTOR(back));
+			addDirtyRect(it->planeRect);
 
 			sortPlanes();
 
@@ -258,6 +295,7 @@ void GfxFrameout::kernelDeletePlane(reg_t object) {
 
 			// Blackout removed plane rect
 			_paint32->fillRect(planeRect, 0);
+			addDirtyRect(planeRect);
 			return;
 		}
 	}
@@ -275,6 +313,7 @@ void GfxFrameout::addPlanePicture(reg_t object, GuiResourceId pictureId, uint16
 	newPicture.startY = startY;
 	newPicture.pictureCels = 0;
 	_planePictures.push_back(newPicture);
+	_fullRedraw = true;
 }
 
 void GfxFrameout::deletePlanePictures(reg_t object) {
@@ -285,6 +324,7 @@ void GfxFrameout::deletePlanePictures(reg_t object) {
 			delete it->pictureCels;
 			delete it->picture;
 			it = _planePictures.erase(it);
+			_fullRedraw = true;
 		} else {
 			++it;
 		}
@@ -303,6 +343,8 @@ reg_t GfxFrameout::addPlaneLine(reg_t object, Common::Point startPoint, Common::
 			line.priority = priority;
 			line.control = control;
 			it->lines.push_back(line);
+			// Lines aren't clipped to their plane
+			_fullRedraw = true;
 			return line.hunkId;
 		}
 	}
@@ -324,6 +366,7 @@ void GfxFrameout::updatePlaneLine(reg_t object, reg_t hunkId, Common::Point star
 					it2->color = color;
 					it2->priority = priority;
 					it2->control = control;
+					_fullRedraw = true;
 					return;
 				}
 			}
@@ -342,6 +385,7 @@ void GfxFrameout::deletePlaneLine(reg_t object, reg_t hunkId) {
 				if (it2->hunkId == hunkId) {
 					_segMan->freeHunkEntry(hunkId);
 					it2 = it->lines.erase(it2);
+					_fullRedraw = true;
 					return;
 				}
 			}
@@ -391,7 +435,9 @@ void GfxFrameout::kernelAddScreenItem(reg_t object) {
 	itemEntry->object = object;
 	itemEntry->givenOrderNr = _screenItems.size();
 	itemEntry->visible = true;
+	itemEntry->dirty = true;
 	_screenItems.push_back(itemEntry);
+	_screenItemMap[object] = itemEntry;
 
 	kernelUpdateScreenItem(object);
 }
@@ -409,6 +455,8 @@ void GfxFrameout::kernelUpdateScreenItem(reg_t object) {
 		return;
 	}
 
+	const FrameoutEntry lastEntry = *itemEntry;
+
 	itemEntry->viewId = readSelectorValue(_segMan, object, SELECTOR(view));
 	itemEntry->loopNo = readSelectorValue(_segMan, object, SELECTOR(loop));
 	itemEntry->celNo = readSelectorValue(_segMan, object, SELECTOR(cel));
@@ -434,6 +482,16 @@ void GfxFrameout::kernelUpdateScreenItem(reg_t object) {
 	// Check if the entry can be hidden
 	if (lookupSelector(_segMan, object, SELECTOR(visible), NULL, NULL) != kSelectorNone)
 		itemEntry->visible = readSelectorValue(_segMan, object, SELECTOR(visible));
+
+	// A changed position or cel shows up in the screen rect as well, but a
+	// changed priority only affects the drawing order
+	if (itemEntry->viewId != lastEntry.viewId || itemEntry->loopNo != lastEntry.loopNo ||
+		itemEntry->celNo != lastEntry.celNo || itemEntry->x != lastEntry.x ||
+		itemEntry->y != lastEntry.y || itemEntry->z != lastEntry.z ||
+		itemEntry->priority != lastEntry.priority || itemEntry->signal != lastEntry.signal ||
+		itemEntry->scaleSignal != lastEntry.scaleSignal || itemEntry->scaleX != lastEntry.scaleX ||
+		itemEntry->scaleY != lastEntry.scaleY || itemEntry->visible != lastEntry.visible)
+		itemEntry->dirty = true;
 }
 
 void GfxFrameout::kernelDeleteScreenItem(reg_t object) {
@@ -442,6 +500,8 @@ void GfxFrameout::kernelDeleteScreenItem(reg_t object) {
 	if (!itemEntry)
 		return;
 
+	addDirtyRect(itemEntry->screenRect);
+	_screenItemMap.erase(object);
 	_screenItems.remove(itemEntry);
 	delete itemEntry;
 }
@@ -460,6 +520,8 @@ void GfxFrameout::deletePlaneItems(reg_t planeObject) {
 
 		if (objectMatches) {
 			FrameoutEntry *itemEntry = *listIterator;
+			addDirtyRect(itemEntry->screenRect);
+			_screenItemMap.erase(itemEntry->object);
 			listIterator = _screenItems.erase(listIterator);
 			delete itemEntry;
 		} else {
@@ -469,11 +531,9 @@ void GfxFrameout::deletePlaneItems(reg_t planeObject) {
 }
 
 FrameoutEntry *GfxFrameout::findScreenItem(reg_t object) {
-	for (FrameoutList::iterator listIterator = _screenItems.begin(); listIterator != _screenItems.end(); listIterator++) {
-		FrameoutEntry *itemEntry = *listIterator;
-		if (itemEntry->object == object)
-			return itemEntry;
-	}
+	FrameoutMap::iterator it = _screenItemMap.find(object);
+	if (it != _screenItemMap.end())
+		return it->_value;
 
 	return NULL;
 }
@@ -509,10 +569,12 @@ bool planeSortHelper(const PlaneEntry &entry1, const PlaneEntry &entry2) {
 void GfxFrameout::sortPlanes() {
 	// First, remove any invalid planes
 	for (PlaneList::iterator it = _planes.begin(); it != _planes.end();) {
-		if (!_segMan->isObject(it->object))
+		if (!_segMan->isObject(it->object)) {
+			addDirtyRect(it->planeRect);
 			it = _planes.erase(it);
-		else
+		} else {
 			it++;
+		}
 	}
 
 	// Sort the rest of them
@@ -549,6 +611,9 @@ void GfxFrameout::showVideo() {
 
 		g_system->delayMillis(10);
 	}
+
+	// The video was drawn over the last frame
+	_fullRedraw = true;
 }
 
 void GfxFrameout::createPlaneItemList(reg_t planeObject, FrameoutList &itemList) {
@@ -592,7 +657,7 @@ void GfxFrameout::createPlaneItemList(reg_t planeObject, FrameoutList &itemList)
 	Common::sort(itemList.begin(), itemList.end(), sortHelper);
 }
 
-bool GfxFrameout::isPictureOutOfView(FrameoutEntry *itemEntry, Common::Rect planeRect, int16 planeOffsetX, int16 planeOffsetY) {
+bool GfxFrameout::isPictureOutOfView(const FrameoutEntry *itemEntry, Common::Rect planeRect, int16 planeOffsetX, int16 planeOffsetY) {
 	// Out of view horizontally (sanity checks)
 	int16 pictureCelStartX = itemEntry->picStartX + itemEntry->x;
 	int16 pictureCelEndX = pictureCelStartX + itemEntry->picture->getSci32celWidth(itemEntry->celNo);
@@ -616,7 +681,7 @@ bool GfxFrameout::isPictureOutOfView(FrameoutEntry *itemEntry, Common::Rect plan
 	return false;
 }
 
-void GfxFrameout::drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored) {
+void GfxFrameout::drawPicture(const FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored) {
 	int16 pictureOffsetX = planeOffsetX;
 	int16 pictureX = itemEntry->x;
 	if ((planeOffsetX) || (itemEntry->picStartX)) {
@@ -643,6 +708,154 @@ void GfxFrameout::drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int1
 	//	warning("picture cel %d %d", itemEntry->celNo, itemEntry->priority);
 }
 
+bool GfxFrameout::prepareScreenItem(const PlaneEntry &plane, FrameoutEntry *itemEntry) {
+	GfxView *view = (itemEntry->viewId != 0xFFFF) ? _cache->getView(itemEntry->viewId) : NULL;
+	int16 dummyX = 0;
+
+	if (view && view->isSci2Hires()) {
+		view->adjustToUpscaledCoordinates(itemEntry->y, itemEntry->x);
+		view->adjustToUpscaledCoordinates(itemEntry->z, dummyX);
+	} else if (getSciVersion() >= SCI_VERSION_2_1) {
+		_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
+		_coordAdjuster->fromScriptToDisplay(itemEntry->z, dummyX);
+	}
+
+	// Adjust according to current scroll position
+	itemEntry->x -= plane.planeOffsetX;
+	itemEntry->y -= plane.planeOffsetY;
+
+	uint16 useInsetRect = readSelectorValue(_segMan, itemEntry->object, SELECTOR(useInsetRect));
+	if (useInsetRect) {
+		itemEntry->celRect.top = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inTop));
+		itemEntry->celRect.left = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inLeft));
+		itemEntry->celRect.bottom = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inBottom));
+		itemEntry->celRect.right = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inRight));
+		if (view && view->isSci2Hires()) {
+			view->adjustToUpscaledCoordinates(itemEntry->celRect.top, itemEntry->celRect.left);
+			view->adjustToUpscaledCoordinates(itemEntry->celRect.bottom, itemEntry->celRect.right);
+		}
+		itemEntry->celRect.translate(itemEntry->x, itemEntry->y);
+		// TODO: maybe we should clip the cels rect with this, i'm not sure
+		//  the only currently known usage is game menu of gk1
+	} else if (view) {
+		// Process global scaling, if needed.
+		// TODO: Seems like SCI32 always processes global scaling for scaled objects
+		// TODO: We can only process symmetrical scaling for now (i.e. same value for scaleX/scaleY)
+		if ((itemEntry->scaleSignal & kScaleSignalDoScaling32) && 
+		   !(itemEntry->scaleSignal & kScaleSignalDisableGlobalScaling32) &&
+		    (itemEntry->scaleX == itemEntry->scaleY) &&
+			itemEntry->scaleX != 128)
+			applyGlobalScaling(itemEntry, plane.planeRect, view->getHeight(itemEntry->loopNo, itemEntry->celNo));
+
+		if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
+			view->getCelRect(itemEntry->loopNo, itemEntry->celNo,
+				itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->celRect);
+		else
+			view->getCelScaledRect(itemEntry->loopNo, itemEntry->celNo,
+				itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->scaleX,
+				itemEntry->scaleY, itemEntry->celRect);
+
+		Common::Rect nsRect = itemEntry->celRect;
+		// Translate back to actual coordinate within scrollable plane
+		nsRect.translate(plane.planeOffsetX, plane.planeOffsetY);
+
+		if (g_sci->getGameId() == GID_PHANTASMAGORIA2) {
+			// HACK: Some (?) objects in Phantasmagoria 2 have no NS rect. Skip them for now.
+			// TODO: Remove once we figure out how Phantasmagoria 2 draws objects on screen.
+			if (lookupSelector(_segMan, itemEntry->object, SELECTOR(nsLeft), NULL, NULL) != kSelectorVariable)
+				return false;
+		}
+
+		if (view && view->isSci2Hires()) {
+			view->adjustBackUpscaledCoordinates(nsRect.top, nsRect.left);
+			view->adjustBackUpscaledCoordinates(nsRect.bottom, nsRect.right);
+			g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
+		} else if (getSciVersion() >= SCI_VERSION_2_1 && _resMan->detectHires()) {
+			_coordAdjuster->fromDisplayToScript(nsRect.top, nsRect.left);
+			_coordAdjuster->fromDisplayToScript(nsRect.bottom, nsRect.right);
+			g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
+		}
+	}
+
+	// Don't attempt to draw sprites that are outside the visible
+	// screen area. An example is the random people walking in
+	// Jackson Square in GK1.
+	if (itemEntry->celRect.bottom < 0 || itemEntry->celRect.top  >= _screen->getDisplayHeight() ||
+	    itemEntry->celRect.right  < 0 || itemEntry->celRect.left >= _screen->getDisplayWidth())
+		return false;
+
+	itemEntry->clipRect = itemEntry->celRect;
+
+	if (view && view->isSci2Hires()) {
+		itemEntry->clipRect.clip(plane.upscaledPlaneClipRect);
+		itemEntry->screenRect = itemEntry->clipRect;
+		itemEntry->screenRect.translate(plane.upscaledPlaneRect.left, plane.upscaledPlaneRect.top);
+	} else {
+		// QFG4 passes invalid rectangles when a battle is starting
+		if (!itemEntry->clipRect.isValidRect())
+			return false;
+		itemEntry->clipRect.clip(plane.planeClipRect);
+		itemEntry->screenRect = itemEntry->clipRect;
+		itemEntry->screenRect.translate(plane.planeRect.left, plane.planeRect.top);
+	}
+
+	return true;
+}
+
+void GfxFrameout::drawPlane(const PlaneEntry &plane, const FrameoutDrawList &drawList) {
+	// There is a race condition lurking in SQ6, which causes the game to hang in the intro, when teleporting to Polysorbate LX.
+	// Since I first wrote the patch, the race has stopped occurring for me though.
+	// I'll leave this for investigation later, when someone can reproduce.
+	//if (plane.pictureId == kPlanePlainColored)	// FIXME: This is what SSCI does, and fixes the intro of LSL7, but breaks the dialogs in GK1 (adds black boxes)
+	if (plane.pictureId == kPlanePlainColored && (plane.planeBack || g_sci->getGameId() != GID_GK1))
+		_paint32->fillRect(plane.planeRect, plane.planeBack);
+
+	_coordAdjuster->pictureSetDisplayArea(plane.planeRect);
+
+	for (FrameoutDrawList::const_iterator listIterator = drawList.begin(); listIterator != drawList.end(); listIterator++) {
+		const FrameoutEntry *itemEntry = listIterator;
+
+		if (itemEntry->object.isNull()) {
+			// Picture cel data
+			if (!isPictureOutOfView(itemEntry, plane.planeRect, plane.planeOffsetX, plane.planeOffsetY))
+				drawPicture(itemEntry, plane.planeOffsetX, plane.planeOffsetY, plane.planePictureMirrored);
+			continue;
+		}
+
+		GfxView *view = (itemEntry->viewId != 0xFFFF) ? _cache->getView(itemEntry->viewId) : NULL;
+
+		if (view && !itemEntry->clipRect.isEmpty()) {
+			if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
+				view->draw(itemEntry->celRect, itemEntry->clipRect, itemEntry->screenRect,
+					itemEntry->loopNo, itemEntry->celNo, 255, 0, view->isSci2Hires());
+			else
+				view->drawScaled(itemEntry->celRect, itemEntry->clipRect, itemEntry->screenRect,
+					itemEntry->loopNo, itemEntry->celNo, 255, itemEntry->scaleX, itemEntry->scaleY);
+		}
+
+		// Draw text, if it exists
+		if (lookupSelector(_segMan, itemEntry->object, SELECTOR(text), NULL, NULL) == kSelectorVariable) {
+			g_sci->_gfxText32->drawTextBitmap(itemEntry->x, itemEntry->y, plane.planeRect, itemEntry->object);
+		}
+	}
+}
+
+void GfxFrameout::drawDirtyRects(const FrameoutRectList &rects) {
+	const byte color = _screen->getColorWhite();
+
+	if (_fullRedraw)
+		_overlayRects.push_back(Common::Rect(_screen->getWidth(), _screen->getHeight()));
+	else
+		_overlayRects = rects;
+
+	for (FrameoutRectList::const_iterator it = _overlayRects.begin(); it != _overlayRects.end(); ++it) {
+		_paint32->fillRect(Common::Rect(it->left, it->top, it->right, it->top + 1), color);
+		_paint32->fillRect(Common::Rect(it->left, it->bottom - 1, it->right, it->bottom), color);
+		_paint32->fillRect(Common::Rect(it->left, it->top, it->left + 1, it->bottom), color);
+		_paint32->fillRect(Common::Rect(it->right - 1, it->top, it->right, it->bottom), color);
+	}
+}
+
 void GfxFrameout::kernelFrameout() {
 	if (g_sci->_robotDecoder->isVideoLoaded()) {
 		showVideo();
@@ -651,27 +864,30 @@ void GfxFrameout::kernelFrameout() {
 
 	_palette->palVaryUpdate();
 
-	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); it++) {
-		reg_t planeObject = it->object;
+	// Views used in the previous frame may be evicted from now on
+	_cache->startFrame();
 
-		// Draw any plane lines, if they exist
-		// These are drawn on invisible planes as well. (e.g. "invisiblePlane" in LSL6 hires)
-		// FIXME: Lines aren't always drawn (e.g. when the narrator speaks in LSL6 hires).
-		// Perhaps something is painted over them?
-		for (PlaneLineList::iterator it2 = it->lines.begin(); it2 != it->lines.end(); ++it2) {
-			Common::Point startPoint = it2->startPoint;
-			Common::Point endPoint = it2->endPoint;
-			_coordAdjuster->kernelLocalToGlobal(startPoint.x, startPoint.y, it->object);
-			_coordAdjuster->kernelLocalToGlobal(endPoint.x, endPoint.y, it->object);
-			_screen->drawLine(startPoint, endPoint, it2->color, it2->priority, it2->control);
-		}
+	// The scroll text is drawn over all planes
+	if (_alwaysFullRedraw || (_showScrollText && _curScrollText >= 0))
+		_fullRedraw = true;
 
+	// Update all screen items first, to find out which screen areas changed
+	// since the last frame
+	Common::Array<FrameoutDrawList> drawLists;
+	drawLists.resize(_planes.size());
+	uint planeNr = 0;
+
+	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); ++it, ++planeNr) {
+		reg_t planeObject = it->object;
 		int16 planeLastPriority = it->lastPriority;
 
 		// Update priority here, sq6 sets it w/o UpdatePlane
 		int16 planePriority = it->priority = readSelectorValue(_segMan, planeObject, SELECTOR(priority));
 
 		it->lastPriority = planePriority;
+		if (planePriority != planeLastPriority)
+			addDirtyRect(it->planeRect);
+
 		if (planePriority < 0) { // Plane currently not meant to be shown
 			// If plane was shown before, delete plane rect
 			if (planePriority != planeLastPriority)
@@ -679,14 +895,6 @@ void GfxFrameout::kernelFrameout() {
 			continue;
 		}
 
-		// There is a race condition lurking in SQ6, which causes the game to hang in the intro, when teleporting to Polysorbate LX.
-		// Since I first wrote the patch, the race has stopped occurring for me though.
-		// I'll leave this for investigation later, when someone can reproduce.
-		//if (it->pictureId == kPlanePlainColored)	// FIXME: This is what SSCI does, and fixes the intro of LSL7, but breaks the dialogs in GK1 (adds black boxes)
-		if (it->pictureId == kPlanePlainColored && (it->planeBack || g_sci->getGameId() != GID_GK1))
-			_paint32->fillRect(it->planeRect, it->planeBack);
-
-		_coordAdjuster->pictureSetDisplayArea(it->planeRect);
 		// Invoking drewPicture() with an invalid picture ID in SCI32 results in
 		// invalidating the palVary palette when a palVary effect is active. This
 		// is quite obvious in QFG4, where the day time palette is incorrectly
@@ -699,127 +907,44 @@ void GfxFrameout::kernelFrameout() {
 
 		createPlaneItemList(planeObject, itemList);
 
+		FrameoutDrawList &drawList = drawLists[planeNr];
+
 		for (FrameoutList::iterator listIterator = itemList.begin(); listIterator != itemList.end(); listIterator++) {
 			FrameoutEntry *itemEntry = *listIterator;
 
-			if (!itemEntry->visible)
+			if (!itemEntry->visible && itemEntry->screenRect.isEmpty())
 				continue;
 
+			// The screen items keep the coordinates of the scripts, and the
+			// display coordinates are only calculated for drawing
+			FrameoutEntry drawEntry = *itemEntry;
+
 			if (itemEntry->object.isNull()) {
 				// Picture cel data
-				_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
-				_coordAdjuster->fromScriptToDisplay(itemEntry->picStartY, itemEntry->picStartX);
-
-				if (!isPictureOutOfView(itemEntry, it->planeRect, it->planeOffsetX, it->planeOffsetY))
-					drawPicture(itemEntry, it->planeOffsetX, it->planeOffsetY, it->planePictureMirrored);
-			} else {
-				GfxView *view = (itemEntry->viewId != 0xFFFF) ? _cache->getView(itemEntry->viewId) : NULL;
-				int16 dummyX = 0;
-
-				if (view && view->isSci2Hires()) {
-					view->adjustToUpscaledCoordinates(itemEntry->y, itemEntry->x);
-					view->adjustToUpscaledCoordinates(itemEntry->z, dummyX);
-				} else if (getSciVersion() >= SCI_VERSION_2_1) {
-					_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
-					_coordAdjuster->fromScriptToDisplay(itemEntry->z, dummyX);
-				}
-
-				// Adjust according to current scroll position
-				itemEntry->x -= it->planeOffsetX;
-				itemEntry->y -= it->planeOffsetY;
-
-				uint16 useInsetRect = readSelectorValue(_segMan, itemEntry->object, SELECTOR(useInsetRect));
-				if (useInsetRect) {
-					itemEntry->celRect.top = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inTop));
-					itemEntry->celRect.left = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inLeft));
-					itemEntry->celRect.bottom = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inBottom));
-					itemEntry->celRect.right = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inRight));
-					if (view && view->isSci2Hires()) {
-						view->adjustToUpscaledCoordinates(itemEntry->celRect.top, itemEntry->celRect.left);
-						view->adjustToUpscaledCoordinates(itemEntry->celRect.bottom, itemEntry->celRect.right);
-					}
-					itemEntry->celRect.translate(itemEntry->x, itemEntry->y);
-					// TODO: maybe we should clip the cels rect with this, i'm not sure
-					//  the only currently known usage is game menu of gk1
-				} else if (view) {
-					// Process global scaling, if needed.
-					// TODO: Seems like SCI32 always processes global scaling for scaled objects
-					// TODO: We can only process symmetrical scaling for now (i.e. same value for scaleX/scaleY)
-					if ((itemEntry->scaleSignal & kScaleSignalDoScaling32) && 
-					   !(itemEntry->scaleSignal & kScaleSignalDisableGlobalScaling32) &&
-					    (itemEntry->scaleX == itemEntry->scaleY) &&
-						itemEntry->scaleX != 128)
-						applyGlobalScaling(itemEntry, it->planeRect, view->getHeight(itemEntry->loopNo, itemEntry->celNo));
-
-					if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
-						view->getCelRect(itemEntry->loopNo, itemEntry->celNo,
-							itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->celRect);
-					else
-						view->getCelScaledRect(itemEntry->loopNo, itemEntry->celNo,
-							itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->scaleX,
-							itemEntry->scaleY, itemEntry->celRect);
-
-					Common::Rect nsRect = itemEntry->celRect;
-					// Translate back to actual coordinate within scrollable plane
-					nsRect.translate(it->planeOffsetX, it->planeOffsetY);
-
-					if (g_sci->getGameId() == GID_PHANTASMAGORIA2) {
-						// HACK: Some (?) objects in Phantasmagoria 2 have no NS rect. Skip them for now.
-						// TODO: Remove once we figure out how Phantasmagoria 2 draws objects on screen.
-						if (lookupSelector(_segMan, itemEntry->object, SELECTOR(nsLeft), NULL, NULL) != kSelectorVariable)
-							continue;
-					}
-
-					if (view && view->isSci2Hires()) {
-						view->adjustBackUpscaledCoordinates(nsRect.top, nsRect.left);
-						view->adjustBackUpscaledCoordinates(nsRect.bottom, nsRect.right);
-						g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
-					} else if (getSciVersion() >= SCI_VERSION_2_1 && _resMan->detectHires()) {
-						_coordAdjuster->fromDisplayToScript(nsRect.top, nsRect.left);
-						_coordAdjuster->fromDisplayToScript(nsRect.bottom, nsRect.right);
-						g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
-					}
-				}
+				_coordAdjuster->fromScriptToDisplay(drawEntry.y, drawEntry.x);
+				_coordAdjuster->fromScriptToDisplay(drawEntry.picStartY, drawEntry.picStartX);
+				drawList.push_back(drawEntry);
+				continue;
+			}
 
-				// Don't attempt to draw sprites that are outside the visible
-				// screen area. An example is the random people walking in
-				// Jackson Square in GK1.
-				if (itemEntry->celRect.bottom < 0 || itemEntry->celRect.top  >= _screen->getDisplayHeight() ||
-				    itemEntry->celRect.right  < 0 || itemEntry->celRect.left >= _screen->getDisplayWidth())
-					continue;
-
-				Common::Rect clipRect, translatedClipRect;
-				clipRect = itemEntry->celRect;
-
-				if (view && view->isSci2Hires()) {
-					clipRect.clip(it->upscaledPlaneClipRect);
-					translatedClipRect = clipRect;
-					translatedClipRect.translate(it->upscaledPlaneRect.left, it->upscaledPlaneRect.top);
-				} else {
-					// QFG4 passes invalid rectangles when a battle is starting
-					if (!clipRect.isValidRect())
-						continue;
-					clipRect.clip(it->planeClipRect);
-					translatedClipRect = clipRect;
-					translatedClipRect.translate(it->planeRect.left, it->planeRect.top);
-				}
+			bool drawItem = itemEntry->visible && prepareScreenItem(*it, &drawEntry);
+			if (!drawItem)
+				drawEntry.screenRect = Common::Rect();
+			itemEntry->celRect = drawEntry.celRect;
 
-				if (view) {
-					if (!clipRect.isEmpty()) {
-						if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
-							view->draw(itemEntry->celRect, clipRect, translatedClipRect,
-								itemEntry->loopNo, itemEntry->celNo, 255, 0, view->isSci2Hires());
-						else
-							view->drawScaled(itemEntry->celRect, clipRect, translatedClipRect,
-								itemEntry->loopNo, itemEntry->celNo, 255, itemEntry->scaleX, itemEntry->scaleY);
-					}
-				}
+			// Text bitmaps may be changed without updating the screen item, so
+			// the area of the plane is always redrawn for them
+			bool hasText = lookupSelector(_segMan, itemEntry->object, SELECTOR(text), NULL, NULL) == kSelectorVariable;
 
-				// Draw text, if it exists
-				if (lookupSelector(_segMan, itemEntry->object, SELECTOR(text), NULL, NULL) == kSelectorVariable) {
-					g_sci->_gfxText32->drawTextBitmap(itemEntry->x, itemEntry->y, it->planeRect, itemEntry->object);
-				}
+			if (itemEntry->dirty || hasText || drawEntry.screenRect != itemEntry->screenRect) {
+				addDirtyRect(itemEntry->screenRect);
+				addDirtyRect(hasText ? it->planeRect : drawEntry.screenRect);
+				itemEntry->screenRect = drawEntry.screenRect;
+				itemEntry->dirty = false;
 			}
+
+			if (drawItem)
+				drawList.push_back(drawEntry);
 		}
 
 		for (PlanePictureList::iterator pictureIt = _planePictures.begin(); pictureIt != _planePictures.end(); pictureIt++) {
@@ -830,9 +955,106 @@ void GfxFrameout::kernelFrameout() {
 		}
 	}
 
+	if (!_fullRedraw && _dirtyRects.empty()) {
+		// Nothing changed, the screen still shows the last frame
+		_framesSkipped++;
+		g_sci->getEngineState()->_throttleTrigger = true;
+		return;
+	}
+
+	// Hires views are drawn in upscaled coordinates, so only the whole
+	// screen is redrawn on upscaled screens
+	if (_screen->getUpscaledHires()) {
+		_dirtyRects.clear();
+		_fullRedraw = true;
+	}
+
+	// The overlay shows the rects which changed in this frame, and the
+	// overlay of the last frame is removed
+	const FrameoutRectList changedRects = _dirtyRects.getRects();
+	for (FrameoutRectList::const_iterator it = _overlayRects.begin(); it != _overlayRects.end(); ++it)
+		addDirtyRect(*it);
+	_overlayRects.clear();
+
+	// Redraw the planes which cover a dirty rect. The planes in front of them
+	// are redrawn as well where they overlap, as a plane is always drawn as
+	// a whole.
+	FrameoutRectList redrawRects = _dirtyRects.getRects();
+	planeNr = 0;
+
+	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); ++it, ++planeNr) {
+		// Draw any plane lines, if they exist
+		// These are drawn on invisible planes as well. (e.g. "invisiblePlane" in LSL6 hires)
+		// FIXME: Lines aren't always drawn (e.g. when the narrator speaks in LSL6 hires).
+		// Perhaps something is painted over them?
+		// Lines aren't clipped to their plane, so they are only drawn when
+		// their bounds need to be redrawn, and the planes in front of them
+		// are then redrawn over them as well.
+		PlaneLineList lines;
+		Common::Rect lineBounds;
+		for (PlaneLineList::iterator it2 = it->lines.begin(); it2 != it->lines.end(); ++it2) {
+			PlaneLineEntry line = *it2;
+			_coordAdjuster->kernelLocalToGlobal(line.startPoint.x, line.startPoint.y, it->object);
+			_coordAdjuster->kernelLocalToGlobal(line.endPoint.x, line.endPoint.y, it->object);
+			lines.push_back(line);
+
+			Common::Rect lineRect(MIN(line.startPoint.x, line.endPoint.x), MIN(line.startPoint.y, line.endPoint.y),
+								MAX(line.startPoint.x, line.endPoint.x) + 1, MAX(line.startPoint.y, line.endPoint.y) + 1);
+			if (lineBounds.isEmpty())
+				lineBounds = lineRect;
+			else
+				lineBounds.extend(lineRect);
+		}
+
+		bool redrawLines = _fullRedraw;
+		for (FrameoutRectList::const_iterator rectIt = redrawRects.begin(); !redrawLines && rectIt != redrawRects.end(); ++rectIt)
+			redrawLines = lineBounds.intersects(*rectIt);
+
+		if (redrawLines) {
+			for (PlaneLineList::iterator it2 = lines.begin(); it2 != lines.end(); ++it2)
+				_screen->drawLine(it2->startPoint, it2->endPoint, it2->color, it2->priority, it2->control);
+
+			if (!_fullRedraw) {
+				redrawRects.push_back(lineBounds);
+				addDirtyRect(lineBounds);
+			}
+		}
+
+		if (it->priority < 0)
+			continue;
+
+		bool redrawPlane = _fullRedraw;
+		for (FrameoutRectList::const_iterator rectIt = redrawRects.begin(); !redrawPlane && rectIt != redrawRects.end(); ++rectIt)
+			redrawPlane = it->planeRect.intersects(*rectIt);
+
+		if (!redrawPlane)
+			continue;
+
+		if (!_fullRedraw)
+			redrawRects.push_back(it->planeRect);
+
+		drawPlane(*it, drawLists[planeNr]);
+	}
+
 	showCurrentScrollText();
 
-	_screen->copyToScreen();
+	if (_showDirtyRects)
+		drawDirtyRects(changedRects);
+
+	if (_fullRedraw) {
+		_screen->copyToScreen();
+		_pixelsCopied += _screen->getDisplayWidth() * _screen->getDisplayHeight();
+		_fullRedraws++;
+	} else {
+		for (FrameoutRectList::const_iterator it = _dirtyRects.getRects().begin(); it != _dirtyRects.getRects().end(); ++it) {
+			_screen->copyRectToScreen(*it);
+			_pixelsCopied += it->width() * it->height();
+		}
+	}
+
+	_dirtyRects.clear();
+	_fullRedraw = false;
+	_framesDrawn++;
 
 	g_sci->getEngineState()->_throttleTrigger = true;
 }
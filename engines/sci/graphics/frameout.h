@@ -23,6 +23,11 @@
 #ifndef SCI_GRAPHICS_FRAMEOUT_H
 #define SCI_GRAPHICS_FRAMEOUT_H
 
+#include "common/hashmap.h"
+#include "graphics/dirtyrects.h"
+
+#include "sci/engine/gc.h"
+
 namespace Sci {
 
 class GfxPicture;
@@ -69,13 +74,19 @@ struct FrameoutEntry {
 	int16 scaleX;
 	int16 scaleY;
 	Common::Rect celRect;
+	Common::Rect clipRect; // celRect, clipped to the plane
+	Common::Rect screenRect; // clipRect in screen coordinates, empty if not drawn
 	GfxPicture *picture;
 	int16 picStartX;
 	int16 picStartY;
 	bool visible;
+	bool dirty; // changed since the last frame
 };
 
 typedef Common::List<FrameoutEntry *> FrameoutList;
+typedef Common::HashMap<reg_t, FrameoutEntry *, reg_t_Hash> FrameoutMap;
+typedef Common::Array<FrameoutEntry> FrameoutDrawList;
+typedef Common::Array<Common::Rect> FrameoutRectList;
 
 struct PlanePictureEntry {
 	reg_t object;
@@ -146,16 +157,42 @@ public:
 	void lastScrollText() { if (_scrollTexts.size() > 0) _curScrollText = _scrollTexts.size() - 1; }
 	void prevScrollText() { if (_curScrollText > 0) _curScrollText--; }
 	void nextScrollText() { if (_curScrollText + 1 < (uint16)_scrollTexts.size()) _curScrollText++; }
-	void toggleScrollText(bool show) { _showScrollText = show; }
+	void toggleScrollText(bool show) { _showScrollText = show; _fullRedraw = true; }
+
+	/**
+	 * Forces the next frame to be redrawn and copied to the screen completely.
+	 * Needed after anything else has drawn on the screen, e.g. a video.
+	 */
+	void invalidate() { _fullRedraw = true; }
+
+	// Dirty rectangle statistics and debug overlay
+	void showDirtyRects(bool show) { _showDirtyRects = show; _fullRedraw = true; }
+	bool isShowingDirtyRects() const { return _showDirtyRects; }
+
+	/**
+	 * Redraw the whole screen in every frame, as before dirty rects were
+	 * tracked. A fallback for games in which the dirty rects miss changes.
+	 */
+	void setAlwaysFullRedraw(bool full) { _alwaysFullRedraw = full; _fullRedraw = true; }
+	bool isAlwaysFullRedraw() const { return _alwaysFullRedraw; }
+	uint32 getFramesDrawn() const { return _framesDrawn; }
+	uint32 getFramesSkipped() const { return _framesSkipped; }
+	uint32 getFullRedraws() const { return _fullRedraws; }
+	uint32 getPixelsCopied() const { return _pixelsCopied; }
+	void resetCounters();
 
 	void printPlaneList(Console *con);
 	void printPlaneItemList(Console *con, reg_t planeObject);
 
 private:
 	void showVideo();
+	void addDirtyRect(const Common::Rect &rect);
 	void createPlaneItemList(reg_t planeObject, FrameoutList &itemList);
-	bool isPictureOutOfView(FrameoutEntry *itemEntry, Common::Rect planeRect, int16 planeOffsetX, int16 planeOffsetY);
-	void drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored);
+	bool prepareScreenItem(const PlaneEntry &plane, FrameoutEntry *itemEntry);
+	void drawPlane(const PlaneEntry &plane, const FrameoutDrawList &drawList);
+	void drawDirtyRects(const FrameoutRectList &rects);
+	bool isPictureOutOfView(const FrameoutEntry *itemEntry, Common::Rect planeRect, int16 planeOffsetX, int16 planeOffsetY);
+	void drawPicture(const FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored);
 
 	SegManager *_segMan;
 	ResourceManager *_resMan;
@@ -166,6 +203,7 @@ private:
 	GfxPaint32 *_paint32;
 
 	FrameoutList _screenItems;
+	FrameoutMap _screenItemMap;
 	PlaneList _planes;
 	PlanePictureList _planePictures;
 	ScrollTextList _scrollTexts;
@@ -173,6 +211,22 @@ private:
 	bool _showScrollText;
 	uint16 _maxScrollTexts;
 
+	/**
+	 * Screen areas which changed since the last frame. Only the planes which
+	 * cover them are redrawn, and only these areas are copied to the screen.
+	 */
+	Graphics::DirtyRectList _dirtyRects;
+	bool _fullRedraw;
+	bool _alwaysFullRedraw;
+
+	bool _showDirtyRects;
+	FrameoutRectList _overlayRects;
+
+	uint32 _framesDrawn;
+	uint32 _framesSkipped;
+	uint32 _fullRedraws;
+	uint32 _pixelsCopied;
+
 	void sortPlanes();
 };
 
@@ -56,16 +56,16 @@ GuiResourceId GfxText16::GetFontId() {
 	return _ports->_curPort->fontId;
 }
 
+// The font is always fetched again, as the cache may have evicted the last one
+// since an earlier frame
 GfxFont *GfxText16::GetFont() {
-	if ((_font == NULL) || (_font->getResourceId() != _ports->_curPort->fontId))
-		_font = _cache->getFont(_ports->_curPort->fontId);
+	_font = _cache->getFont(_ports->_curPort->fontId);
 
 	return _font;
 }
 
 void GfxText16::SetFont(GuiResourceId fontId) {
-	if ((_font == NULL) || (_font->getResourceId() != fontId))
-		_font = _cache->getFont(fontId);
+	_font = _cache->getFont(fontId);
 
 	_ports->_curPort->fontId = _font->getResourceId();
 	_ports->_curPort->fontHeight = _font->getHeight();
@@ -35,6 +35,11 @@ GfxView::GfxView(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette
 	assert(resourceId != -1);
 	_coordAdjuster = g_sci->_gfxCoordAdjuster;
 	initData(resourceId);
+
+	// Unpacked cels are added by getBitmap()
+	_memoryUsage = sizeof(GfxView) + _resourceSize + _loopCount * sizeof(LoopInfo);
+	for (uint16 loopNo = 0; loopNo < _loopCount; loopNo++)
+		_memoryUsage += _loop[loopNo].celCount * sizeof(CelInfo);
 }
 
 GfxView::~GfxView() {
@@ -590,6 +595,7 @@ const byte *GfxView::getBitmap(int16 loopNo, int16 celNo) {
 	// allocating memory to store cel's bitmap
 	int pixelCount = width * height;
 	_loop[loopNo].cel[celNo].rawBitmap = new byte[pixelCount];
+	_memoryUsage += pixelCount;
 	byte *pBitmap = _loop[loopNo].cel[celNo].rawBitmap;
 
 	// unpack the actual cel bitmap data
@@ -79,6 +79,9 @@ public:
 	uint16 getCelCount(int16 loopNo) const;
 	Palette *getPalette();
 
+	/** Returns the memory used by the view, including the unpacked cels. */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
 	bool isScaleable();
 	bool isSci2Hires();
 
@@ -101,6 +104,7 @@ private:
 	Resource *_resource;
 	byte *_resourceData;
 	int _resourceSize;
+	uint32 _memoryUsage;
 
 	uint16 _loopCount;
 	LoopInfo *_loop;
@@ -22,13 +22,17 @@
 
 // Resource library
 
+#include "common/algorithm.h"
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
 #include "sci/resource_intern.h"
+#include "sci/engine/vm.h"	// for op_ldi and op_pushi
 #include "sci/util.h"
 
 namespace Sci {
@@ -367,7 +371,15 @@ Common::SeekableReadStream *ResourceManager::getVolumeFile(ResourceSource *sourc
 }
 
 void ResourceManager::loadResource(Resource *res) {
+	const uint32 startTime = g_system->getMillis();
+
 	res->_source->loadResource(this, res);
+
+	_loadStats.reads++;
+	_loadStats.bytes += res->size;
+	_loadStats.time += g_system->getMillis() - startTime;
+	if (_prefetching)
+		_loadStats.prefetched++;
 }
 
 
@@ -887,12 +899,21 @@ ResourceManager::ResourceManager() {
 }
 
 void ResourceManager::init(bool initFromFallbackDetector) {
+	_maxMemoryLRU = kDefaultMaxMemory;
+	if (ConfMan.hasKey("sci_resource_cache_size"))
+		_maxMemoryLRU = MAX(ConfMan.getInt("sci_resource_cache_size"), 0) * 1024;
 	_memoryLocked = 0;
 	_memoryLRU = 0;
 	_LRU.clear();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
+	_currentRoom = -1;
+	memset(&_loadStats, 0, sizeof(_loadStats));
+	_prefetchQueue.clear();
+	_prefetching = false;
+	_maxPrefetchTime = 0;
+
 	// FIXME: put this in an Init() function, so that we can error out if detection fails completely
 
 	_mapVersion = detectMapVersion();
@@ -1030,7 +1051,7 @@ void ResourceManager::printLRU() {
 }
 
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
+	while (_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
 		Resource *goner = *_LRU.reverse_begin();
 		removeFromLRU(goner);
@@ -1041,6 +1062,101 @@ void ResourceManager::freeOldResources() {
 	}
 }
 
+void ResourceManager::setCurrentRoom(uint16 roomNumber) {
+	if (roomNumber == _currentRoom)
+		return;
+
+	if (_currentRoom != -1) {
+		debugC(1, kDebugLevelResMan, "resMan: Room %d: %d resources (%d prefetched, %d bytes) read in %d ms",
+				_currentRoom, _loadStats.reads, _loadStats.prefetched, _loadStats.bytes, _loadStats.time);
+	}
+
+	_currentRoom = roomNumber;
+	memset(&_loadStats, 0, sizeof(_loadStats));
+	_prefetchQueue.clear();
+
+	// Guess the rooms which may follow from the constants which the room's
+	// script loads or pushes. By convention, a room has a script and a
+	// picture with its number, which filters out most other constants.
+	Resource *script = testResource(ResourceId(kResourceTypeScript, roomNumber));
+	if (!script || !script->data)
+		return;
+
+	Common::Array<uint16> rooms;
+	for (uint32 offset = 0; offset + 1 < script->size && rooms.size() < kMaxPrefetchRooms; offset++) {
+		const byte opcode = script->data[offset] >> 1;
+		if (opcode != op_ldi && opcode != op_pushi)
+			continue;
+
+		uint16 number;
+		if (script->data[offset] & 1)
+			number = script->data[offset + 1];
+		else if (offset + 2 < script->size)
+			number = READ_SCI11ENDIAN_UINT16(script->data + offset + 1);
+		else
+			break;
+
+		if (number == roomNumber || Common::find(rooms.begin(), rooms.end(), number) != rooms.end())
+			continue;
+		if (!testResource(ResourceId(kResourceTypeScript, number)) || !testResource(ResourceId(kResourceTypePic, number)))
+			continue;
+
+		rooms.push_back(number);
+		queueRoomPrefetch(number);
+	}
+}
+
+void ResourceManager::queueRoomPrefetch(uint16 roomNumber) {
+	static const ResourceType types[] = {
+		kResourceTypeScript, kResourceTypeHeap, kResourceTypePic, kResourceTypeView
+	};
+
+	for (uint i = 0; i < ARRAYSIZE(types); i++) {
+		ResourceId id(types[i], roomNumber);
+		if (testResource(id))
+			_prefetchQueue.push(id);
+	}
+}
+
+bool ResourceManager::prefetchNext(uint32 idleTime) {
+	// Decompressing a resource can't be interrupted, so only prefetch when
+	// there is plenty of time left compared to the slowest prefetch so far
+	if (idleTime < MAX<uint32>(kMinPrefetchIdleTime, 2 * _maxPrefetchTime))
+		return false;
+
+	while (!_prefetchQueue.empty()) {
+		Resource *res = testResource(_prefetchQueue.pop());
+		if (!res || res->_status != kResStatusNoMalloc)
+			continue;
+
+		// Prefetching must never push other resources out of memory. The
+		// size of most resources is only known after loading them, so the
+		// resource is loaded directly, without freeOldResources(), and
+		// dropped again if it turns out not to fit.
+		if (_memoryLRU + (int)res->size > _maxMemoryLRU) {
+			if (_memoryLRU >= _maxMemoryLRU)
+				_prefetchQueue.clear();
+			continue;
+		}
+
+		const uint32 startTime = g_system->getMillis();
+		_prefetching = true;
+		loadResource(res);
+		_prefetching = false;
+		_maxPrefetchTime = MAX(_maxPrefetchTime, g_system->getMillis() - startTime);
+
+		if (res->_status == kResStatusAllocated) {
+			if (_memoryLRU + (int)res->size > _maxMemoryLRU)
+				res->unalloc();
+			else
+				addToLRU(res);
+		}
+		return true;
+	}
+
+	return false;
+}
+
 Common::List<ResourceId> ResourceManager::listResources(ResourceType type, int mapNumber) {
 	Common::List<ResourceId> resources;
 
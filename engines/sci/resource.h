@@ -26,6 +26,7 @@
 #include "common/str.h"
 #include "common/list.h"
 #include "common/hashmap.h"
+#include "common/queue.h"
 
 #include "sci/graphics/helpers.h"		// for ViewType
 #include "sci/decompressor.h"
@@ -378,17 +379,52 @@ public:
 	 */
 	ResourceType convertResType(byte type);
 
+	/**
+	 * Tells the resource manager which room the game is in. When the room
+	 * has changed, the disk reads of the previous room are reported, and
+	 * the resources of the rooms which the new room's script refers to are
+	 * queued for prefetching.
+	 * @param roomNumber	The current room number
+	 */
+	void setCurrentRoom(uint16 roomNumber);
+
+	/**
+	 * Loads the next resource queued for prefetching, as long as it fits
+	 * into the memory budget. Meant to be called while the game is idle.
+	 * Nothing is loaded when the idle time is short compared to the
+	 * slowest prefetch so far.
+	 * @param idleTime	Milliseconds until the game continues
+	 * @return true if a resource was loaded
+	 */
+	bool prefetchNext(uint32 idleTime);
+
 protected:
-	// Maximum number of bytes to allow being allocated for resources
-	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
-	// for resources which are not explicitly locked. However, a warning will be
-	// issued whenever this limit is exceeded.
+	// Default number of bytes to allow being allocated for resources, which
+	// can be changed with the "sci_resource_cache_size" config key (in KB).
+	// Note: this will not be interpreted as a hard limit, only as a restriction
+	// for resources which are not explicitly locked.
+	// Ports with little RAM keep the budget SCI used to have.
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+#if defined(__DS__) || defined(__PSP__) || defined(__N64__) || defined(__PLAYSTATION2__) || defined(__DC__) || defined(__GP32__) || defined(GP2X) || defined(_WIN32_WCE)
+		kDefaultMaxMemory = 256 * 1024,	// 256KB
+#else
+		kDefaultMaxMemory = 32 * 1024 * 1024,	// 32MB
+#endif
+		kMaxPrefetchRooms = 4,	///< Maximum number of rooms to prefetch for each room change
+		kMinPrefetchIdleTime = 20	///< Idle milliseconds needed to prefetch a resource
+	};
+
+	/** Disk reads since the last room change */
+	struct LoadStats {
+		uint32 reads;		///< Number of resources loaded
+		uint32 bytes;		///< Total size of the loaded resources
+		uint32 time;		///< Milliseconds spent reading and decompressing
+		uint32 prefetched;	///< Number of resources loaded by prefetchNext()
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
+	int _maxMemoryLRU;	///< Amount of resource bytes allowed under LRU control
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
 	Common::List<Resource *> _LRU; ///< Last Resource Used list
@@ -398,6 +434,12 @@ protected:
 	ResVersion _volVersion; ///< resource.0xx version
 	ResVersion _mapVersion; ///< resource.map version
 
+	int _currentRoom; ///< Room number passed to setCurrentRoom(), or -1
+	LoadStats _loadStats;
+	Common::Queue<ResourceId> _prefetchQueue;
+	bool _prefetching; ///< Set while prefetchNext() loads a resource
+	uint32 _maxPrefetchTime; ///< Milliseconds taken by the slowest prefetch
+
 	/**
 	 * Add a path to the resource manager's list of sources.
 	 * @return a pointer to the added source structure, or NULL if an error occurred.
@@ -512,6 +554,9 @@ protected:
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
 
+	/** Queues the script, heap, picture and view of a room for prefetching. */
+	void queueRoomPrefetch(uint16 roomNumber);
+
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
 	bool hasSci0Voc999();
@@ -116,6 +116,7 @@ SciEngine::SciEngine(OSystem *syst, const ADGameDescription *desc, SciGameId gam
 	DebugMan.addDebugChannel(kDebugLevelResMan, "ResMan", "Resource manager debugging");
 	DebugMan.addDebugChannel(kDebugLevelOnStartup, "OnStartup", "Enter debugger at start of game");
 	DebugMan.addDebugChannel(kDebugLevelDebugMode, "DebugMode", "Enable game debug mode at start of game");
+	DebugMan.addDebugChannel(kDebugLevelVMStats, "VMStats", "Report the VM instructions per second");
 
 	const Common::FSNode gameDataDir(ConfMan.get("path"));
 
@@ -637,7 +638,7 @@ void SciEngine::initGraphics() {
 
 	_gfxPalette = new GfxPalette(_resMan, _gfxScreen);
 	_gfxCache = new GfxCache(_resMan, _gfxScreen, _gfxPalette);
-	_gfxCursor = new GfxCursor(_resMan, _gfxPalette, _gfxScreen);
+	_gfxCursor = new GfxCursor(_resMan, _gfxPalette, _gfxScreen, _gfxCache);
 
 #ifdef ENABLE_SCI32
 	if (getSciVersion() >= SCI_VERSION_2) {
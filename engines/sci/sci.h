@@ -103,7 +103,8 @@ enum kDebugLevels {
 	kDebugLevelGC         = 1 << 18,
 	kDebugLevelResMan     = 1 << 19,
 	kDebugLevelOnStartup  = 1 << 20,
-	kDebugLevelDebugMode  = 1 << 21
+	kDebugLevelDebugMode  = 1 << 21,
+	kDebugLevelVMStats    = 1 << 22
 };
 
 enum SciGameId {
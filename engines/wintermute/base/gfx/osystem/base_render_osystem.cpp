@@ -34,12 +34,16 @@
 #include "engines/wintermute/math/math_util.h"
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/base_sprite.h"
+#include "engines/wintermute/wintermute.h"
 #include "common/system.h"
-#include "engines/wintermute/graphics/transparent_surface.h"
+#include "common/debug.h"
+#include "graphics/transparent_surface.h"
 #include "common/queue.h"
 #include "common/config-manager.h"
 
 #define DIRTY_RECT_LIMIT 800
+// Default memory budget for scaled sprites, in KB
+#define SPRITE_CACHE_SIZE 16384
 
 namespace Wintermute {
 
@@ -48,7 +52,7 @@ BaseRenderer *makeOSystemRenderer(BaseGame *inGame) {
 }
 
 //////////////////////////////////////////////////////////////////////////
-BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
+BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame), _scaledSurfaceCache(SPRITE_CACHE_SIZE * 1024) {
 	_renderSurface = new Graphics::Surface();
 	_blankSurface = new Graphics::Surface();
 	_drawNum = 1;
@@ -62,12 +66,18 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 	_ratioX = _ratioY = 1.0f;
 	setAlphaMod(255);
 	setColorMod(255, 255, 255);
-	_dirtyRect = nullptr;
 	_disableDirtyRects = false;
 	_tempDisableDirtyRects = 0;
+	_frameStats.dirtyRects = 0;
+	_frameStats.dirtyPixels = 0;
+	_frameStats.blittedPixels = 0;
+	_frameStats.culledTickets = 0;
 	if (ConfMan.hasKey("dirty_rects")) {
 		_disableDirtyRects = !ConfMan.getBool("dirty_rects");
 	}
+	if (ConfMan.hasKey("sprite_cache_size")) {
+		_scaledSurfaceCache.setBudget((uint32)MAX(ConfMan.getInt("sprite_cache_size"), 0) * 1024);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -79,13 +89,11 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 		delete ticket;
 	}
 
-	delete _dirtyRect;
-
 	_renderSurface->free();
 	delete _renderSurface;
 	_blankSurface->free();
 	delete _blankSurface;
-	TransparentSurface::destroyLookup();
+	Graphics::TransparentSurface::destroyLookup();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -174,8 +182,7 @@ bool BaseRenderOSystem::flip() {
 	}
 	if (_skipThisFrame) {
 		_skipThisFrame = false;
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		g_system->updateScreen();
 		_needsFlip = false;
 		_drawNum = 1;
@@ -202,9 +209,7 @@ bool BaseRenderOSystem::flip() {
 		if (_disableDirtyRects || _tempDisableDirtyRects) {
 			g_system->copyRectToScreen((byte *)_renderSurface->pixels, _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
 		}
-		//  g_system->copyRectToScreen((byte *)_renderSurface->pixels, _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		g_system->updateScreen();
 		_needsFlip = false;
 	}
@@ -299,8 +304,14 @@ Graphics::PixelFormat BaseRenderOSystem::getPixelFormat() const {
 }
 
 void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, bool mirrorX, bool mirrorY, bool disableAlpha) {
+	// Only copies of the owner's own surface can be cached, repeatLastDraw() passes the ticket's copy instead
+	ScaledSurfaceCache *cache = nullptr;
+	if (owner && surf == owner->getSurface()) {
+		cache = &_scaledSurfaceCache;
+	}
+
 	if (_tempDisableDirtyRects || _disableDirtyRects) {
-		RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, mirrorX, mirrorY, disableAlpha);
+		RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, mirrorX, mirrorY, disableAlpha, cache);
 		ticket->_colorMod = _colorMod;
 		ticket->_wantsDraw = true;
 		_renderQueue.push_back(ticket);
@@ -349,7 +360,7 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 			}
 		}
 	}
-	RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, mirrorX, mirrorY, disableAlpha);
+	RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, mirrorX, mirrorY, disableAlpha, cache);
 	ticket->_colorMod = _colorMod;
 	if (!_disableDirtyRects) {
 		drawFromTicket(ticket);
@@ -409,6 +420,7 @@ void BaseRenderOSystem::invalidateTicket(RenderTicket *renderTicket) {
 }
 
 void BaseRenderOSystem::invalidateTicketsFromSurface(BaseSurfaceOSystem *surf) {
+	_scaledSurfaceCache.invalidate(surf);
 	RenderQueueIterator it;
 	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
 		if ((*it)->_owner == surf) {
@@ -476,12 +488,7 @@ void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
 }
 
 void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
-	if (!_dirtyRect) {
-		_dirtyRect = new Common::Rect(rect);
-	} else {
-		_dirtyRect->extend(rect);
-	}
-	_dirtyRect->clip(_renderRect);
+	_dirtyRects.addDirtyRect(rect, _renderRect);
 }
 
 void BaseRenderOSystem::drawTickets() {
@@ -503,7 +510,7 @@ void BaseRenderOSystem::drawTickets() {
 			++it;
 		}
 	}
-	if (!_dirtyRect || _dirtyRect->width() == 0 || _dirtyRect->height() == 0) {
+	if (_dirtyRects.isEmpty()) {
 		it = _renderQueue.begin();
 		while (it != _renderQueue.end()) {
 			RenderTicket *ticket = *it;
@@ -516,37 +523,40 @@ void BaseRenderOSystem::drawTickets() {
 	// draw, we need to keep track of what it was prior to draw.
 	uint32 oldColorMod = _colorMod;
 
-	// Apply the clear-color to the dirty rect.
-	_renderSurface->fillRect(*_dirtyRect, _clearColor);
+	_drawOrder.resize(0);
 	_drawNum = 1;
 	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
 		RenderTicket *ticket = *it;
 		assert(ticket->_drawNum == _drawNum);
 		++_drawNum;
-		if (ticket->_dstRect.intersects(*_dirtyRect)) {
-			// dstClip is the area we want redrawn.
-			Common::Rect dstClip(ticket->_dstRect);
-			// reduce it to the dirty rect
-			dstClip.clip(*_dirtyRect);
-			// we need to keep track of the position to redraw the dirty rect
-			Common::Rect pos(dstClip);
-			int16 offsetX = ticket->_dstRect.left;
-			int16 offsetY = ticket->_dstRect.top;
-			// convert from screen-coords to surface-coords.
-			dstClip.translate(-offsetX, -offsetY);
-
-			_colorMod = ticket->_colorMod;
-			drawFromSurface(ticket, &pos, &dstClip);
-			_needsFlip = true;
-		}
+		_drawOrder.push_back(ticket);
 		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
 		ticket->_wantsDraw = false;
 	}
-	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(_dirtyRect->left, _dirtyRect->top), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
+
+	_frameStats.dirtyPixels = 0;
+	_frameStats.blittedPixels = 0;
+	_frameStats.culledTickets = 0;
+
+	// Each part of the dirty region is redrawn and copied to the screen separately,
+	// so changes far apart from each other don't force a redraw of everything in between.
+	const Common::Array<Common::Rect> &dirtyRects = _dirtyRects.getRects();
+	for (uint i = 0; i < dirtyRects.size(); i++) {
+		const Common::Rect &dirtyRect = dirtyRects[i];
+		drawDirtyRect(dirtyRect);
+		g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(dirtyRect.left, dirtyRect.top), _renderSurface->pitch, dirtyRect.left, dirtyRect.top, dirtyRect.width(), dirtyRect.height());
+		_frameStats.dirtyPixels += dirtyRect.width() * dirtyRect.height();
+	}
+	_frameStats.dirtyRects = dirtyRects.size();
+	_needsFlip = true;
+
+	debugC(kWintermuteDebugRender, "Redrew %d rects: %d of %d pixels on screen, %d pixels blitted, %d tickets culled",
+	       _frameStats.dirtyRects, _frameStats.dirtyPixels, _renderSurface->w * _renderSurface->h,
+	       _frameStats.blittedPixels, _frameStats.culledTickets);
 
 	// Revert the colorMod-state.
 	_colorMod = oldColorMod;
-	
+
 	it = _renderQueue.begin();
 	// Clean out the old tickets
 	decrement = 0;
@@ -565,6 +575,63 @@ void BaseRenderOSystem::drawTickets() {
 
 }
 
+void BaseRenderOSystem::drawDirtyRect(const Common::Rect &dirtyRect) {
+	// Walk the tickets from the top down to find out which of them are actually
+	// visible: a ticket is skipped if its part of the dirty rect is entirely
+	// covered by an opaque ticket above it.
+	_visibleTickets.resize(0);
+	_occluders.resize(0);
+	bool covered = false;
+	for (int i = (int)_drawOrder.size() - 1; i >= 0; i--) {
+		RenderTicket *ticket = _drawOrder[i];
+		if (!ticket->_dstRect.intersects(dirtyRect)) {
+			continue;
+		}
+		Common::Rect visible = ticket->_dstRect.findIntersectingRect(dirtyRect);
+		bool hidden = false;
+		for (uint j = 0; j < _occluders.size(); j++) {
+			if (_occluders[j].contains(visible)) {
+				hidden = true;
+				break;
+			}
+		}
+		if (hidden) {
+			_frameStats.culledTickets++;
+			continue;
+		}
+		_visibleTickets.push_back(i);
+		if (ticket->isOpaque()) {
+			if (visible == dirtyRect) {
+				// Nothing below this one can show through.
+				covered = true;
+				break;
+			}
+			_occluders.push_back(visible);
+		}
+	}
+
+	if (!covered) {
+		// Apply the clear-color to the dirty rect.
+		_renderSurface->fillRect(dirtyRect, _clearColor);
+	}
+
+	for (int i = (int)_visibleTickets.size() - 1; i >= 0; i--) {
+		RenderTicket *ticket = _drawOrder[_visibleTickets[i]];
+		// dstClip is the area we want redrawn.
+		Common::Rect dstClip = ticket->_dstRect.findIntersectingRect(dirtyRect);
+		// we need to keep track of the position to redraw the dirty rect
+		Common::Rect pos(dstClip);
+		int16 offsetX = ticket->_dstRect.left;
+		int16 offsetY = ticket->_dstRect.top;
+		// convert from screen-coords to surface-coords.
+		dstClip.translate(-offsetX, -offsetY);
+
+		_colorMod = ticket->_colorMod;
+		drawFromSurface(ticket, &pos, &dstClip);
+		_frameStats.blittedPixels += pos.width() * pos.height();
+	}
+}
+
 // Replacement for SDL2's SDL_RenderCopy
 void BaseRenderOSystem::drawFromSurface(RenderTicket *ticket) {
 	ticket->drawToSurface(_renderSurface);
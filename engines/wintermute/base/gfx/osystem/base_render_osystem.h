@@ -30,6 +30,8 @@
 #define WINTERMUTE_BASE_RENDERER_SDL_H
 
 #include "engines/wintermute/base/gfx/base_renderer.h"
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
+#include "engines/wintermute/base/gfx/osystem/scaled_surface_cache.h"
 #include "common/rect.h"
 #include "graphics/surface.h"
 #include "common/list.h"
@@ -39,6 +41,14 @@ class BaseSurfaceOSystem;
 class RenderTicket;
 class BaseRenderOSystem : public BaseRenderer {
 public:
+	/** Statistics about the last frame drawn with dirty rects. */
+	struct FrameStats {
+		uint32 dirtyRects;      ///< number of rects the dirty region was split into
+		uint32 dirtyPixels;     ///< pixels copied to the screen
+		uint32 blittedPixels;   ///< pixels drawn by tickets, overdraw included
+		uint32 culledTickets;   ///< tickets skipped as hidden behind opaque ones
+	};
+
 	BaseRenderOSystem(BaseGame *inGame);
 	~BaseRenderOSystem();
 
@@ -83,16 +93,26 @@ public:
 	void drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, bool mirrorX, bool mirrorY, bool disableAlpha = false) ;
 	void repeatLastDraw(int offsetX, int offsetY, int numTimesX, int numTimesY);
 	BaseSurface *createSurface() override;
+
+	const FrameStats &getFrameStats() const { return _frameStats; }
+	ScaledSurfaceCache &getScaledSurfaceCache() { return _scaledSurfaceCache; }
 private:
 	void addDirtyRect(const Common::Rect &rect) ;
 	void drawTickets();
+	void drawDirtyRect(const Common::Rect &dirtyRect);
 	// Non-dirty-rects:
 	void drawFromSurface(RenderTicket *ticket);
 	// Dirty-rects:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
 	typedef Common::List<RenderTicket *>::iterator RenderQueueIterator;
-	Common::Rect *_dirtyRect;
+	DirtyRectContainer _dirtyRects;
 	Common::List<RenderTicket *> _renderQueue;
+	// Scratch space for drawTickets(), kept around to avoid reallocating every frame
+	Common::Array<RenderTicket *> _drawOrder;
+	Common::Array<uint> _visibleTickets;
+	Common::Array<Common::Rect> _occluders;
+	FrameStats _frameStats;
+	ScaledSurfaceCache _scaledSurfaceCache;
 	RenderQueueIterator _lastAddedTicket;
 	RenderTicket *_previousTicket;
 
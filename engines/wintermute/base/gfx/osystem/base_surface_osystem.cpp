@@ -36,7 +36,7 @@
 #include "graphics/decoders/bmp.h"
 #include "graphics/decoders/jpeg.h"
 #include "graphics/decoders/tga.h"
-#include "engines/wintermute/graphics/transparent_surface.h"
+#include "graphics/transparent_surface.h"
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 #include "common/stream.h"
@@ -165,13 +165,17 @@ bool BaseSurfaceOSystem::finishLoad() {
 	}
 	
 	if (needsColorKey) {
-		TransparentSurface trans(*_surface);
+		Graphics::TransparentSurface trans(*_surface);
 		trans.applyColorKey(_ckRed, _ckGreen, _ckBlue, replaceAlpha);
 	}
 
 	_hasAlpha = hasTransparency(_surface);
 	_valid = true;
 
+	// Drop anything made from the previous contents
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->invalidateTicketsFromSurface(this);
+
 	_gameRef->addMem(_width * _height * 4);
 
 	delete image;
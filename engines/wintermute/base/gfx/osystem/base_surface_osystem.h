@@ -34,7 +34,6 @@
 #include "common/list.h"
 
 namespace Wintermute {
-struct TransparentSurface;
 class BaseImage;
 class BaseSurfaceOSystem : public BaseSurface {
 public:
@@ -59,6 +58,7 @@ public:
 	bool displayTransform(int x, int y, int hotX, int hotY, Rect32 Rect, float zoomX, float zoomY, uint32 alpha, float rotate, TSpriteBlendMode blendMode = BLEND_NORMAL, bool mirrorX = false, bool mirrorY = false) override;
 	bool repeatLastDisplayOp(int offsetX, int offsetY, int numTimesX, int numTimesY) override;
 	virtual bool putSurface(const Graphics::Surface &surface, bool hasAlpha = false) override;
+	const Graphics::Surface *getSurface() const { return _surface; }
 	/*  static unsigned DLL_CALLCONV ReadProc(void *buffer, unsigned size, unsigned count, fi_handle handle);
 	    static int DLL_CALLCONV SeekProc(fi_handle handle, long offset, int origin);
 	    static long DLL_CALLCONV TellProc(fi_handle handle);*/
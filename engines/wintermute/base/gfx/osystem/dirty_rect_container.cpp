@@ -0,0 +1,164 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
+
+namespace Wintermute {
+
+DirtyRectContainer::DirtyRectContainer() : _disjointValid(true) {
+}
+
+void DirtyRectContainer::addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect) {
+	Common::Rect newRect = rect.findIntersectingRect(clipRect);
+	if (newRect.isEmpty()) {
+		return;
+	}
+
+	uint i = 0;
+	while (i < _rects.size()) {
+		if (_rects[i].contains(newRect)) {
+			return;
+		}
+		if (newRect.contains(_rects[i]) || shouldMerge(_rects[i], newRect)) {
+			newRect.extend(_rects[i]);
+			_rects[i] = _rects.back();
+			_rects.pop_back();
+			// The grown rect might now be worth merging with rects we already checked
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if (_rects.size() >= kMaxDirtyRects) {
+		// Too fragmented to be worth it, fall back to a single rect.
+		for (i = 0; i < _rects.size(); i++) {
+			newRect.extend(_rects[i]);
+		}
+		_rects.resize(0);
+	}
+	_rects.push_back(newRect);
+	_disjointValid = false;
+}
+
+void DirtyRectContainer::reset() {
+	_rects.resize(0);
+	_disjointRects.resize(0);
+	_disjointValid = true;
+}
+
+bool DirtyRectContainer::shouldMerge(const Common::Rect &a, const Common::Rect &b) {
+	Common::Rect merged(a);
+	merged.extend(b);
+	uint32 covered = area(a) + area(b) - area(a.findIntersectingRect(b));
+	uint32 waste = area(merged) - covered;
+
+	// Small rects close to each other are always merged, larger ones only
+	// if they overlap or touch, and the merged rect is mostly dirty anyway.
+	if (waste <= kMergeSlack) {
+		return true;
+	}
+	bool touching = (a.left <= b.right) && (b.left <= a.right) && (a.top <= b.bottom) && (b.top <= a.bottom);
+	return touching && waste * 4 <= area(merged);
+}
+
+void DirtyRectContainer::subtract(const Common::Rect &rect, const Common::Rect &hole, Common::Array<Common::Rect> &out) {
+	Common::Rect inner = rect.findIntersectingRect(hole);
+	if (inner.isEmpty()) {
+		out.push_back(rect);
+		return;
+	}
+	// Full-width bands above and below the hole, then what's left on either side of it.
+	if (rect.top < inner.top) {
+		out.push_back(Common::Rect(rect.left, rect.top, rect.right, inner.top));
+	}
+	if (inner.bottom < rect.bottom) {
+		out.push_back(Common::Rect(rect.left, inner.bottom, rect.right, rect.bottom));
+	}
+	if (rect.left < inner.left) {
+		out.push_back(Common::Rect(rect.left, inner.top, inner.left, inner.bottom));
+	}
+	if (inner.right < rect.right) {
+		out.push_back(Common::Rect(inner.right, inner.top, rect.right, inner.bottom));
+	}
+}
+
+void DirtyRectContainer::coalesce() {
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (uint i = 0; i < _disjointRects.size(); i++) {
+			for (uint j = i + 1; j < _disjointRects.size(); j++) {
+				Common::Rect &a = _disjointRects[i];
+				const Common::Rect &b = _disjointRects[j];
+				bool sameRows = (a.top == b.top && a.bottom == b.bottom);
+				bool sameColumns = (a.left == b.left && a.right == b.right);
+				if ((sameRows && (a.right == b.left || b.right == a.left)) ||
+				    (sameColumns && (a.bottom == b.top || b.bottom == a.top))) {
+					a.extend(b);
+					_disjointRects.remove_at(j);
+					merged = true;
+					j--;
+				}
+			}
+		}
+	}
+}
+
+const Common::Array<Common::Rect> &DirtyRectContainer::getRects() {
+	if (_disjointValid) {
+		return _disjointRects;
+	}
+
+	// Cut away the parts of each rect that are already covered by the ones before it.
+	_disjointRects.resize(0);
+	Common::Array<Common::Rect> pieces;
+	Common::Array<Common::Rect> remaining;
+	for (uint i = 0; i < _rects.size(); i++) {
+		pieces.resize(0);
+		pieces.push_back(_rects[i]);
+		uint numDisjoint = _disjointRects.size();
+		for (uint j = 0; j < numDisjoint && !pieces.empty(); j++) {
+			remaining.resize(0);
+			for (uint k = 0; k < pieces.size(); k++) {
+				subtract(pieces[k], _disjointRects[j], remaining);
+			}
+			pieces = remaining;
+		}
+		_disjointRects.push_back(pieces);
+	}
+	coalesce();
+
+	_disjointValid = true;
+	return _disjointRects;
+}
+
+uint32 DirtyRectContainer::getArea() {
+	const Common::Array<Common::Rect> &rects = getRects();
+	uint32 total = 0;
+	for (uint i = 0; i < rects.size(); i++) {
+		total += area(rects[i]);
+	}
+	return total;
+}
+
+} // end of namespace Wintermute
@@ -0,0 +1,81 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_DIRTY_RECT_CONTAINER_H
+#define WINTERMUTE_DIRTY_RECT_CONTAINER_H
+
+#include "common/rect.h"
+#include "common/array.h"
+
+namespace Wintermute {
+
+/**
+ * Keeps track of the areas of the screen that need to be redrawn.
+ *
+ * Rather than growing a single rectangle, which for a sprite in one corner
+ * and the cursor in the other ends up covering the whole screen, the region
+ * is stored as a small set of rectangles. Rectangles that overlap or touch
+ * are merged as long as that does not add much area which isn't dirty, and
+ * once there are too many of them everything is merged into their bounding
+ * rectangle. getRects() returns the region as non-overlapping rectangles.
+ */
+class DirtyRectContainer {
+public:
+	DirtyRectContainer();
+
+	/** Add a rectangle to the region, clipped to clipRect. */
+	void addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect);
+
+	/** Empty the region. */
+	void reset();
+
+	bool isEmpty() const { return _rects.empty(); }
+
+	/**
+	 * Return the region as a list of non-overlapping rectangles. Pieces which
+	 * line up are coalesced again, to keep the number of blits down.
+	 */
+	const Common::Array<Common::Rect> &getRects();
+
+	/** Return the number of pixels covered by the region. */
+	uint32 getArea();
+
+private:
+	enum {
+		kMaxDirtyRects = 32,
+		/** Area that may always be added by a merge, in pixels. */
+		kMergeSlack = 32 * 32
+	};
+
+	static uint32 area(const Common::Rect &rect) { return (uint32)rect.width() * rect.height(); }
+	static bool shouldMerge(const Common::Rect &a, const Common::Rect &b);
+	static void subtract(const Common::Rect &rect, const Common::Rect &hole, Common::Array<Common::Rect> &out);
+	void coalesce();
+
+	Common::Array<Common::Rect> _rects;
+	Common::Array<Common::Rect> _disjointRects;
+	bool _disjointValid;
+};
+
+} // end of namespace Wintermute
+
+#endif
@@ -26,48 +26,47 @@
  * Copyright (c) 2011 Jan Nedoma
  */
 
-#include "engines/wintermute/graphics/transparent_surface.h"
+#include "graphics/transparent_surface.h"
 #include "engines/wintermute/base/gfx/osystem/render_ticket.h"
+#include "engines/wintermute/base/gfx/osystem/scaled_surface_cache.h"
 
 namespace Wintermute {
 
-RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, bool mirrorX, bool mirrorY, bool disableAlpha) : _owner(owner),
+RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, bool mirrorX, bool mirrorY, bool disableAlpha, ScaledSurfaceCache *cache) : _owner(owner),
 _srcRect(*srcRect), _dstRect(*dstRect), _drawNum(0), _isValid(true), _wantsDraw(true), _hasAlpha(!disableAlpha) {
 	_colorMod = 0;
 	_batchNum = 0;
-	_mirror = TransparentSurface::FLIP_NONE;
+	_mirror = Graphics::TransparentSurface::FLIP_NONE;
 	if (mirrorX) {
-		_mirror |= TransparentSurface::FLIP_V;
+		_mirror |= Graphics::TransparentSurface::FLIP_V;
 	}
 	if (mirrorY) {
-		_mirror |= TransparentSurface::FLIP_H;
+		_mirror |= Graphics::TransparentSurface::FLIP_H;
 	}
-	if (surf) {
-		_surface = new Graphics::Surface();
-		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
-		assert(_surface->format.bytesPerPixel == 4);
+	bool scaled = dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height();
+	if (surf && scaled && cache) {
+		_surface = cache->getScaledSurface(owner, surf, *srcRect, dstRect->width(), dstRect->height());
+	} else if (surf) {
+		Graphics::Surface *copy = new Graphics::Surface();
+		copy->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
+		assert(copy->format.bytesPerPixel == 4);
 		// Get a clipped copy of the surface
-		for (int i = 0; i < _surface->h; i++) {
-			memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
+		for (int i = 0; i < copy->h; i++) {
+			memcpy(copy->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * copy->format.bytesPerPixel);
 		}
 		// Then scale it if necessary
-		if (dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height()) {
-			TransparentSurface src(*_surface, false);
+		if (scaled) {
+			Graphics::TransparentSurface src(*copy, false);
 			Graphics::Surface *temp = src.scale(dstRect->width(), dstRect->height());
-			_surface->free();
-			delete _surface;
-			_surface = temp;
+			copy->free();
+			delete copy;
+			copy = temp;
 		}
-	} else {
-		_surface = nullptr;
+		_surface = Common::SharedPtr<Graphics::Surface>(copy, Graphics::SharedPtrSurfaceDeleter());
 	}
 }
 
 RenderTicket::~RenderTicket() {
-	if (_surface) {
-		_surface->free();
-		delete _surface;
-	}
 }
 
 bool RenderTicket::operator==(RenderTicket &t) {
@@ -85,7 +84,7 @@ bool RenderTicket::operator==(RenderTicket &t) {
 
 // Replacement for SDL2's SDL_RenderCopy
 void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface) {
-	TransparentSurface src(*getSurface(), false);
+	Graphics::TransparentSurface src(*getSurface(), false);
 
 	Common::Rect clipRect;
 	clipRect.setWidth(getSurface()->w);
@@ -96,7 +95,7 @@ void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface) {
 }
 
 void RenderTicket::drawToSurface(Graphics::Surface *_targetSurface, Common::Rect *dstRect, Common::Rect *clipRect) {
-	TransparentSurface src(*getSurface(), false);
+	Graphics::TransparentSurface src(*getSurface(), false);
 	bool doDelete = false;
 	if (!clipRect) {
 		doDelete = true;
@@ -31,16 +31,19 @@
 
 #include "graphics/surface.h"
 #include "common/rect.h"
+#include "common/ptr.h"
 
 namespace Wintermute {
 
 class BaseSurfaceOSystem;
+class ScaledSurfaceCache;
 class RenderTicket {
 public:
-	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, bool mirrorX = false, bool mirrorY = false, bool disableAlpha = false);
+	// If a cache is passed, scaled copies are taken from it. surf must be the surface of owner then.
+	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, bool mirrorX = false, bool mirrorY = false, bool disableAlpha = false, ScaledSurfaceCache *cache = nullptr);
 	RenderTicket() : _isValid(true), _wantsDraw(false), _drawNum(0) {}
 	~RenderTicket();
-	const Graphics::Surface *getSurface() { return _surface; }
+	const Graphics::Surface *getSurface() { return _surface.get(); }
 	// Non-dirty-rects:
 	void drawToSurface(Graphics::Surface *_targetSurface);
 	// Dirty-rects:
@@ -57,8 +60,10 @@ public:
 	BaseSurfaceOSystem *_owner;
 	bool operator==(RenderTicket &a);
 	const Common::Rect *getSrcRect() { return &_srcRect; }
+	/** Whether drawing this ticket replaces every pixel of its _dstRect. */
+	bool isOpaque() const { return _surface && !_hasAlpha && _colorMod == 0xFFFFFFFF; }
 private:
-	Graphics::Surface *_surface;
+	Common::SharedPtr<Graphics::Surface> _surface;
 	Common::Rect _srcRect;
 	bool _hasAlpha;
 	uint32 _mirror;
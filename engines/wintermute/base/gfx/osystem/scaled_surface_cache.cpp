@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/wintermute/base/gfx/osystem/scaled_surface_cache.h"
+#include "graphics/transparent_surface.h"
+
+namespace Wintermute {
+
+uint ScaledSurfaceCache::KeyHash::operator()(const Key &k) const {
+	uint hash = (uint)((size_t)k._owner >> 3);
+	hash = hash * 31 + (uint16)k._srcRect.left;
+	hash = hash * 31 + (uint16)k._srcRect.top;
+	hash = hash * 31 + (uint16)k._srcRect.right;
+	hash = hash * 31 + (uint16)k._srcRect.bottom;
+	hash = hash * 31 + (uint16)k._width;
+	hash = hash * 31 + (uint16)k._height;
+	return hash;
+}
+
+ScaledSurfaceCache::ScaledSurfaceCache(uint32 budget) : _budget(budget), _memoryUsed(0) {
+	resetStats();
+}
+
+ScaledSurfaceCache::~ScaledSurfaceCache() {
+	clear();
+}
+
+ScaledSurfaceCache::SurfacePtr ScaledSurfaceCache::getScaledSurface(const BaseSurfaceOSystem *owner, const Graphics::Surface *surf, const Common::Rect &srcRect, int16 width, int16 height) {
+	Key key;
+	key._owner = owner;
+	key._srcRect = srcRect;
+	key._width = width;
+	key._height = height;
+
+	LookupMap::iterator it = _lookup.find(key);
+	if (it != _lookup.end()) {
+		_stats.hits++;
+		// Move the entry to the front of the list
+		_entries.splice(_entries.begin(), _entries, it->_value);
+		return it->_value->_surface;
+	}
+
+	_stats.misses++;
+	Graphics::TransparentSurface src(*surf, false);
+	SurfacePtr scaled(src.scale(srcRect, Common::Rect(width, height)), Graphics::SharedPtrSurfaceDeleter());
+
+	uint32 size = scaled->pitch * scaled->h;
+	if (size > _budget) {
+		return scaled;
+	}
+	shrinkTo(_budget - size);
+
+	Entry entry;
+	entry._key = key;
+	entry._surface = scaled;
+	entry._size = size;
+	_entries.push_front(entry);
+	_lookup[key] = _entries.begin();
+	_memoryUsed += size;
+	return scaled;
+}
+
+void ScaledSurfaceCache::invalidate(const BaseSurfaceOSystem *owner) {
+	EntryList::iterator it = _entries.begin();
+	while (it != _entries.end()) {
+		EntryList::iterator next = it;
+		++next;
+		if (it->_key._owner == owner) {
+			removeEntry(it);
+		}
+		it = next;
+	}
+}
+
+void ScaledSurfaceCache::clear() {
+	_entries.clear();
+	_lookup.clear();
+	_memoryUsed = 0;
+}
+
+void ScaledSurfaceCache::setBudget(uint32 budget) {
+	_budget = budget;
+	shrinkTo(budget);
+}
+
+void ScaledSurfaceCache::resetStats() {
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+void ScaledSurfaceCache::removeEntry(EntryList::iterator entry) {
+	_memoryUsed -= entry->_size;
+	_lookup.erase(entry->_key);
+	_entries.erase(entry);
+}
+
+void ScaledSurfaceCache::shrinkTo(uint32 budget) {
+	while (_memoryUsed > budget && !_entries.empty()) {
+		EntryList::iterator last = _entries.end();
+		--last;
+		removeEntry(last);
+		_stats.evictions++;
+	}
+}
+
+} // end of namespace Wintermute
@@ -0,0 +1,117 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_SCALED_SURFACE_CACHE_H
+#define WINTERMUTE_SCALED_SURFACE_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/rect.h"
+#include "graphics/surface.h"
+
+namespace Wintermute {
+
+class BaseSurfaceOSystem;
+
+/**
+ * Keeps the scaled copies RenderTickets make of sprites around, so actors
+ * walking through scale levels don't need to be rescaled every frame while
+ * their zoom doesn't change.
+ *
+ * Entries are keyed by the surface they were made from, the source rect and
+ * the target size. Mirroring is done while blitting, so the same copy serves
+ * all flip modes. The least recently used entries are dropped once the
+ * copies take up more than the memory budget. Surfaces are shared with the
+ * tickets using them, so dropping an entry never invalidates a ticket.
+ */
+class ScaledSurfaceCache {
+public:
+	typedef Common::SharedPtr<Graphics::Surface> SurfacePtr;
+
+	struct Stats {
+		uint32 hits;
+		uint32 misses;
+		uint32 evictions;
+	};
+
+	ScaledSurfaceCache(uint32 budget);
+	~ScaledSurfaceCache();
+
+	/**
+	 * Return srcRect of surf scaled to width x height, making the copy
+	 * if it isn't in the cache yet. surf has to be the surface of owner.
+	 */
+	SurfacePtr getScaledSurface(const BaseSurfaceOSystem *owner, const Graphics::Surface *surf, const Common::Rect &srcRect, int16 width, int16 height);
+
+	/** Forget all copies made from owner, e.g. because it was reloaded. */
+	void invalidate(const BaseSurfaceOSystem *owner);
+	void clear();
+
+	/** Set the memory budget in bytes, 0 disables caching. */
+	void setBudget(uint32 budget);
+	uint32 getBudget() const { return _budget; }
+	uint32 getMemoryUsed() const { return _memoryUsed; }
+	uint32 getNumEntries() const { return _lookup.size(); }
+
+	const Stats &getStats() const { return _stats; }
+	void resetStats();
+
+private:
+	struct Key {
+		const BaseSurfaceOSystem *_owner;
+		Common::Rect _srcRect;
+		int16 _width;
+		int16 _height;
+
+		bool operator==(const Key &k) const {
+			return _owner == k._owner && _srcRect == k._srcRect && _width == k._width && _height == k._height;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &k) const;
+	};
+
+	struct Entry {
+		Key _key;
+		SurfacePtr _surface;
+		uint32 _size;
+	};
+
+	// Most recently used entries first
+	typedef Common::List<Entry> EntryList;
+	typedef Common::HashMap<Key, EntryList::iterator, KeyHash> LookupMap;
+
+	EntryList _entries;
+	LookupMap _lookup;
+	uint32 _budget;
+	uint32 _memoryUsed;
+	Stats _stats;
+
+	void removeEntry(EntryList::iterator entry);
+	void shrinkTo(uint32 budget);
+};
+
+} // end of namespace Wintermute
+
+#endif
@@ -25,12 +25,14 @@
 #include "engines/wintermute/base/base_engine.h"
 #include "engines/wintermute/base/base_file_manager.h"
 #include "engines/wintermute/base/base_game.h"
+#include "engines/wintermute/base/gfx/osystem/base_render_osystem.h"
 
 namespace Wintermute {
 
 Console::Console(WintermuteEngine *vm) : GUI::Debugger(), _engineRef(vm) {
 	DCmd_Register("show_fps", WRAP_METHOD(Console, Cmd_ShowFps));
 	DCmd_Register("dump_file", WRAP_METHOD(Console, Cmd_DumpFile));
+	DCmd_Register("sprite_cache", WRAP_METHOD(Console, Cmd_SpriteCache));
 }
 
 Console::~Console(void) {
@@ -81,4 +83,31 @@ bool Console::Cmd_DumpFile(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::Cmd_SpriteCache(int argc, const char **argv) {
+	if (argc > 2) {
+		DebugPrintf("Usage: %s [clear | reset | <size in KB>]\n", argv[0]);
+		return true;
+	}
+
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_engineRef->_game->_renderer);
+	ScaledSurfaceCache &cache = renderer->getScaledSurfaceCache();
+	if (argc == 2) {
+		Common::String arg = argv[1];
+		if (arg == "clear") {
+			cache.clear();
+		} else if (arg == "reset") {
+			cache.resetStats();
+		} else {
+			cache.setBudget(atoi(argv[1]) * 1024);
+		}
+	}
+
+	const ScaledSurfaceCache::Stats &stats = cache.getStats();
+	uint32 lookups = stats.hits + stats.misses;
+	DebugPrintf("Scaled sprite cache: %d entries, %d of %d KB used\n", cache.getNumEntries(), cache.getMemoryUsed() / 1024, cache.getBudget() / 1024);
+	DebugPrintf("%d hits, %d misses (%d%% hit rate), %d evictions\n", stats.hits, stats.misses,
+	            lookups ? stats.hits * 100 / lookups : 0, stats.evictions);
+	return true;
+}
+
 } // end of namespace Wintermute
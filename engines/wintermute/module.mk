@@ -52,7 +52,9 @@ MODULE_OBJS := \
 	base/gfx/base_surface.o \
 	base/gfx/osystem/base_surface_osystem.o \
 	base/gfx/osystem/base_render_osystem.o \
+	base/gfx/osystem/dirty_rect_container.o \
 	base/gfx/osystem/render_ticket.o \
+	base/gfx/osystem/scaled_surface_cache.o \
 	base/particles/part_particle.o \
 	base/particles/part_emitter.o \
 	base/particles/part_force.o \
@@ -89,7 +91,6 @@ MODULE_OBJS := \
 	base/save_thumb_helper.o \
 	base/timer.o \
 	detection.o \
-	graphics/transparent_surface.o \
 	math/math_util.o \
 	math/matrix4.o \
 	math/vector2.o \
@@ -0,0 +1,130 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/dirtyrects.h"
+
+namespace Graphics {
+
+static inline int rectArea(const Common::Rect &r) {
+	return r.width() * r.height();
+}
+
+static inline Common::Rect rectUnion(const Common::Rect &a, const Common::Rect &b) {
+	Common::Rect r = a;
+	r.extend(b);
+	return r;
+}
+
+DirtyRectList::DirtyRectList(uint maxRects) : _maxRects(maxRects) {
+	assert(maxRects > 0);
+	_rects.reserve(maxRects);
+}
+
+bool DirtyRectList::add(const Common::Rect &rect) {
+	if (rect.isEmpty())
+		return true;
+
+	return insert(rect, false);
+}
+
+void DirtyRectList::addMerging(const Common::Rect &rect) {
+	if (!rect.isEmpty())
+		insert(rect, true);
+}
+
+bool DirtyRectList::insert(const Common::Rect &rect, bool mergeWhenFull) {
+	for (uint i = 0; i < _rects.size(); ++i) {
+		const Common::Rect r = _rects[i];
+		const Common::Rect merged = rectUnion(r, rect);
+
+		if (rectArea(merged) <= rectArea(r) + rectArea(rect)) {
+			if (rectArea(merged) == rectArea(r))
+				return true;
+
+			remove(i);
+			return insert(merged, mergeWhenFull);
+		}
+
+		if (r.intersects(rect)) {
+			// Only add the parts of the rect which are not covered yet:
+			// the rows above and below r, and the columns left and right
+			// of it in between.
+			const int16 top = MAX(rect.top, r.top);
+			const int16 bottom = MIN(rect.bottom, r.bottom);
+
+			if (rect.top < top && !insert(Common::Rect(rect.left, rect.top, rect.right, top), mergeWhenFull))
+				return false;
+			if (bottom < rect.bottom && !insert(Common::Rect(rect.left, bottom, rect.right, rect.bottom), mergeWhenFull))
+				return false;
+			if (rect.left < r.left && !insert(Common::Rect(rect.left, top, r.left, bottom), mergeWhenFull))
+				return false;
+			if (r.right < rect.right && !insert(Common::Rect(r.right, top, rect.right, bottom), mergeWhenFull))
+				return false;
+			return true;
+		}
+	}
+
+	if (_rects.size() < _maxRects) {
+		_rects.push_back(rect);
+		return true;
+	}
+
+	if (!mergeWhenFull)
+		return false;
+
+	// Merge the rect into the one which grows the least
+	uint best = 0;
+	int bestGrowth = 0;
+
+	for (uint i = 0; i < _rects.size(); ++i) {
+		const int growth = rectArea(rectUnion(_rects[i], rect)) - rectArea(_rects[i]);
+
+		if (i == 0 || growth < bestGrowth) {
+			best = i;
+			bestGrowth = growth;
+		}
+	}
+
+	Common::Rect merged = rectUnion(_rects[best], rect);
+	remove(best);
+
+	// Swallow all rects the merged one overlaps now
+	for (uint i = 0; i < _rects.size();) {
+		if (merged.intersects(_rects[i])) {
+			merged.extend(_rects[i]);
+			remove(i);
+			i = 0;
+		} else {
+			++i;
+		}
+	}
+
+	_rects.push_back(merged);
+	return true;
+}
+
+void DirtyRectList::remove(uint index) {
+	_rects[index] = _rects.back();
+	_rects.pop_back();
+}
+
+} // End of namespace Graphics
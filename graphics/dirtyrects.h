@@ -0,0 +1,85 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_DIRTYRECTS_H
+#define GRAPHICS_DIRTYRECTS_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * A list of the screen areas which have to be redrawn, for a limited number
+ * of rects which never overlap.
+ *
+ * An added rect is merged with a rect in the list if the merged rect is not
+ * larger than both of them together, as redrawing it at once is then no
+ * more work. This also covers rects containing each other, and neighbors
+ * sharing a whole edge. If an added rect only partly overlaps a rect in the
+ * list, just its parts which are not covered yet are added.
+ */
+class DirtyRectList {
+public:
+	typedef Common::Array<Common::Rect> RectArray;
+
+	/** Create a list holding at most maxRects rects. */
+	explicit DirtyRectList(uint maxRects);
+
+	/**
+	 * Add a rect to the list. Empty rects are ignored.
+	 *
+	 * @return false if the list ran full. Parts of the rect may have been
+	 *         added then, and the caller should give up on the list, e.g. by
+	 *         redrawing everything.
+	 */
+	bool add(const Common::Rect &rect);
+
+	/**
+	 * Add a rect to the list. If the list runs full, the rect is merged
+	 * into the rect which grows the least, along with all rects which the
+	 * merged one overlaps then. The list then covers more than needed, but
+	 * never less.
+	 */
+	void addMerging(const Common::Rect &rect);
+
+	/** Remove all rects. */
+	void clear() { _rects.clear(); }
+
+	bool empty() const { return _rects.empty(); }
+	uint size() const { return _rects.size(); }
+	uint getMaxRects() const { return _maxRects; }
+
+	const Common::Rect &operator[](uint index) const { return _rects[index]; }
+	const RectArray &getRects() const { return _rects; }
+
+private:
+	bool insert(const Common::Rect &rect, bool mergeWhenFull);
+	void remove(uint index);
+
+	const uint _maxRects;
+	RectArray _rects;
+};
+
+} // End of namespace Graphics
+
+#endif
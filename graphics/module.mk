@@ -3,6 +3,7 @@ MODULE := graphics
 MODULE_OBJS := \
 	conversion.o \
 	cursorman.o \
+	dirtyrects.o \
 	font.o \
 	fontman.o \
 	fonts/bdf.o \
@@ -12,12 +13,14 @@ MODULE_OBJS := \
 	fonts/ttf.o \
 	fonts/winfont.o \
 	maccursor.o \
+	palette_lookup.o \
 	primitives.o \
 	scaler.o \
 	scaler/thumbnail_intern.o \
 	sjis.o \
 	surface.o \
 	thumbnail.o \
+	transparent_surface.o \
 	VectorRenderer.o \
 	VectorRendererSpec.o \
 	wincursor.o \
@@ -49,7 +52,8 @@ endif
 ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
 	scaler/hq2x.o \
-	scaler/hq3x.o
+	scaler/hq3x.o \
+	scaler/pattern.o
 
 ifdef USE_NASM
 MODULE_OBJS += \
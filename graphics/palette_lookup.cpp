@@ -0,0 +1,143 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/cpudetect.h"
+#include "common/textconsole.h"
+#include "graphics/palette_lookup.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace Graphics {
+
+namespace {
+
+template<typename PixelInt>
+void convertRow(PixelInt *dst, const byte *src, const uint32 *map, int x, int width) {
+	for (; x + 4 <= width; x += 4) {
+		dst[x + 0] = map[src[x + 0]];
+		dst[x + 1] = map[src[x + 1]];
+		dst[x + 2] = map[src[x + 2]];
+		dst[x + 3] = map[src[x + 3]];
+	}
+
+	for (; x < width; x++)
+		dst[x] = map[src[x]];
+}
+
+#ifdef SCUMMVM_SIMD_X86
+
+/** Look up 8 palette entries, for the 8 indices in the low bytes of src. */
+SCUMMVM_TARGET_AVX2 inline __m256i gatherAVX2(const byte *src, const uint32 *map) {
+	const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+	return _mm256_i32gather_epi32((const int *)map, indices, 4);
+}
+
+SCUMMVM_TARGET_AVX2 int convertRowAVX2(uint16 *dst, const byte *src, const uint32 *map, int width) {
+	int x = 0;
+
+	for (; x + 16 <= width; x += 16) {
+		// The entries fit in 16 bits, so packing them does not saturate.
+		// The packing works per 128 bit lane, which the permute undoes.
+		const __m256i pixels = _mm256_packus_epi32(gatherAVX2(src + x, map), gatherAVX2(src + x + 8, map));
+		_mm256_storeu_si256((__m256i *)(dst + x), _mm256_permute4x64_epi64(pixels, 0xD8));
+	}
+
+	return x;
+}
+
+SCUMMVM_TARGET_AVX2 int convertRowAVX2(uint32 *dst, const byte *src, const uint32 *map, int width) {
+	int x = 0;
+
+	for (; x + 16 <= width; x += 16) {
+		_mm256_storeu_si256((__m256i *)(dst + x), gatherAVX2(src + x, map));
+		_mm256_storeu_si256((__m256i *)(dst + x + 8), gatherAVX2(src + x + 8, map));
+	}
+
+	return x;
+}
+
+#endif // SCUMMVM_SIMD_X86
+
+template<typename PixelInt>
+void convertRect(byte *dst, uint dstPitch, const byte *src, uint srcPitch, uint w, uint h, const uint32 *map) {
+#ifdef SCUMMVM_SIMD_X86
+	const bool avx2 = Common::hasCPUFeature(Common::kCPUFeatureAVX2);
+#endif
+
+	while (h--) {
+		PixelInt *row = (PixelInt *)dst;
+		int x = 0;
+#ifdef SCUMMVM_SIMD_X86
+		if (avx2)
+			x = convertRowAVX2(row, src, map, w);
+#endif
+		convertRow<PixelInt>(row, src, map, x, w);
+
+		src += srcPitch;
+		dst += dstPitch;
+	}
+}
+
+} // End of anonymous namespace
+
+PaletteLookup::PaletteLookup() : _paletteChangeID(0), _mapChangeID(0) {
+	memset(_palette, 0, sizeof(_palette));
+	setFormat(PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+}
+
+void PaletteLookup::setFormat(const PixelFormat &format) {
+	if (format.bytesPerPixel != 2 && format.bytesPerPixel != 4)
+		error("PaletteLookup: Unsupported pixel format with %d bytes per pixel", format.bytesPerPixel);
+
+	_format = format;
+
+	// Expand the palette again on the next conversion
+	_mapChangeID = _paletteChangeID - 1;
+}
+
+void PaletteLookup::setPalette(const byte *colors, uint start, uint num) {
+	assert(start + num <= 256);
+
+	memcpy(_palette + start * 3, colors, num * 3);
+	_paletteChangeID++;
+}
+
+void PaletteLookup::updateMap() {
+	for (int i = 0; i < 256; i++)
+		_map[i] = _format.RGBToColor(_palette[i * 3], _palette[i * 3 + 1], _palette[i * 3 + 2]);
+
+	_mapChangeID = _paletteChangeID;
+}
+
+void PaletteLookup::convert(byte *dst, uint dstPitch, const byte *src, uint srcPitch, uint w, uint h) {
+	if (_mapChangeID != _paletteChangeID)
+		updateMap();
+
+	if (_format.bytesPerPixel == 2)
+		convertRect<uint16>(dst, dstPitch, src, srcPitch, w, h, _map);
+	else
+		convertRect<uint32>(dst, dstPitch, src, srcPitch, w, h, _map);
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,92 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_PALETTE_LOOKUP_H
+#define GRAPHICS_PALETTE_LOOKUP_H
+
+#include "common/scummsys.h"
+#include "graphics/pixelformat.h"
+
+namespace Graphics {
+
+/**
+ * Expands paletted (CLUT8) pixels to a 16 or 32 bit pixel format.
+ *
+ * The palette is expanded to the destination format once per palette
+ * change, and the pixels are then converted through that table, with SIMD
+ * gathers where the CPU has them. This is meant for backends which keep
+ * the game screen in CLUT8 and need to convert the dirty parts of it for
+ * every frame.
+ */
+class PaletteLookup {
+public:
+	PaletteLookup();
+
+	/**
+	 * Set the format the pixels are converted to. It must have 2 or 4
+	 * bytes per pixel.
+	 */
+	void setFormat(const PixelFormat &format);
+
+	/** Get the format the pixels are converted to. */
+	const PixelFormat &getFormat() const { return _format; }
+
+	/**
+	 * Change palette entries.
+	 *
+	 * @param colors  the new colors, as RGB triplets like in OSystem::setPalette
+	 * @param start   the first palette entry to change
+	 * @param num     the number of entries to change
+	 */
+	void setPalette(const byte *colors, uint start, uint num);
+
+	/**
+	 * Get an ID which changes on every palette change, so that callers can
+	 * tell whether converted pixels they keep around are still valid.
+	 */
+	uint32 getPaletteChangeID() const { return _paletteChangeID; }
+
+	/**
+	 * Convert a rect of paletted pixels.
+	 *
+	 * @param dst       the destination of the converted pixels
+	 * @param dstPitch  the pitch of the destination, in bytes
+	 * @param src       the paletted pixels
+	 * @param srcPitch  the pitch of the source, in bytes
+	 * @param w         the width of the rect
+	 * @param h         the height of the rect
+	 */
+	void convert(byte *dst, uint dstPitch, const byte *src, uint srcPitch, uint w, uint h);
+
+private:
+	void updateMap();
+
+	PixelFormat _format;
+	byte _palette[256 * 3];
+	uint32 _map[256];          ///< the palette in the destination format
+	uint32 _paletteChangeID;
+	uint32 _mapChangeID;       ///< the palette change ID _map was expanded for
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -135,13 +135,17 @@ void InitScalers(uint32 BitFormat) {
 		format = Graphics::createPixelFormat<555>();
 	} else if (gBitFormat == 565) {
 		format = Graphics::createPixelFormat<565>();
+	} else if (gBitFormat == 8888) {
+		format = Graphics::createPixelFormat<8888>();
 	} else {
 		assert(g_system);
 		format = g_system->getOverlayFormat();
 	}
 
 #ifdef USE_HQ_SCALERS
-	InitLUT(format);
+	// The HQ scalers compute the YUV values of 32 bit pixels directly
+	if (format.bytesPerPixel == 2)
+		InitLUT(format);
 #endif
 
 	// Build dotmatrix lookup table for the DotMatrix scaler.
@@ -166,13 +170,15 @@ void DestroyScalers() {
  */
 void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							int width, int height) {
+	const uint32 lineSize = (gBitFormat == 8888 ? sizeof(uint32) : sizeof(uint16)) * width;
+
 	// Spot the case when it can all be done in 1 hit
-	if ((srcPitch == sizeof(uint16) * (uint)width) && (dstPitch == sizeof(uint16) * (uint)width)) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width * height);
+	if (srcPitch == lineSize && dstPitch == lineSize) {
+		memcpy(dstPtr, srcPtr, lineSize * height);
 		return;
 	}
 	while (height--) {
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
+		memcpy(dstPtr, srcPtr, lineSize);
 		srcPtr += srcPitch;
 		dstPtr += dstPitch;
 	}
@@ -180,6 +186,28 @@ void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 
 #ifdef USE_SCALERS
 
+/**
+ * Trivial nearest-neighbor scaler for 32 bit pixels, by an integral factor.
+ */
+template<int scale>
+static void NormalScale32bpp(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							int width, int height) {
+	assert(IS_ALIGNED(dstPtr, 4));
+	while (height--) {
+		uint32 *r = (uint32 *)dstPtr;
+		for (int i = 0; i < width; ++i, r += scale) {
+			const uint32 color = *(((const uint32 *)srcPtr) + i);
+
+			for (int j = 0; j < scale; ++j)
+				r[j] = color;
+		}
+		for (int j = 1; j < scale; ++j)
+			memcpy(dstPtr + j * dstPitch, dstPtr, width * scale * sizeof(uint32));
+
+		srcPtr += srcPitch;
+		dstPtr += dstPitch * scale;
+	}
+}
 
 #ifdef USE_ARM_SCALER_ASM
 extern "C" void Normal2xARM(const uint8  *srcPtr,
@@ -195,7 +223,10 @@ void Normal2x(const uint8  *srcPtr,
                     uint32  dstPitch,
                     int     width,
                     int     height) {
-	Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	if (gBitFormat == 8888)
+		NormalScale32bpp<2>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else
+		Normal2xARM(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
 #else
@@ -206,6 +237,11 @@ void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 							int width, int height) {
 	uint8 *r;
 
+	if (gBitFormat == 8888) {
+		NormalScale32bpp<2>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
 	assert(IS_ALIGNED(dstPtr, 4));
 	while (height--) {
 		r = dstPtr;
@@ -232,6 +268,11 @@ void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 	const uint32 dstPitch2 = dstPitch * 2;
 	const uint32 dstPitch3 = dstPitch * 3;
 
+	if (gBitFormat == 8888) {
+		NormalScale32bpp<3>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
 	assert(IS_ALIGNED(dstPtr, 2));
 	while (height--) {
 		r = dstPtr;
@@ -305,7 +346,7 @@ void Normal1o5x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstP
  */
 void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, gBitFormat == 8888 ? 4 : 2, width, height);
 }
 
 /**
@@ -314,7 +355,7 @@ void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
  */
 void AdvMame3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
-	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
+	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, gBitFormat == 8888 ? 4 : 2, width, height);
 }
 
 template<typename ColorMask>
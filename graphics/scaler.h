@@ -25,6 +25,12 @@
 #include "common/scummsys.h"
 #include "graphics/surface.h"
 
+/**
+ * Set up the scalers for the given pixel format: 565 and 555 for 16 bit
+ * pixels, or 8888 for 32 bit pixels with 8 bits per channel and green in
+ * the second byte. Only Normal1x, Normal2x, Normal3x, AdvMame2x, AdvMame3x,
+ * HQ2x and HQ3x handle 32 bit pixels.
+ */
 extern void InitScalers(uint32 BitFormat);
 extern void DestroyScalers();
 
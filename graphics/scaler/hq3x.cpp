@@ -97,23 +97,24 @@ void HQ3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 #define PIXEL22_C   *(q+2+nextlineDst2) = w5;
 
 extern "C" uint32   *RGBtoYUV;
-#define YUV(x)	RGBtoYUV[w ## x]
+#define YUV(x)	getYUV<ColorMask>(RGBtoYUV, w ## x)
 
 /*
  * The HQ3x high quality 3x graphics filter.
  * Original author Maxim Stepin (see http://www.hiend3d.com/hq3x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
-template<typename ColorMask>
+template<typename ColorMask, typename Pixel>
 static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	register int  w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	uint16 patterns[kMaxPatternRowWidth];
 
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
 	const uint32 nextlineDst2 = 2 * nextlineDst;
-	uint16 *q = (uint16 *)dstPtr;
+	Pixel *q = (Pixel *)dstPtr;
 
 	//	 +----+----+----+
 	//	 |    |    |    |
@@ -135,6 +136,10 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
+		// Let SIMD code compute the patterns of the whole row, if possible
+		const bool hasPatterns = width <= kMaxPatternRowWidth && computeHQPatterns<ColorMask>(p, nextlineSrc, width, patterns);
+		int x = 0;
+
 		int tmpWidth = width;
 		while (tmpWidth--) {
 			p++;
@@ -143,18 +148,34 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			int pattern;
+			if (hasPatterns) {
+				pattern = patterns[x++];
+			} else {
+				pattern = 0;
+				const int yuv5 = YUV(5);
+				if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
+				if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
+				if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
+				if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
+				if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
+				if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
+				if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
+				if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			}
 
 			switch (pattern) {
+			case kHQFlatPattern:
+				PIXEL00_C
+				PIXEL01_C
+				PIXEL02_C
+				PIXEL10_C
+				PIXEL11
+				PIXEL12_C
+				PIXEL20_C
+				PIXEL21_C
+				PIXEL22_C
+				break;
 			case 0:
 			case 1:
 			case 4:
@@ -2936,10 +2957,12 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 
 void HQ3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	extern int gBitFormat;
-	if (gBitFormat == 565)
-		HQ3x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	if (gBitFormat == 8888)
+		HQ3x_implementation<Graphics::ColorMasks<8888>, uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+	else if (gBitFormat == 565)
+		HQ3x_implementation<Graphics::ColorMasks<565>, uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 	else
-		HQ3x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		HQ3x_implementation<Graphics::ColorMasks<555>, uint16>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
 
 #endif // Assembly version
@@ -179,6 +179,95 @@ static inline unsigned interpolate16_1_1_1_1(unsigned p1, unsigned p2, unsigned
 	return ((p1+p2+p3+p4) - lowbits) >> 2;
 }
 
+/**
+ * Interpolate three 32 bit pixels with 8 bits per channel, with weights w1,
+ * w2 and w3 adding up to (1 << shift), which must be at most 16. Every byte
+ * is interpolated separately, so the order of the channels does not matter.
+ */
+template<int w1, int w2, int w3, int shift>
+static inline unsigned interpolate8888(unsigned p1, unsigned p2, unsigned p3) {
+	const unsigned rb = ((p1 & 0x00FF00FF) * w1 + (p2 & 0x00FF00FF) * w2 + (p3 & 0x00FF00FF) * w3) >> shift;
+	const unsigned ag = (((p1 >> 8) & 0x00FF00FF) * w1 + ((p2 >> 8) & 0x00FF00FF) * w2 + ((p3 >> 8) & 0x00FF00FF) * w3) >> shift;
+	return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+}
+
+// The 16 bit interpolation functions above, for 32 bit pixels. This lets
+// the scaler templates handle both kinds of pixels with the same code.
+
+template<>
+inline unsigned interpolate16_1_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2) {
+	return interpolate8888<1, 1, 0, 1>(p1, p2, 0);
+}
+
+template<>
+inline unsigned interpolate16_3_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2) {
+	return interpolate8888<3, 1, 0, 2>(p1, p2, 0);
+}
+
+template<>
+inline unsigned interpolate16_5_3<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2) {
+	return interpolate8888<5, 3, 0, 3>(p1, p2, 0);
+}
+
+template<>
+inline unsigned interpolate16_7_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2) {
+	return interpolate8888<7, 1, 0, 3>(p1, p2, 0);
+}
+
+template<>
+inline unsigned interpolate16_2_1_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<2, 1, 1, 2>(p1, p2, p3);
+}
+
+template<>
+inline unsigned interpolate16_5_2_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<5, 2, 1, 3>(p1, p2, p3);
+}
+
+template<>
+inline unsigned interpolate16_6_1_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<6, 1, 1, 3>(p1, p2, p3);
+}
+
+template<>
+inline unsigned interpolate16_2_3_3<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<2, 3, 3, 3>(p1, p2, p3);
+}
+
+template<>
+inline unsigned interpolate16_2_7_7<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<2, 7, 7, 4>(p1, p2, p3);
+}
+
+template<>
+inline unsigned interpolate16_14_1_1<Graphics::ColorMasks<8888> >(unsigned p1, unsigned p2, unsigned p3) {
+	return interpolate8888<14, 1, 1, 4>(p1, p2, p3);
+}
+
+/**
+ * Return the YUV value (encoded 8-8-8) of a pixel, as used by the hq scaler
+ * family. 16 bit pixels are looked up in the table set up by InitLUT().
+ */
+template<typename ColorMask>
+static inline int getYUV(const uint32 *rgbToYuv, unsigned color) {
+	return rgbToYuv[color];
+}
+
+/**
+ * 32 bit pixels are converted directly, the same way InitLUT() does it.
+ */
+template<>
+inline int getYUV<Graphics::ColorMasks<8888> >(const uint32 *, unsigned color) {
+	const int r = (color >> 16) & 0xFF;
+	const int g = (color >> 8) & 0xFF;
+	const int b = color & 0xFF;
+
+	const int Y = (r + g + b) >> 2;
+	const int u = 128 + ((r - b) >> 2);
+	const int v = 128 + ((-r + 2 * g - b) >> 3);
+	return (Y << 16) | (u << 8) | v;
+}
+
 /**
  * Compare two YUV values (encoded 8-8-8) and check if they differ by more than
  * a certain hard coded threshold. Used by the hq scaler family.
@@ -218,4 +307,37 @@ static inline bool diffYUV(int yuv1, int yuv2) {
 */
 }
 
+/**
+ * Pattern value computeHQPatterns() sets in addition to the neighbor bits
+ * when all neighbors of a pixel have exactly its color.
+ */
+enum {
+	kHQFlatPattern = 0x100
+};
+
+/** The widest row the scalers compute patterns for at once. */
+enum {
+	kMaxPatternRowWidth = 1024
+};
+
+/**
+ * Compute the neighbor pattern the hq scaler family switches on for count
+ * pixels in a row, using SIMD instructions. Bit n is set when neighbor n
+ * (counting w1 to w9, without w5) differs from the pixel according to
+ * diffYUV().
+ *
+ * @return false if there are no SIMD instructions to do this on this CPU,
+ *         in which case the caller has to compute the patterns itself
+ */
+template<typename ColorMask>
+bool computeHQPatterns(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns);
+
+/**
+ * There is no SIMD code for the patterns of 32 bit pixels.
+ */
+template<typename ColorMask>
+inline bool computeHQPatterns(const uint32 *src, uint32 nextlineSrc, int count, uint16 *patterns) {
+	return false;
+}
+
 #endif
@@ -0,0 +1,268 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// SIMD versions of the neighborhood checks done for every pixel by the
+// HQ scalers. The scalers themselves stay in C, since they mostly consist
+// of a large switch over the results of these checks.
+
+#include "graphics/scaler/intern.h"
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(USE_HQ_SCALERS) && !defined(USE_NASM)
+
+namespace {
+
+// The thresholds of diffYUV()
+enum {
+	kYThreshold = 0x30,
+	kUThreshold = 0x07,
+	kVThreshold = 0x06
+};
+
+/**
+ * Offsets of the neighbors w1 to w9 of a pixel, without w5, in the order of
+ * the pattern bits.
+ */
+void getNeighborOffsets(uint32 nextlineSrc, int *offsets) {
+	const int line = nextlineSrc;
+
+	offsets[0] = -line - 1;
+	offsets[1] = -line;
+	offsets[2] = -line + 1;
+	offsets[3] = -1;
+	offsets[4] = 1;
+	offsets[5] = line - 1;
+	offsets[6] = line;
+	offsets[7] = line + 1;
+}
+
+#ifdef SCUMMVM_SIMD_X86
+
+/**
+ * Compute Y, U and V of eight pixels the way InitLUT() does, without the
+ * offset of 128 added to U and V, which cancels out in diffYUV() anyway.
+ */
+template<typename ColorMask>
+SCUMMVM_TARGET_SSE2 inline void getYUVSSE2(__m128i c, __m128i &y, __m128i &u, __m128i &v) {
+	const __m128i r = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(c, ColorMask::kRedShift), _mm_set1_epi16((1 << ColorMask::kRedBits) - 1)), 8 - ColorMask::kRedBits);
+	const __m128i g = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(c, ColorMask::kGreenShift), _mm_set1_epi16((1 << ColorMask::kGreenBits) - 1)), 8 - ColorMask::kGreenBits);
+	const __m128i b = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(c, ColorMask::kBlueShift), _mm_set1_epi16((1 << ColorMask::kBlueBits) - 1)), 8 - ColorMask::kBlueBits);
+
+	y = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(r, g), b), 2);
+	u = _mm_srai_epi16(_mm_sub_epi16(r, b), 2);
+	v = _mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(g, g), _mm_add_epi16(r, b)), 3);
+}
+
+SCUMMVM_TARGET_SSE2 inline __m128i exceedsSSE2(__m128i a, __m128i b, int threshold) {
+	const __m128i diff = _mm_sub_epi16(a, b);
+	const __m128i absDiff = _mm_max_epi16(diff, _mm_sub_epi16(_mm_setzero_si128(), diff));
+	return _mm_cmpgt_epi16(absDiff, _mm_set1_epi16(threshold));
+}
+
+template<typename ColorMask>
+SCUMMVM_TARGET_SSE2 int computeHQPatternsSSE2(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns) {
+	int offsets[8];
+	getNeighborOffsets(nextlineSrc, offsets);
+
+	int x = 0;
+	for (; x + 8 <= count; x += 8) {
+		const uint16 *p = src + x;
+		const __m128i w5 = _mm_loadu_si128((const __m128i *)p);
+
+		__m128i y5, u5, v5;
+		getYUVSSE2<ColorMask>(w5, y5, u5, v5);
+
+		__m128i pattern = _mm_setzero_si128();
+		__m128i same = _mm_set1_epi16(-1);
+
+		for (int n = 0; n < 8; n++) {
+			const __m128i w = _mm_loadu_si128((const __m128i *)(p + offsets[n]));
+
+			__m128i y, u, v;
+			getYUVSSE2<ColorMask>(w, y, u, v);
+
+			const __m128i diff = _mm_or_si128(_mm_or_si128(exceedsSSE2(y, y5, kYThreshold), exceedsSSE2(u, u5, kUThreshold)), exceedsSSE2(v, v5, kVThreshold));
+			pattern = _mm_or_si128(pattern, _mm_and_si128(diff, _mm_set1_epi16(1 << n)));
+			same = _mm_and_si128(same, _mm_cmpeq_epi16(w, w5));
+		}
+
+		pattern = _mm_or_si128(pattern, _mm_and_si128(same, _mm_set1_epi16(kHQFlatPattern)));
+		_mm_storeu_si128((__m128i *)(patterns + x), pattern);
+	}
+
+	return x;
+}
+
+template<typename ColorMask>
+SCUMMVM_TARGET_AVX2 inline void getYUVAVX2(__m256i c, __m256i &y, __m256i &u, __m256i &v) {
+	const __m256i r = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c, ColorMask::kRedShift), _mm256_set1_epi16((1 << ColorMask::kRedBits) - 1)), 8 - ColorMask::kRedBits);
+	const __m256i g = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c, ColorMask::kGreenShift), _mm256_set1_epi16((1 << ColorMask::kGreenBits) - 1)), 8 - ColorMask::kGreenBits);
+	const __m256i b = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c, ColorMask::kBlueShift), _mm256_set1_epi16((1 << ColorMask::kBlueBits) - 1)), 8 - ColorMask::kBlueBits);
+
+	y = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(r, g), b), 2);
+	u = _mm256_srai_epi16(_mm256_sub_epi16(r, b), 2);
+	v = _mm256_srai_epi16(_mm256_sub_epi16(_mm256_add_epi16(g, g), _mm256_add_epi16(r, b)), 3);
+}
+
+SCUMMVM_TARGET_AVX2 inline __m256i exceedsAVX2(__m256i a, __m256i b, int threshold) {
+	return _mm256_cmpgt_epi16(_mm256_abs_epi16(_mm256_sub_epi16(a, b)), _mm256_set1_epi16(threshold));
+}
+
+template<typename ColorMask>
+SCUMMVM_TARGET_AVX2 int computeHQPatternsAVX2(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns) {
+	int offsets[8];
+	getNeighborOffsets(nextlineSrc, offsets);
+
+	int x = 0;
+	for (; x + 16 <= count; x += 16) {
+		const uint16 *p = src + x;
+		const __m256i w5 = _mm256_loadu_si256((const __m256i *)p);
+
+		__m256i y5, u5, v5;
+		getYUVAVX2<ColorMask>(w5, y5, u5, v5);
+
+		__m256i pattern = _mm256_setzero_si256();
+		__m256i same = _mm256_set1_epi16(-1);
+
+		for (int n = 0; n < 8; n++) {
+			const __m256i w = _mm256_loadu_si256((const __m256i *)(p + offsets[n]));
+
+			__m256i y, u, v;
+			getYUVAVX2<ColorMask>(w, y, u, v);
+
+			const __m256i diff = _mm256_or_si256(_mm256_or_si256(exceedsAVX2(y, y5, kYThreshold), exceedsAVX2(u, u5, kUThreshold)), exceedsAVX2(v, v5, kVThreshold));
+			pattern = _mm256_or_si256(pattern, _mm256_and_si256(diff, _mm256_set1_epi16(1 << n)));
+			same = _mm256_and_si256(same, _mm256_cmpeq_epi16(w, w5));
+		}
+
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(same, _mm256_set1_epi16(kHQFlatPattern)));
+		_mm256_storeu_si256((__m256i *)(patterns + x), pattern);
+	}
+
+	return x;
+}
+
+#endif // SCUMMVM_SIMD_X86
+
+#ifdef SCUMMVM_SIMD_NEON
+
+template<typename ColorMask>
+inline void getYUVNEON(uint16x8_t c, int16x8_t &y, int16x8_t &u, int16x8_t &v) {
+	const int16x8_t r = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(vshlq_u16(c, vdupq_n_s16(-ColorMask::kRedShift)), vdupq_n_u16((1 << ColorMask::kRedBits) - 1)), 8 - ColorMask::kRedBits));
+	const int16x8_t g = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(vshlq_u16(c, vdupq_n_s16(-ColorMask::kGreenShift)), vdupq_n_u16((1 << ColorMask::kGreenBits) - 1)), 8 - ColorMask::kGreenBits));
+	const int16x8_t b = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(vshlq_u16(c, vdupq_n_s16(-ColorMask::kBlueShift)), vdupq_n_u16((1 << ColorMask::kBlueBits) - 1)), 8 - ColorMask::kBlueBits));
+
+	y = vshrq_n_s16(vaddq_s16(vaddq_s16(r, g), b), 2);
+	u = vshrq_n_s16(vsubq_s16(r, b), 2);
+	v = vshrq_n_s16(vsubq_s16(vaddq_s16(g, g), vaddq_s16(r, b)), 3);
+}
+
+template<typename ColorMask>
+int computeHQPatternsNEON(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns) {
+	int offsets[8];
+	getNeighborOffsets(nextlineSrc, offsets);
+
+	int x = 0;
+	for (; x + 8 <= count; x += 8) {
+		const uint16 *p = src + x;
+		const uint16x8_t w5 = vld1q_u16(p);
+
+		int16x8_t y5, u5, v5;
+		getYUVNEON<ColorMask>(w5, y5, u5, v5);
+
+		uint16x8_t pattern = vdupq_n_u16(0);
+		uint16x8_t same = vdupq_n_u16(0xFFFF);
+
+		for (int n = 0; n < 8; n++) {
+			const uint16x8_t w = vld1q_u16(p + offsets[n]);
+
+			int16x8_t y, u, v;
+			getYUVNEON<ColorMask>(w, y, u, v);
+
+			const uint16x8_t diff = vorrq_u16(vorrq_u16(vcgtq_s16(vabdq_s16(y, y5), vdupq_n_s16(kYThreshold)), vcgtq_s16(vabdq_s16(u, u5), vdupq_n_s16(kUThreshold))), vcgtq_s16(vabdq_s16(v, v5), vdupq_n_s16(kVThreshold)));
+			pattern = vorrq_u16(pattern, vandq_u16(diff, vdupq_n_u16(1 << n)));
+			same = vandq_u16(same, vceqq_u16(w, w5));
+		}
+
+		pattern = vorrq_u16(pattern, vandq_u16(same, vdupq_n_u16(kHQFlatPattern)));
+		vst1q_u16(patterns + x, pattern);
+	}
+
+	return x;
+}
+
+#endif // SCUMMVM_SIMD_NEON
+
+} // End of anonymous namespace
+
+extern "C" uint32 *RGBtoYUV;
+
+template<typename ColorMask>
+bool computeHQPatterns(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns) {
+	int x;
+
+#if defined(SCUMMVM_SIMD_X86)
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		x = computeHQPatternsAVX2<ColorMask>(src, nextlineSrc, count, patterns);
+	else if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		x = computeHQPatternsSSE2<ColorMask>(src, nextlineSrc, count, patterns);
+	else
+		return false;
+#elif defined(SCUMMVM_SIMD_NEON)
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		x = computeHQPatternsNEON<ColorMask>(src, nextlineSrc, count, patterns);
+	else
+		return false;
+#else
+	return false;
+#endif
+
+	int offsets[8];
+	getNeighborOffsets(nextlineSrc, offsets);
+
+	for (; x < count; x++) {
+		const uint16 *p = src + x;
+		const int yuv5 = RGBtoYUV[*p];
+
+		int pattern = 0;
+		for (int n = 0; n < 8; n++) {
+			if (*p != p[offsets[n]] && diffYUV(yuv5, RGBtoYUV[p[offsets[n]]]))
+				pattern |= 1 << n;
+		}
+
+		patterns[x] = pattern;
+	}
+
+	return true;
+}
+
+template bool computeHQPatterns<Graphics::ColorMasks<565> >(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns);
+template bool computeHQPatterns<Graphics::ColorMasks<555> >(const uint16 *src, uint32 nextlineSrc, int count, uint16 *patterns);
+
+#endif
@@ -36,6 +36,12 @@
 
 #include "graphics/scaler/scale2x.h"
 
+#if defined(SCUMMVM_SIMD_X86)
+#include <immintrin.h>
+#elif defined(SCUMMVM_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 /***************************************************************************/
 /* Scale2x C implementation */
 
@@ -500,3 +506,136 @@ void scale2x_32_mmx(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_ui
 }
 
 #endif
+
+/***************************************************************************/
+/* Scale2x SSE2/AVX2/NEON implementation */
+
+#if defined(SCUMMVM_SIMD_X86)
+
+/**
+ * Return x where mask is set, and y elsewhere.
+ */
+SCUMMVM_TARGET_SSE2 static inline __m128i scale2x_select_sse2(__m128i mask, __m128i x, __m128i y) {
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+SCUMMVM_TARGET_SSE2 static unsigned scale2x_16_sse2_run(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m128i B = _mm_loadu_si128((const __m128i *)(src0 + i));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(src1 + i - 1));
+		const __m128i E = _mm_loadu_si128((const __m128i *)(src1 + i));
+		const __m128i F = _mm_loadu_si128((const __m128i *)(src1 + i + 1));
+		const __m128i H = _mm_loadu_si128((const __m128i *)(src2 + i));
+
+		/* B != H && D != F */
+		const __m128i cond = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi16(B, H), _mm_cmpeq_epi16(D, F)), _mm_set1_epi16(-1));
+
+		const __m128i e0 = scale2x_select_sse2(_mm_and_si128(cond, _mm_cmpeq_epi16(D, B)), B, E);
+		const __m128i e1 = scale2x_select_sse2(_mm_and_si128(cond, _mm_cmpeq_epi16(F, B)), B, E);
+		const __m128i e2 = scale2x_select_sse2(_mm_and_si128(cond, _mm_cmpeq_epi16(D, H)), H, E);
+		const __m128i e3 = scale2x_select_sse2(_mm_and_si128(cond, _mm_cmpeq_epi16(F, H)), H, E);
+
+		_mm_storeu_si128((__m128i *)(dst0 + 2 * i), _mm_unpacklo_epi16(e0, e1));
+		_mm_storeu_si128((__m128i *)(dst0 + 2 * i + 8), _mm_unpackhi_epi16(e0, e1));
+		_mm_storeu_si128((__m128i *)(dst1 + 2 * i), _mm_unpacklo_epi16(e2, e3));
+		_mm_storeu_si128((__m128i *)(dst1 + 2 * i + 8), _mm_unpackhi_epi16(e2, e3));
+	}
+
+	return i;
+}
+
+SCUMMVM_TARGET_AVX2 static inline __m256i scale2x_select_avx2(__m256i mask, __m256i x, __m256i y) {
+	return _mm256_blendv_epi8(y, x, mask);
+}
+
+SCUMMVM_TARGET_AVX2 static unsigned scale2x_16_avx2_run(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		const __m256i B = _mm256_loadu_si256((const __m256i *)(src0 + i));
+		const __m256i D = _mm256_loadu_si256((const __m256i *)(src1 + i - 1));
+		const __m256i E = _mm256_loadu_si256((const __m256i *)(src1 + i));
+		const __m256i F = _mm256_loadu_si256((const __m256i *)(src1 + i + 1));
+		const __m256i H = _mm256_loadu_si256((const __m256i *)(src2 + i));
+
+		/* B != H && D != F */
+		const __m256i cond = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi16(B, H), _mm256_cmpeq_epi16(D, F)), _mm256_set1_epi16(-1));
+
+		const __m256i e0 = scale2x_select_avx2(_mm256_and_si256(cond, _mm256_cmpeq_epi16(D, B)), B, E);
+		const __m256i e1 = scale2x_select_avx2(_mm256_and_si256(cond, _mm256_cmpeq_epi16(F, B)), B, E);
+		const __m256i e2 = scale2x_select_avx2(_mm256_and_si256(cond, _mm256_cmpeq_epi16(D, H)), H, E);
+		const __m256i e3 = scale2x_select_avx2(_mm256_and_si256(cond, _mm256_cmpeq_epi16(F, H)), H, E);
+
+		/* The unpack instructions work on 128 bit lanes, so put the lanes back in order */
+		const __m256i lo0 = _mm256_unpacklo_epi16(e0, e1), hi0 = _mm256_unpackhi_epi16(e0, e1);
+		const __m256i lo1 = _mm256_unpacklo_epi16(e2, e3), hi1 = _mm256_unpackhi_epi16(e2, e3);
+
+		_mm256_storeu_si256((__m256i *)(dst0 + 2 * i), _mm256_permute2x128_si256(lo0, hi0, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst0 + 2 * i + 16), _mm256_permute2x128_si256(lo0, hi0, 0x31));
+		_mm256_storeu_si256((__m256i *)(dst1 + 2 * i), _mm256_permute2x128_si256(lo1, hi1, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst1 + 2 * i + 16), _mm256_permute2x128_si256(lo1, hi1, 0x31));
+	}
+
+	return i;
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def(), but uses SSE2 instructions,
+ * which the CPU must support.
+ */
+void scale2x_16_sse2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	const unsigned done = scale2x_16_sse2_run(dst0, dst1, src0, src1, src2, count);
+	if (done < count)
+		scale2x_16_def(dst0 + 2 * done, dst1 + 2 * done, src0 + done, src1 + done, src2 + done, count - done);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def(), but uses AVX2 instructions,
+ * which the CPU must support.
+ */
+void scale2x_16_avx2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	const unsigned done = scale2x_16_avx2_run(dst0, dst1, src0, src1, src2, count);
+	if (done < count)
+		scale2x_16_sse2(dst0 + 2 * done, dst1 + 2 * done, src0 + done, src1 + done, src2 + done, count - done);
+}
+
+#endif
+
+#if defined(SCUMMVM_SIMD_NEON)
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def(), but uses NEON instructions.
+ */
+void scale2x_16_neon(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const uint16x8_t B = vld1q_u16(src0 + i);
+		const uint16x8_t D = vld1q_u16(src1 + i - 1);
+		const uint16x8_t E = vld1q_u16(src1 + i);
+		const uint16x8_t F = vld1q_u16(src1 + i + 1);
+		const uint16x8_t H = vld1q_u16(src2 + i);
+
+		/* B != H && D != F */
+		const uint16x8_t cond = vmvnq_u16(vorrq_u16(vceqq_u16(B, H), vceqq_u16(D, F)));
+
+		uint16x8x2_t row0, row1;
+		row0.val[0] = vbslq_u16(vandq_u16(cond, vceqq_u16(D, B)), B, E);
+		row0.val[1] = vbslq_u16(vandq_u16(cond, vceqq_u16(F, B)), B, E);
+		row1.val[0] = vbslq_u16(vandq_u16(cond, vceqq_u16(D, H)), H, E);
+		row1.val[1] = vbslq_u16(vandq_u16(cond, vceqq_u16(F, H)), H, E);
+
+		vst2q_u16(dst0 + 2 * i, row0);
+		vst2q_u16(dst1 + 2 * i, row1);
+	}
+
+	if (i < count)
+		scale2x_16_def(dst0 + 2 * i, dst1 + 2 * i, src0 + i, src1 + i, src2 + i, count - i);
+}
+
+#endif
@@ -21,6 +21,8 @@
 #ifndef SCALER_SCALE2X_H
 #define SCALER_SCALE2X_H
 
+#include "common/cpudetect.h"
+
 #if defined(_MSC_VER)
 #define __restrict__
 #endif
@@ -65,4 +67,17 @@ extern "C" void scale2x_32_arm(scale2x_uint32* dst0, scale2x_uint32* dst1, const
 
 #endif
 
+#if defined(SCUMMVM_SIMD_X86)
+
+void scale2x_16_sse2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count);
+void scale2x_16_avx2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count);
+
+#endif
+
+#if defined(SCUMMVM_SIMD_NEON)
+
+void scale2x_16_neon(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count);
+
+#endif
+
 #endif
@@ -36,6 +36,12 @@
 
 #include "graphics/scaler/scale3x.h"
 
+#if defined(SCUMMVM_SIMD_X86)
+#include <immintrin.h>
+#elif defined(SCUMMVM_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 /***************************************************************************/
 /* Scale3x C implementation */
 
@@ -220,3 +226,225 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+/***************************************************************************/
+/* Scale3x SSE2/AVX2/NEON implementation */
+
+#if defined(SCUMMVM_SIMD_X86)
+
+SCUMMVM_TARGET_SSE2 static inline __m128i scale3x_select_sse2(__m128i mask, __m128i x, __m128i y) {
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+/**
+ * Store the 16 bit values of a, b and c interleaved, i.e. a0 b0 c0 a1 b1 c1...
+ */
+SCUMMVM_TARGET_SSE2 static inline void scale3x_store_sse2(scale3x_uint16* dst, __m128i a, __m128i b, __m128i c) {
+	const __m128i lane0 = _mm_set_epi32(0, 0, 0, -1);
+	const __m128i lane1 = _mm_set_epi32(0, 0, -1, 0);
+	const __m128i lane2 = _mm_set_epi32(0, -1, 0, 0);
+	const __m128i lane3 = _mm_set_epi32(-1, 0, 0, 0);
+
+	/* pairs a0 b0, b0 c0 and c0 a1, of which every output holds one per 32 bits */
+	const __m128i a1 = _mm_srli_si128(a, 2);
+	const __m128i ab = _mm_unpacklo_epi16(a, b), abhi = _mm_unpackhi_epi16(a, b);
+	const __m128i bc = _mm_unpacklo_epi16(b, c), bchi = _mm_unpackhi_epi16(b, c);
+	const __m128i ca = _mm_unpacklo_epi16(c, a1), cahi = _mm_unpackhi_epi16(c, a1);
+
+	/* a0 b0 c0 a1 b1 c1 a2 b2 */
+	const __m128i out0 = _mm_or_si128(_mm_or_si128(
+		_mm_and_si128(_mm_shuffle_epi32(ab, _MM_SHUFFLE(2, 0, 0, 0)), _mm_or_si128(lane0, lane3)),
+		_mm_and_si128(_mm_shuffle_epi32(ca, _MM_SHUFFLE(0, 0, 0, 0)), lane1)),
+		_mm_and_si128(_mm_shuffle_epi32(bc, _MM_SHUFFLE(1, 1, 1, 1)), lane2));
+	/* c2 a3 b3 c3 a4 b4 c4 a5 */
+	const __m128i out1 = _mm_or_si128(_mm_or_si128(
+		_mm_and_si128(_mm_shuffle_epi32(ca, _MM_SHUFFLE(2, 2, 2, 2)), lane0),
+		_mm_and_si128(_mm_shuffle_epi32(bc, _MM_SHUFFLE(3, 3, 3, 3)), lane1)), _mm_or_si128(
+		_mm_and_si128(_mm_shuffle_epi32(abhi, _MM_SHUFFLE(0, 0, 0, 0)), lane2),
+		_mm_and_si128(_mm_shuffle_epi32(cahi, _MM_SHUFFLE(0, 0, 0, 0)), lane3)));
+	/* b5 c5 a6 b6 c6 a7 b7 c7 */
+	const __m128i out2 = _mm_or_si128(_mm_or_si128(
+		_mm_and_si128(_mm_shuffle_epi32(bchi, _MM_SHUFFLE(3, 1, 1, 1)), _mm_or_si128(lane0, lane3)),
+		_mm_and_si128(_mm_shuffle_epi32(abhi, _MM_SHUFFLE(2, 2, 2, 2)), lane1)),
+		_mm_and_si128(_mm_shuffle_epi32(cahi, _MM_SHUFFLE(2, 2, 2, 2)), lane2));
+
+	_mm_storeu_si128((__m128i *)dst, out0);
+	_mm_storeu_si128((__m128i *)(dst + 8), out1);
+	_mm_storeu_si128((__m128i *)(dst + 16), out2);
+}
+
+SCUMMVM_TARGET_SSE2 static unsigned scale3x_16_sse2_run(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m128i A = _mm_loadu_si128((const __m128i *)(src0 + i - 1));
+		const __m128i B = _mm_loadu_si128((const __m128i *)(src0 + i));
+		const __m128i C = _mm_loadu_si128((const __m128i *)(src0 + i + 1));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(src1 + i - 1));
+		const __m128i E = _mm_loadu_si128((const __m128i *)(src1 + i));
+		const __m128i F = _mm_loadu_si128((const __m128i *)(src1 + i + 1));
+		const __m128i G = _mm_loadu_si128((const __m128i *)(src2 + i - 1));
+		const __m128i H = _mm_loadu_si128((const __m128i *)(src2 + i));
+		const __m128i I = _mm_loadu_si128((const __m128i *)(src2 + i + 1));
+
+		/* B != H && D != F */
+		const __m128i cond = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi16(B, H), _mm_cmpeq_epi16(D, F)), _mm_set1_epi16(-1));
+
+		const __m128i DB = _mm_and_si128(cond, _mm_cmpeq_epi16(D, B));
+		const __m128i FB = _mm_and_si128(cond, _mm_cmpeq_epi16(F, B));
+		const __m128i DH = _mm_and_si128(cond, _mm_cmpeq_epi16(D, H));
+		const __m128i FH = _mm_and_si128(cond, _mm_cmpeq_epi16(F, H));
+
+		/* masks of E != A, E != C, E != G and E != I */
+		const __m128i EA = _mm_cmpeq_epi16(E, A), EC = _mm_cmpeq_epi16(E, C);
+		const __m128i EG = _mm_cmpeq_epi16(E, G), EI = _mm_cmpeq_epi16(E, I);
+
+		scale3x_store_sse2(dst0 + 3 * i,
+			scale3x_select_sse2(DB, D, E),
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EC, DB), _mm_andnot_si128(EA, FB)), B, E),
+			scale3x_select_sse2(FB, F, E));
+		scale3x_store_sse2(dst1 + 3 * i,
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EG, DB), _mm_andnot_si128(EA, DH)), D, E),
+			E,
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EI, FB), _mm_andnot_si128(EC, FH)), F, E));
+		scale3x_store_sse2(dst2 + 3 * i,
+			scale3x_select_sse2(DH, D, E),
+			scale3x_select_sse2(_mm_or_si128(_mm_andnot_si128(EI, DH), _mm_andnot_si128(EG, FH)), H, E),
+			scale3x_select_sse2(FH, F, E));
+	}
+
+	return i;
+}
+
+SCUMMVM_TARGET_AVX2 static inline __m256i scale3x_select_avx2(__m256i mask, __m256i x, __m256i y) {
+	return _mm256_blendv_epi8(y, x, mask);
+}
+
+/**
+ * Store the 16 bit values of a, b and c interleaved, i.e. a0 b0 c0 a1 b1 c1...
+ */
+SCUMMVM_TARGET_AVX2 static inline void scale3x_store_avx2(scale3x_uint16* dst, __m256i a, __m256i b, __m256i c) {
+	scale3x_store_sse2(dst, _mm256_castsi256_si128(a), _mm256_castsi256_si128(b), _mm256_castsi256_si128(c));
+	scale3x_store_sse2(dst + 24, _mm256_extracti128_si256(a, 1), _mm256_extracti128_si256(b, 1), _mm256_extracti128_si256(c, 1));
+}
+
+SCUMMVM_TARGET_AVX2 static unsigned scale3x_16_avx2_run(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		const __m256i A = _mm256_loadu_si256((const __m256i *)(src0 + i - 1));
+		const __m256i B = _mm256_loadu_si256((const __m256i *)(src0 + i));
+		const __m256i C = _mm256_loadu_si256((const __m256i *)(src0 + i + 1));
+		const __m256i D = _mm256_loadu_si256((const __m256i *)(src1 + i - 1));
+		const __m256i E = _mm256_loadu_si256((const __m256i *)(src1 + i));
+		const __m256i F = _mm256_loadu_si256((const __m256i *)(src1 + i + 1));
+		const __m256i G = _mm256_loadu_si256((const __m256i *)(src2 + i - 1));
+		const __m256i H = _mm256_loadu_si256((const __m256i *)(src2 + i));
+		const __m256i I = _mm256_loadu_si256((const __m256i *)(src2 + i + 1));
+
+		/* B != H && D != F */
+		const __m256i cond = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi16(B, H), _mm256_cmpeq_epi16(D, F)), _mm256_set1_epi16(-1));
+
+		const __m256i DB = _mm256_and_si256(cond, _mm256_cmpeq_epi16(D, B));
+		const __m256i FB = _mm256_and_si256(cond, _mm256_cmpeq_epi16(F, B));
+		const __m256i DH = _mm256_and_si256(cond, _mm256_cmpeq_epi16(D, H));
+		const __m256i FH = _mm256_and_si256(cond, _mm256_cmpeq_epi16(F, H));
+
+		/* masks of E != A, E != C, E != G and E != I */
+		const __m256i EA = _mm256_cmpeq_epi16(E, A), EC = _mm256_cmpeq_epi16(E, C);
+		const __m256i EG = _mm256_cmpeq_epi16(E, G), EI = _mm256_cmpeq_epi16(E, I);
+
+		scale3x_store_avx2(dst0 + 3 * i,
+			scale3x_select_avx2(DB, D, E),
+			scale3x_select_avx2(_mm256_or_si256(_mm256_andnot_si256(EC, DB), _mm256_andnot_si256(EA, FB)), B, E),
+			scale3x_select_avx2(FB, F, E));
+		scale3x_store_avx2(dst1 + 3 * i,
+			scale3x_select_avx2(_mm256_or_si256(_mm256_andnot_si256(EG, DB), _mm256_andnot_si256(EA, DH)), D, E),
+			E,
+			scale3x_select_avx2(_mm256_or_si256(_mm256_andnot_si256(EI, FB), _mm256_andnot_si256(EC, FH)), F, E));
+		scale3x_store_avx2(dst2 + 3 * i,
+			scale3x_select_avx2(DH, D, E),
+			scale3x_select_avx2(_mm256_or_si256(_mm256_andnot_si256(EI, DH), _mm256_andnot_si256(EG, FH)), H, E),
+			scale3x_select_avx2(FH, F, E));
+	}
+
+	return i;
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def(), but uses SSE2 instructions,
+ * which the CPU must support.
+ */
+void scale3x_16_sse2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	const unsigned done = scale3x_16_sse2_run(dst0, dst1, dst2, src0, src1, src2, count);
+	if (done < count)
+		scale3x_16_def(dst0 + 3 * done, dst1 + 3 * done, dst2 + 3 * done, src0 + done, src1 + done, src2 + done, count - done);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def(), but uses AVX2 instructions,
+ * which the CPU must support.
+ */
+void scale3x_16_avx2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	const unsigned done = scale3x_16_avx2_run(dst0, dst1, dst2, src0, src1, src2, count);
+	if (done < count)
+		scale3x_16_sse2(dst0 + 3 * done, dst1 + 3 * done, dst2 + 3 * done, src0 + done, src1 + done, src2 + done, count - done);
+}
+
+#endif
+
+#if defined(SCUMMVM_SIMD_NEON)
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def(), but uses NEON instructions.
+ */
+void scale3x_16_neon(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	unsigned i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const uint16x8_t A = vld1q_u16(src0 + i - 1);
+		const uint16x8_t B = vld1q_u16(src0 + i);
+		const uint16x8_t C = vld1q_u16(src0 + i + 1);
+		const uint16x8_t D = vld1q_u16(src1 + i - 1);
+		const uint16x8_t E = vld1q_u16(src1 + i);
+		const uint16x8_t F = vld1q_u16(src1 + i + 1);
+		const uint16x8_t G = vld1q_u16(src2 + i - 1);
+		const uint16x8_t H = vld1q_u16(src2 + i);
+		const uint16x8_t I = vld1q_u16(src2 + i + 1);
+
+		/* B != H && D != F */
+		const uint16x8_t cond = vmvnq_u16(vorrq_u16(vceqq_u16(B, H), vceqq_u16(D, F)));
+
+		const uint16x8_t DB = vandq_u16(cond, vceqq_u16(D, B));
+		const uint16x8_t FB = vandq_u16(cond, vceqq_u16(F, B));
+		const uint16x8_t DH = vandq_u16(cond, vceqq_u16(D, H));
+		const uint16x8_t FH = vandq_u16(cond, vceqq_u16(F, H));
+
+		/* masks of E != A, E != C, E != G and E != I */
+		const uint16x8_t EA = vceqq_u16(E, A), EC = vceqq_u16(E, C);
+		const uint16x8_t EG = vceqq_u16(E, G), EI = vceqq_u16(E, I);
+
+		uint16x8x3_t row0, row1, row2;
+		row0.val[0] = vbslq_u16(DB, D, E);
+		row0.val[1] = vbslq_u16(vorrq_u16(vbicq_u16(DB, EC), vbicq_u16(FB, EA)), B, E);
+		row0.val[2] = vbslq_u16(FB, F, E);
+		row1.val[0] = vbslq_u16(vorrq_u16(vbicq_u16(DB, EG), vbicq_u16(DH, EA)), D, E);
+		row1.val[1] = E;
+		row1.val[2] = vbslq_u16(vorrq_u16(vbicq_u16(FB, EI), vbicq_u16(FH, EC)), F, E);
+		row2.val[0] = vbslq_u16(DH, D, E);
+		row2.val[1] = vbslq_u16(vorrq_u16(vbicq_u16(DH, EI), vbicq_u16(FH, EG)), H, E);
+		row2.val[2] = vbslq_u16(FH, F, E);
+
+		vst3q_u16(dst0 + 3 * i, row0);
+		vst3q_u16(dst1 + 3 * i, row1);
+		vst3q_u16(dst2 + 3 * i, row2);
+	}
+
+	if (i < count)
+		scale3x_16_def(dst0 + 3 * i, dst1 + 3 * i, dst2 + 3 * i, src0 + i, src1 + i, src2 + i, count - i);
+}
+
+#endif
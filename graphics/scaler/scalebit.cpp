@@ -48,15 +48,43 @@ static inline void stage_scale2x(void* dst0, void* dst1, const void* src0, const
 	switch (pixel) {
 #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
 	case 1 : scale2x_8_mmx(DST(8,0), DST(8,1), SRC(8,0), SRC(8,1), SRC(8,2), pixel_per_row); break;
-	case 2 : scale2x_16_mmx(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row); break;
+	case 2 :
+#if defined(SCUMMVM_SIMD_X86)
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2)) {
+			scale2x_16_avx2(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2)) {
+			scale2x_16_sse2(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+#endif
+		scale2x_16_mmx(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+		break;
 	case 4 : scale2x_32_mmx(DST(32,0), DST(32,1), SRC(32,0), SRC(32,1), SRC(32,2), pixel_per_row); break;
 #elif defined(USE_ARM_SCALER_ASM)
 	case 1 : scale2x_8_arm(DST(8,0), DST(8,1), SRC(8,0), SRC(8,1), SRC(8,2), pixel_per_row); break;
-	case 2 : scale2x_16_arm(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row); break;
+	case 2 :
+#if defined(SCUMMVM_SIMD_NEON)
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON)) {
+			scale2x_16_neon(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+#endif
+		scale2x_16_arm(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+		break;
 	case 4 : scale2x_32_arm(DST(32,0), DST(32,1), SRC(32,0), SRC(32,1), SRC(32,2), pixel_per_row); break;
 #else
 	case 1 : scale2x_8_def(DST(8,0), DST(8,1), SRC(8,0), SRC(8,1), SRC(8,2), pixel_per_row); break;
-	case 2 : scale2x_16_def(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row); break;
+	case 2 :
+#if defined(SCUMMVM_SIMD_NEON)
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON)) {
+			scale2x_16_neon(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+#endif
+		scale2x_16_def(DST(16,0), DST(16,1), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+		break;
 	case 4 : scale2x_32_def(DST(32,0), DST(32,1), SRC(32,0), SRC(32,1), SRC(32,2), pixel_per_row); break;
 #endif
 	}
@@ -68,7 +96,24 @@ static inline void stage_scale2x(void* dst0, void* dst1, const void* src0, const
 static inline void stage_scale3x(void* dst0, void* dst1, void* dst2, const void* src0, const void* src1, const void* src2, unsigned pixel, unsigned pixel_per_row) {
 	switch (pixel) {
 	case 1 : scale3x_8_def(DST(8,0), DST(8,1), DST(8,2), SRC(8,0), SRC(8,1), SRC(8,2), pixel_per_row); break;
-	case 2 : scale3x_16_def(DST(16,0), DST(16,1), DST(16,2), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row); break;
+	case 2 :
+#if defined(SCUMMVM_SIMD_X86)
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2)) {
+			scale3x_16_avx2(DST(16,0), DST(16,1), DST(16,2), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2)) {
+			scale3x_16_sse2(DST(16,0), DST(16,1), DST(16,2), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+#elif defined(SCUMMVM_SIMD_NEON)
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON)) {
+			scale3x_16_neon(DST(16,0), DST(16,1), DST(16,2), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+			break;
+		}
+#endif
+		scale3x_16_def(DST(16,0), DST(16,1), DST(16,2), SRC(16,0), SRC(16,1), SRC(16,2), pixel_per_row);
+		break;
 	case 4 : scale3x_32_def(DST(32,0), DST(32,1), DST(32,2), SRC(32,0), SRC(32,1), SRC(32,2), pixel_per_row); break;
 	}
 }
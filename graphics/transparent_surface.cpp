@@ -0,0 +1,906 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "common/algorithm.h"
+#include "common/cpudetect.h"
+#include "common/endian.h"
+#include "common/util.h"
+#include "common/rect.h"
+#include "common/textconsole.h"
+#include "graphics/primitives.h"
+#include "graphics/transparent_surface.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Graphics {
+
+byte *TransparentSurface::_lookup = nullptr;
+
+void TransparentSurface::destroyLookup() {
+	delete[] _lookup;
+	_lookup = nullptr;
+}
+
+TransparentSurface::TransparentSurface() : Surface(), _enableAlphaBlit(true) {}
+
+TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Surface(), _enableAlphaBlit(true) {
+	if (copyData) {
+		copyFrom(surf);
+	} else {
+		w = surf.w;
+		h = surf.h;
+		pitch = surf.pitch;
+		format = surf.format;
+		pixels = surf.pixels;
+	}
+}
+
+#ifdef SCUMM_LITTLE_ENDIAN
+// The vector kernels below treat the B, G and R channels alike and only need
+// to know where alpha is, which they assume to be the most significant byte.
+#ifdef SCUMMVM_SIMD_X86
+#define TRANSPARENTSURFACE_SIMD_X86
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#define TRANSPARENTSURFACE_SIMD_NEON
+#endif
+#endif
+
+/**
+ * The two source pixels a bilinearly scaled pixel is interpolated from, along
+ * one axis, and the weight of the second one in 1/256.
+ */
+struct ScaleTap {
+	int first;
+	int second;
+	int weight;
+};
+
+/**
+ * Interpolate two pixels channel by channel. The vector kernels below round
+ * the same way, so that all of them give identical results.
+ */
+static inline uint32 lerpPixel(uint32 a, uint32 b, int weight) {
+	uint32 result = 0;
+	for (int shift = 0; shift < 32; shift += 8) {
+		const uint32 ca = (a >> shift) & 0xFF;
+		const uint32 cb = (b >> shift) & 0xFF;
+		result |= ((ca * (256 - weight) + cb * weight + 128) >> 8) << shift;
+	}
+	return result;
+}
+
+#ifdef TRANSPARENTSURFACE_SIMD_X86
+
+/**
+ * Copy a row of width pixels, setting them to full opacity.
+ * Returns the number of pixels done, the rest is left to the caller.
+ */
+SCUMMVM_TARGET_SSE2 static uint32 copyRowOpaqueSSE2(const byte *in, byte *out, uint32 width) {
+	const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+	uint32 done = 0;
+	for (; done + 4 <= width; done += 4) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)in);
+		_mm_storeu_si128((__m128i *)out, _mm_or_si128(src, alphaMask));
+		in += 16;
+		out += 16;
+	}
+	return done;
+}
+
+/**
+ * Blend 4 pixels exactly like doBlitAlpha does. The lookup table holds
+ * (i * j) >> 8, so the blending is done in 16 bit lanes with the same
+ * truncations, and the fully transparent and opaque cases are selected
+ * afterwards.
+ */
+SCUMMVM_TARGET_SSE2 static inline __m128i blendPixelsSSE2(__m128i src, __m128i dst, __m128i transparent, __m128i opaque) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	const __m128i srcLo = _mm_unpacklo_epi8(src, zero);
+	const __m128i srcHi = _mm_unpackhi_epi8(src, zero);
+	const __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i lo = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(srcLo, aLo), 8),
+	                                 _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), _mm_sub_epi16(max, aLo)), 8));
+	const __m128i hi = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(srcHi, aHi), 8),
+	                                 _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), _mm_sub_epi16(max, aHi)), 8));
+	__m128i blended = _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32((int)0xFF000000));
+	blended = _mm_or_si128(_mm_and_si128(opaque, src), _mm_andnot_si128(opaque, blended));
+	return _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, blended));
+}
+
+SCUMMVM_TARGET_SSE2 static uint32 blendRowSSE2(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi32(255);
+	uint32 done = 0;
+	for (; done + 4 <= width; done += 4) {
+		__m128i src;
+		if (inStep > 0) {
+			src = _mm_loadu_si128((const __m128i *)in);
+		} else {
+			src = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+		}
+		in += 4 * inStep;
+
+		const __m128i alpha = _mm_srli_epi32(src, 24);
+		const __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+		const __m128i opaque = _mm_cmpeq_epi32(alpha, max);
+		// Sprites mostly consist of runs of fully opaque or fully transparent pixels
+		if (_mm_movemask_epi8(opaque) == 0xFFFF) {
+			_mm_storeu_si128((__m128i *)out, src);
+		} else if (_mm_movemask_epi8(transparent) != 0xFFFF) {
+			const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+			_mm_storeu_si128((__m128i *)out, blendPixelsSSE2(src, dst, transparent, opaque));
+		}
+		out += 16;
+	}
+	return done;
+}
+
+/** AVX2 variant of blendPixelsSSE2, unpacking and packing work per 128 bit lane. */
+SCUMMVM_TARGET_AVX2 static inline __m256i blendPixelsAVX2(__m256i src, __m256i dst, __m256i transparent, __m256i opaque) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi16(255);
+	const __m256i srcLo = _mm256_unpacklo_epi8(src, zero);
+	const __m256i srcHi = _mm256_unpackhi_epi8(src, zero);
+	const __m256i aLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m256i aHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m256i lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(srcLo, aLo), 8),
+	                                    _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(max, aLo)), 8));
+	const __m256i hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(srcHi, aHi), 8),
+	                                    _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(max, aHi)), 8));
+	__m256i blended = _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32((int)0xFF000000));
+	blended = _mm256_blendv_epi8(blended, src, opaque);
+	return _mm256_blendv_epi8(blended, dst, transparent);
+}
+
+SCUMMVM_TARGET_AVX2 static uint32 blendRowAVX2(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi32(255);
+	const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	uint32 done = 0;
+	for (; done + 8 <= width; done += 8) {
+		__m256i src;
+		if (inStep > 0) {
+			src = _mm256_loadu_si256((const __m256i *)in);
+		} else {
+			src = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(in - 28)), reverse);
+		}
+		in += 8 * inStep;
+
+		const __m256i alpha = _mm256_srli_epi32(src, 24);
+		const __m256i transparent = _mm256_cmpeq_epi32(alpha, zero);
+		const __m256i opaque = _mm256_cmpeq_epi32(alpha, max);
+		if (_mm256_movemask_epi8(opaque) == -1) {
+			_mm256_storeu_si256((__m256i *)out, src);
+		} else if (_mm256_movemask_epi8(transparent) != -1) {
+			const __m256i dst = _mm256_loadu_si256((const __m256i *)out);
+			_mm256_storeu_si256((__m256i *)out, blendPixelsAVX2(src, dst, transparent, opaque));
+		}
+		out += 32;
+	}
+	return done;
+}
+
+/**
+ * Nearest neighbour resampling of one row, with the source offsets of
+ * every target pixel computed up front.
+ */
+SCUMMVM_TARGET_AVX2 static int scaleRowAVX2(uint32 *dst, const uint32 *src, const int *offsets, int width) {
+	int done = 0;
+	for (; done + 8 <= width; done += 8) {
+		const __m256i index = _mm256_loadu_si256((const __m256i *)(offsets + done));
+		_mm256_storeu_si256((__m256i *)(dst + done), _mm256_i32gather_epi32((const int *)src, index, 4));
+	}
+	return done;
+}
+
+/** lerpPixel on 16 bit lanes, none of the sums can overflow them. */
+SCUMMVM_TARGET_SSE2 static inline __m128i lerpSSE2(__m128i a, __m128i b, __m128i weightA, __m128i weightB) {
+	const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, weightA), _mm_mullo_epi16(b, weightB));
+	return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+/**
+ * Interpolate two rows of width pixels with the same weight.
+ * Returns the number of pixels done, the rest is left to the caller.
+ */
+SCUMMVM_TARGET_SSE2 static int lerpRowSSE2(uint32 *dst, const uint32 *top, const uint32 *bottom, int width, int weight) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weightTop = _mm_set1_epi16((short)(256 - weight));
+	const __m128i weightBottom = _mm_set1_epi16((short)weight);
+	int done = 0;
+	for (; done + 4 <= width; done += 4) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(top + done));
+		const __m128i b = _mm_loadu_si128((const __m128i *)(bottom + done));
+		const __m128i lo = lerpSSE2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), weightTop, weightBottom);
+		const __m128i hi = lerpSSE2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), weightTop, weightBottom);
+		_mm_storeu_si128((__m128i *)(dst + done), _mm_packus_epi16(lo, hi));
+	}
+	return done;
+}
+
+/**
+ * Interpolate every target pixel of a row between the two source pixels
+ * its tap refers to.
+ * Returns the number of pixels done, the rest is left to the caller.
+ */
+SCUMMVM_TARGET_SSE2 static int lerpColumnsSSE2(uint32 *dst, const uint32 *src, const ScaleTap *taps, int width) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(256);
+	int done = 0;
+	for (; done + 4 <= width; done += 4) {
+		const ScaleTap *t = taps + done;
+		const __m128i a = _mm_setr_epi32((int)src[t[0].first], (int)src[t[1].first], (int)src[t[2].first], (int)src[t[3].first]);
+		const __m128i b = _mm_setr_epi32((int)src[t[0].second], (int)src[t[1].second], (int)src[t[2].second], (int)src[t[3].second]);
+		const __m128i weightLo = _mm_setr_epi16(t[0].weight, t[0].weight, t[0].weight, t[0].weight,
+		                                        t[1].weight, t[1].weight, t[1].weight, t[1].weight);
+		const __m128i weightHi = _mm_setr_epi16(t[2].weight, t[2].weight, t[2].weight, t[2].weight,
+		                                        t[3].weight, t[3].weight, t[3].weight, t[3].weight);
+		const __m128i lo = lerpSSE2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_sub_epi16(max, weightLo), weightLo);
+		const __m128i hi = lerpSSE2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_sub_epi16(max, weightHi), weightHi);
+		_mm_storeu_si128((__m128i *)(dst + done), _mm_packus_epi16(lo, hi));
+	}
+	return done;
+}
+
+#endif // TRANSPARENTSURFACE_SIMD_X86
+
+#ifdef TRANSPARENTSURFACE_SIMD_NEON
+
+static uint32 copyRowOpaqueNEON(const byte *in, byte *out, uint32 width) {
+	const uint32x4_t alphaMask = vdupq_n_u32(0xFF000000);
+	uint32 done = 0;
+	for (; done + 4 <= width; done += 4) {
+		vst1q_u32((uint32 *)out, vorrq_u32(vld1q_u32((const uint32 *)in), alphaMask));
+		in += 16;
+		out += 16;
+	}
+	return done;
+}
+
+/**
+ * NEON variant of blendRowSSE2. The channels get deinterleaved on load, so
+ * the products can be narrowed back to bytes right away.
+ */
+static uint32 blendRowNEON(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const uint8x8_t zero = vdup_n_u8(0);
+	const uint8x8_t max = vdup_n_u8(255);
+	uint32 done = 0;
+	for (; done + 8 <= width; done += 8) {
+		uint8x8x4_t src;
+		if (inStep > 0) {
+			src = vld4_u8(in);
+		} else {
+			src = vld4_u8(in - 28);
+			for (int i = 0; i < 4; i++) {
+				src.val[i] = vrev64_u8(src.val[i]);
+			}
+		}
+		in += 8 * inStep;
+
+		const uint8x8_t alpha = src.val[3];
+		const uint8x8_t transparent = vceq_u8(alpha, zero);
+		const uint8x8_t opaque = vceq_u8(alpha, max);
+		const uint8x8_t invAlpha = vmvn_u8(alpha);
+		uint8x8x4_t dst = vld4_u8(out);
+		for (int i = 0; i < 3; i++) {
+			const uint8x8_t blended = vadd_u8(vshrn_n_u16(vmull_u8(src.val[i], alpha), 8),
+			                                  vshrn_n_u16(vmull_u8(dst.val[i], invAlpha), 8));
+			dst.val[i] = vbsl_u8(transparent, dst.val[i], vbsl_u8(opaque, src.val[i], blended));
+		}
+		dst.val[3] = vbsl_u8(transparent, dst.val[3], max);
+		vst4_u8(out, dst);
+		out += 32;
+	}
+	return done;
+}
+
+/** NEON variant of lerpRowSSE2. The rounding shift adds the 128 of lerpPixel. */
+static int lerpRowNEON(uint32 *dst, const uint32 *top, const uint32 *bottom, int width, int weight) {
+	const uint16 weightTop = 256 - weight;
+	const uint16 weightBottom = weight;
+	int done = 0;
+	for (; done + 4 <= width; done += 4) {
+		const uint8x16_t a = vld1q_u8((const uint8 *)(top + done));
+		const uint8x16_t b = vld1q_u8((const uint8 *)(bottom + done));
+		const uint16x8_t lo = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(a)), weightTop), vmovl_u8(vget_low_u8(b)), weightBottom);
+		const uint16x8_t hi = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(a)), weightTop), vmovl_u8(vget_high_u8(b)), weightBottom);
+		vst1q_u8((uint8 *)(dst + done), vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+	}
+	return done;
+}
+
+/** NEON variant of lerpColumnsSSE2. */
+static int lerpColumnsNEON(uint32 *dst, const uint32 *src, const ScaleTap *taps, int width) {
+	const uint16x8_t max = vdupq_n_u16(256);
+	int done = 0;
+	for (; done + 4 <= width; done += 4) {
+		const ScaleTap *t = taps + done;
+		uint32x4_t a = vdupq_n_u32(src[t[0].first]);
+		a = vsetq_lane_u32(src[t[1].first], a, 1);
+		a = vsetq_lane_u32(src[t[2].first], a, 2);
+		a = vsetq_lane_u32(src[t[3].first], a, 3);
+		uint32x4_t b = vdupq_n_u32(src[t[0].second]);
+		b = vsetq_lane_u32(src[t[1].second], b, 1);
+		b = vsetq_lane_u32(src[t[2].second], b, 2);
+		b = vsetq_lane_u32(src[t[3].second], b, 3);
+		const uint16x8_t weightLo = vcombine_u16(vdup_n_u16(t[0].weight), vdup_n_u16(t[1].weight));
+		const uint16x8_t weightHi = vcombine_u16(vdup_n_u16(t[2].weight), vdup_n_u16(t[3].weight));
+		const uint8x16_t a8 = vreinterpretq_u8_u32(a);
+		const uint8x16_t b8 = vreinterpretq_u8_u32(b);
+		const uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(a8)), vsubq_u16(max, weightLo)), vmovl_u8(vget_low_u8(b8)), weightLo);
+		const uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(a8)), vsubq_u16(max, weightHi)), vmovl_u8(vget_high_u8(b8)), weightHi);
+		vst1q_u8((uint8 *)(dst + done), vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+	}
+	return done;
+}
+
+#endif // TRANSPARENTSURFACE_SIMD_NEON
+
+void doBlitOpaque(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
+	byte *in, *out;
+
+#ifdef SCUMM_LITTLE_ENDIAN
+	const int aIndex = 3;
+#else
+	const int aIndex = 0;
+#endif
+
+	uint32 (*copyRow)(const byte *, byte *, uint32) = nullptr;
+	// The rows are always copied forwards, so mirrored blits stay on the plain path
+	if (inStep > 0) {
+#ifdef TRANSPARENTSURFACE_SIMD_X86
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+			copyRow = &copyRowOpaqueSSE2;
+#endif
+#ifdef TRANSPARENTSURFACE_SIMD_NEON
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+			copyRow = &copyRowOpaqueNEON;
+#endif
+	}
+
+	for (uint32 i = 0; i < height; i++) {
+		out = outo;
+		in = ino;
+		uint32 done = copyRow ? copyRow(in, out, width) : 0;
+		memcpy(out + done * 4, in + done * 4, (width - done) * 4);
+		out += done * 4;
+		for (uint32 j = done; j < width; j++) {
+			out[aIndex] = 0xFF;
+			out += 4;
+		}
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+void TransparentSurface::generateLookup() {
+	_lookup = new byte[256 * 256];
+	for (int i = 0; i < 256; i++) {
+		for (int j = 0; j < 256; j++) {
+			_lookup[(i << 8) + j] = (i * j) >> 8;
+		}
+	}
+}
+
+void TransparentSurface::doBlitAlpha(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
+	byte *in, *out;
+
+	if (!_lookup) {
+		generateLookup();
+	}
+
+#ifdef SCUMM_LITTLE_ENDIAN
+	const int aIndex = 3;
+	const int bIndex = 0;
+	const int gIndex = 1;
+	const int rIndex = 2;
+#else
+	const int aIndex = 0;
+	const int bIndex = 3;
+	const int gIndex = 2;
+	const int rIndex = 1;
+#endif
+
+	const int bShift = 0;//img->format.bShift;
+	const int gShift = 8;//img->format.gShift;
+	const int rShift = 16;//img->format.rShift;
+	const int aShift = 24;//img->format.aShift;
+
+	const int bShiftTarget = 0;//target.format.bShift;
+	const int gShiftTarget = 8;//target.format.gShift;
+	const int rShiftTarget = 16;//target.format.rShift;
+
+	// The vector kernels do as many pixels of each row as they can, the
+	// remainder is done here.
+	uint32 (*blendRow)(const byte *, byte *, uint32, int32) = nullptr;
+#ifdef TRANSPARENTSURFACE_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		blendRow = &blendRowAVX2;
+	else if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		blendRow = &blendRowSSE2;
+#endif
+#ifdef TRANSPARENTSURFACE_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		blendRow = &blendRowNEON;
+#endif
+
+	for (uint32 i = 0; i < height; i++) {
+		out = outo;
+		in = ino;
+		uint32 done = blendRow ? blendRow(in, out, width, inStep) : 0;
+		in += (int32)done * inStep;
+		out += done * 4;
+		for (uint32 j = done; j < width; j++) {
+			uint32 pix = *(uint32 *)in;
+			uint32 oPix = *(uint32 *) out;
+			int b = (pix >> bShift) & 0xff;
+			int g = (pix >> gShift) & 0xff;
+			int r = (pix >> rShift) & 0xff;
+			int a = (pix >> aShift) & 0xff;
+			int outb, outg, outr, outa;
+			in += inStep;
+
+			switch (a) {
+				case 0: // Full transparency
+					out += 4;
+					break;
+				case 255: // Full opacity
+					outb = b;
+					outg = g;
+					outr = r;
+					outa = a;
+
+					out[aIndex] = outa;
+					out[bIndex] = outb;
+					out[gIndex] = outg;
+					out[rIndex] = outr;
+					out += 4;
+					break;
+
+				default: // alpha blending
+					outa = 255;
+
+					outb = _lookup[(((oPix >> bShiftTarget) & 0xff)) + ((255 - a) << 8)];
+					outg = _lookup[(((oPix >> gShiftTarget) & 0xff)) + ((255 - a) << 8)];
+					outr = _lookup[(((oPix >> rShiftTarget) & 0xff)) + ((255 - a) << 8)];
+					outb += _lookup[b + (a << 8)];
+					outg += _lookup[g + (a << 8)];
+					outr += _lookup[r + (a << 8)];
+
+					out[aIndex] = outa;
+					out[bIndex] = outb;
+					out[gIndex] = outg;
+					out[rIndex] = outr;
+					out += 4;
+			}
+		}
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+
+Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height) {
+	int ca = (color >> 24) & 0xff;
+
+	Common::Rect retSize;
+	retSize.top = 0;
+	retSize.left = 0;
+	retSize.setWidth(0);
+	retSize.setHeight(0);
+	// Check if we need to draw anything at all
+	if (ca == 0)
+		return retSize;
+
+	int cr = (color >> 16) & 0xff;
+	int cg = (color >> 8) & 0xff;
+	int cb = (color >> 0) & 0xff;
+
+	// Compensate for transparency. Since we're coming
+	// down to 255 alpha, we just compensate for the colors here
+	if (ca != 255) {
+		cr = cr * ca >> 8;
+		cg = cg * ca >> 8;
+		cb = cb * ca >> 8;
+	}
+
+	// Create an encapsulating surface for the data
+	TransparentSurface srcImage(*this, false);
+	// TODO: Is the data really in the screen format?
+	if (format.bytesPerPixel != 4) {
+		warning("TransparentSurface can only blit 32 bpp images");
+		return retSize;
+	}
+
+	if (pPartRect) {
+		srcImage.pixels = &((char *)pixels)[pPartRect->top * srcImage.pitch + pPartRect->left * 4];
+		srcImage.w = pPartRect->width();
+		srcImage.h = pPartRect->height();
+
+		debug(6, "Blit(%d, %d, %d, [%d, %d, %d, %d], %08x, %d, %d)", posX, posY, flipping,
+		      pPartRect->left,  pPartRect->top, pPartRect->width(), pPartRect->height(), color, width, height);
+	} else {
+
+		debug(6, "Blit(%d, %d, %d, [%d, %d, %d, %d], %08x, %d, %d)", posX, posY, flipping, 0, 0,
+		      srcImage.w, srcImage.h, color, width, height);
+	}
+
+	if (width == -1)
+		width = srcImage.w;
+	if (height == -1)
+		height = srcImage.h;
+
+#ifdef SCALING_TESTING
+	// Hardcode scaling to 66% to test scaling
+	width = width * 2 / 3;
+	height = height * 2 / 3;
+#endif
+
+	Graphics::Surface *img = nullptr;
+	Graphics::Surface *imgScaled = nullptr;
+	byte *savedPixels = nullptr;
+	if ((width != srcImage.w) || (height != srcImage.h)) {
+		// Scale the image
+		img = imgScaled = srcImage.scale(width, height);
+		savedPixels = (byte *)img->pixels;
+	} else {
+		img = &srcImage;
+	}
+
+	// Handle off-screen clipping
+	if (posY < 0) {
+		img->h = MAX(0, (int)img->h - -posY);
+		img->pixels = (byte *)img->pixels + img->pitch * -posY;
+		posY = 0;
+	}
+
+	if (posX < 0) {
+		img->w = MAX(0, (int)img->w - -posX);
+		img->pixels = (byte *)img->pixels + (-posX * 4);
+		posX = 0;
+	}
+
+	img->w = CLIP((int)img->w, 0, (int)MAX((int)target.w - posX, 0));
+	img->h = CLIP((int)img->h, 0, (int)MAX((int)target.h - posY, 0));
+
+	if ((img->w > 0) && (img->h > 0)) {
+		int xp = 0, yp = 0;
+
+		int inStep = 4;
+		int inoStep = img->pitch;
+		if (flipping & TransparentSurface::FLIP_V) {
+			inStep = -inStep;
+			xp = img->w - 1;
+		}
+
+		if (flipping & TransparentSurface::FLIP_H) {
+			inoStep = -inoStep;
+			yp = img->h - 1;
+		}
+
+		byte *ino = (byte *)img->getBasePtr(xp, yp);
+		byte *outo = (byte *)target.getBasePtr(posX, posY);
+		byte *in, *out;
+
+#ifdef SCUMM_LITTLE_ENDIAN
+		const int aIndex = 3;
+		const int bIndex = 0;
+		const int gIndex = 1;
+		const int rIndex = 2;
+#else
+		const int aIndex = 0;
+		const int bIndex = 3;
+		const int gIndex = 2;
+		const int rIndex = 1;
+#endif
+		const int bShift = 0;//img->format.bShift;
+		const int gShift = 8;//img->format.gShift;
+		const int rShift = 16;//img->format.rShift;
+		const int aShift = 24;//img->format.aShift;
+
+		const int bShiftTarget = 0;//target.format.bShift;
+		const int gShiftTarget = 8;//target.format.gShift;
+		const int rShiftTarget = 16;//target.format.rShift;
+
+		if (ca == 255 && cb == 255 && cg == 255 && cr == 255) {
+			if (_enableAlphaBlit) {
+				doBlitAlpha(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
+			} else {
+				doBlitOpaque(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
+			}
+		} else {
+			for (int i = 0; i < img->h; i++) {
+				out = outo;
+				in = ino;
+				for (int j = 0; j < img->w; j++) {
+					uint32 pix = *(uint32 *)in;
+					uint32 o_pix = *(uint32 *) out;
+					int b = (pix >> bShift) & 0xff;
+					int g = (pix >> gShift) & 0xff;
+					int r = (pix >> rShift) & 0xff;
+					int a = (pix >> aShift) & 0xff;
+					int outb, outg, outr, outa;
+					in += inStep;
+
+					if (ca != 255) {
+						a = a * ca >> 8;
+					}
+
+					switch (a) {
+					case 0: // Full transparency
+						out += 4;
+						break;
+					case 255: // Full opacity
+						if (cb != 255)
+							outb = (b * cb) >> 8;
+						else
+							outb = b;
+
+						if (cg != 255)
+							outg = (g * cg) >> 8;
+						else
+							outg = g;
+
+						if (cr != 255)
+							outr = (r * cr) >> 8;
+						else
+							outr = r;
+						outa = a;
+						out[aIndex] = outa;
+						out[bIndex] = outb;
+						out[gIndex] = outg;
+						out[rIndex] = outr;
+						out += 4;
+						break;
+
+					default: // alpha blending
+						outa = 255;
+						outb = (o_pix >> bShiftTarget) & 0xff;
+						outg = (o_pix >> gShiftTarget) & 0xff;
+						outr = (o_pix >> rShiftTarget) & 0xff;
+						if (cb == 0)
+							outb = 0;
+						else if (cb != 255)
+							outb += ((b - outb) * a * cb) >> 16;
+						else
+							outb += ((b - outb) * a) >> 8;
+						if (cg == 0)
+							outg = 0;
+						else if (cg != 255)
+							outg += ((g - outg) * a * cg) >> 16;
+						else
+							outg += ((g - outg) * a) >> 8;
+						if (cr == 0)
+							outr = 0;
+						else if (cr != 255)
+							outr += ((r - outr) * a * cr) >> 16;
+						else
+							outr += ((r - outr) * a) >> 8;
+						out[aIndex] = outa;
+						out[bIndex] = outb;
+						out[gIndex] = outg;
+						out[rIndex] = outr;
+						out += 4;
+					}
+				}
+				outo += target.pitch;
+				ino += inoStep;
+			}
+		}
+	}
+
+	retSize.setWidth(img->w);
+	retSize.setHeight(img->h);
+
+	if (imgScaled) {
+		imgScaled->pixels = savedPixels;
+		imgScaled->free();
+		delete imgScaled;
+	}
+
+	return retSize;
+}
+
+TransparentSurface *TransparentSurface::scale(uint16 newWidth, uint16 newHeight, ScaleFilter filter) const {
+	Common::Rect srcRect(0, 0, (int16)w, (int16)h);
+	Common::Rect dstRect(0, 0, (int16)newWidth, (int16)newHeight);
+	return scale(srcRect, dstRect, filter);
+}
+
+// Copied from clone2727's https://github.com/clone2727/scummvm/blob/pegasus/engines/pegasus/surface.cpp#L247
+TransparentSurface *TransparentSurface::scale(const Common::Rect &srcRect, const Common::Rect &dstRect, ScaleFilter filter) const {
+	// I'm doing simple linear scaling here
+	// dstRect(x, y) = srcRect(x * srcW / dstW, y * srcH / dstH);
+	TransparentSurface *target = new TransparentSurface();
+
+	assert(format.bytesPerPixel == 4);
+
+	int srcW = srcRect.width();
+	int srcH = srcRect.height();
+	int dstW = dstRect.width();
+	int dstH = dstRect.height();
+
+	target->create((uint16)dstW, (uint16)dstH, this->format);
+
+	if (dstW <= 0 || dstH <= 0) {
+		return target;
+	}
+
+	if (filter == kScaleBilinear) {
+		scaleBilinear(target, srcRect, dstRect);
+		return target;
+	}
+
+	// The source column is the same for every row, so only compute it once.
+	int *offsets = new int[dstW];
+	for (int x = 0; x < dstW; x++) {
+		offsets[x] = x * srcW / dstW + srcRect.left;
+	}
+
+	int (*scaleRow)(uint32 *, const uint32 *, const int *, int) = nullptr;
+#ifdef SCUMMVM_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		scaleRow = &scaleRowAVX2;
+#endif
+
+	int lastSrcY = -1;
+	for (int y = 0; y < dstH; y++) {
+		int srcY = y * srcH / dstH + srcRect.top;
+		uint32 *dst = (uint32 *)target->getBasePtr(dstRect.left, y + dstRect.top);
+		if (srcY == lastSrcY) {
+			// When scaling up, rows are repeated
+			memcpy(dst, target->getBasePtr(dstRect.left, y - 1 + dstRect.top), dstW * 4);
+			continue;
+		}
+		lastSrcY = srcY;
+
+		const uint32 *src = (const uint32 *)getBasePtr(0, srcY);
+		int x = scaleRow ? scaleRow(dst, src, offsets, dstW) : 0;
+		for (; x < dstW; x++) {
+			dst[x] = src[offsets[x]];
+		}
+	}
+
+	delete[] offsets;
+	return target;
+
+}
+
+/**
+ * Compute the taps for resampling srcSize pixels to dstSize ones. Every
+ * target pixel samples the source at its center, and the outermost ones
+ * are clamped to the edge.
+ */
+static ScaleTap *computeScaleTaps(int srcSize, int dstSize) {
+	ScaleTap *taps = new ScaleTap[dstSize];
+	// 16.16 fixed point, which is enough for any size a surface can have
+	const uint32 step = ((uint32)srcSize << 16) / dstSize;
+	for (int i = 0; i < dstSize; i++) {
+		const int32 pos = (int32)(i * step + step / 2) - 0x8000;
+		if (pos <= 0) {
+			taps[i].first = 0;
+			taps[i].weight = 0;
+		} else {
+			taps[i].first = pos >> 16;
+			taps[i].weight = (pos >> 8) & 0xFF;
+		}
+
+		if (taps[i].first >= srcSize - 1) {
+			taps[i].first = srcSize - 1;
+			taps[i].weight = 0;
+		}
+		taps[i].second = MIN(taps[i].first + 1, srcSize - 1);
+	}
+	return taps;
+}
+
+void TransparentSurface::scaleBilinear(TransparentSurface *target, const Common::Rect &srcRect, const Common::Rect &dstRect) const {
+	const int srcW = srcRect.width();
+	const int srcH = srcRect.height();
+	const int dstW = dstRect.width();
+	const int dstH = dstRect.height();
+
+	if (srcW <= 0 || srcH <= 0) {
+		return;
+	}
+
+	// Every target row is interpolated from two source rows, which are
+	// first merged into one, so that only its columns are left to do.
+	ScaleTap *columns = computeScaleTaps(srcW, dstW);
+	ScaleTap *rows = computeScaleTaps(srcH, dstH);
+	uint32 *merged = new uint32[srcW];
+
+	int (*lerpRow)(uint32 *, const uint32 *, const uint32 *, int, int) = nullptr;
+	int (*lerpColumns)(uint32 *, const uint32 *, const ScaleTap *, int) = nullptr;
+#ifdef TRANSPARENTSURFACE_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureSSE2)) {
+		lerpRow = &lerpRowSSE2;
+		lerpColumns = &lerpColumnsSSE2;
+	}
+#endif
+#ifdef TRANSPARENTSURFACE_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON)) {
+		lerpRow = &lerpRowNEON;
+		lerpColumns = &lerpColumnsNEON;
+	}
+#endif
+
+	for (int y = 0; y < dstH; y++) {
+		const ScaleTap &row = rows[y];
+		uint32 *dst = (uint32 *)target->getBasePtr(dstRect.left, y + dstRect.top);
+		if (y > 0 && row.first == rows[y - 1].first && row.weight == rows[y - 1].weight) {
+			// When scaling up a lot, rows can be repeated
+			memcpy(dst, target->getBasePtr(dstRect.left, y - 1 + dstRect.top), dstW * 4);
+			continue;
+		}
+
+		const uint32 *top = (const uint32 *)getBasePtr(srcRect.left, srcRect.top + row.first);
+		const uint32 *bottom = (const uint32 *)getBasePtr(srcRect.left, srcRect.top + row.second);
+		int x = lerpRow ? lerpRow(merged, top, bottom, srcW, row.weight) : 0;
+		for (; x < srcW; x++) {
+			merged[x] = lerpPixel(top[x], bottom[x], row.weight);
+		}
+
+		x = lerpColumns ? lerpColumns(dst, merged, columns, dstW) : 0;
+		for (; x < dstW; x++) {
+			dst[x] = lerpPixel(merged[columns[x].first], merged[columns[x].second], columns[x].weight);
+		}
+	}
+
+	delete[] merged;
+	delete[] rows;
+	delete[] columns;
+}
+
+/**
+ * Writes a color key to the alpha channel of the surface
+ * @param rKey  the red component of the color key
+ * @param gKey  the green component of the color key
+ * @param bKey  the blue component of the color key
+ * @param overwriteAlpha if true, all other alpha will be set fully opaque
+ */
+void TransparentSurface::applyColorKey(uint8 rKey, uint8 gKey, uint8 bKey, bool overwriteAlpha) {
+	assert(format.bytesPerPixel == 4);
+	for (int i = 0; i < h; i++) {
+		for (int j = 0; j < w; j++) {
+			uint32 pix = ((uint32 *)pixels)[i * w + j];
+			uint8 r, g, b, a;
+			format.colorToARGB(pix, a, r, g, b);
+			if (r == rKey && g == gKey && b == bKey) {
+				a = 0;
+				((uint32 *)pixels)[i * w + j] = format.ARGBToColor(a, r, g, b);
+			} else if (overwriteAlpha) {
+				a = 255;
+				((uint32 *)pixels)[i * w + j] = format.ARGBToColor(a, r, g, b);
+			}
+		}
+	}
+}
+
+} // End of namespace Graphics
@@ -37,7 +37,7 @@
 #define BS_RGB(R,G,B)       (0xFF000000 | ((R) << 16) | ((G) << 8) | (B))
 #define BS_ARGB(A,R,G,B)    (((A) << 24) | ((R) << 16) | ((G) << 8) | (B))
 
-namespace Wintermute {
+namespace Graphics {
 
 /**
  * A transparent graphics surface, which implements alpha blitting.
@@ -102,14 +102,26 @@ struct TransparentSurface : public Graphics::Surface {
 	                  uint color = BS_ARGB(255, 255, 255, 255),
 	                  int width = -1, int height = -1);
 	void applyColorKey(uint8 r, uint8 g, uint8 b, bool overwriteAlpha = false);
+
+	/**
+	 @brief The filters the scale methods can resample with.
+	 */
+	enum ScaleFilter {
+	    /// Every target pixel is a copy of one source pixel, like blit() scales.
+	    kScaleNearest,
+	    /// Every target pixel is interpolated from the four closest source pixels.
+	    kScaleBilinear
+	};
+
 	// The following scale-code supports arbitrary scaling (i.e. no repeats of column 0 at the end of lines)
-	TransparentSurface *scale(uint16 newWidth, uint16 newHeight) const;
-	TransparentSurface *scale(const Common::Rect &srcRect, const Common::Rect &dstRect) const;
+	TransparentSurface *scale(uint16 newWidth, uint16 newHeight, ScaleFilter filter = kScaleNearest) const;
+	TransparentSurface *scale(const Common::Rect &srcRect, const Common::Rect &dstRect, ScaleFilter filter = kScaleNearest) const;
 	static byte *_lookup;
 	static void destroyLookup();
 private:
 	static void doBlitAlpha(byte *ino, byte* outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
 	static void generateLookup();
+	void scaleBilinear(TransparentSurface *target, const Common::Rect &srcRect, const Common::Rect &dstRect) const;
 };
 
 /**
@@ -83,9 +83,21 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/cpudetect.h"
+#include "common/mutex.h"
+#include "common/system.h"
+#include "common/util.h"
+#include "common/workerpool.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -157,8 +169,527 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 	}
 }
 
+namespace {
+
+/** Where the row kernels put the R, G and B values of a pixel. */
+struct RowFormat {
+	int bytesPerPixel;
+	bool itu;             ///< whether the luminance uses the ITU-R BT.601 range
+	int rLoss, gLoss, bLoss;
+	int rShift, gShift, bShift;
+	uint32 alpha;         ///< bits set in every pixel
+};
+
+/**
+ * A row kernel converts a prefix of a row of width pixels and returns its
+ * length, the rest is left to the caller. Instead of the U and V values, it
+ * gets the color table entries for them, i.e. what the chroma adds to the
+ * luminance for each of R, G and B. With 4:2:0 images, two neighbouring
+ * pixels share each of these values.
+ */
+typedef int (*ConvertRowProc)(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width, const RowFormat &format);
+
+/**
+ * A chroma kernel computes the color table entries for a prefix of count
+ * U and V values, and returns its length.
+ */
+typedef int (*ConvertChromaProc)(const byte *uSrc, const byte *vSrc, int16 *crR, int16 *crbG, int16 *cbB, int count);
+
+/** A band of rows converted by one thread. */
+struct ConversionBand {
+	ConvertRowProc convertRow;
+	ConvertChromaProc convertChroma; ///< 0 if the color table has to be used
+	RowFormat format;
+	const uint32 *rgbToPix;
+	const int16 *colorTab;
+	int subsampling;
+	byte *dst;
+	int dstPitch;
+	const byte *ySrc, *uSrc, *vSrc;
+	int yWidth, yPitch, uvPitch;
+	int firstRow, endRow;
+	int16 *chroma;        ///< space for three rows of yWidth chroma values, and yWidth U and V values
+};
+
+enum {
+	kMaxBands = 8,
+	kMinThreadedPixels = 1280 * 720
+};
+
+bool getRowFormat(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale, RowFormat &rowFormat) {
+	// 32 bit formats are only done with 8 bits per component, since the
+	// kernels only shift the components into place there
+	if (format.bytesPerPixel == 4) {
+		if (format.rLoss || format.gLoss || format.bLoss)
+			return false;
+	} else if (format.bytesPerPixel != 2) {
+		return false;
+	}
+
+	rowFormat.bytesPerPixel = format.bytesPerPixel;
+	rowFormat.itu = (scale == YUVToRGBManager::kScaleITU);
+	rowFormat.rLoss = format.rLoss;
+	rowFormat.gLoss = format.gLoss;
+	rowFormat.bLoss = format.bLoss;
+	rowFormat.rShift = format.rShift;
+	rowFormat.gShift = format.gShift;
+	rowFormat.bShift = format.bShift;
+	rowFormat.alpha = format.RGBToColor(0, 0, 0);
+	return true;
+}
+
+/**
+ * The color table entries for c = value - 128 can be computed exactly as
+ * sign(c) * (((|c| << 7) * kMul >> 16) >> kShift), with the constants below
+ * and the sign flipped for the green entries. The chroma kernels do this,
+ * unless YUVToRGBManager's constructor found a mismatch with the table.
+ */
+enum {
+	kCrRMul = 717,   kCrRShift = 0,
+	kCrGMul = 731,   kCrGShift = 1,
+	kCbGMul = 2821,  kCbGShift = 4,
+	kCbBMul = 29055, kCbBShift = 5
+};
+
+int16 scaleChroma(int c, int mul, int shift) {
+	const int q = ((((c < 0) ? -c : c) << 7) * mul >> 16) >> shift;
+	return (c < 0) ? -q : q;
+}
+
+#ifdef SCUMMVM_SIMD_X86
+
+/**
+ * Clamp the sums of luminance and chroma to the valid range, and scale them
+ * the same way as YUVToRGBLookup does. (c - 16) * 255 / 219 is computed as
+ * a multiplication with 2^22 / 219, which is exact for all c in [16, 235].
+ */
+template<bool kITU>
+SCUMMVM_TARGET_SSE2 inline __m128i clampComponentSSE2(__m128i c) {
+	if (!kITU)
+		return _mm_min_epi16(_mm_max_epi16(c, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+	c = _mm_min_epi16(_mm_max_epi16(c, _mm_set1_epi16(16)), _mm_set1_epi16(235));
+	c = _mm_sub_epi16(c, _mm_set1_epi16(16));
+	c = _mm_sub_epi16(_mm_slli_epi16(c, 8), c);
+	return _mm_srli_epi16(_mm_mulhi_epu16(c, _mm_set1_epi16(19153)), 6);
+}
+
+template<bool kHalfChroma>
+SCUMMVM_TARGET_SSE2 inline void loadChromaSSE2(const int16 *chroma, int x, __m128i &lo, __m128i &hi) {
+	if (kHalfChroma) {
+		const __m128i c = _mm_loadu_si128((const __m128i *)(chroma + x / 2));
+		lo = _mm_unpacklo_epi16(c, c);
+		hi = _mm_unpackhi_epi16(c, c);
+	} else {
+		lo = _mm_loadu_si128((const __m128i *)(chroma + x));
+		hi = _mm_loadu_si128((const __m128i *)(chroma + x + 8));
+	}
+}
+
+SCUMMVM_TARGET_SSE2 inline void storePixelsSSE2(uint16 *dst, __m128i r, __m128i g, __m128i b, const RowFormat &format) {
+	r = _mm_sll_epi16(_mm_srl_epi16(r, _mm_cvtsi32_si128(format.rLoss)), _mm_cvtsi32_si128(format.rShift));
+	g = _mm_sll_epi16(_mm_srl_epi16(g, _mm_cvtsi32_si128(format.gLoss)), _mm_cvtsi32_si128(format.gShift));
+	b = _mm_sll_epi16(_mm_srl_epi16(b, _mm_cvtsi32_si128(format.bLoss)), _mm_cvtsi32_si128(format.bShift));
+
+	const __m128i pixels = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi16((int16)format.alpha)));
+	_mm_storeu_si128((__m128i *)dst, pixels);
+}
+
+SCUMMVM_TARGET_SSE2 inline void storePixelsSSE2(uint32 *dst, __m128i r, __m128i g, __m128i b, const RowFormat &format) {
+	const __m128i rShift = _mm_cvtsi32_si128(format.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(format.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(format.bShift);
+	const __m128i alpha = _mm_set1_epi32(format.alpha);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i pixels = _mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rShift), _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gShift));
+	pixels = _mm_or_si128(pixels, _mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bShift), alpha));
+	_mm_storeu_si128((__m128i *)dst, pixels);
+
+	pixels = _mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rShift), _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gShift));
+	pixels = _mm_or_si128(pixels, _mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bShift), alpha));
+	_mm_storeu_si128((__m128i *)(dst + 4), pixels);
+}
+
+template<typename PixelInt, bool kITU, bool kHalfChroma>
+SCUMMVM_TARGET_SSE2 int convertRowSSE2(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width, const RowFormat &format) {
+	PixelInt *out = (PixelInt *)dst;
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x + 16 <= width; x += 16) {
+		const __m128i luma = _mm_loadu_si128((const __m128i *)(ySrc + x));
+		const __m128i yLo = _mm_unpacklo_epi8(luma, zero);
+		const __m128i yHi = _mm_unpackhi_epi8(luma, zero);
+
+		__m128i rLo, rHi, gLo, gHi, bLo, bHi;
+		loadChromaSSE2<kHalfChroma>(crR, x, rLo, rHi);
+		loadChromaSSE2<kHalfChroma>(crbG, x, gLo, gHi);
+		loadChromaSSE2<kHalfChroma>(cbB, x, bLo, bHi);
+
+		storePixelsSSE2(out + x,
+			clampComponentSSE2<kITU>(_mm_add_epi16(yLo, rLo)),
+			clampComponentSSE2<kITU>(_mm_add_epi16(yLo, gLo)),
+			clampComponentSSE2<kITU>(_mm_add_epi16(yLo, bLo)), format);
+		storePixelsSSE2(out + x + 8,
+			clampComponentSSE2<kITU>(_mm_add_epi16(yHi, rHi)),
+			clampComponentSSE2<kITU>(_mm_add_epi16(yHi, gHi)),
+			clampComponentSSE2<kITU>(_mm_add_epi16(yHi, bHi)), format);
+	}
+
+	return x;
+}
+
+/** AVX2 variant of clampComponentSSE2. */
+template<bool kITU>
+SCUMMVM_TARGET_AVX2 inline __m256i clampComponentAVX2(__m256i c) {
+	if (!kITU)
+		return _mm256_min_epi16(_mm256_max_epi16(c, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+
+	c = _mm256_min_epi16(_mm256_max_epi16(c, _mm256_set1_epi16(16)), _mm256_set1_epi16(235));
+	c = _mm256_sub_epi16(c, _mm256_set1_epi16(16));
+	c = _mm256_sub_epi16(_mm256_slli_epi16(c, 8), c);
+	return _mm256_srli_epi16(_mm256_mulhi_epu16(c, _mm256_set1_epi16(19153)), 6);
+}
+
+/**
+ * Load the chroma values of 16 pixels. Unlike the unpack instructions, the
+ * sign extension keeps the values in order across the two 128 bit lanes.
+ */
+template<bool kHalfChroma>
+SCUMMVM_TARGET_AVX2 inline __m256i loadChromaAVX2(const int16 *chroma, int x) {
+	if (!kHalfChroma)
+		return _mm256_loadu_si256((const __m256i *)(chroma + x));
+
+	const __m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(chroma + x / 2)));
+	return _mm256_or_si256(_mm256_and_si256(c, _mm256_set1_epi32(0xFFFF)), _mm256_slli_epi32(c, 16));
+}
+
+SCUMMVM_TARGET_AVX2 inline void storePixelsAVX2(uint16 *dst, __m256i r, __m256i g, __m256i b, const RowFormat &format) {
+	r = _mm256_sll_epi16(_mm256_srl_epi16(r, _mm_cvtsi32_si128(format.rLoss)), _mm_cvtsi32_si128(format.rShift));
+	g = _mm256_sll_epi16(_mm256_srl_epi16(g, _mm_cvtsi32_si128(format.gLoss)), _mm_cvtsi32_si128(format.gShift));
+	b = _mm256_sll_epi16(_mm256_srl_epi16(b, _mm_cvtsi32_si128(format.bLoss)), _mm_cvtsi32_si128(format.bShift));
+
+	const __m256i pixels = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_set1_epi16((int16)format.alpha)));
+	_mm256_storeu_si256((__m256i *)dst, pixels);
+}
+
+SCUMMVM_TARGET_AVX2 inline __m256i packPixelsAVX2(__m128i r, __m128i g, __m128i b, const RowFormat &format) {
+	__m256i pixels = _mm256_or_si256(
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(r), _mm_cvtsi32_si128(format.rShift)),
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(g), _mm_cvtsi32_si128(format.gShift)));
+	return _mm256_or_si256(pixels, _mm256_or_si256(
+		_mm256_sll_epi32(_mm256_cvtepu16_epi32(b), _mm_cvtsi32_si128(format.bShift)),
+		_mm256_set1_epi32(format.alpha)));
+}
+
+SCUMMVM_TARGET_AVX2 inline void storePixelsAVX2(uint32 *dst, __m256i r, __m256i g, __m256i b, const RowFormat &format) {
+	_mm256_storeu_si256((__m256i *)dst, packPixelsAVX2(
+		_mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b), format));
+	_mm256_storeu_si256((__m256i *)(dst + 8), packPixelsAVX2(
+		_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1), format));
+}
+
+template<typename PixelInt, bool kITU, bool kHalfChroma>
+SCUMMVM_TARGET_AVX2 int convertRowAVX2(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width, const RowFormat &format) {
+	PixelInt *out = (PixelInt *)dst;
+	int x = 0;
+
+	for (; x + 16 <= width; x += 16) {
+		const __m256i luma = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + x)));
+
+		storePixelsAVX2(out + x,
+			clampComponentAVX2<kITU>(_mm256_add_epi16(luma, loadChromaAVX2<kHalfChroma>(crR, x))),
+			clampComponentAVX2<kITU>(_mm256_add_epi16(luma, loadChromaAVX2<kHalfChroma>(crbG, x))),
+			clampComponentAVX2<kITU>(_mm256_add_epi16(luma, loadChromaAVX2<kHalfChroma>(cbB, x))), format);
+	}
+
+	return x;
+}
+
+/** Apply the sign mask s, which is all ones for negative values, to q. */
+SCUMMVM_TARGET_SSE2 inline __m128i withSignSSE2(__m128i q, __m128i s) {
+	return _mm_sub_epi16(_mm_xor_si128(q, s), s);
+}
+
+template<int kMul, int kShift>
+SCUMMVM_TARGET_SSE2 inline __m128i scaleChromaSSE2(__m128i absC) {
+	return _mm_srli_epi16(_mm_mulhi_epu16(absC, _mm_set1_epi16(kMul)), kShift);
+}
+
+SCUMMVM_TARGET_SSE2 int convertChromaSSE2(const byte *uSrc, const byte *vSrc, int16 *crR, int16 *crbG, int16 *cbB, int count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	int x = 0;
+
+	for (; x + 8 <= count; x += 8) {
+		const __m128i u = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x)), zero), bias);
+		const __m128i v = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x)), zero), bias);
+		const __m128i uSign = _mm_srai_epi16(u, 15);
+		const __m128i vSign = _mm_srai_epi16(v, 15);
+		const __m128i uAbs = _mm_slli_epi16(_mm_max_epi16(u, _mm_sub_epi16(zero, u)), 7);
+		const __m128i vAbs = _mm_slli_epi16(_mm_max_epi16(v, _mm_sub_epi16(zero, v)), 7);
+
+		const __m128i g = _mm_add_epi16(
+			withSignSSE2(scaleChromaSSE2<kCrGMul, kCrGShift>(vAbs), vSign),
+			withSignSSE2(scaleChromaSSE2<kCbGMul, kCbGShift>(uAbs), uSign));
+
+		_mm_storeu_si128((__m128i *)(crR + x), withSignSSE2(scaleChromaSSE2<kCrRMul, kCrRShift>(vAbs), vSign));
+		_mm_storeu_si128((__m128i *)(crbG + x), _mm_sub_epi16(zero, g));
+		_mm_storeu_si128((__m128i *)(cbB + x), withSignSSE2(scaleChromaSSE2<kCbBMul, kCbBShift>(uAbs), uSign));
+	}
+
+	return x;
+}
+
+SCUMMVM_TARGET_AVX2 inline __m256i withSignAVX2(__m256i q, __m256i s) {
+	return _mm256_sub_epi16(_mm256_xor_si256(q, s), s);
+}
+
+template<int kMul, int kShift>
+SCUMMVM_TARGET_AVX2 inline __m256i scaleChromaAVX2(__m256i absC) {
+	return _mm256_srli_epi16(_mm256_mulhi_epu16(absC, _mm256_set1_epi16(kMul)), kShift);
+}
+
+SCUMMVM_TARGET_AVX2 int convertChromaAVX2(const byte *uSrc, const byte *vSrc, int16 *crR, int16 *crbG, int16 *cbB, int count) {
+	const __m256i bias = _mm256_set1_epi16(128);
+	int x = 0;
+
+	for (; x + 16 <= count; x += 16) {
+		const __m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + x))), bias);
+		const __m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + x))), bias);
+		const __m256i uSign = _mm256_srai_epi16(u, 15);
+		const __m256i vSign = _mm256_srai_epi16(v, 15);
+		const __m256i uAbs = _mm256_slli_epi16(_mm256_abs_epi16(u), 7);
+		const __m256i vAbs = _mm256_slli_epi16(_mm256_abs_epi16(v), 7);
+
+		const __m256i g = _mm256_add_epi16(
+			withSignAVX2(scaleChromaAVX2<kCrGMul, kCrGShift>(vAbs), vSign),
+			withSignAVX2(scaleChromaAVX2<kCbGMul, kCbGShift>(uAbs), uSign));
+
+		_mm256_storeu_si256((__m256i *)(crR + x), withSignAVX2(scaleChromaAVX2<kCrRMul, kCrRShift>(vAbs), vSign));
+		_mm256_storeu_si256((__m256i *)(crbG + x), _mm256_sub_epi16(_mm256_setzero_si256(), g));
+		_mm256_storeu_si256((__m256i *)(cbB + x), withSignAVX2(scaleChromaAVX2<kCbBMul, kCbBShift>(uAbs), uSign));
+	}
+
+	return x;
+}
+
+#endif // SCUMMVM_SIMD_X86
+
+#ifdef SCUMMVM_SIMD_NEON
+
+/** NEON variant of clampComponentSSE2. */
+template<bool kITU>
+inline uint16x8_t clampComponentNEON(int16x8_t c) {
+	if (!kITU)
+		return vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(c, vdupq_n_s16(0)), vdupq_n_s16(255)));
+
+	c = vsubq_s16(vminq_s16(vmaxq_s16(c, vdupq_n_s16(16)), vdupq_n_s16(235)), vdupq_n_s16(16));
+	const uint16x8_t n = vreinterpretq_u16_s16(vsubq_s16(vshlq_n_s16(c, 8), c));
+	const uint16x4_t lo = vshrn_n_u32(vmull_u16(vget_low_u16(n), vdup_n_u16(19153)), 16);
+	const uint16x4_t hi = vshrn_n_u32(vmull_u16(vget_high_u16(n), vdup_n_u16(19153)), 16);
+	return vshrq_n_u16(vcombine_u16(lo, hi), 6);
+}
+
+template<bool kHalfChroma>
+inline int16x8_t loadChromaNEON(const int16 *chroma, int x) {
+	if (!kHalfChroma)
+		return vld1q_s16(chroma + x);
+
+	const int16x4_t c = vld1_s16(chroma + x / 2);
+	const int16x4x2_t pairs = vzip_s16(c, c);
+	return vcombine_s16(pairs.val[0], pairs.val[1]);
+}
+
+/** Shift right by the loss, then left into place; vshlq shifts right for negative counts. */
+inline void storePixelsNEON(uint16 *dst, uint16x8_t r, uint16x8_t g, uint16x8_t b, const RowFormat &format) {
+	r = vshlq_u16(vshlq_u16(r, vdupq_n_s16(-format.rLoss)), vdupq_n_s16(format.rShift));
+	g = vshlq_u16(vshlq_u16(g, vdupq_n_s16(-format.gLoss)), vdupq_n_s16(format.gShift));
+	b = vshlq_u16(vshlq_u16(b, vdupq_n_s16(-format.bLoss)), vdupq_n_s16(format.bShift));
+
+	vst1q_u16(dst, vorrq_u16(vorrq_u16(r, g), vorrq_u16(b, vdupq_n_u16((uint16)format.alpha))));
+}
+
+inline void storePixelsNEON(uint32 *dst, uint16x8_t r, uint16x8_t g, uint16x8_t b, const RowFormat &format) {
+	const int32x4_t rShift = vdupq_n_s32(format.rShift);
+	const int32x4_t gShift = vdupq_n_s32(format.gShift);
+	const int32x4_t bShift = vdupq_n_s32(format.bShift);
+	const uint32x4_t alpha = vdupq_n_u32(format.alpha);
+
+	uint32x4_t pixels = vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(r)), rShift), vshlq_u32(vmovl_u16(vget_low_u16(g)), gShift));
+	vst1q_u32(dst, vorrq_u32(pixels, vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(b)), bShift), alpha)));
+
+	pixels = vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(r)), rShift), vshlq_u32(vmovl_u16(vget_high_u16(g)), gShift));
+	vst1q_u32(dst + 4, vorrq_u32(pixels, vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(b)), bShift), alpha)));
+}
+
+template<typename PixelInt, bool kITU, bool kHalfChroma>
+int convertRowNEON(byte *dst, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int width, const RowFormat &format) {
+	PixelInt *out = (PixelInt *)dst;
+	int x = 0;
+
+	for (; x + 8 <= width; x += 8) {
+		const int16x8_t luma = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc + x)));
+
+		storePixelsNEON(out + x,
+			clampComponentNEON<kITU>(vaddq_s16(luma, loadChromaNEON<kHalfChroma>(crR, x))),
+			clampComponentNEON<kITU>(vaddq_s16(luma, loadChromaNEON<kHalfChroma>(crbG, x))),
+			clampComponentNEON<kITU>(vaddq_s16(luma, loadChromaNEON<kHalfChroma>(cbB, x))), format);
+	}
+
+	return x;
+}
+
+inline int16x8_t withSignNEON(uint16x8_t q, int16x8_t s) {
+	return vsubq_s16(veorq_s16(vreinterpretq_s16_u16(q), s), s);
+}
+
+/** vshlq shifts right for negative counts, which also works for a shift of 0. */
+inline uint16x8_t scaleChromaNEON(uint16x8_t absC, uint16 mul, int shift) {
+	const uint16x4_t lo = vshrn_n_u32(vmull_u16(vget_low_u16(absC), vdup_n_u16(mul)), 16);
+	const uint16x4_t hi = vshrn_n_u32(vmull_u16(vget_high_u16(absC), vdup_n_u16(mul)), 16);
+	return vshlq_u16(vcombine_u16(lo, hi), vdupq_n_s16(-shift));
+}
+
+int convertChromaNEON(const byte *uSrc, const byte *vSrc, int16 *crR, int16 *crbG, int16 *cbB, int count) {
+	const int16x8_t bias = vdupq_n_s16(128);
+	int x = 0;
+
+	for (; x + 8 <= count; x += 8) {
+		const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(uSrc + x))), bias);
+		const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(vSrc + x))), bias);
+		const int16x8_t uSign = vshrq_n_s16(u, 15);
+		const int16x8_t vSign = vshrq_n_s16(v, 15);
+		const uint16x8_t uAbs = vshlq_n_u16(vreinterpretq_u16_s16(vabsq_s16(u)), 7);
+		const uint16x8_t vAbs = vshlq_n_u16(vreinterpretq_u16_s16(vabsq_s16(v)), 7);
+
+		const int16x8_t g = vaddq_s16(
+			withSignNEON(scaleChromaNEON(vAbs, kCrGMul, kCrGShift), vSign),
+			withSignNEON(scaleChromaNEON(uAbs, kCbGMul, kCbGShift), uSign));
+
+		vst1q_s16(crR + x, withSignNEON(scaleChromaNEON(vAbs, kCrRMul, kCrRShift), vSign));
+		vst1q_s16(crbG + x, vnegq_s16(g));
+		vst1q_s16(cbB + x, withSignNEON(scaleChromaNEON(uAbs, kCbBMul, kCbBShift), uSign));
+	}
+
+	return x;
+}
+
+#endif // SCUMMVM_SIMD_NEON
+
+template<typename PixelInt, bool kITU, bool kHalfChroma>
+ConvertRowProc getRowKernel() {
+#ifdef SCUMMVM_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		return &convertRowAVX2<PixelInt, kITU, kHalfChroma>;
+	if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		return &convertRowSSE2<PixelInt, kITU, kHalfChroma>;
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		return &convertRowNEON<PixelInt, kITU, kHalfChroma>;
+#endif
+	return 0;
+}
+
+template<typename PixelInt>
+ConvertRowProc getRowKernel(bool itu, bool halfChroma) {
+	if (itu)
+		return halfChroma ? getRowKernel<PixelInt, true, true>() : getRowKernel<PixelInt, true, false>();
+	else
+		return halfChroma ? getRowKernel<PixelInt, false, true>() : getRowKernel<PixelInt, false, false>();
+}
+
+ConvertChromaProc getChromaKernel() {
+#ifdef SCUMMVM_SIMD_X86
+	if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+		return &convertChromaAVX2;
+	if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		return &convertChromaSSE2;
+#endif
+#ifdef SCUMMVM_SIMD_NEON
+	if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+		return &convertChromaNEON;
+#endif
+	return 0;
+}
+
+/** Convert the pixels of a row the kernel left over, through the lookup table. */
+template<typename PixelInt>
+void convertRowRest(byte *dst, const uint32 *rgbToPix, const byte *ySrc, const int16 *crR, const int16 *crbG, const int16 *cbB, int x, int width, bool halfChroma) {
+	PixelInt *out = (PixelInt *)dst;
+
+	for (; x < width; x++) {
+		const int c = halfChroma ? (x >> 1) : x;
+		const uint32 *L = &rgbToPix[ySrc[x] + 256];
+		out[x] = L[crR[c]] | L[crbG[c] + 768] | L[cbB[c] + 2 * 768];
+	}
+}
+
+/** Fill the chroma rows with the color table entries for count U and V values. */
+void convertChroma(const ConversionBand &band, const byte *uSrc, const byte *vSrc, int16 *crR, int16 *crbG, int16 *cbB, int count) {
+	const int16 *colorTab = band.colorTab;
+	int x = band.convertChroma ? band.convertChroma(uSrc, vSrc, crR, crbG, cbB, count) : 0;
+
+	for (; x < count; x++) {
+		crR[x] = colorTab[vSrc[x]] - (0 * 768 + 256);
+		crbG[x] = colorTab[256 + vSrc[x]] + colorTab[2 * 256 + uSrc[x]] - (1 * 768 + 256);
+		cbB[x] = colorTab[3 * 256 + uSrc[x]] - (2 * 768 + 256);
+	}
+}
+
+void convertBand(void *param) {
+	const ConversionBand &band = *(const ConversionBand *)param;
+	const bool halfChroma = (band.subsampling == YUVToRGBManager::kSubsampling420);
+
+	int16 *crR = band.chroma;
+	int16 *crbG = crR + band.yWidth;
+	int16 *cbB = crbG + band.yWidth;
+	byte *uRow = (byte *)(cbB + band.yWidth);
+	byte *vRow = uRow + band.yWidth;
+
+	for (int y = band.firstRow; y < band.endRow; y++) {
+		if (band.subsampling == YUVToRGBManager::kSubsampling444) {
+			convertChroma(band, band.uSrc + y * band.uvPitch, band.vSrc + y * band.uvPitch, crR, crbG, cbB, band.yWidth);
+		} else if (band.subsampling == YUVToRGBManager::kSubsampling420) {
+			// Both rows of a pair share their chroma values
+			if (y == band.firstRow || !(y & 1))
+				convertChroma(band, band.uSrc + (y >> 1) * band.uvPitch, band.vSrc + (y >> 1) * band.uvPitch, crR, crbG, cbB, band.yWidth / 2);
+		} else {
+			// The same bilinear interpolation as convertYUV410ToRGB()
+			const int yDiff = y & 3;
+			const byte *uSrc = band.uSrc + (y >> 2) * band.uvPitch;
+			const byte *vSrc = band.vSrc + (y >> 2) * band.uvPitch;
+			for (int x = 0; x < band.yWidth; x++) {
+				const int index = x >> 2;
+				const int xDiff = x & 3;
+				const int wA = (4 - xDiff) * (4 - yDiff), wB = xDiff * (4 - yDiff);
+				const int wC = yDiff * (4 - xDiff), wD = xDiff * yDiff;
+				uRow[x] = (uSrc[index] * wA + uSrc[index + 1] * wB + uSrc[index + band.uvPitch] * wC + uSrc[index + band.uvPitch + 1] * wD) >> 4;
+				vRow[x] = (vSrc[index] * wA + vSrc[index + 1] * wB + vSrc[index + band.uvPitch] * wC + vSrc[index + band.uvPitch + 1] * wD) >> 4;
+			}
+			convertChroma(band, uRow, vRow, crR, crbG, cbB, band.yWidth);
+		}
+
+		byte *dst = band.dst + y * band.dstPitch;
+		const byte *ySrc = band.ySrc + y * band.yPitch;
+		const int done = band.convertRow(dst, ySrc, crR, crbG, cbB, band.yWidth, band.format);
+
+		if (band.format.bytesPerPixel == 2)
+			convertRowRest<uint16>(dst, band.rgbToPix, ySrc, crR, crbG, cbB, done, band.yWidth, halfChroma);
+		else
+			convertRowRest<uint32>(dst, band.rgbToPix, ySrc, crR, crbG, cbB, done, band.yWidth, halfChroma);
+	}
+}
+
+} // End of anonymous namespace
+
 YUVToRGBManager::YUVToRGBManager() {
 	_lookup = 0;
+	_mutex = g_system ? g_system->createMutex() : 0;
+	_workers = 0;
+	setThreadedConversion(g_system && g_system->getCPUCount() > 1);
 
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
@@ -177,10 +708,36 @@ YUVToRGBManager::YUVToRGBManager() {
 		Cb_g_tab[i] = (int16) (-(0.114 / 0.331) * CB);
 		Cb_b_tab[i] = (int16) ( (0.587 / 0.331) * CB) + 2 * 768 + 256;
 	}
+
+	// The chroma kernels compute the tables in fixed point, make sure that
+	// this gives the same result as the floating point math of this compiler
+	_fixedPointChroma = true;
+	for (int i = 0; i < 256; i++) {
+		if (Cr_r_tab[i] - (0 * 768 + 256) != scaleChroma(i - 128, kCrRMul, kCrRShift) ||
+		    Cr_g_tab[i] - (1 * 768 + 256) != -scaleChroma(i - 128, kCrGMul, kCrGShift) ||
+		    Cb_g_tab[i] != -scaleChroma(i - 128, kCbGMul, kCbGShift) ||
+		    Cb_b_tab[i] - (2 * 768 + 256) != scaleChroma(i - 128, kCbBMul, kCbBShift))
+			_fixedPointChroma = false;
+	}
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
+	delete _workers;
 	delete _lookup;
+
+	if (_mutex)
+		g_system->deleteMutex(_mutex);
+}
+
+void YUVToRGBManager::setThreadedConversion(bool enable) {
+	Common::StackLock lock(_mutex);
+
+	if (enable && !_workers) {
+		_workers = new Common::WorkerPool();
+	} else if (!enable) {
+		delete _workers;
+		_workers = 0;
+	}
 }
 
 const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
@@ -192,6 +749,69 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+bool YUVToRGBManager::convertSIMD(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, Subsampling subsampling, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	RowFormat format;
+	if (!getRowFormat(dst->format, scale, format))
+		return false;
+
+	const bool halfChroma = (subsampling == kSubsampling420);
+	ConvertRowProc convertRow;
+	if (format.bytesPerPixel == 2)
+		convertRow = getRowKernel<uint16>(format.itu, halfChroma);
+	else
+		convertRow = getRowKernel<uint32>(format.itu, halfChroma);
+
+	if (!convertRow)
+		return false;
+
+	const ConvertChromaProc convertChroma = _fixedPointChroma ? getChromaKernel() : 0;
+
+	const uint32 *rgbToPix = getLookup(dst->format, scale)->getRGBToPix();
+
+	// Split big frames into bands of rows, one for each worker thread and
+	// one for this thread. Bands start on a new row of chroma values.
+	int bandCount = 1;
+	if (_workers && yWidth * yHeight >= kMinThreadedPixels)
+		bandCount = MIN<int>(_workers->getThreadCount() + 1, kMaxBands);
+
+	const int rowAlign = (subsampling == kSubsampling410) ? 4 : (subsampling == kSubsampling420) ? 2 : 1;
+	const int bandRows = (yHeight / bandCount) & ~(rowAlign - 1);
+
+	_chromaRows.resize(bandCount * 4 * yWidth);
+
+	ConversionBand bands[kMaxBands];
+	for (int i = 0; i < bandCount; i++) {
+		ConversionBand &band = bands[i];
+		band.convertRow = convertRow;
+		band.convertChroma = convertChroma;
+		band.format = format;
+		band.rgbToPix = rgbToPix;
+		band.colorTab = _colorTab;
+		band.subsampling = subsampling;
+		band.dst = (byte *)dst->pixels;
+		band.dstPitch = dst->pitch;
+		band.ySrc = ySrc;
+		band.uSrc = uSrc;
+		band.vSrc = vSrc;
+		band.yWidth = yWidth;
+		band.yPitch = yPitch;
+		band.uvPitch = uvPitch;
+		band.firstRow = i * bandRows;
+		band.endRow = (i == bandCount - 1) ? yHeight : (i + 1) * bandRows;
+		band.chroma = &_chromaRows[i * 4 * yWidth];
+	}
+
+	for (int i = 1; i < bandCount; i++)
+		_workers->addJob(&convertBand, &bands[i]);
+
+	convertBand(&bands[0]);
+
+	if (bandCount > 1)
+		_workers->wait();
+
+	return true;
+}
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -233,6 +853,11 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 
+	Common::StackLock lock(_mutex);
+
+	if (convertSIMD(dst, scale, kSubsampling444, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch))
+		return;
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
@@ -274,7 +899,7 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			dstPtr += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
+		dstPtr += (dstPitch << 1) - yWidth * sizeof(PixelInt);
 		ySrc += (yPitch << 1) - yWidth;
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
@@ -289,6 +914,11 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
+	Common::StackLock lock(_mutex);
+
+	if (convertSIMD(dst, scale, kSubsampling420, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch))
+		return;
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
@@ -374,6 +1004,11 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
 
+	Common::StackLock lock(_mutex);
+
+	if (convertSIMD(dst, scale, kSubsampling410, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch))
+		return;
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
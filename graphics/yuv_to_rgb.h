@@ -32,13 +32,29 @@
 #define GRAPHICS_YUV_TO_RGB_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/singleton.h"
+#include "common/system.h"
 #include "graphics/surface.h"
 
+namespace Common {
+class WorkerPool;
+}
+
 namespace Graphics {
 
 class YUVToRGBLookup;
 
+/**
+ * Converts YUV images to RGB surfaces.
+ *
+ * The manager keeps the lookup table of the last destination format and
+ * scratch space for the conversion, so conversions are serialized by a
+ * mutex; they may be started from worker threads as well. The threads used
+ * for splitting big frames are started when the manager is created, which
+ * therefore has to happen on the main thread, as does every call of
+ * setThreadedConversion(). See OSystem::createThread().
+ */
 class YUVToRGBManager : public Common::Singleton<YUVToRGBManager> {
 public:
 	/** The scale of the luminance values */
@@ -47,6 +63,13 @@ public:
 		kScaleITU   /** Luminance values range from [16, 235], the range from ITU-R BT.601 */
 	};
 
+	/** The resolution of the chroma planes, relative to the luminance plane */
+	enum Subsampling {
+		kSubsampling444, /** Full resolution */
+		kSubsampling420, /** Half the width and height */
+		kSubsampling410  /** A quarter of the width and height */
+	};
+
 	/**
 	 * Convert a YUV444 image to an RGB surface
 	 *
@@ -98,6 +121,17 @@ public:
 	 */
 	void convert410(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Enable or disable splitting the conversion of frames of 1280x720
+	 * pixels and up between several threads. This is only done when the
+	 * destination format has a SIMD conversion, and it is enabled by
+	 * default on systems with more than one CPU core.
+	 *
+	 * This starts or stops the worker threads, so it may only be called
+	 * from the main thread.
+	 */
+	void setThreadedConversion(bool enable);
+
 private:
 	friend class Common::Singleton<SingletonBaseType>;
 	YUVToRGBManager();
@@ -105,8 +139,19 @@ private:
 
 	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
 
+	/**
+	 * Convert the image with the SIMD row kernels, if there is one for the
+	 * destination format on this CPU. Returns false if there is none.
+	 */
+	bool convertSIMD(Graphics::Surface *dst, LuminanceScale scale, Subsampling subsampling, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+
 	YUVToRGBLookup *_lookup;
 	int16 _colorTab[4 * 256]; // 2048 bytes
+	bool _fixedPointChroma;   ///< whether the SIMD code computes the same color table values
+
+	OSystem::MutexRef _mutex;         ///< held during conversions, 0 without an OSystem
+	Common::WorkerPool *_workers;     ///< threads for converting big frames, if enabled
+	Common::Array<int16> _chromaRows; ///< chroma values of the rows being converted, per band
 };
 
 } // End of namespace Graphics
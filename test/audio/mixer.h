@@ -0,0 +1,179 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_intern.h"
+#include "audio/decoders/raw.h"
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+/**
+ * The mixer needs an OSystem for its mutexes and for the time stamps of
+ * its channels. This one provides just that, with a single thread.
+ */
+class MixerTestSystem : public OSystem {
+public:
+	MixerTestSystem() : _millis(0) {}
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return false; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	virtual uint32 getMillis() { return _millis++; }
+	virtual void delayMillis(uint msecs) { _millis += msecs; }
+	virtual void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	// Only one thread runs, so the mutexes never have to do anything
+	virtual MutexRef createMutex() { return (MutexRef)this; }
+	virtual void lockMutex(MutexRef mutex) {}
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+	virtual Audio::Mixer *getMixer() { return 0; }
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	uint32 _millis;
+};
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		g_system = &_system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+	}
+
+	void test_queued_commands() {
+		Audio::MixerImpl mixer(g_system, kRate);
+		mixer.setReady(true);
+		Audio::SoundHandle handle = playTone(mixer);
+		TS_ASSERT(mix(mixer));
+
+		// The changes are only seen by the channel in the next period,
+		// the getters report them right away
+		mixer.setChannelVolume(handle, 0);
+		mixer.setChannelBalance(handle, -127);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 0);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), -127);
+
+		Audio::MixerImpl::CommandQueueStats stats = mixer.getCommandQueueStats();
+		TS_ASSERT_EQUALS(stats.queued, 2U);
+		TS_ASSERT_EQUALS(stats.direct, 0U);
+		TS_ASSERT_EQUALS(stats.applied, 0U);
+
+		TS_ASSERT(!mix(mixer));
+		stats = mixer.getCommandQueueStats();
+		TS_ASSERT_EQUALS(stats.applied, 2U);
+		TS_ASSERT_EQUALS(stats.lastDepth, 2U);
+		TS_ASSERT_EQUALS(stats.maxDepth, 2U);
+
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		mixer.pauseHandle(handle, true);
+		TS_ASSERT(!mix(mixer));
+		mixer.pauseHandle(handle, false);
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT_EQUALS(mixer.getCommandQueueStats().applied, 5U);
+	}
+
+	void test_stale_handle() {
+		Audio::MixerImpl mixer(g_system, kRate);
+		mixer.setReady(true);
+		Audio::SoundHandle handle = playTone(mixer);
+		mixer.stopHandle(handle);
+
+		// Commands for a sound which is gone are dropped
+		mixer.setChannelVolume(handle, 10);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 0);
+		Audio::SoundHandle newHandle = playTone(mixer);
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT_EQUALS(mixer.getCommandQueueStats().applied, 1U);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(newHandle), Audio::Mixer::kMaxChannelVolume);
+	}
+
+	void test_queue_full() {
+		Audio::MixerImpl mixer(g_system, kRate);
+		mixer.setReady(true);
+		Audio::SoundHandle handle = playTone(mixer);
+
+		// Fill the queue, the first command which does not fit any more
+		// is applied right away, along with all queued ones
+		while (mixer.getCommandQueueStats().direct == 0)
+			mixer.setChannelVolume(handle, 0);
+		const uint32 capacity = mixer.getCommandQueueStats().queued;
+		TS_ASSERT_LESS_THAN(0U, capacity);
+		TS_ASSERT_EQUALS(mixer.getCommandQueueStats().applied, capacity);
+		TS_ASSERT(!mix(mixer));
+		TS_ASSERT_EQUALS(mixer.getCommandQueueStats().lastDepth, 0U);
+
+		// The direct command must not overtake the queued ones
+		for (uint32 i = 0; i < capacity; ++i)
+			mixer.setChannelVolume(handle, 0);
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		Audio::MixerImpl::CommandQueueStats stats = mixer.getCommandQueueStats();
+		TS_ASSERT_EQUALS(stats.queued, 2 * capacity);
+		TS_ASSERT_EQUALS(stats.direct, 2U);
+		TS_ASSERT_EQUALS(stats.applied, 2 * capacity);
+		TS_ASSERT(mix(mixer));
+	}
+
+private:
+	enum {
+		kRate = 22050,
+		kToneLength = 4096
+	};
+
+	MixerTestSystem _system;
+	OSystem *_oldSystem;
+
+	/** Plays a constant, long enough for the tests, at full volume. */
+	Audio::SoundHandle playTone(Audio::MixerImpl &mixer) {
+		int16 *tone = (int16 *)malloc(kToneLength * sizeof(int16));
+		for (int i = 0; i < kToneLength; ++i)
+			tone[i] = 0x2000;
+
+		// Call through Mixer, for its default arguments
+		Audio::Mixer &base = mixer;
+		Audio::SoundHandle handle;
+		base.playStream(Audio::Mixer::kPlainSoundType, &handle,
+			Audio::makeRawStream((const byte *)tone, kToneLength * sizeof(int16), kRate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN));
+		return handle;
+	}
+
+	/** Mixes one period and returns whether it is audible. */
+	bool mix(Audio::MixerImpl &mixer) {
+		int16 samples[2 * 64];
+		mixer.mixCallback((byte *)samples, sizeof(samples));
+
+		for (int i = 0; i < ARRAYSIZE(samples); ++i) {
+			if (samples[i])
+				return true;
+		}
+		return false;
+	}
+};
@@ -0,0 +1,157 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "audio/decoders/raw.h"
+#include "common/cpudetect.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+
+#include "../common/helper.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	/**
+	 * Create a stream of full range pseudo random noise, so that both signs
+	 * and all rounding cases of the volume scaling are covered.
+	 */
+	Audio::SeekableAudioStream *createNoiseStream(const int sampleRate, const bool isStereo) {
+		const int samples = sampleRate * (isStereo ? 2 : 1);
+		int16 *noise = (int16 *)malloc(samples * sizeof(int16));
+
+		TestRandom rnd(0x1234567);
+		for (int i = 0; i < samples; ++i) {
+			const uint32 value = rnd.next();
+			noise[i] = (int16)(value >> 16);
+		}
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)noise, samples * sizeof(int16), DisposeAfterUse::YES);
+		return Audio::makeRawStream(stream, sampleRate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	/**
+	 * Run a converter over a noise stream into a prefilled output buffer,
+	 * once with all vector kernels disabled, once without AVX2 and once with
+	 * whatever the host supports, and check that all produce the same output.
+	 */
+	void compareWithScalar(const int inRate, const int outRate, const bool isStereo, const bool reverseStereo, const Audio::st_volume_t volL, const Audio::st_volume_t volR, const Audio::RateConverterQuality quality = Audio::kRateConverterLinear) {
+		const int outFrames = 4000;
+		const uint32 disabledFeatures[3] = { 0xFFFFFFFF, Common::kCPUFeatureAVX2, 0 };
+		int16 *result[3];
+
+		for (int pass = 0; pass < 3; ++pass) {
+			Common::disableCPUFeatures(disabledFeatures[pass]);
+
+			Audio::SeekableAudioStream *s = createNoiseStream(inRate, isStereo);
+			Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo, reverseStereo, quality);
+
+			// Prefill with values close to the limits, so that clamping
+			// is exercised, too.
+			result[pass] = new int16[outFrames * 2];
+			for (int i = 0; i < outFrames * 2; ++i)
+				result[pass][i] = (int16)((i * 7919) & 0xFFFF);
+
+			// Use odd chunk sizes to cover the vector loop tails.
+			int done = 0;
+			int chunk = 1;
+			while (done < outFrames) {
+				const int len = MIN(chunk, outFrames - done);
+				TS_ASSERT_EQUALS(converter->flow(*s, result[pass] + done * 2, len, volL, volR), len);
+				done += len;
+				chunk = chunk * 3 + 1;
+			}
+
+			delete converter;
+			delete s;
+		}
+
+		Common::disableCPUFeatures(0);
+
+		TS_ASSERT_EQUALS(memcmp(result[0], result[1], outFrames * 2 * sizeof(int16)), 0);
+		TS_ASSERT_EQUALS(memcmp(result[0], result[2], outFrames * 2 * sizeof(int16)), 0);
+
+		for (int pass = 0; pass < 3; ++pass)
+			delete[] result[pass];
+	}
+
+public:
+	void test_copy_mono() {
+		compareWithScalar(22050, 22050, false, false, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		compareWithScalar(22050, 22050, false, false, 77, 200);
+	}
+
+	void test_copy_stereo() {
+		compareWithScalar(44100, 44100, true, false, Audio::Mixer::kMaxMixerVolume, 13);
+		compareWithScalar(44100, 44100, true, true, 255, 31);
+	}
+
+	void test_simple_mono() {
+		compareWithScalar(44100, 11025, false, false, 128, 255);
+	}
+
+	void test_simple_stereo() {
+		compareWithScalar(44100, 22050, true, false, 3, Audio::Mixer::kMaxMixerVolume);
+		compareWithScalar(44100, 22050, true, true, 3, Audio::Mixer::kMaxMixerVolume);
+	}
+
+	void test_linear_mono() {
+		compareWithScalar(11025, 44100, false, false, 200, 100);
+	}
+
+	void test_linear_stereo() {
+		compareWithScalar(22050, 48000, true, false, 256, 256);
+		compareWithScalar(32000, 22050, true, true, 17, 250);
+	}
+
+	void test_linear_high_rate() {
+		// The fixed point increment used to overflow for rates >= 2^16
+		int16 out[2 * 100];
+		memset(out, 0, sizeof(out));
+
+		Audio::SeekableAudioStream *s = createNoiseStream(96000, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(96000, 44100, true);
+		TS_ASSERT_EQUALS(converter->flow(*s, out, 100, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 100);
+
+		// One second of input has to result in one second of output
+		int16 *rest = new int16[2 * 44100];
+		memset(rest, 0, 2 * 44100 * sizeof(int16));
+		const int restFrames = converter->flow(*s, rest, 44100, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_DELTA(restFrames, 44100 - 100, 2);
+		delete[] rest;
+
+		delete converter;
+		delete s;
+	}
+
+	void test_sinc_vector() {
+		compareWithScalar(22050, 44100, false, false, 256, 256, Audio::kRateConverterSinc);
+		compareWithScalar(11025, 48000, true, false, 100, 200, Audio::kRateConverterSinc);
+		compareWithScalar(48000, 22050, true, true, 256, 50, Audio::kRateConverterSinc);
+	}
+
+	void test_sinc_dc() {
+		// A constant input has to come out unchanged, apart from the
+		// filter warming up from silence at the start.
+		const int frames = 2000;
+		int16 *in = (int16 *)malloc(frames * sizeof(int16));
+		for (int i = 0; i < frames; ++i)
+			WRITE_LE_UINT16(&in[i], 12345);
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)in, frames * sizeof(int16), DisposeAfterUse::YES);
+		Audio::SeekableAudioStream *s = Audio::makeRawStream(stream, 22050, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, false, false, Audio::kRateConverterSinc);
+
+		int16 out[2 * 1000];
+		memset(out, 0, sizeof(out));
+		TS_ASSERT_EQUALS(converter->flow(*s, out, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+
+		for (int i = 100; i < 1000; ++i) {
+			TS_ASSERT_EQUALS(out[i * 2 + 0], 12345);
+			TS_ASSERT_EQUALS(out[i * 2 + 1], 12345);
+		}
+
+		delete converter;
+		delete s;
+	}
+};
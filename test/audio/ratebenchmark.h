@@ -0,0 +1,80 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "audio/decoders/raw.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "../common/helper.h"
+
+/**
+ * Measures the cost of all rate converters, in CPU cycles per output frame.
+ * The results are printed as traces and not checked against any limit.
+ * Only run if the benchmarks are enabled, see test/common/helper.h.
+ */
+class RateConverterBenchmarkSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kOutputFrames = 48000
+	};
+
+	void benchmark(const char *name, const int inRate, const int outRate, const bool isStereo, const Audio::RateConverterQuality quality) {
+#ifdef TEST_BENCHMARKS
+		// Two seconds of input are enough for kOutputFrames at any ratio used
+		const int samples = inRate * 2 * (isStereo ? 2 : 1);
+		int16 *input = (int16 *)malloc(samples * sizeof(int16));
+		TestRandom rnd;
+		for (int i = 0; i < samples; ++i) {
+			const uint32 value = rnd.next();
+			input[i] = (int16)(value >> 16) / 4;
+		}
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)input, samples * sizeof(int16), DisposeAfterUse::YES);
+		Audio::SeekableAudioStream *s = Audio::makeRawStream(stream, inRate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo, false, quality);
+
+		int16 *output = new int16[kOutputFrames * 2];
+		memset(output, 0, kOutputFrames * 2 * sizeof(int16));
+
+		// Mix in periods of a typical backend buffer size
+		const int period = 1024;
+		const uint64 start = readCycleCounter();
+		for (int done = 0; done < kOutputFrames; done += period)
+			converter->flow(*s, output + done * 2, MIN<int>(period, kOutputFrames - done), 200, 180);
+		const uint64 end = readCycleCounter();
+
+		const double perFrame = (double)(end - start) / kOutputFrames;
+		TS_TRACE(Common::String::format("%-8s %s %5d -> %5d Hz: %8.1f cycles per output frame",
+			name, isStereo ? "stereo" : "mono  ", inRate, outRate, perFrame).c_str());
+
+		delete[] output;
+		delete converter;
+		delete s;
+#endif
+	}
+
+public:
+	void test_benchmark_copy() {
+		benchmark("copy", 44100, 44100, true, Audio::kRateConverterLinear);
+		benchmark("copy", 22050, 22050, false, Audio::kRateConverterLinear);
+	}
+
+	void test_benchmark_simple() {
+		benchmark("simple", 44100, 22050, true, Audio::kRateConverterLinear);
+	}
+
+	void test_benchmark_linear() {
+		benchmark("linear", 22050, 44100, true, Audio::kRateConverterLinear);
+		benchmark("linear", 44100, 48000, true, Audio::kRateConverterLinear);
+		benchmark("linear", 11025, 44100, false, Audio::kRateConverterLinear);
+	}
+
+	void test_benchmark_sinc() {
+		benchmark("sinc", 22050, 44100, true, Audio::kRateConverterSinc);
+		benchmark("sinc", 44100, 48000, true, Audio::kRateConverterSinc);
+		benchmark("sinc", 48000, 22050, true, Audio::kRateConverterSinc);
+		benchmark("sinc", 11025, 44100, false, Audio::kRateConverterSinc);
+	}
+};
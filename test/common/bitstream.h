@@ -2,6 +2,9 @@
 
 #include "common/bitstream.h"
 #include "common/memstream.h"
+#include "common/substream.h"
+
+#include "helper.h"
 
 class BitStreamTestSuite : public CxxTest::TestSuite
 {
@@ -149,4 +152,273 @@ class BitStreamTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
 		TS_ASSERT(!bs.eos());
 	}
+
+	void test_get_bits_32() {
+		byte contents[] = { 0x78, 0x56, 0x34, 0x12, 0xF0, 0xDE, 0xBC, 0x9A };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStream32LELSB bs(ms);
+		TS_ASSERT_EQUALS(bs.getBits(4), 0x8u);
+		TS_ASSERT_EQUALS(bs.getBits(32), 0x01234567u);
+		TS_ASSERT_EQUALS(bs.peekBits(28), 0x9ABCDEFu);
+		TS_ASSERT_EQUALS(bs.pos(), 36u);
+		bs.skip(24);
+		TS_ASSERT_EQUALS(bs.getBits(4), 0x9u);
+		TS_ASSERT(bs.eos());
+
+		Common::BitStream32BEMSB bs2(ms);
+		bs2.rewind();
+		TS_ASSERT_EQUALS(bs2.getBits(32), 0x78563412u);
+		TS_ASSERT_EQUALS(bs2.getBits(12), 0xF0Du);
+		TS_ASSERT_EQUALS(bs2.size(), 64u);
+	}
+
+	void test_skip_full_buffer() {
+		byte contents[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		// Peeking fills the whole 64 bit buffer, which is then skipped
+		Common::BitStream8MSB bs(ms);
+		TS_ASSERT_EQUALS(bs.peekBits(8), 0xFFu);
+		bs.skip(64);
+		TS_ASSERT_EQUALS(bs.pos(), 64u);
+		TS_ASSERT_EQUALS(bs.getBits(8), 8u);
+		TS_ASSERT_EQUALS(bs.getBits(16), 0x090Au);
+
+		Common::BitStream8LSB bs2(ms);
+		bs2.rewind();
+		TS_ASSERT_EQUALS(bs2.peekBits(8), 0xFFu);
+		bs2.skip(64);
+		TS_ASSERT_EQUALS(bs2.getBits(16), 0x0908u);
+
+		Common::BitStream32LELSB bs3(ms);
+		bs3.rewind();
+		TS_ASSERT_EQUALS(bs3.peekBits(8), 0xFFu);
+		bs3.skip(64);
+		TS_ASSERT_EQUALS(bs3.getBits(32), 0x0B0A0908u);
+		TS_ASSERT_EQUALS(bs3.getBits(32), 0x0F0E0D0Cu);
+		TS_ASSERT(bs3.eos());
+	}
+
+	void test_size_rounding() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		// Only whole values are part of the stream
+		Common::BitStream16LEMSB bs16(ms);
+		TS_ASSERT_EQUALS(bs16.size(), 48u);
+		Common::BitStream32LEMSB bs32(ms);
+		TS_ASSERT_EQUALS(bs32.size(), 32u);
+	}
+
+private:
+	/** Return bit n of the data, as the given memory layout hands it out. */
+	static uint32 referenceBit(const byte *data, uint32 n, int valueBits, bool isLE, bool isMSB2LSB) {
+		const uint32 valueBytes = valueBits / 8;
+		const byte *value = data + (n / valueBits) * valueBytes;
+		uint32 bit = n % valueBits;
+		if (isMSB2LSB)
+			bit = valueBits - 1 - bit;
+		// The byte holding the bit, counting from the least significant one
+		const uint32 byteIndex = bit / 8;
+		const byte b = isLE ? value[byteIndex] : value[valueBytes - 1 - byteIndex];
+		return (b >> (bit % 8)) & 1;
+	}
+
+	static uint32 referenceBits(const byte *data, uint32 pos, uint8 n, int valueBits, bool isLE, bool isMSB2LSB) {
+		uint32 v = 0;
+		for (uint8 i = 0; i < n; i++) {
+			if (isMSB2LSB)
+				v = (v << 1) | referenceBit(data, pos + i, valueBits, isLE, isMSB2LSB);
+			else
+				v |= referenceBit(data, pos + i, valueBits, isLE, isMSB2LSB) << i;
+		}
+		return v;
+	}
+
+	template<int valueBits, bool isLE, bool isMSB2LSB>
+	void checkLayout(const byte *data, uint32 dataSize, bool fromMemory) {
+		Common::MemoryReadStream ms(data, dataSize);
+		Common::BitStreamImpl<valueBits, isLE, isMSB2LSB> *bs;
+		if (fromMemory)
+			bs = new Common::BitStreamImpl<valueBits, isLE, isMSB2LSB>(ms);
+		else
+			bs = new Common::BitStreamImpl<valueBits, isLE, isMSB2LSB>(new Common::SeekableSubReadStream(&ms, 0, dataSize), true);
+
+		TestRandom rnd;
+		uint32 pos = 0;
+		while (true) {
+			const uint32 value = rnd.next();
+			const uint8 n = (value >> 16) % 33;
+			if (pos + 80 > bs->size())
+				break;
+
+			switch ((value >> 8) % 4) {
+			case 0:
+				TS_ASSERT_EQUALS(bs->getBits(n), referenceBits(data, pos, n, valueBits, isLE, isMSB2LSB));
+				pos += n;
+				break;
+			case 1:
+				TS_ASSERT_EQUALS(bs->peekBits(n), referenceBits(data, pos, n, valueBits, isLE, isMSB2LSB));
+				break;
+			case 2:
+				TS_ASSERT_EQUALS(bs->getBit(), referenceBit(data, pos, valueBits, isLE, isMSB2LSB));
+				pos++;
+				break;
+			default:
+				// Also skip beyond the buffered bits now and then
+				bs->skip(n * 3);
+				pos += n * 3;
+				break;
+			}
+			TS_ASSERT_EQUALS(bs->pos(), pos);
+		}
+
+		bs->rewind();
+		TS_ASSERT_EQUALS(bs->getBits(32), referenceBits(data, 0, 32, valueBits, isLE, isMSB2LSB));
+		delete bs;
+	}
+
+public:
+	void test_layouts() {
+		byte data[1024];
+		for (uint i = 0; i < sizeof(data); i++)
+			data[i] = (byte)(i * 167 + (i >> 3) * 13);
+
+		for (int fromMemory = 0; fromMemory < 2; fromMemory++) {
+			checkLayout< 8, false, true >(data, sizeof(data), fromMemory);
+			checkLayout< 8, false, false>(data, sizeof(data), fromMemory);
+			checkLayout<16, true , true >(data, sizeof(data), fromMemory);
+			checkLayout<16, true , false>(data, sizeof(data), fromMemory);
+			checkLayout<16, false, true >(data, sizeof(data), fromMemory);
+			checkLayout<16, false, false>(data, sizeof(data), fromMemory);
+			checkLayout<32, true , true >(data, sizeof(data), fromMemory);
+			checkLayout<32, true , false>(data, sizeof(data), fromMemory);
+			checkLayout<32, false, true >(data, sizeof(data), fromMemory);
+			checkLayout<32, false, false>(data, sizeof(data), fromMemory);
+		}
+	}
+};
+
+/**
+ * Measures how fast bits can be read, for the access patterns of the
+ * decoders using BitStream: single bits, multi-bit values of varying
+ * width, and peeking at a fixed number of bits followed by a shorter skip,
+ * as done for VLC lookups. The result is reported in bits per CPU cycle,
+ * i.e. Gbit/s per GHz. Only run if the benchmarks are enabled, see helper.h.
+ */
+class BitStreamBenchmarkSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kDataSize = 256 * 1024
+	};
+
+	enum Pattern {
+		kSingleBits,
+		kMultiBits,
+		kPeekSkip
+	};
+
+	byte *_data;
+	uint32 _checksum;
+
+	template<class Stream>
+	uint32 readAll(Stream &bs, Pattern pattern) {
+		uint32 sum = 0;
+		uint32 bits = 0;
+		const uint32 end = bs.size() - 64;
+		switch (pattern) {
+		case kSingleBits:
+			while (bs.pos() < end) {
+				for (int i = 0; i < 64; i++)
+					sum += bs.getBit();
+				bits += 64;
+			}
+			break;
+		case kMultiBits:
+			while (bs.pos() < end) {
+				for (uint8 n = 1; n <= 11; n++)
+					sum += bs.getBits(n);
+				bits += 66;
+			}
+			break;
+		case kPeekSkip:
+			while (bs.pos() < end) {
+				const uint32 code = bs.peekBits(12);
+				const uint8 length = (code & 7) + 1;
+				sum += code;
+				bs.skip(length);
+				bits += length;
+			}
+			break;
+		}
+		_checksum += sum;
+		return bits;
+	}
+
+	template<class Stream>
+	void benchmark(const char *name, Pattern pattern, Stream &bs, const char *source) {
+#ifdef TEST_BENCHMARKS
+		const uint64 start = readCycleCounter();
+		const uint32 bits = readAll(bs, pattern);
+		const uint64 cycles = readCycleCounter() - start;
+		TS_ASSERT(bits > kDataSize * 7);
+
+		TS_TRACE(Common::String::format("%-13s %-7s %6.3f bits per cycle",
+			name, source, (double)bits / cycles).c_str());
+#endif
+	}
+
+	template<class Stream>
+	void benchmarkPattern(const char *name, Pattern pattern) {
+		// Used directly, the compiler knows the layout and can inline everything
+		Common::MemoryReadStream memory(_data, kDataSize);
+		Stream fromMemory(memory);
+		benchmark(name, pattern, fromMemory, "memory");
+
+		Common::MemoryReadStream parent(_data, kDataSize);
+		Common::SeekableSubReadStream sub(&parent, 0, kDataSize);
+		Stream fromStream(sub);
+		benchmark(name, pattern, fromStream, "stream");
+
+		// Through the interface, as decoders keeping a BitStream pointer do
+		Common::MemoryReadStream shared(_data, kDataSize);
+		Common::BitStream *virtualStream = new Stream(shared);
+		benchmark(name, pattern, *virtualStream, "virtual");
+		delete virtualStream;
+	}
+
+public:
+	void setUp() {
+		_data = new byte[kDataSize];
+		TestRandom rnd;
+		for (uint32 i = 0; i < kDataSize; i++) {
+			const uint32 value = rnd.next();
+			_data[i] = value >> 16;
+		}
+		_checksum = 0;
+	}
+
+	void tearDown() {
+		delete[] _data;
+	}
+
+	void test_benchmark_single_bits() {
+		benchmarkPattern<Common::BitStream32LELSB>("getBit", kSingleBits);
+		benchmarkPattern<Common::BitStream8MSB>("getBit", kSingleBits);
+	}
+
+	void test_benchmark_multi_bits() {
+		benchmarkPattern<Common::BitStream32LELSB>("getBits", kMultiBits);
+		benchmarkPattern<Common::BitStream8MSB>("getBits", kMultiBits);
+	}
+
+	void test_benchmark_peek_skip() {
+		benchmarkPattern<Common::BitStream32LELSB>("peekBits/skip", kPeekSkip);
+		benchmarkPattern<Common::BitStream8MSB>("peekBits/skip", kPeekSkip);
+	}
 };
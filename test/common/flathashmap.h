@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+#include "helper.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		TS_ASSERT_EQUALS(container2["FOO"], "bar");
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 2U);
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.find(2), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.size(), 2U);
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<int, Common::String> map1, map2;
+		for (int i = 0; i < 100; ++i)
+			map1[i * 7] = Common::String::format("%d", i);
+		map2 = map1;
+		map1.clear();
+
+		Common::FlatHashMap<int, Common::String> map3(map2);
+		TS_ASSERT_EQUALS(map3.size(), 100U);
+		for (int i = 0; i < 100; ++i)
+			TS_ASSERT_EQUALS(map3[i * 7], Common::String::format("%d", i));
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 50; ++i)
+			container[i] = i * 2;
+		for (int i = 0; i < 50; i += 2)
+			container.erase(i);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::const_iterator i;
+		for (i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT(i->_key & 1);
+			TS_ASSERT_EQUALS(i->_value, i->_key * 2);
+			found++;
+		}
+		TS_ASSERT_EQUALS(found, 25);
+	}
+
+	void test_against_hashmap() {
+		// Random inserts and erases, so that tables grow, fill up with
+		// deleted markers and get cleaned again
+		Common::FlatHashMap<uint, uint> flat;
+		Common::HashMap<uint, uint> reference;
+		TestRandom rnd;
+		for (int i = 0; i < 100000; ++i) {
+			const uint32 value = rnd.next();
+			const uint key = (value >> 16) % 2000;
+			if (value & 0x100) {
+				flat[key] = i;
+				reference[key] = i;
+			} else {
+				flat.erase(key);
+				reference.erase(key);
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		Common::HashMap<uint, uint>::const_iterator i;
+		for (i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, 0xFFFFFFFF), i->_value);
+
+		uint count = 0;
+		Common::FlatHashMap<uint, uint>::iterator j;
+		for (j = flat.begin(); j != flat.end(); ++j) {
+			TS_ASSERT(reference.contains(j->_key));
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+};
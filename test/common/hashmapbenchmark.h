@@ -0,0 +1,83 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+#include "helper.h"
+
+/**
+ * Compares HashMap and FlatHashMap on 100000 keys: inserting them, looking
+ * them up in an order unrelated to the insertion order, and erasing and
+ * re-inserting every other key. The string keys look like resource names and
+ * use the case insensitive functors. Only run if the benchmarks are enabled,
+ * see helper.h.
+ */
+class HashMapBenchmarkSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kKeys = 100000,
+		kRounds = 10
+	};
+
+	template<class Map, class Key>
+	void benchmark(const char *name, const char *keyType, const Common::Array<Key> &keys) {
+#ifdef TEST_BENCHMARKS
+		Map map;
+
+		uint64 start = readCycleCounter();
+		for (uint i = 0; i < keys.size(); ++i)
+			map[keys[i]] = i;
+		const uint64 insert = readCycleCounter() - start;
+
+		// Look the keys up in a different order than they were inserted in,
+		// since HashMap allocates its nodes in insertion order
+		uint found = 0;
+		start = readCycleCounter();
+		for (int round = 0; round < kRounds; ++round) {
+			for (uint i = 0; i < keys.size(); ++i)
+				found += map.contains(keys[(i * 7919) % keys.size()]);
+		}
+		const uint64 lookup = readCycleCounter() - start;
+
+		// Erase and re-insert half of the keys
+		start = readCycleCounter();
+		for (uint i = 0; i < keys.size(); i += 2)
+			map.erase(keys[i]);
+		for (uint i = 0; i < keys.size(); i += 2)
+			map[keys[i]] = i;
+		const uint64 churn = readCycleCounter() - start;
+
+		TS_ASSERT_EQUALS(found, kRounds * keys.size());
+		TS_ASSERT_EQUALS(map.size(), keys.size());
+		TS_TRACE(Common::String::format("%-11s %-6s keys: insert %6.1f, lookup %6.1f, erase/insert %6.1f cycles per operation",
+			name, keyType, (double)insert / keys.size(), (double)lookup / (kRounds * keys.size()),
+			(double)churn / keys.size()).c_str());
+#endif
+	}
+
+public:
+	void test_benchmark_int() {
+		Common::Array<uint> keys;
+		TestRandom rnd;
+		for (int i = 0; i < kKeys; ++i) {
+			const uint32 value = rnd.next();
+			keys.push_back(value);
+		}
+
+		benchmark<Common::HashMap<uint, uint>, uint>("HashMap", "int", keys);
+		benchmark<Common::FlatHashMap<uint, uint>, uint>("FlatHashMap", "int", keys);
+	}
+
+	void test_benchmark_string() {
+		Common::Array<Common::String> keys;
+		for (int i = 0; i < kKeys; ++i)
+			keys.push_back(Common::String::format("resource.%03d/entry_%d", i % 1000, i));
+
+		benchmark<Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo>, Common::String>("HashMap", "string", keys);
+		benchmark<Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo>, Common::String>("FlatHashMap", "string", keys);
+	}
+};
@@ -0,0 +1,45 @@
+// The benchmark helpers need the system headers, which the test headers
+// included by the runner can not include any more.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "helper.h"
+
+#ifdef TEST_BENCHMARKS
+
+#include "common/memstream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+Common::SeekableReadStream *openBenchmarkFile(const char *variable) {
+	const char *path = getenv(variable);
+	if (!path || !*path)
+		return 0;
+
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte *data = (size > 0) ? (byte *)malloc(size) : 0;
+	if (!data || fread(data, size, 1, file) != 1) {
+		free(data);
+		fclose(file);
+		return 0;
+	}
+
+	fclose(file);
+	return new Common::MemoryReadStream(data, size, DisposeAfterUse::YES);
+}
+
+uint32 getBenchmarkMillis() {
+	timeval time;
+	gettimeofday(&time, 0);
+	return time.tv_sec * 1000 + time.tv_usec / 1000;
+}
+
+#endif
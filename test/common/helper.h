@@ -0,0 +1,51 @@
+#ifndef TEST_COMMON_HELPER_H
+#define TEST_COMMON_HELPER_H
+
+#include "common/scummsys.h"
+#include "common/cpudetect.h"
+
+/**
+ * A linear congruential generator, for test data which looks random but is
+ * the same on every run and every host.
+ */
+class TestRandom {
+public:
+	TestRandom(uint32 seed = 1) : _seed(seed) {}
+
+	uint32 next() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed;
+	}
+
+private:
+	uint32 _seed;
+};
+
+// The benchmarks only run if SCUMMVM_BENCHMARKS is defined, see
+// test/module.mk, since they take a while and their results are only of
+// interest when working on the code they measure. They count CPU cycles,
+// which is only done on x86 hosts, and print their results as traces.
+#if defined(SCUMMVM_BENCHMARKS) && defined(SCUMMVM_SIMD_X86)
+#define TEST_BENCHMARKS
+
+static inline uint64 readCycleCounter() {
+	return __builtin_ia32_rdtsc();
+}
+
+namespace Common {
+class SeekableReadStream;
+}
+
+// For benchmarks of real data and wall clock time, in helper.cpp
+
+/**
+ * Open the file named by the given environment variable, or return 0 if
+ * the variable is not set or the file can not be read.
+ */
+Common::SeekableReadStream *openBenchmarkFile(const char *variable);
+
+/** Return the wall clock time in milliseconds. */
+uint32 getBenchmarkMillis();
+#endif
+
+#endif
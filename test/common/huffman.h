@@ -0,0 +1,163 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "helper.h"
+
+class HuffmanTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kCodeCount = 4 * 18,
+		kSymbolCount = 4096
+	};
+
+	uint32 _codes[kCodeCount];
+	uint32 _codesLSB[kCodeCount];
+	uint8 _lengths[kCodeCount];
+	uint32 _symbols[kCodeCount];
+
+	uint32 _input[kSymbolCount];
+	byte _data[kSymbolCount * 3];
+
+	static uint32 reverse(uint32 value, uint8 n) {
+		uint32 result = 0;
+		for (uint8 i = 0; i < n; i++, value >>= 1)
+			result = (result << 1) | (value & 1);
+		return result;
+	}
+
+	/** Write the input symbols' codes into _data, as the 8 bit bit streams expect them. */
+	void encode(bool msbFirst) {
+		memset(_data, 0, sizeof(_data));
+
+		uint32 pos = 0;
+		for (uint32 i = 0; i < kSymbolCount; i++) {
+			const uint32 code = _codes[_input[i]];
+			const uint8 length = _lengths[_input[i]];
+
+			for (int8 j = length - 1; j >= 0; j--, pos++) {
+				if (!((code >> j) & 1))
+					continue;
+
+				if (msbFirst)
+					_data[pos / 8] |= 0x80 >> (pos % 8);
+				else
+					_data[pos / 8] |= 1 << (pos % 8);
+			}
+		}
+	}
+
+	template<class Stream>
+	void decode(const Common::Huffman &huffman, const uint32 *symbols) {
+		Common::MemoryReadStream ms(_data, sizeof(_data));
+		Stream bs(ms);
+
+		for (uint32 i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bs), symbols ? symbols[_input[i]] : _input[i]);
+	}
+
+public:
+	void setUp() {
+		// A canonical code with four codes each of 3 to 20 bits, leaving some codes unused
+		uint32 code = 0;
+		for (uint32 i = 0; i < kCodeCount; i++) {
+			_lengths[i] = 3 + i / 4;
+			if (i > 0)
+				code = (code + 1) << (_lengths[i] - _lengths[i - 1]);
+
+			_codes[i] = code;
+			_codesLSB[i] = reverse(code, _lengths[i]);
+			_symbols[i] = 1000 + i * 7;
+		}
+
+		// Mostly short codes, with the occasional long one
+		TestRandom rnd;
+		for (uint32 i = 0; i < kSymbolCount; i++) {
+			const uint32 value = rnd.next();
+			uint32 symbol = (value >> 16) % 12;
+			if (symbol >= 8)
+				symbol = (value >> 8) % kCodeCount;
+			_input[i] = symbol;
+		}
+	}
+
+	void test_msb() {
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+
+		encode(true);
+		decode<Common::BitStream8MSB>(huffman, 0);
+		decode<Common::BitStream16BEMSB>(huffman, 0);
+	}
+
+	void test_lsb() {
+		Common::Huffman huffman(0, kCodeCount, _codesLSB, _lengths);
+
+		encode(false);
+		decode<Common::BitStream8LSB>(huffman, 0);
+		decode<Common::BitStream32LELSB>(huffman, 0);
+	}
+
+	void test_symbols() {
+		Common::Huffman huffman(20, kCodeCount, _codes, _lengths, _symbols);
+
+		encode(true);
+		decode<Common::BitStream8MSB>(huffman, _symbols);
+
+		huffman.setSymbols();
+		decode<Common::BitStream8MSB>(huffman, 0);
+
+		huffman.setSymbols(_symbols);
+		decode<Common::BitStream8MSB>(huffman, _symbols);
+	}
+
+	void test_unsorted_codes() {
+		// The codes don't need to be ordered by their length
+		const uint32 codes[]   = { 6, 0, 7, 2 };
+		const uint8  lengths[] = { 3, 1, 3, 2 };
+		Common::Huffman huffman(0, 4, codes, lengths);
+
+		// 0 10 110 111 110, padded with zero bits
+		const byte data[] = { 0x5B, 0xE0 };
+		Common::MemoryReadStream ms(data, sizeof(data));
+		Common::BitStream8MSB bs(ms);
+
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 1u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 3u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 0u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 2u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 0u);
+		TS_ASSERT_EQUALS(bs.pos(), 12u);
+
+		// The end of the stream is decoded bit by bit
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 1u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 1u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 1u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bs), 1u);
+		TS_ASSERT(bs.eos());
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+		encode(true);
+
+		uint32 sum = 0;
+		const uint64 start = readCycleCounter();
+		for (int i = 0; i < 16; i++) {
+			Common::MemoryReadStream ms(_data, sizeof(_data));
+			Common::BitStream8MSB bs(ms);
+			for (uint32 j = 0; j < kSymbolCount; j++)
+				sum += huffman.getSymbol(bs);
+		}
+		const uint64 cycles = readCycleCounter() - start;
+
+		TS_ASSERT(sum > 0);
+		TS_TRACE(Common::String::format("getSymbol: %.1f cycles per symbol",
+			(double)cycles / (16 * kSymbolCount)).c_str());
+#endif
+	}
+};
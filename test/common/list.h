@@ -204,6 +204,54 @@ class ListTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(iter, container.end());
 	}
 
+	void test_splice() {
+		Common::List<int> container, other;
+		Common::List<int>::iterator iter, moved;
+
+		container.push_back(17);
+		container.push_back(33);
+		container.push_back(-11);
+		other.push_back(42);
+
+		// Move the last element to the front, the iterator stays valid
+		moved = container.reverse_begin();
+		container.splice(container.begin(), container, moved);
+		TS_ASSERT_EQUALS(container.begin(), moved);
+		TS_ASSERT_EQUALS(*moved, -11);
+
+		// Moving an element to where it already is changes nothing
+		container.splice(container.begin(), container, moved);
+		iter = moved;
+		++iter;
+		container.splice(iter, container, moved);
+
+		// Move the element of the other list to the end
+		container.splice(container.end(), other, other.begin());
+		TS_ASSERT(other.empty());
+
+		iter = container.begin();
+		TS_ASSERT_EQUALS(*iter, -11);
+		++iter;
+		TS_ASSERT_EQUALS(*iter, 17);
+		++iter;
+		TS_ASSERT_EQUALS(*iter, 33);
+		++iter;
+		TS_ASSERT_EQUALS(*iter, 42);
+		++iter;
+		TS_ASSERT_EQUALS(iter, container.end());
+
+		iter = container.reverse_begin();
+		TS_ASSERT_EQUALS(*iter, 42);
+		--iter;
+		TS_ASSERT_EQUALS(*iter, 33);
+		--iter;
+		TS_ASSERT_EQUALS(*iter, 17);
+		--iter;
+		TS_ASSERT_EQUALS(*iter, -11);
+		--iter;
+		TS_ASSERT_EQUALS(iter, container.end());
+	}
+
 	void test_reverse() {
 		Common::List<int> container;
 		Common::List<int>::iterator iter;
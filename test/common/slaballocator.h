@@ -0,0 +1,122 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/slaballocator.h"
+
+class SlabAllocatorTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_chunk_size() {
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(0), 8U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(8), 8U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(9), 16U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(33), 64U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(1024), 1024U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getChunkSize(1025), 0U);
+	}
+
+	void test_alloc_free() {
+		Common::SlabAllocator allocator;
+		byte *blocks[1000];
+
+		// Fill each block with a pattern and check it is still intact
+		// after all others have been allocated.
+		for (int i = 0; i < 1000; ++i) {
+			const size_t size = 1 + (i * 37) % 1500;
+			blocks[i] = (byte *)allocator.allocate(size);
+			TS_ASSERT(blocks[i] != 0);
+			memset(blocks[i], i & 0xFF, size);
+		}
+		for (int i = 0; i < 1000; ++i) {
+			const size_t size = 1 + (i * 37) % 1500;
+			for (size_t j = 0; j < size; ++j) {
+				if (blocks[i][j] != (i & 0xFF)) {
+					TS_FAIL("block was overwritten");
+					break;
+				}
+			}
+		}
+
+		Common::SlabAllocator::Stats stats = allocator.getStats();
+		TS_ASSERT(stats.largeAllocations > 0);
+		TS_ASSERT(stats.usedPages > 0);
+		TS_ASSERT(stats.reservedBytes >= stats.usedPages * 8192);
+
+		for (int i = 0; i < 1000; ++i)
+			allocator.deallocate(blocks[i], 1 + (i * 37) % 1500);
+
+		stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.largeAllocations, 0U);
+
+		// Only chunks held in the thread cache may remain
+		for (int i = 0; i < Common::SlabAllocator::kNumSizeClasses; ++i)
+			TS_ASSERT_LESS_THAN_EQUALS(stats.chunksInUse[i], 32U);
+	}
+
+	void test_pages_are_released() {
+		Common::SlabAllocator allocator;
+		void *blocks[4000];
+
+		for (int round = 0; round < 2; ++round) {
+			for (int i = 0; i < 4000; ++i)
+				blocks[i] = allocator.allocate(64);
+			for (int i = 0; i < 4000; ++i)
+				allocator.deallocate(blocks[i], 64);
+		}
+
+		// Only the pages holding chunks in the thread cache may be left
+		Common::SlabAllocator::Stats stats = allocator.getStats();
+		TS_ASSERT(stats.peakReservedBytes >= 4000 * 64);
+		TS_ASSERT_LESS_THAN_EQUALS(stats.chunksInUse[3], 32U);
+		TS_ASSERT_LESS_THAN_EQUALS(stats.usedPages, stats.chunksInUse[3]);
+
+		allocator.releaseAll();
+		allocator.freeUnusedArenas();
+		stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.usedPages, 0U);
+		TS_ASSERT_EQUALS(stats.reservedBytes, 0U);
+	}
+
+	void test_release_thread_caches() {
+		Common::SlabAllocator allocator;
+		void *blocks[100];
+		for (int i = 0; i < 100; ++i)
+			blocks[i] = allocator.allocate(64);
+		for (int i = 0; i < 100; ++i)
+			allocator.deallocate(blocks[i], 64);
+
+		// As when a worker thread exits: nothing stays in its cache
+		Common::SlabAllocator::releaseThreadCaches();
+		Common::SlabAllocator::Stats stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.chunksInUse[3], 0U);
+		TS_ASSERT_EQUALS(stats.usedPages, 0U);
+		TS_ASSERT_EQUALS(stats.allocations, 100U);
+	}
+
+	void test_release_all() {
+		Common::SlabAllocator allocator;
+		for (int i = 0; i < 500; ++i)
+			allocator.allocate(100);
+		allocator.releaseAll();
+
+		Common::SlabAllocator::Stats stats = allocator.getStats();
+		TS_ASSERT_EQUALS(stats.usedPages, 0U);
+		TS_ASSERT_EQUALS(stats.reservedBytes, 0U);
+
+		// The allocator can be used again afterwards
+		void *ptr = allocator.allocate(100);
+		TS_ASSERT(ptr != 0);
+		allocator.deallocate(ptr, 100);
+	}
+
+	struct Object : public Common::SlabAllocated {
+		int _a, _b;
+	};
+
+	void test_slab_allocated() {
+		Object *obj = new Object();
+		obj->_a = 1;
+		obj->_b = 2;
+		TS_ASSERT_EQUALS(obj->_a + obj->_b, 3);
+		delete obj;
+	}
+};
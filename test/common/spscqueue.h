@@ -0,0 +1,58 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spscqueue.h"
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite {
+public:
+	void test_empty_size() {
+		Common::SPSCQueue<int, 8> queue;
+		TS_ASSERT(queue.empty());
+		TS_ASSERT_EQUALS(queue.size(), 0u);
+
+		if (!queue.isLockFree())
+			return;
+
+		TS_ASSERT(queue.push(1));
+		TS_ASSERT(queue.push(2));
+		TS_ASSERT(!queue.empty());
+		TS_ASSERT_EQUALS(queue.size(), 2u);
+	}
+
+	void test_fifo_order() {
+		Common::SPSCQueue<int, 8> queue;
+		if (!queue.isLockFree())
+			return;
+
+		int x;
+		// Go around the ring a few times
+		for (int i = 0; i < 20; ++i) {
+			TS_ASSERT(queue.push(i * 2));
+			TS_ASSERT(queue.push(i * 2 + 1));
+			TS_ASSERT(queue.pop(x));
+			TS_ASSERT_EQUALS(x, i * 2);
+			TS_ASSERT(queue.pop(x));
+			TS_ASSERT_EQUALS(x, i * 2 + 1);
+		}
+
+		TS_ASSERT(!queue.pop(x));
+	}
+
+	void test_full() {
+		Common::SPSCQueue<int, 4> queue;
+		if (!queue.isLockFree())
+			return;
+
+		TS_ASSERT_EQUALS(queue.capacity(), 3u);
+		TS_ASSERT(queue.push(1));
+		TS_ASSERT(queue.push(2));
+		TS_ASSERT(queue.push(3));
+		TS_ASSERT(!queue.push(4));
+		TS_ASSERT_EQUALS(queue.size(), 3u);
+
+		int x;
+		TS_ASSERT(queue.pop(x));
+		TS_ASSERT_EQUALS(x, 1);
+		TS_ASSERT(queue.push(4));
+		TS_ASSERT_EQUALS(queue.size(), 3u);
+	}
+};
@@ -392,6 +392,79 @@ class StringTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(strcmp(test4, resultString), 0);
 	}
 
+	void test_swap() {
+		Common::String shortStr("short");
+		Common::String longStr("a string which is too long for the internal storage");
+		const char *longStorage = longStr.c_str();
+
+		shortStr.swap(longStr);
+		TS_ASSERT_EQUALS(shortStr, "a string which is too long for the internal storage");
+		TS_ASSERT_EQUALS(longStr, "short");
+		// The heap storage changes hands, it is not copied
+		TS_ASSERT_EQUALS(shortStr.c_str(), longStorage);
+
+		Common::String copy = shortStr;
+		copy.swap(longStr);
+		TS_ASSERT_EQUALS(copy, "short");
+		TS_ASSERT_EQUALS(longStr, shortStr);
+	}
+
+	void test_reserve() {
+		Common::String str("x");
+		str.reserve(100);
+		const char *storage = str.c_str();
+		for (int i = 0; i < 99; ++i)
+			str += 'x';
+		TS_ASSERT_EQUALS(str.size(), 100U);
+		TS_ASSERT_EQUALS(str.c_str(), storage);
+
+		// Reserving unshares the storage
+		Common::String copy = str;
+		copy.reserve(10);
+		TS_ASSERT_DIFFERS(copy.c_str(), str.c_str());
+		TS_ASSERT_EQUALS(copy, str);
+	}
+
+	void test_concat() {
+		Common::String longStr("a string which is too long for the internal storage");
+		TS_ASSERT_EQUALS(Common::String("ab") + Common::String("cd"), "abcd");
+		TS_ASSERT_EQUALS(longStr + "!", "a string which is too long for the internal storage!");
+		TS_ASSERT_EQUALS("!" + longStr, "!a string which is too long for the internal storage");
+		TS_ASSERT_EQUALS('!' + longStr + '?', "!a string which is too long for the internal storage?");
+		TS_ASSERT_EQUALS(longStr + "", longStr);
+		TS_ASSERT_EQUALS(longStr + Common::String(), longStr);
+		TS_ASSERT_EQUALS(('\0' + Common::String("a")).size(), 1U);
+	}
+
+	void test_string_builder() {
+		Common::StringBuilder builder;
+		TS_ASSERT(builder.empty());
+		builder.append("Hello").append(',').append(Common::String(" world"));
+		builder.appendFormat(" %d%s", 42, "!");
+		TS_ASSERT_EQUALS(builder.toString(), "Hello, world 42!");
+		TS_ASSERT_EQUALS(builder.size(), 16U);
+
+		builder.clear();
+		TS_ASSERT(builder.empty());
+		TS_ASSERT_EQUALS(builder.toString(), "");
+
+		// Grow well beyond the internal storage, using both append and
+		// appendFormat
+		Common::String expected;
+		for (int i = 0; i < 200; ++i) {
+			builder.appendFormat("[%d]", i);
+			builder.append("-");
+			expected += Common::String::format("[%d]-", i);
+		}
+		TS_ASSERT_EQUALS(builder.toString(), expected);
+		TS_ASSERT_EQUALS(strlen(builder.c_str()), builder.size());
+
+		// A single long formatted piece
+		builder.clear();
+		builder.appendFormat("%s", expected.c_str());
+		TS_ASSERT_EQUALS(builder.toString(), expected);
+	}
+
 	void test_scumm_stricmp() {
 		TS_ASSERT_EQUALS(scumm_stricmp("abCd", "abCd"), 0);
 		TS_ASSERT_EQUALS(scumm_stricmp("abCd", "ABCd"), 0);
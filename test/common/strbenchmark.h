@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/str.h"
+
+#include "helper.h"
+
+/**
+ * Compares ways of composing a block of text, as engines do for debug
+ * overlays or script output every frame. Checks the string storage
+ * allocations per frame, and if the benchmarks are enabled, see helper.h,
+ * reports them along with the CPU cycles per frame.
+ */
+class StringBenchmarkSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kFrames = 200,
+		kLinesPerFrame = 20
+	};
+
+	enum Method {
+		kConcat,
+		kAppend,
+		kBuilder
+	};
+
+	Common::String _result;
+
+	void buildFrame(Method method, int frame, Common::StringBuilder &builder) {
+		switch (method) {
+		case kConcat: {
+			Common::String text;
+			for (int i = 0; i < kLinesPerFrame; ++i)
+				text = text + Common::String::format("Object %d: x=%d y=%d", i, frame + i, frame * 2 - i) + " state=" + "idle" + '\n';
+			_result = text;
+			break;
+		}
+
+		case kAppend: {
+			Common::String text;
+			text.reserve(kLinesPerFrame * 48);
+			for (int i = 0; i < kLinesPerFrame; ++i) {
+				text += Common::String::format("Object %d: x=%d y=%d", i, frame + i, frame * 2 - i);
+				text += " state=";
+				text += "idle";
+				text += '\n';
+			}
+			_result = text;
+			break;
+		}
+
+		case kBuilder:
+			builder.clear();
+			for (int i = 0; i < kLinesPerFrame; ++i) {
+				builder.appendFormat("Object %d: x=%d y=%d", i, frame + i, frame * 2 - i);
+				builder.append(" state=").append("idle").append('\n');
+			}
+			_result = builder.toString();
+			break;
+		}
+	}
+
+	double benchmark(const char *name, Method method) {
+		Common::StringBuilder builder;
+		// The first frame sets up the builder's buffer
+		buildFrame(method, 0, builder);
+
+		const uint32 allocationsBefore = Common::String::getAllocationCount();
+#ifdef TEST_BENCHMARKS
+		const uint64 start = readCycleCounter();
+#endif
+		for (int frame = 1; frame <= kFrames; ++frame)
+			buildFrame(method, frame, builder);
+#ifdef TEST_BENCHMARKS
+		const uint64 cycles = readCycleCounter() - start;
+#endif
+		const uint32 allocations = Common::String::getAllocationCount() - allocationsBefore;
+
+		TS_ASSERT(_result.hasSuffix(Common::String::format("Object %d: x=%d y=%d state=idle\n", kLinesPerFrame - 1, kFrames + kLinesPerFrame - 1, kFrames * 2 - kLinesPerFrame + 1)));
+
+		const double perFrame = (double)allocations / kFrames;
+#ifdef TEST_BENCHMARKS
+		TS_TRACE(Common::String::format("%-8s %6.1f allocations, %9.0f cycles per frame",
+			name, perFrame, (double)cycles / kFrames).c_str());
+#endif
+		return perFrame;
+	}
+
+public:
+	void test_benchmark_compose() {
+		const double concat = benchmark("concat", kConcat);
+		const double append = benchmark("append", kAppend);
+		const double builder = benchmark("builder", kBuilder);
+
+		// Only the final String is allocated by the builder
+		TS_ASSERT_LESS_THAN_EQUALS(builder, 1.0);
+		TS_ASSERT_LESS_THAN_EQUALS(builder, append);
+		TS_ASSERT_LESS_THAN_EQUALS(append, concat);
+	}
+};
@@ -0,0 +1,196 @@
+// The system headers are needed for the threads, which the test headers
+// included by the runner can not include any more.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "threadsystem.h"
+
+#ifdef POSIX
+#include <pthread.h>
+#include <unistd.h>
+
+namespace {
+
+struct Thread {
+	pthread_t handle;
+	OSystem::ThreadProc proc;
+	void *param;
+};
+
+struct Semaphore {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint value;
+};
+
+void *runThread(void *param) {
+	Thread *thread = (Thread *)param;
+	thread->proc(thread->param);
+	return 0;
+}
+
+} // End of anonymous namespace
+
+ThreadTestSystem::ThreadTestSystem() : _waitHook(0) {
+	_mainThread = new pthread_t(pthread_self());
+}
+
+ThreadTestSystem::~ThreadTestSystem() {
+	delete (pthread_t *)_mainThread;
+}
+
+bool ThreadTestSystem::hasThreads() const {
+	return true;
+}
+
+bool ThreadTestSystem::isMainThread() const {
+	return pthread_equal(pthread_self(), *(pthread_t *)_mainThread);
+}
+
+uint ThreadTestSystem::getCPUCount() {
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 1) ? count : 1;
+}
+
+void ThreadTestSystem::delayMillis(uint msecs) {
+	usleep(msecs * 1000);
+}
+
+OSystem::MutexRef ThreadTestSystem::createMutex() {
+	// Common::StackLock may be nested, like with the backends' mutexes
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+	pthread_mutex_t *mutex = new pthread_mutex_t;
+	pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return (MutexRef)mutex;
+}
+
+void ThreadTestSystem::lockMutex(MutexRef mutex) {
+	pthread_mutex_lock((pthread_mutex_t *)mutex);
+}
+
+void ThreadTestSystem::unlockMutex(MutexRef mutex) {
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+void ThreadTestSystem::deleteMutex(MutexRef mutex) {
+	pthread_mutex_destroy((pthread_mutex_t *)mutex);
+	delete (pthread_mutex_t *)mutex;
+}
+
+OSystem::ThreadRef ThreadTestSystem::createThread(ThreadProc proc, void *param) {
+	Thread *thread = new Thread;
+	thread->proc = proc;
+	thread->param = param;
+
+	if (pthread_create(&thread->handle, 0, &runThread, thread)) {
+		delete thread;
+		return 0;
+	}
+
+	return (ThreadRef)thread;
+}
+
+void ThreadTestSystem::waitThread(ThreadRef thread) {
+	pthread_join(((Thread *)thread)->handle, 0);
+	delete (Thread *)thread;
+}
+
+OSystem::SemaphoreRef ThreadTestSystem::createSemaphore(uint value) {
+	Semaphore *semaphore = new Semaphore;
+	pthread_mutex_init(&semaphore->mutex, 0);
+	pthread_cond_init(&semaphore->cond, 0);
+	semaphore->value = value;
+	return (SemaphoreRef)semaphore;
+}
+
+void ThreadTestSystem::postSemaphore(SemaphoreRef semaphore) {
+	Semaphore *s = (Semaphore *)semaphore;
+	pthread_mutex_lock(&s->mutex);
+	s->value++;
+	pthread_cond_signal(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+
+void ThreadTestSystem::waitSemaphore(SemaphoreRef semaphore) {
+	if (isMainThread() && _waitHook && semaphore != _waitHook)
+		postSemaphore(_waitHook);
+
+	Semaphore *s = (Semaphore *)semaphore;
+	pthread_mutex_lock(&s->mutex);
+	while (!s->value)
+		pthread_cond_wait(&s->cond, &s->mutex);
+	s->value--;
+	pthread_mutex_unlock(&s->mutex);
+}
+
+void ThreadTestSystem::deleteSemaphore(SemaphoreRef semaphore) {
+	Semaphore *s = (Semaphore *)semaphore;
+	pthread_cond_destroy(&s->cond);
+	pthread_mutex_destroy(&s->mutex);
+	delete s;
+}
+
+#else
+
+// Without threads, createThread() fails like on backends without them, and
+// the tests only check the fallbacks
+
+ThreadTestSystem::ThreadTestSystem() : _mainThread(0), _waitHook(0) {
+}
+
+ThreadTestSystem::~ThreadTestSystem() {
+}
+
+bool ThreadTestSystem::hasThreads() const {
+	return false;
+}
+
+bool ThreadTestSystem::isMainThread() const {
+	return true;
+}
+
+uint ThreadTestSystem::getCPUCount() {
+	return 1;
+}
+
+void ThreadTestSystem::delayMillis(uint msecs) {
+}
+
+// Only one thread runs, so the mutexes never have to do anything
+OSystem::MutexRef ThreadTestSystem::createMutex() {
+	return (MutexRef)this;
+}
+
+void ThreadTestSystem::lockMutex(MutexRef mutex) {
+}
+
+void ThreadTestSystem::unlockMutex(MutexRef mutex) {
+}
+
+void ThreadTestSystem::deleteMutex(MutexRef mutex) {
+}
+
+OSystem::ThreadRef ThreadTestSystem::createThread(ThreadProc proc, void *param) {
+	return 0;
+}
+
+void ThreadTestSystem::waitThread(ThreadRef thread) {
+}
+
+OSystem::SemaphoreRef ThreadTestSystem::createSemaphore(uint value) {
+	return 0;
+}
+
+void ThreadTestSystem::postSemaphore(SemaphoreRef semaphore) {
+}
+
+void ThreadTestSystem::waitSemaphore(SemaphoreRef semaphore) {
+}
+
+void ThreadTestSystem::deleteSemaphore(SemaphoreRef semaphore) {
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef TEST_COMMON_THREADSYSTEM_H
+#define TEST_COMMON_THREADSYSTEM_H
+
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+/**
+ * An OSystem for tests of code which uses threads. It provides real
+ * threads, semaphores and mutexes where pthreads are available, and
+ * nothing else. Elsewhere createThread() fails like on backends without
+ * threads, so that the tests can still check the fallbacks.
+ */
+class ThreadTestSystem : public OSystem {
+public:
+	ThreadTestSystem();
+	virtual ~ThreadTestSystem();
+
+	/** Whether createThread() works at all. */
+	bool hasThreads() const;
+
+	/**
+	 * Post the given semaphore whenever the main thread is about to wait
+	 * for another one, so that a test can make a thread wait until then.
+	 */
+	void setWaitHook(SemaphoreRef semaphore) { _waitHook = semaphore; }
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return false; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	// The time does not pass, it would only make the tests depend on the host
+	virtual uint32 getMillis() { return 0; }
+	virtual void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	virtual Audio::Mixer *getMixer() { return 0; }
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+
+	// Implemented in threadsystem.cpp, which can include the system headers
+	virtual uint getCPUCount();
+	virtual void delayMillis(uint msecs);
+	virtual MutexRef createMutex();
+	virtual void lockMutex(MutexRef mutex);
+	virtual void unlockMutex(MutexRef mutex);
+	virtual void deleteMutex(MutexRef mutex);
+	virtual ThreadRef createThread(ThreadProc proc, void *param);
+	virtual void waitThread(ThreadRef thread);
+	virtual SemaphoreRef createSemaphore(uint value);
+	virtual void postSemaphore(SemaphoreRef semaphore);
+	virtual void waitSemaphore(SemaphoreRef semaphore);
+	virtual void deleteSemaphore(SemaphoreRef semaphore);
+
+private:
+	/** Whether the calling thread is the one which created the system. */
+	bool isMainThread() const;
+
+	void *_mainThread;
+	SemaphoreRef _waitHook;
+};
+
+#endif
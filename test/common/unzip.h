@@ -0,0 +1,259 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/util.h"
+#include "common/zlib.h"
+
+/**
+ * Tests reading members of zip archives which are big enough to be streamed
+ * from the archive rather than inflated into memory when they are opened.
+ */
+class UnzipTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kStoredSize = 300 * 1024,
+		// Deflated members get a checkpoint every 1MB
+		kDeflatedSize = 3 * 1024 * 1024 + 12345
+	};
+
+	struct Member {
+		const char *name;
+		const byte *data;
+		uint32 size;
+		bool deflate;
+	};
+
+	static byte contents(uint32 pos) {
+		// Compressible, but without repeating every few bytes
+		return (byte)((pos >> 3) ^ (pos * 7) ^ (pos >> 13));
+	}
+
+	static byte *createContents(uint32 size) {
+		byte *data = new byte[size];
+		for (uint32 i = 0; i < size; ++i)
+			data[i] = contents(i);
+		return data;
+	}
+
+	static bool checkContents(const byte *data, uint32 pos, uint32 size) {
+		for (uint32 i = 0; i < size; ++i) {
+			if (data[i] != contents(pos + i))
+				return false;
+		}
+		return true;
+	}
+
+	static void writeUint32(Common::Array<byte> &out, uint32 value) {
+		for (int i = 0; i < 4; ++i)
+			out.push_back((byte)(value >> (i * 8)));
+	}
+
+	static void writeUint16(Common::Array<byte> &out, uint16 value) {
+		out.push_back((byte)value);
+		out.push_back((byte)(value >> 8));
+	}
+
+	static void writeData(Common::Array<byte> &out, const byte *data, uint32 size) {
+		for (uint32 i = 0; i < size; ++i)
+			out.push_back(data[i]);
+	}
+
+	/** Deflate the data, and compute its CRC-32 on the way. */
+	static void deflateData(const byte *data, uint32 size, Common::Array<byte> &out, uint32 &crc) {
+		Common::MemoryWriteStreamDynamic *gzip = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *stream = Common::wrapCompressedWriteStream(gzip);
+		stream->write(data, size);
+		stream->finalize();
+		byte *gzipData = gzip->getData();
+		const uint32 gzipSize = gzip->size();
+		delete stream;
+
+		// Strip the 10 byte gzip header and the trailer with the CRC and
+		// size, which leaves the raw deflate data zip archives hold.
+		writeData(out, gzipData + 10, gzipSize - 18);
+		crc = READ_LE_UINT32(gzipData + gzipSize - 8);
+		free(gzipData);
+	}
+
+	static Common::Archive *createArchive(const Member *members, int count) {
+		Common::Array<byte> zip, centralDir;
+
+		for (int i = 0; i < count; ++i) {
+			const Member &member = members[i];
+
+			// Streamed members are not CRC checked, so stored ones simply
+			// get a CRC of 0
+			Common::Array<byte> data;
+			uint32 crc = 0;
+			if (member.deflate)
+				deflateData(member.data, member.size, data, crc);
+			else
+				writeData(data, member.data, member.size);
+
+			const uint32 offset = zip.size();
+			const uint16 nameLength = strlen(member.name);
+
+			writeUint32(zip, 0x04034b50);
+			writeUint16(zip, 20);	// version needed
+			writeUint16(zip, 0);	// flags
+			writeUint16(zip, member.deflate ? 8 : 0);
+			writeUint32(zip, 0);	// time and date
+			writeUint32(zip, crc);
+			writeUint32(zip, data.size());
+			writeUint32(zip, member.size);
+			writeUint16(zip, nameLength);
+			writeUint16(zip, 0);	// extra field length
+			writeData(zip, (const byte *)member.name, nameLength);
+			writeData(zip, data.begin(), data.size());
+
+			writeUint32(centralDir, 0x02014b50);
+			writeUint16(centralDir, 20);	// version made by
+			writeUint16(centralDir, 20);	// version needed
+			writeUint16(centralDir, 0);		// flags
+			writeUint16(centralDir, member.deflate ? 8 : 0);
+			writeUint32(centralDir, 0);		// time and date
+			writeUint32(centralDir, crc);
+			writeUint32(centralDir, data.size());
+			writeUint32(centralDir, member.size);
+			writeUint16(centralDir, nameLength);
+			writeUint16(centralDir, 0);		// extra field length
+			writeUint16(centralDir, 0);		// comment length
+			writeUint16(centralDir, 0);		// disk number
+			writeUint16(centralDir, 0);		// internal attributes
+			writeUint32(centralDir, 0);		// external attributes
+			writeUint32(centralDir, offset);
+			writeData(centralDir, (const byte *)member.name, nameLength);
+		}
+
+		const uint32 centralDirOffset = zip.size();
+		writeData(zip, centralDir.begin(), centralDir.size());
+
+		writeUint32(zip, 0x06054b50);
+		writeUint16(zip, 0);	// disk number
+		writeUint16(zip, 0);	// disk with the central directory
+		writeUint16(zip, count);
+		writeUint16(zip, count);
+		writeUint32(zip, centralDir.size());
+		writeUint32(zip, centralDirOffset);
+		writeUint16(zip, 0);	// comment length
+
+		byte *buffer = (byte *)malloc(zip.size());
+		memcpy(buffer, zip.begin(), zip.size());
+		return Common::makeZipArchive(new Common::MemoryReadStream(buffer, zip.size(), DisposeAfterUse::YES));
+	}
+
+	/** Read size bytes at pos and check them, in chunks of the given size. */
+	static bool readAt(Common::SeekableReadStream *stream, uint32 pos, uint32 size, uint32 chunkSize) {
+		if (!stream->seek(pos, SEEK_SET) || (uint32)stream->pos() != pos)
+			return false;
+
+		byte *buffer = new byte[chunkSize];
+		bool ok = true;
+		for (uint32 done = 0; done < size && ok; done += chunkSize) {
+			const uint32 len = MIN<uint32>(chunkSize, size - done);
+			ok = stream->read(buffer, len) == len && checkContents(buffer, pos + done, len);
+		}
+		delete[] buffer;
+
+		return ok && !stream->err() && (uint32)stream->pos() == pos + size;
+	}
+
+	void checkMember(Common::SeekableReadStream *stream, uint32 size) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		TS_ASSERT_EQUALS((uint32)stream->size(), size);
+
+		// Odd chunk sizes, so that reads end in between checkpoints
+		TS_ASSERT(readAt(stream, 0, size, 100003));
+		TS_ASSERT(!stream->eos());
+
+		// Backwards, to the start and to the middle
+		TS_ASSERT(readAt(stream, 0, 1000, 1000));
+		TS_ASSERT(readAt(stream, size / 2, 20000, 777));
+
+		// Reading past the end
+		byte buffer[16];
+		TS_ASSERT(stream->seek(-8, SEEK_END));
+		TS_ASSERT_EQUALS(stream->read(buffer, 16), 8U);
+		TS_ASSERT(checkContents(buffer, size - 8, 8));
+		TS_ASSERT(stream->eos());
+
+		// Seeking clears the end of stream flag
+		TS_ASSERT(readAt(stream, 10, 10, 10));
+		TS_ASSERT(!stream->eos());
+	}
+
+public:
+	void test_stored_member() {
+		byte *data = createContents(kStoredSize);
+		const Member members[] = { { "stored.bin", data, kStoredSize, false } };
+		Common::Archive *archive = createArchive(members, 1);
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("stored.bin");
+		checkMember(stream, kStoredSize);
+
+		delete stream;
+		delete archive;
+		delete[] data;
+	}
+
+	void test_deflated_member() {
+#ifdef USE_ZLIB
+		byte *data = createContents(kDeflatedSize);
+		const Member members[] = { { "deflated.bin", data, kDeflatedSize, true } };
+		Common::Archive *archive = createArchive(members, 1);
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("deflated.bin");
+		checkMember(stream, kDeflatedSize);
+
+		// Back across the checkpoints at 1MB and 2MB
+		TS_ASSERT(readAt(stream, 2 * 1024 * 1024 + 1000, 5000, 5000));
+		TS_ASSERT(readAt(stream, 1024 * 1024 - 100, 1024 * 1024 + 200, 65536));
+		TS_ASSERT(readAt(stream, 1024 * 1024, 10, 10));
+		TS_ASSERT(readAt(stream, 100, 10, 10));
+
+		delete stream;
+		delete archive;
+		delete[] data;
+#endif
+	}
+
+	void test_members_share_the_archive() {
+#ifdef USE_ZLIB
+		byte *data = createContents(kDeflatedSize);
+		const Member members[] = {
+			{ "stored.bin", data, kStoredSize, false },
+			{ "deflated.bin", data, kDeflatedSize, true }
+		};
+		Common::Archive *archive = createArchive(members, 2);
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.bin");
+		Common::SeekableReadStream *deflated = archive->createReadStreamForMember("deflated.bin");
+		TS_ASSERT(stored && deflated);
+
+		// Members are independent of each other, and outlive the archive
+		delete archive;
+
+		if (stored && deflated) {
+			for (uint32 pos = 0; pos < kStoredSize - 4096; pos += 50000) {
+				TS_ASSERT(readAt(deflated, pos * 3, 4096, 4096));
+				TS_ASSERT(readAt(stored, pos, 4096, 1024));
+			}
+		}
+
+		delete stored;
+		delete deflated;
+		delete[] data;
+#endif
+	}
+};
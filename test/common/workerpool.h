@@ -0,0 +1,97 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/workerpool.h"
+
+#include "threadsystem.h"
+
+static void addToSum(void *param) {
+	int *values = (int *)param;
+	values[0] += values[1];
+}
+
+/** A job which only finishes once the thread which queued it lets it. */
+struct BlockedJob {
+	OSystem::SemaphoreRef start;
+	bool done;
+};
+
+static void runBlockedJob(void *param) {
+	BlockedJob *job = (BlockedJob *)param;
+	g_system->waitSemaphore(job->start);
+	job->done = true;
+}
+
+class WorkerPoolTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_inline_jobs() {
+		// Without a backend, jobs have to be run right away
+		Common::WorkerPool pool(2);
+		TS_ASSERT_EQUALS(pool.getThreadCount(), 0u);
+
+		int values[2] = { 1, 2 };
+		pool.addJob(addToSum, values);
+		TS_ASSERT_EQUALS(values[0], 3);
+
+		pool.addJob(addToSum, values);
+		pool.wait();
+		TS_ASSERT_EQUALS(values[0], 5);
+	}
+
+	void test_threaded_jobs() {
+		ThreadTestSystem system;
+		if (!system.hasThreads())
+			return;
+
+		OSystem *oldSystem = g_system;
+		g_system = &system;
+		int values[kJobCount][2];
+
+		{
+			Common::WorkerPool pool(2);
+			TS_ASSERT_EQUALS(pool.getThreadCount(), 2u);
+
+			// The jobs run in the workers, else addJob() would not return
+			BlockedJob jobs[2];
+			for (int i = 0; i < 2; ++i) {
+				jobs[i].start = g_system->createSemaphore(0);
+				jobs[i].done = false;
+				pool.addJob(runBlockedJob, &jobs[i]);
+			}
+
+			for (int i = 0; i < 2; ++i)
+				g_system->postSemaphore(jobs[i].start);
+
+			pool.wait();
+			for (int i = 0; i < 2; ++i) {
+				TS_ASSERT(jobs[i].done);
+				g_system->deleteSemaphore(jobs[i].start);
+			}
+
+			// Each job is run exactly once, and wait() waits for all of them
+			for (int i = 0; i < kJobCount; ++i) {
+				values[i][0] = i;
+				values[i][1] = 1;
+				pool.addJob(addToSum, values[i]);
+			}
+
+			pool.wait();
+			for (int i = 0; i < kJobCount; ++i)
+				TS_ASSERT_EQUALS(values[i][0], i + 1);
+
+			// The destructor waits for jobs which are still queued
+			for (int i = 0; i < kJobCount; ++i)
+				pool.addJob(addToSum, values[i]);
+		}
+
+		for (int i = 0; i < kJobCount; ++i)
+			TS_ASSERT_EQUALS(values[i][0], i + 2);
+
+		g_system = oldSystem;
+	}
+
+	private:
+	enum {
+		kJobCount = 100
+	};
+};
@@ -0,0 +1,165 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyrects.h"
+
+#include "../common/helper.h"
+
+class DirtyRectListTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_contained() {
+		Graphics::DirtyRectList list(8);
+		list.add(Common::Rect(10, 10, 50, 50));
+		list.add(Common::Rect(20, 20, 30, 30));
+		TS_ASSERT_EQUALS(list.size(), 1U);
+		TS_ASSERT(list[0] == Common::Rect(10, 10, 50, 50));
+
+		// A rect containing the one in the list replaces it
+		list.add(Common::Rect(0, 0, 60, 60));
+		TS_ASSERT_EQUALS(list.size(), 1U);
+		TS_ASSERT(list[0] == Common::Rect(0, 0, 60, 60));
+	}
+
+	void test_empty() {
+		Graphics::DirtyRectList list(1);
+		TS_ASSERT(list.add(Common::Rect()));
+		TS_ASSERT(list.add(Common::Rect(5, 5, 5, 10)));
+		TS_ASSERT(list.empty());
+	}
+
+	void test_neighbors() {
+		// Neighbors sharing a whole edge are merged, as are rects which
+		// are no larger together
+		Graphics::DirtyRectList list(8);
+		list.add(Common::Rect(0, 0, 10, 10));
+		list.add(Common::Rect(10, 0, 20, 10));
+		list.add(Common::Rect(0, 10, 20, 20));
+		TS_ASSERT_EQUALS(list.size(), 1U);
+		TS_ASSERT(list[0] == Common::Rect(0, 0, 20, 20));
+
+		// Rects far apart are kept separately
+		list.add(Common::Rect(100, 100, 110, 110));
+		TS_ASSERT_EQUALS(list.size(), 2U);
+	}
+
+	void test_partial_overlap() {
+		Graphics::DirtyRectList list(8);
+		list.add(Common::Rect(0, 0, 100, 10));
+		list.add(Common::Rect(40, 5, 50, 100));
+
+		// Only the part below the first rect is added
+		TS_ASSERT_EQUALS(list.size(), 2U);
+		TS_ASSERT(list[1] == Common::Rect(40, 10, 50, 100));
+		checkList(list);
+	}
+
+	void test_full() {
+		Graphics::DirtyRectList list(2);
+		TS_ASSERT(list.add(Common::Rect(0, 0, 10, 10)));
+		TS_ASSERT(list.add(Common::Rect(100, 0, 110, 10)));
+		TS_ASSERT(!list.add(Common::Rect(0, 100, 10, 110)));
+
+		list.clear();
+		TS_ASSERT(list.empty());
+		TS_ASSERT(list.add(Common::Rect(0, 100, 10, 110)));
+	}
+
+	void test_overflow() {
+		// Like the sprites of a busy SCI32 screen: many small rects, some
+		// of them moving over each other
+		Graphics::DirtyRectList list(32);
+		for (int16 i = 0; i < 32; ++i)
+			TS_ASSERT(list.add(Common::Rect(i * 20, i % 2 * 20, i * 20 + 10, i % 2 * 20 + 10)));
+		TS_ASSERT_EQUALS(list.size(), 32U);
+
+		// Rects overlapping the ones in the list still fit
+		TS_ASSERT(list.add(Common::Rect(0, 0, 10, 10)));
+		TS_ASSERT(list.add(Common::Rect(20, 20, 25, 25)));
+		TS_ASSERT_EQUALS(list.size(), 32U);
+
+		TS_ASSERT(!list.add(Common::Rect(0, 100, 10, 110)));
+	}
+
+	void test_merging_when_full() {
+		Graphics::DirtyRectList list(3);
+		list.addMerging(Common::Rect(0, 0, 10, 10));
+		list.addMerging(Common::Rect(100, 0, 110, 10));
+		list.addMerging(Common::Rect(20, 0, 30, 10));
+
+		// Merged into the rect which grows the least
+		list.addMerging(Common::Rect(40, 0, 50, 10));
+		TS_ASSERT_EQUALS(list.size(), 3U);
+		TS_ASSERT(covers(list, Common::Rect(20, 0, 50, 10)));
+
+		// The merged rect swallows the rects it overlaps then
+		list.addMerging(Common::Rect(0, 20, 50, 30));
+		TS_ASSERT_EQUALS(list.size(), 2U);
+		checkList(list);
+		TS_ASSERT(covers(list, Common::Rect(0, 0, 50, 30)));
+		TS_ASSERT(covers(list, Common::Rect(100, 0, 110, 10)));
+	}
+
+	void test_random() {
+		TestRandom random;
+
+		for (int run = 0; run < 50; ++run) {
+			Graphics::DirtyRectList list(16);
+			byte dirty[kSize * kSize];
+			memset(dirty, 0, sizeof(dirty));
+			bool full = false;
+
+			for (int i = 0; i < 24; ++i) {
+				const int16 x = random.next() % kSize;
+				const int16 y = random.next() % kSize;
+				const Common::Rect rect(x, y, x + 1 + random.next() % (kSize - x), y + 1 + random.next() % (kSize - y));
+
+				for (int16 j = rect.top; j < rect.bottom; ++j)
+					memset(dirty + j * kSize + rect.left, 1, rect.width());
+
+				// Every second run checks the list when it gives up
+				if (run & 1) {
+					list.addMerging(rect);
+				} else if (!list.add(rect)) {
+					full = true;
+					break;
+				}
+			}
+
+			TS_ASSERT_LESS_THAN_EQUALS(list.size(), 16U);
+			checkList(list);
+			if (full)
+				continue;
+
+			for (int16 y = 0; y < kSize; ++y) {
+				for (int16 x = 0; x < kSize; ++x) {
+					if (dirty[y * kSize + x])
+						TS_ASSERT(covers(list, Common::Rect(x, y, x + 1, y + 1)));
+				}
+			}
+		}
+	}
+
+private:
+	enum {
+		kSize = 64
+	};
+
+	/** Checks that the rects in the list do not overlap. */
+	void checkList(const Graphics::DirtyRectList &list) {
+		for (uint i = 0; i < list.size(); ++i) {
+			TS_ASSERT(!list[i].isEmpty());
+			for (uint j = i + 1; j < list.size(); ++j)
+				TS_ASSERT(!list[i].intersects(list[j]));
+		}
+	}
+
+	/** Returns whether the rects in the list cover the whole given rect. */
+	bool covers(const Graphics::DirtyRectList &list, const Common::Rect &rect) {
+		int area = 0;
+		for (uint i = 0; i < list.size(); ++i) {
+			const Common::Rect part = list[i].findIntersectingRect(rect);
+			area += part.width() * part.height();
+		}
+		return area == rect.width() * rect.height();
+	}
+};
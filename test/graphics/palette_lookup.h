@@ -0,0 +1,133 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "graphics/palette_lookup.h"
+
+#include "../common/helper.h"
+
+class PaletteLookupTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kWidth = 70,
+		kHeight = 8,
+		kDstPitch = (kWidth + 3) * 4
+	};
+
+	byte _palette[256 * 3];
+	byte _src[kHeight * kWidth];
+	byte _dst[kHeight * kDstPitch];
+
+	/** Convert with and without SIMD, and check each pixel against the palette. */
+	void compare(const Graphics::PixelFormat &format) {
+		Graphics::PaletteLookup lookup;
+		lookup.setFormat(format);
+		lookup.setPalette(_palette, 0, 256);
+
+		for (int simd = 0; simd < 2; simd++) {
+			Common::disableCPUFeatures(simd ? 0 : Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2 | Common::kCPUFeatureNEON);
+
+			// Widths which are no multiple of the SIMD width leave some pixels to the C code
+			for (int width = kWidth - 9; width <= kWidth; width += 3) {
+				memset(_dst, 0, sizeof(_dst));
+				lookup.convert(_dst, kDstPitch, _src, kWidth, width, kHeight);
+
+				for (int y = 0; y < kHeight; y++) {
+					for (int x = 0; x < width; x++) {
+						const byte *color = _palette + _src[y * kWidth + x] * 3;
+						const byte *pixel = _dst + y * kDstPitch + x * format.bytesPerPixel;
+						const uint32 value = (format.bytesPerPixel == 2) ? *(const uint16 *)pixel : *(const uint32 *)pixel;
+						TS_ASSERT_EQUALS(value, format.RGBToColor(color[0], color[1], color[2]));
+					}
+
+					// Nothing is written beyond the rect
+					TS_ASSERT_EQUALS(_dst[y * kDstPitch + width * format.bytesPerPixel], 0);
+				}
+			}
+		}
+
+		Common::disableCPUFeatures(0);
+	}
+
+public:
+	void setUp() {
+		TestRandom rnd;
+		for (int i = 0; i < 256 * 3; i++) {
+			const uint32 value = rnd.next();
+			_palette[i] = (value >> 16) & 0xFF;
+		}
+		for (int i = 0; i < kHeight * kWidth; i++) {
+			const uint32 value = rnd.next();
+			_src[i] = (i % 5 == 0) ? 255 : (value >> 16) & 0xFF;
+		}
+	}
+
+	void test_rgb565() {
+		compare(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+
+	void test_argb8888() {
+		compare(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+	}
+
+	void test_palette_change() {
+		Graphics::PaletteLookup lookup;
+		lookup.setFormat(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+		lookup.setPalette(_palette, 0, 256);
+
+		const uint32 changeID = lookup.getPaletteChangeID();
+		const byte src[2] = { 7, 8 };
+		uint32 dst[2];
+		lookup.convert((byte *)dst, sizeof(dst), src, sizeof(src), 2, 1);
+
+		// Only the changed entries differ after the map is expanded again
+		const byte white[3] = { 255, 255, 255 };
+		lookup.setPalette(white, 8, 1);
+		TS_ASSERT_DIFFERS(lookup.getPaletteChangeID(), changeID);
+
+		uint32 changed[2];
+		lookup.convert((byte *)changed, sizeof(changed), src, sizeof(src), 2, 1);
+		TS_ASSERT_EQUALS(changed[0], dst[0]);
+		TS_ASSERT_EQUALS(changed[1], 0xFFFFFFu);
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		// A 640x480 screen; the pixels repeat the test data
+		const int width = 640, height = 480;
+		byte *src = new byte[width * height];
+		byte *dst = new byte[width * height * 4];
+		for (int i = 0; i < width * height; i++)
+			src[i] = _src[i % (kHeight * kWidth)];
+
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)
+		};
+
+		Graphics::PaletteLookup lookup;
+		lookup.setPalette(_palette, 0, 256);
+
+		for (int i = 0; i < 2; i++) {
+			lookup.setFormat(formats[i]);
+
+			for (int simd = 0; simd < 2; simd++) {
+				Common::disableCPUFeatures(simd ? 0 : Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2);
+
+				const uint64 start = readCycleCounter();
+				for (int j = 0; j < 4; j++)
+					lookup.convert(dst, width * formats[i].bytesPerPixel, src, width, width, height);
+				const uint64 cycles = readCycleCounter() - start;
+
+				TS_TRACE(Common::String::format("CLUT8 to %dbpp %-5s %5.2f cycles per pixel",
+					formats[i].bytesPerPixel * 8, simd ? "simd" : "c", (double)cycles / (4 * width * height)).c_str());
+			}
+		}
+
+		Common::disableCPUFeatures(0);
+		delete[] src;
+		delete[] dst;
+#endif
+	}
+};
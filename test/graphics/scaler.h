@@ -0,0 +1,196 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/scaler.h"
+
+#include "../common/helper.h"
+
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_SCALERS
+private:
+	enum {
+		kWidth = 100,
+		kHeight = 40,
+		kBorder = 2,	// the 2xSaI family reads two pixels beyond the scaled area
+		kSrcPitch = (kWidth + 2 * kBorder) * 2,
+		kDstPitch = kWidth * 3 * 2
+	};
+
+	uint16 _src[(kHeight + 2 * kBorder) * (kWidth + 2 * kBorder)];
+	uint16 _ref[kHeight * 3 * kWidth * 3];
+	uint16 _simd[kHeight * 3 * kWidth * 3];
+
+	uint32 _src32[(kHeight + 2 * kBorder) * (kWidth + 2 * kBorder)];
+	uint32 _dst32[kHeight * 3 * kWidth * 3];
+
+	/**
+	 * Fill the source with flat areas, noise, and areas of similar colors,
+	 * so that every kind of neighborhood shows up.
+	 */
+	void fill(int bitFormat) {
+		const uint16 greenMask = (bitFormat == 565) ? 0x07E0 : 0x03E0;
+		const uint16 palette[] = { 0x0000, 0xFFFF, 0x001F, greenMask, 0x4208, 0x4228, 0x1234 };
+
+		TestRandom rnd;
+		for (int y = 0; y < kHeight + 2 * kBorder; y++) {
+			for (int x = 0; x < kWidth + 2 * kBorder; x++) {
+				const uint32 value = rnd.next();
+				const uint32 random = value >> 8;
+
+				uint16 color;
+				if (x < 30)
+					color = palette[((x / 7) + (y / 5)) % ARRAYSIZE(palette)];
+				else if (x < 60)
+					color = palette[random % ARRAYSIZE(palette)];
+				else if (x < 80)
+					color = 0x4208 + ((random % 4) * 0x0821);
+				else
+					color = random;
+
+				if (bitFormat == 555)
+					color &= 0x7FFF;
+				_src[y * (kWidth + 2 * kBorder) + x] = color;
+			}
+		}
+	}
+
+	void scale(ScalerProc *scaler, uint16 *dst, int width, int height) {
+		scaler((const uint8 *)(_src + kBorder * (kWidth + 2 * kBorder) + kBorder), kSrcPitch, (uint8 *)dst, kDstPitch, width, height);
+	}
+
+	/** Compare the SIMD versions of a scaler with the C version. */
+	void compare(ScalerProc *scaler, int factor) {
+		const uint32 simdFeatures[] = { Common::kCPUFeatureAVX2, Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2 | Common::kCPUFeatureNEON };
+
+		for (int bitFormat = 555; bitFormat <= 565; bitFormat += 10) {
+			InitScalers(bitFormat);
+			fill(bitFormat);
+
+			// Widths which are no multiple of the SIMD width leave some pixels to the C code
+			for (int width = kWidth - 7; width <= kWidth; width += 7) {
+				memset(_ref, 0, sizeof(_ref));
+				Common::disableCPUFeatures(simdFeatures[1]);
+				scale(scaler, _ref, width, kHeight);
+
+				for (int i = 0; i < 2; i++) {
+					memset(_simd, 0, sizeof(_simd));
+					Common::disableCPUFeatures(i ? 0 : simdFeatures[0]);
+					scale(scaler, _simd, width, kHeight);
+
+					for (int y = 0; y < kHeight * factor; y++)
+						TS_ASSERT_EQUALS(memcmp(_ref + y * kDstPitch / 2, _simd + y * kDstPitch / 2, width * factor * 2), 0);
+				}
+			}
+		}
+
+		Common::disableCPUFeatures(0);
+		DestroyScalers();
+	}
+
+	/**
+	 * Compare the 32 bit version of a scaler with the 16 bit one. The 32 bit
+	 * pixels get the 565 colors with the lower bits cleared, so that they
+	 * have the same YUV values, and the results only differ in these bits.
+	 */
+	void compare32bpp(ScalerProc *scaler, int factor) {
+		InitScalers(565);
+		fill(565);
+		scale(scaler, _ref, kWidth, kHeight);
+
+		for (int i = 0; i < (kHeight + 2 * kBorder) * (kWidth + 2 * kBorder); i++) {
+			const uint16 color = _src[i];
+			_src32[i] = 0xFF000000 | ((color & 0xF800) << 8) | ((color & 0x07E0) << 5) | ((color & 0x001F) << 3);
+		}
+
+		InitScalers(8888);
+		scaler((const uint8 *)(_src32 + kBorder * (kWidth + 2 * kBorder) + kBorder), kSrcPitch * 2,
+			(uint8 *)_dst32, kDstPitch * 2, kWidth, kHeight);
+
+		for (int y = 0; y < kHeight * factor; y++) {
+			for (int x = 0; x < kWidth * factor; x++) {
+				const uint32 color = _dst32[y * kDstPitch / 2 + x];
+				TS_ASSERT_EQUALS(color >> 24, 0xFFu);
+				TS_ASSERT_EQUALS(((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F), _ref[y * kDstPitch / 2 + x]);
+			}
+		}
+
+		DestroyScalers();
+	}
+
+	void benchmark(const char *name, ScalerProc *scaler) {
+#ifdef TEST_BENCHMARKS
+		InitScalers(565);
+		fill(565);
+
+		for (int simd = 0; simd < 2; simd++) {
+			Common::disableCPUFeatures(simd ? 0 : Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2);
+
+			const uint64 start = readCycleCounter();
+			for (int i = 0; i < 20; i++)
+				scale(scaler, _simd, kWidth, kHeight);
+			const uint64 cycles = readCycleCounter() - start;
+
+			TS_TRACE(Common::String::format("%s %s %.1f cycles per pixel", name, simd ? "simd" : "c   ",
+				(double)cycles / (20 * kWidth * kHeight)).c_str());
+		}
+
+		Common::disableCPUFeatures(0);
+		DestroyScalers();
+#endif
+	}
+#endif
+
+public:
+	void test_advmame() {
+#ifdef USE_SCALERS
+		compare(AdvMame2x, 2);
+		compare(AdvMame3x, 3);
+#endif
+	}
+
+	void test_2xsai() {
+#ifdef USE_SCALERS
+		compare(_2xSaI, 2);
+		compare(Super2xSaI, 2);
+		compare(SuperEagle, 2);
+#endif
+	}
+
+	void test_hq() {
+#ifdef USE_HQ_SCALERS
+		compare(HQ2x, 2);
+		compare(HQ3x, 3);
+#endif
+	}
+
+	void test_32bpp() {
+#ifdef USE_SCALERS
+		compare32bpp(Normal1x, 1);
+		compare32bpp(Normal2x, 2);
+		compare32bpp(Normal3x, 3);
+		compare32bpp(AdvMame2x, 2);
+		compare32bpp(AdvMame3x, 3);
+#ifdef USE_HQ_SCALERS
+		compare32bpp(HQ2x, 2);
+		compare32bpp(HQ3x, 3);
+#endif
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef USE_SCALERS
+		benchmark("AdvMame2x ", AdvMame2x);
+		benchmark("AdvMame3x ", AdvMame3x);
+		benchmark("2xSaI     ", _2xSaI);
+		benchmark("Super2xSaI", Super2xSaI);
+		benchmark("SuperEagle", SuperEagle);
+#ifdef USE_HQ_SCALERS
+		benchmark("HQ2x      ", HQ2x);
+		benchmark("HQ3x      ", HQ3x);
+#endif
+#endif
+	}
+};
@@ -0,0 +1,188 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/cpudetect.h"
+#include "common/rect.h"
+#include "graphics/surface.h"
+#include "graphics/transparent_surface.h"
+
+#include "../common/helper.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kSpriteWidth = 61, // No multiple of any SIMD width
+		kSpriteHeight = 23,
+		kTargetWidth = 100,
+		kTargetHeight = 50
+	};
+
+	enum AlphaType {
+		kAlphaMixed,	///< Arbitrary alpha, including fully opaque and transparent pixels
+		kAlphaBinary,	///< Runs of fully opaque and fully transparent pixels
+		kAlphaOpaque	///< Blitted without alpha blending
+	};
+
+	Graphics::PixelFormat _format;
+	Graphics::TransparentSurface _sprite;
+	Graphics::Surface _background;
+
+	void fillSprite(AlphaType alphaType) {
+		TestRandom rnd;
+		for (int y = 0; y < kSpriteHeight; y++) {
+			uint32 *row = (uint32 *)_sprite.getBasePtr(0, y);
+			for (int x = 0; x < kSpriteWidth; x++) {
+				const uint32 value = rnd.next();
+
+				uint32 alpha;
+				if (alphaType == kAlphaBinary)
+					alpha = ((x / 13 + y / 5) & 1) ? 0xFF : 0;
+				else
+					alpha = (x % 7 == 0) ? 0 : (x % 7 == 1) ? 0xFF : (value >> 24);
+
+				row[x] = (alpha << 24) | (value & 0xFFFFFF);
+			}
+		}
+
+		_sprite._enableAlphaBlit = (alphaType != kAlphaOpaque);
+	}
+
+	/** Blit the sprite onto the background, with the given CPU features disabled. */
+	void blit(Graphics::Surface &target, uint32 disabledFeatures, int posX, int posY, int flipping, Common::Rect *partRect, int width, int height) {
+		target.copyFrom(_background);
+
+		Common::disableCPUFeatures(disabledFeatures);
+		_sprite.blit(target, posX, posY, flipping, partRect, BS_ARGB(255, 255, 255, 255), width, height);
+		Common::disableCPUFeatures(0);
+	}
+
+	/** Compare the SIMD blits with the plain ones, which all CPUs use without SIMD. */
+	void compare(AlphaType alphaType, int posX, int posY, Common::Rect *partRect = nullptr, int width = -1, int height = -1) {
+		fillSprite(alphaType);
+
+		for (int flipping = 0; flipping < 4; flipping++) {
+			Graphics::Surface ref, sse2, fastest;
+			blit(ref, Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2 | Common::kCPUFeatureNEON, posX, posY, flipping, partRect, width, height);
+			blit(sse2, Common::kCPUFeatureAVX2, posX, posY, flipping, partRect, width, height);
+			blit(fastest, 0, posX, posY, flipping, partRect, width, height);
+
+			TS_ASSERT_EQUALS(memcmp(ref.pixels, sse2.pixels, ref.pitch * ref.h), 0);
+			TS_ASSERT_EQUALS(memcmp(ref.pixels, fastest.pixels, ref.pitch * ref.h), 0);
+
+			ref.free();
+			sse2.free();
+			fastest.free();
+		}
+	}
+
+	/** Scale the sprite bilinearly, with the given CPU features disabled. */
+	Graphics::TransparentSurface *scale(uint32 disabledFeatures, const Common::Rect &srcRect, int width, int height) {
+		Common::disableCPUFeatures(disabledFeatures);
+		Graphics::TransparentSurface *scaled = _sprite.scale(srcRect, Common::Rect(width, height), Graphics::TransparentSurface::kScaleBilinear);
+		Common::disableCPUFeatures(0);
+		return scaled;
+	}
+
+	/** Compare the SIMD bilinear scalers with the plain one. */
+	void compareScaled(const Common::Rect &srcRect, int width, int height) {
+		fillSprite(kAlphaMixed);
+
+		Graphics::TransparentSurface *ref = scale(Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2 | Common::kCPUFeatureNEON, srcRect, width, height);
+		Graphics::TransparentSurface *fastest = scale(0, srcRect, width, height);
+
+		for (int y = 0; y < height; y++)
+			TS_ASSERT_EQUALS(memcmp(ref->getBasePtr(0, y), fastest->getBasePtr(0, y), width * 4), 0);
+
+		ref->free();
+		delete ref;
+		fastest->free();
+		delete fastest;
+	}
+
+public:
+	void setUp() {
+		_format = Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		_sprite.create(kSpriteWidth, kSpriteHeight, _format);
+		_background.create(kTargetWidth, kTargetHeight, _format);
+
+		TestRandom rnd(2);
+		for (int y = 0; y < kTargetHeight; y++) {
+			uint32 *row = (uint32 *)_background.getBasePtr(0, y);
+			for (int x = 0; x < kTargetWidth; x++) {
+				const uint32 value = rnd.next();
+				row[x] = value;
+			}
+		}
+	}
+
+	void tearDown() {
+		_sprite.free();
+		_background.free();
+		Graphics::TransparentSurface::destroyLookup();
+	}
+
+	void test_blit_alpha() {
+		compare(kAlphaMixed, 3, 5);
+		compare(kAlphaBinary, 3, 5);
+	}
+
+	void test_blit_opaque() {
+		compare(kAlphaOpaque, 3, 5);
+	}
+
+	void test_blit_clipped() {
+		// Clipped at every edge of the target
+		compare(kAlphaMixed, -7, -3);
+		compare(kAlphaMixed, kTargetWidth - 30, kTargetHeight - 10);
+		compare(kAlphaOpaque, -7, kTargetHeight - 10);
+	}
+
+	void test_blit_part() {
+		Common::Rect partRect(5, 2, 40, 20);
+		compare(kAlphaMixed, 10, 10, &partRect);
+		compare(kAlphaOpaque, 10, 10, &partRect);
+	}
+
+	void test_blit_scaled() {
+		compare(kAlphaMixed, 0, 0, nullptr, kSpriteWidth * 3 / 2, kSpriteHeight * 2);
+		compare(kAlphaMixed, 8, 4, nullptr, kSpriteWidth / 2, kSpriteHeight * 2 / 3);
+		compare(kAlphaBinary, 0, 0, nullptr, kTargetWidth, kTargetHeight);
+	}
+
+	void test_scale_bilinear() {
+		const Common::Rect full(kSpriteWidth, kSpriteHeight);
+		compareScaled(full, kSpriteWidth * 3 / 2, kSpriteHeight * 2);
+		compareScaled(full, kSpriteWidth / 2, kSpriteHeight * 2 / 3);
+		compareScaled(full, kSpriteWidth * 5, 3);
+		compareScaled(Common::Rect(5, 2, 40, 20), kTargetWidth, kTargetHeight);
+	}
+
+	void test_scale_bilinear_values() {
+		Graphics::TransparentSurface gradient;
+		gradient.create(2, 2, _format);
+		for (int y = 0; y < 2; y++) {
+			((uint32 *)gradient.getBasePtr(0, y))[0] = 0;
+			((uint32 *)gradient.getBasePtr(0, y))[1] = 0xFFFFFFFF;
+		}
+
+		// The outer pixels keep their color, the ones between are interpolated
+		Graphics::TransparentSurface *scaled = gradient.scale(4, 3, Graphics::TransparentSurface::kScaleBilinear);
+		const uint32 expected[] = { 0, 0x40404040, 0xBFBFBFBF, 0xFFFFFFFF };
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 4; x++)
+				TS_ASSERT_EQUALS(((const uint32 *)scaled->getBasePtr(0, y))[x], expected[x]);
+		}
+		scaled->free();
+		delete scaled;
+
+		// Not resizing does not change anything
+		fillSprite(kAlphaMixed);
+		scaled = _sprite.scale(kSpriteWidth, kSpriteHeight, Graphics::TransparentSurface::kScaleBilinear);
+		for (int y = 0; y < kSpriteHeight; y++)
+			TS_ASSERT_EQUALS(memcmp(scaled->getBasePtr(0, y), _sprite.getBasePtr(0, y), kSpriteWidth * 4), 0);
+		scaled->free();
+		delete scaled;
+
+		gradient.free();
+	}
+};
@@ -0,0 +1,134 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include "../common/helper.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kWidth = 120,
+		kHeight = 36,
+		kPlaneSize = (kWidth + 1) * (kHeight + 1)
+	};
+
+	byte _y[kPlaneSize], _u[kPlaneSize], _v[kPlaneSize];
+
+	void convert(Graphics::Surface &dst, Graphics::YUVToRGBManager::LuminanceScale scale, Graphics::YUVToRGBManager::Subsampling subsampling, int width, int height) {
+		switch (subsampling) {
+		case Graphics::YUVToRGBManager::kSubsampling444:
+			YUVToRGBMan.convert444(&dst, scale, _y, _u, _v, width, height, kWidth + 1, kWidth + 1);
+			break;
+		case Graphics::YUVToRGBManager::kSubsampling420:
+			YUVToRGBMan.convert420(&dst, scale, _y, _u, _v, width, height, kWidth + 1, kWidth + 1);
+			break;
+		case Graphics::YUVToRGBManager::kSubsampling410:
+			YUVToRGBMan.convert410(&dst, scale, _y, _u, _v, width, height, kWidth + 1, kWidth + 1);
+			break;
+		}
+	}
+
+	/** Compare the SIMD conversions with the lookup table, which all CPUs use without SIMD. */
+	void compare(const Graphics::PixelFormat &format) {
+		Graphics::Surface ref, simd;
+		ref.create(kWidth, kHeight, format);
+		simd.create(kWidth, kHeight, format);
+
+		for (int scale = 0; scale < 2; scale++) {
+			for (int subsampling = 0; subsampling < 3; subsampling++) {
+				// Widths which are no multiple of the SIMD width leave some pixels to the table
+				for (int width = kWidth - 8; width <= kWidth; width += 4) {
+					memset(ref.pixels, 0, ref.pitch * ref.h);
+					memset(simd.pixels, 0, simd.pitch * simd.h);
+
+					Common::disableCPUFeatures(Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2 | Common::kCPUFeatureNEON);
+					convert(ref, (Graphics::YUVToRGBManager::LuminanceScale)scale, (Graphics::YUVToRGBManager::Subsampling)subsampling, width, kHeight);
+					Common::disableCPUFeatures(0);
+					convert(simd, (Graphics::YUVToRGBManager::LuminanceScale)scale, (Graphics::YUVToRGBManager::Subsampling)subsampling, width, kHeight);
+
+					TS_ASSERT_EQUALS(memcmp(ref.pixels, simd.pixels, ref.pitch * ref.h), 0);
+				}
+			}
+		}
+
+		ref.free();
+		simd.free();
+	}
+
+public:
+	void setUp() {
+		// The extreme values clip in every combination, the rest is random
+		TestRandom rnd;
+		for (int i = 0; i < kPlaneSize; i++) {
+			const uint32 value = rnd.next();
+			_y[i] = (i % 7 == 0) ? 0 : (i % 7 == 1) ? 255 : (value >> 16) & 0xFF;
+			_u[i] = (i % 5 == 0) ? 0 : (i % 5 == 1) ? 255 : (value >> 8) & 0xFF;
+			_v[i] = (i % 3 == 0) ? 0 : (i % 3 == 1) ? 255 : (value >> 24) & 0xFF;
+		}
+	}
+
+	void test_rgb565() {
+		compare(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+
+	void test_argb1555() {
+		compare(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
+	}
+
+	void test_xrgb8888() {
+		compare(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+	}
+
+	void test_argb8888() {
+		compare(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+	}
+
+	void test_rgba8888() {
+		compare(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		// A 720p frame; the planes repeat the test data
+		const int width = 1280, height = 720;
+		byte *y = new byte[width * height];
+		byte *uv = new byte[width * height / 4];
+		for (int i = 0; i < width * height; i++)
+			y[i] = _y[i % kPlaneSize];
+		for (int i = 0; i < width * height / 4; i++)
+			uv[i] = _u[i % kPlaneSize];
+
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)
+		};
+
+		for (int i = 0; i < 2; i++) {
+			Graphics::Surface dst;
+			dst.create(width, height, formats[i]);
+
+			for (int simd = 0; simd < 2; simd++) {
+				Common::disableCPUFeatures(simd ? 0 : Common::kCPUFeatureSSE2 | Common::kCPUFeatureAVX2);
+
+				const uint64 start = readCycleCounter();
+				for (int j = 0; j < 4; j++)
+					YUVToRGBMan.convert420(&dst, Graphics::YUVToRGBManager::kScaleFull, y, uv, uv, width, height, width, width / 2);
+				const uint64 cycles = readCycleCounter() - start;
+
+				TS_TRACE(Common::String::format("convert420 %dbpp %-5s %5.2f cycles per pixel",
+					formats[i].bytesPerPixel * 8, simd ? "simd" : "table", (double)cycles / (4 * width * height)).c_str());
+			}
+
+			Common::disableCPUFeatures(0);
+			dst.free();
+		}
+
+		delete[] y;
+		delete[] uv;
+#endif
+	}
+};
@@ -5,8 +5,8 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := video/libvideo.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -25,10 +25,13 @@ endif
 #TEST_FLAGS   += --gui=X11Gui
 #TEST_LDFLAGS += -L/usr/X11R6/lib -lX11
 
+# Enable this to also run the benchmarks, which print their results as traces.
+#TEST_CFLAGS  += -DSCUMMVM_BENCHMARKS
+
 
 test: test/runner
 	./test/runner
-test/runner: test/runner.cpp $(TEST_LIBS)
+test/runner: test/runner.cpp $(srcdir)/test/common/helper.cpp $(srcdir)/test/common/threadsystem.cpp $(TEST_LIBS)
 	$(QUIET_LINK)$(CXX) $(TEST_CXXFLAGS) $(CPPFLAGS) $(TEST_CFLAGS) -o $@ $+ $(TEST_LDFLAGS)
 test/runner.cpp: $(TESTS)
 	@mkdir -p test
@@ -0,0 +1,113 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_idct.h"
+
+#include "../common/helper.h"
+
+// cxxtestgen ignores the preprocessor, so only the contents of the tests may
+// depend on USE_BINK
+class BinkIDCTTestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_BINK
+private:
+	enum {
+		kBlockCount = 200,
+		kPitch = 11 // Rows of pixels which aren't aligned
+	};
+
+	int16 _blocks[kBlockCount][64];
+	byte _pixels[8 * kPitch];
+
+	/** Compare an IDCT with the C one, which all CPUs use without SIMD. */
+	void compare(Video::BinkIDCTType type) {
+		const Video::BinkIDCT *ref = Video::getBinkIDCT(Video::kBinkIDCTC);
+		const Video::BinkIDCT *idct = Video::getBinkIDCT(type);
+		TS_ASSERT(ref);
+		if (!ref || !idct)
+			return;
+
+		for (int i = 0; i < kBlockCount; i++) {
+			int16 refBlock[64], block[64];
+			byte refPixels[8 * kPitch], pixels[8 * kPitch];
+
+			memcpy(refBlock, _blocks[i], sizeof(refBlock));
+			memcpy(block, _blocks[i], sizeof(block));
+			ref->transform(refBlock);
+			idct->transform(block);
+			TS_ASSERT_EQUALS(memcmp(refBlock, block, sizeof(block)), 0);
+
+			memcpy(refBlock, _blocks[i], sizeof(refBlock));
+			memcpy(block, _blocks[i], sizeof(block));
+			memcpy(refPixels, _pixels, sizeof(refPixels));
+			memcpy(pixels, _pixels, sizeof(pixels));
+			ref->put(refPixels, kPitch, refBlock);
+			idct->put(pixels, kPitch, block);
+			TS_ASSERT_EQUALS(memcmp(refPixels, pixels, sizeof(pixels)), 0);
+
+			memcpy(refBlock, _blocks[i], sizeof(refBlock));
+			memcpy(block, _blocks[i], sizeof(block));
+			memcpy(refPixels, _pixels, sizeof(refPixels));
+			memcpy(pixels, _pixels, sizeof(pixels));
+			ref->add(refPixels, kPitch, refBlock);
+			idct->add(pixels, kPitch, block);
+			TS_ASSERT_EQUALS(memcmp(refPixels, pixels, sizeof(pixels)), 0);
+		}
+	}
+#endif
+
+public:
+	void setUp() {
+#ifdef USE_BINK
+		TestRandom rnd;
+		for (int i = 0; i < kBlockCount; i++) {
+			for (int j = 0; j < 64; j++) {
+				const uint32 value = rnd.next();
+
+				if (i < 50) {
+					// Over the whole range, overflowing the 16-bit intermediates
+					_blocks[i][j] = (int16)(value >> 16);
+				} else if (i < 100) {
+					// The range of dequantized coefficients
+					_blocks[i][j] = (int16)(value >> 16) >> 4;
+				} else if (i < 150) {
+					// Mostly zero, like real blocks, which takes the C column shortcut
+					_blocks[i][j] = ((value >> 8) % 8 == 0) ? (int16)(value >> 16) >> 6 : 0;
+				} else if (i < 190) {
+					// Only the DC coefficient
+					_blocks[i][j] = (j == 0) ? (int16)(value >> 16) >> 3 : 0;
+				} else {
+					// The extremes
+					_blocks[i][j] = ((value >> 16) & 1) ? -32768 : 32767;
+				}
+			}
+		}
+
+		for (int i = 0; i < 8 * kPitch; i++) {
+			const uint32 value = rnd.next();
+			_pixels[i] = value >> 24;
+		}
+#endif
+	}
+
+	void test_sse2() {
+#ifdef USE_BINK
+		compare(Video::kBinkIDCTSSE2);
+#endif
+	}
+
+	void test_avx2() {
+#ifdef USE_BINK
+		compare(Video::kBinkIDCTAVX2);
+#endif
+	}
+
+	void test_fastest() {
+#ifdef USE_BINK
+		// The IDCT the decoder uses is one of the tested ones
+		const Video::BinkIDCT *idct = &Video::getBinkIDCT();
+		TS_ASSERT(idct == Video::getBinkIDCT(Video::kBinkIDCTC) ||
+		          idct == Video::getBinkIDCT(Video::kBinkIDCTSSE2) ||
+		          idct == Video::getBinkIDCT(Video::kBinkIDCTAVX2));
+#endif
+	}
+};
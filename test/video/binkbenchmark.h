@@ -0,0 +1,69 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_decoder.h"
+#include "common/stream.h"
+#include "common/str.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include "../common/helper.h"
+#include "../common/threadsystem.h"
+
+/**
+ * Measures how many frames per second the Bink decoder decodes, without
+ * displaying them, with and without decoding the chroma planes in a worker
+ * thread. The video is given by the SCUMMVM_BINK_BENCHMARK environment
+ * variable, e.g. a BIKi video of a game. The results are printed as traces.
+ * Only run if the benchmarks are enabled, see test/common/helper.h.
+ */
+class BinkBenchmarkSuite : public CxxTest::TestSuite
+{
+public:
+	void test_benchmark_serial() {
+		benchmark(false);
+	}
+
+	void test_benchmark_threaded() {
+		benchmark(true);
+	}
+
+private:
+	ThreadTestSystem _system;
+
+	void benchmark(const bool threaded) {
+#if defined(TEST_BENCHMARKS) && defined(USE_BINK)
+		Common::SeekableReadStream *stream = openBenchmarkFile("SCUMMVM_BINK_BENCHMARK");
+		if (!stream) {
+			TS_TRACE("Set SCUMMVM_BINK_BENCHMARK to a Bink video to run the Bink benchmark");
+			return;
+		}
+
+		OSystem *oldSystem = g_system;
+		g_system = &_system;
+
+		{
+			Video::BinkDecoder decoder;
+			decoder.setThreadedDecoding(threaded);
+
+			if (decoder.loadStream(stream)) {
+				uint32 frames = 0;
+				const uint32 start = getBenchmarkMillis();
+				while (!decoder.endOfVideo()) {
+					decoder.decodeNextFrame();
+					frames++;
+				}
+				const uint32 time = MAX<uint32>(getBenchmarkMillis() - start, 1);
+
+				TS_TRACE(Common::String::format("Bink %dx%d, %s: %u frames in %u ms, %.1f frames per second",
+					decoder.getWidth(), decoder.getHeight(), threaded ? "threaded" : "serial  ",
+					frames, time, frames * 1000.0 / time).c_str());
+			} else {
+				TS_FAIL("Not a Bink video");
+			}
+		}
+
+		// The converter's threads must not outlive the system
+		Graphics::YUVToRGBManager::destroy();
+		g_system = oldSystem;
+#endif
+	}
+};
@@ -0,0 +1,228 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/video_decoder.h"
+#include "graphics/surface.h"
+
+#include "../common/threadsystem.h"
+
+/**
+ * A video of kFrameCount frames, filled with their frame number. Decoding
+ * can be held up with a semaphore, which is waited for before each frame.
+ */
+class ReadAheadTestDecoder : public Video::VideoDecoder {
+public:
+	enum {
+		kFrameCount = 10
+	};
+
+	ReadAheadTestDecoder() : _track(0) {}
+	virtual ~ReadAheadTestDecoder() { close(); }
+
+	virtual bool loadStream(Common::SeekableReadStream *stream) {
+		close();
+		delete stream;
+
+		_track = new TestVideoTrack();
+		addTrack(_track);
+		return true;
+	}
+
+	virtual void close() {
+		VideoDecoder::close();
+		_track = 0;
+	}
+
+	void setGate(OSystem::SemaphoreRef gate) { _track->setGate(gate); }
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		TestVideoTrack() : _curFrame(-1), _gate(0) {
+			_surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8());
+		}
+
+		~TestVideoTrack() { _surface.free(); }
+
+		void setGate(OSystem::SemaphoreRef gate) { _gate = gate; }
+
+		uint16 getWidth() const { return _surface.w; }
+		uint16 getHeight() const { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return kFrameCount; }
+		bool isSeekable() const { return true; }
+		bool canDecodeAhead() const { return true; }
+
+		bool seek(const Audio::Timestamp &time) {
+			_curFrame = getFrameAtTime(time) - 1;
+			return true;
+		}
+
+		const Graphics::Surface *decodeNextFrame() {
+			if (_gate)
+				g_system->waitSemaphore(_gate);
+
+			_curFrame++;
+			memset(_surface.pixels, _curFrame, _surface.pitch * _surface.h);
+			return &_surface;
+		}
+
+	protected:
+		Common::Rational getFrameRate() const { return 10; }
+
+	private:
+		int _curFrame;
+		OSystem::SemaphoreRef _gate;
+		Graphics::Surface _surface;
+	};
+
+	TestVideoTrack *_track;
+};
+
+class ReadAheadTestSuite : public CxxTest::TestSuite
+{
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		g_system = &_system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+	}
+
+	void test_frame_order() {
+		// The same frames come out with and without the thread, and with
+		// a queue longer than the video
+		for (uint readAhead = 0; readAhead <= ReadAheadTestDecoder::kFrameCount + 2; readAhead += 3) {
+			ReadAheadTestDecoder decoder;
+			decoder.loadStream(0);
+			decoder.setReadAhead(readAhead);
+
+			for (int i = 0; i < ReadAheadTestDecoder::kFrameCount; ++i) {
+				TS_ASSERT(!decoder.endOfVideo());
+				checkFrame(decoder.decodeNextFrame(), i);
+				TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+			}
+
+			TS_ASSERT(decoder.endOfVideo());
+			TS_ASSERT_EQUALS(decoder.getReadAheadStats().queuedFrames, 0U);
+		}
+	}
+
+	void test_slot_reuse() {
+		if (!threaded())
+			return;
+
+		// Two frames ahead plus the one returned last use three slots
+		ReadAheadTestDecoder decoder;
+		decoder.loadStream(0);
+		decoder.setReadAhead(2);
+
+		const Graphics::Surface *frames[ReadAheadTestDecoder::kFrameCount];
+		for (int i = 0; i < ReadAheadTestDecoder::kFrameCount; ++i) {
+			frames[i] = decoder.decodeNextFrame();
+
+			// With the queue full, the frame returned must still be intact
+			TS_ASSERT(waitForQueue(decoder, MIN(2, ReadAheadTestDecoder::kFrameCount - 1 - i)));
+			TS_ASSERT_EQUALS(decoder.getReadAheadStats().queuedFrames, (uint)MIN(2, ReadAheadTestDecoder::kFrameCount - 1 - i));
+			checkFrame(frames[i], i);
+
+			if (i >= 1)
+				TS_ASSERT_DIFFERS(frames[i], frames[i - 1]);
+			if (i >= 2)
+				TS_ASSERT_DIFFERS(frames[i], frames[i - 2]);
+			if (i >= 3)
+				TS_ASSERT_EQUALS(frames[i], frames[i - 3]);
+		}
+	}
+
+	void test_late_frames() {
+		if (!threaded())
+			return;
+
+		OSystem::SemaphoreRef gate = g_system->createSemaphore(0);
+
+		{
+			ReadAheadTestDecoder decoder;
+			decoder.loadStream(0);
+			decoder.setGate(gate);
+			decoder.setReadAhead(2);
+
+			// The thread can only decode the first frame once the main
+			// thread waits for it
+			_system.setWaitHook(gate);
+			checkFrame(decoder.decodeNextFrame(), 0);
+			_system.setWaitHook(0);
+			TS_ASSERT_EQUALS(decoder.getReadAheadStats().lateFrames, 1U);
+
+			// A frame decoded in time is not late
+			for (int i = 1; i < ReadAheadTestDecoder::kFrameCount; ++i)
+				g_system->postSemaphore(gate);
+			TS_ASSERT(waitForQueue(decoder, 2));
+			checkFrame(decoder.decodeNextFrame(), 1);
+			TS_ASSERT_EQUALS(decoder.getReadAheadStats().lateFrames, 1U);
+		}
+
+		g_system->deleteSemaphore(gate);
+	}
+
+	void test_seek() {
+		ReadAheadTestDecoder decoder;
+		decoder.loadStream(0);
+		decoder.setReadAhead(2);
+
+		for (int i = 0; i < 4; ++i)
+			checkFrame(decoder.decodeNextFrame(), i);
+
+		// The frames decoded ahead are dropped
+		TS_ASSERT(decoder.seekToFrame(7));
+		TS_ASSERT_EQUALS(decoder.getReadAheadStats().queuedFrames, 0U);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 6);
+		checkFrame(decoder.decodeNextFrame(), 7);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 7);
+
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+		for (int i = 0; i < ReadAheadTestDecoder::kFrameCount; ++i)
+			checkFrame(decoder.decodeNextFrame(), i);
+		TS_ASSERT(decoder.endOfVideo());
+
+		// Seeking from the end starts the thread again
+		TS_ASSERT(decoder.seekToFrame(8));
+		checkFrame(decoder.decodeNextFrame(), 8);
+		checkFrame(decoder.decodeNextFrame(), 9);
+		TS_ASSERT(decoder.endOfVideo());
+	}
+
+private:
+	ThreadTestSystem _system;
+	OSystem *_oldSystem;
+
+	/** Whether the decoder can start its thread with this system. */
+	bool threaded() {
+#ifdef SCUMMVM_THREAD_LOCAL
+		return _system.hasThreads();
+#else
+		return false;
+#endif
+	}
+
+	/** Waits for the thread to decode the given number of frames ahead. */
+	bool waitForQueue(const ReadAheadTestDecoder &decoder, uint frames) {
+		for (int i = 0; i < 5000; ++i) {
+			if (decoder.getReadAheadStats().queuedFrames >= frames)
+				return true;
+
+			g_system->delayMillis(1);
+		}
+
+		return false;
+	}
+
+	void checkFrame(const Graphics::Surface *frame, int frameNumber) {
+		TS_ASSERT(frame);
+		if (frame)
+			TS_ASSERT_EQUALS(*(const byte *)frame->getBasePtr(3, 3), frameNumber);
+	}
+};
@@ -167,6 +167,7 @@ private:
 		Graphics::PixelFormat getPixelFormat() const;
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
+		bool canDecodeAhead() const { return true; }
 		const Graphics::Surface *decodeNextFrame() { return _lastFrame; }
 		const byte *getPalette() const { _dirtyPalette = false; return _palette; }
 		bool hasDirtyPalette() const { return _dirtyPalette; }
@@ -24,6 +24,10 @@
 // based quite heavily on the Bink decoder found in FFmpeg.
 // Many thanks to Kostya Shishkov for doing the hard work.
 
+// A chroma plane job leaves the decoder with longjmp() on errors
+#define FORBIDDEN_SYMBOL_EXCEPTION_setjmp
+#define FORBIDDEN_SYMBOL_EXCEPTION_longjmp
+
 #include "audio/audiostream.h"
 #include "audio/decoders/raw.h"
 
@@ -31,6 +35,7 @@
 #include "common/textconsole.h"
 #include "common/math.h"
 #include "common/stream.h"
+#include "common/memstream.h"
 #include "common/substream.h"
 #include "common/file.h"
 #include "common/str.h"
@@ -39,12 +44,16 @@
 #include "common/rdft.h"
 #include "common/dct.h"
 #include "common/system.h"
+#include "common/workerpool.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
 
 #include "video/binkdata.h"
 #include "video/bink_decoder.h"
+#include "video/bink_idct.h"
+
+#include <setjmp.h>
 
 static const uint32 kBIKfID = MKTAG('B', 'I', 'K', 'f');
 static const uint32 kBIKgID = MKTAG('B', 'I', 'K', 'g');
@@ -63,6 +72,7 @@ namespace Video {
 
 BinkDecoder::BinkDecoder() {
 	_bink = 0;
+	_threadedDecoding = false;
 }
 
 BinkDecoder::~BinkDecoder() {
@@ -102,8 +112,10 @@ bool BinkDecoder::loadStream(Common::SeekableReadStream *stream) {
 	uint32 videoFlags = _bink->readUint32LE();
 
 	// BIKh and BIKi swap the chroma planes
-	addTrack(new BinkVideoTrack(width, height, getDefaultHighColorFormat(), frameCount,
-			Common::Rational(frameRateNum, frameRateDen), (id == kBIKhID || id == kBIKiID), videoFlags & kVideoFlagAlpha, id));
+	BinkVideoTrack *videoTrack = new BinkVideoTrack(width, height, getDefaultHighColorFormat(), frameCount,
+			Common::Rational(frameRateNum, frameRateDen), (id == kBIKhID || id == kBIKiID), videoFlags & kVideoFlagAlpha, id);
+	videoTrack->setThreadedDecoding(_threadedDecoding);
+	addTrack(videoTrack);
 
 	uint32 audioTrackCount = _bink->readUint32LE();
 
@@ -202,23 +214,28 @@ void BinkDecoder::readNextPacket() {
 		}
 	}
 
-	uint32 videoPacketStart = _bink->pos();
-	uint32 videoPacketEnd   = _bink->pos() + frameSize;
+	// Read the whole video packet, so that the planes can be decoded from memory
+	byte *videoPacket = (byte *)malloc(frameSize);
+	if (_bink->read(videoPacket, frameSize) != frameSize)
+		error("Failed to read Bink video packet");
 
-	frame.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-			videoPacketStart, videoPacketEnd), true);
+	frame.packet = new Common::MemoryReadStream(videoPacket, frameSize, DisposeAfterUse::YES);
+	frame.bits = new Common::BitStream32LELSB(frame.packet);
 
 	videoTrack->decodePacket(frame);
 
 	delete frame.bits;
 	frame.bits = 0;
+	delete frame.packet;
+	frame.packet = 0;
 }
 
-BinkDecoder::VideoFrame::VideoFrame() : bits(0) {
+BinkDecoder::VideoFrame::VideoFrame() : bits(0), packet(0) {
 }
 
 BinkDecoder::VideoFrame::~VideoFrame() {
 	delete bits;
+	delete packet;
 }
 
 
@@ -241,25 +258,40 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const G
 	for (int i = 0; i < 16; i++)
 		_huffman[i] = 0;
 
-	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = 0;
+	for (int s = 0; s < 2; s++) {
+		PlaneState &state = _planeStates[s];
 
-		_bundles[i].huffman.index = 0;
-		for (int j = 0; j < 16; j++)
-			_bundles[i].huffman.symbols[j] = j;
+		for (int i = 0; i < kSourceMAX; i++) {
+			state.bundles[i].countLength = 0;
 
-		_bundles[i].data     = 0;
-		_bundles[i].dataEnd  = 0;
-		_bundles[i].curDec   = 0;
-		_bundles[i].curPtr   = 0;
-	}
+			state.bundles[i].huffman.index = 0;
+			for (int j = 0; j < 16; j++)
+				state.bundles[i].huffman.symbols[j] = j;
 
-	for (int i = 0; i < 16; i++) {
-		_colHighHuffman[i].index = 0;
-		for (int j = 0; j < 16; j++)
-			_colHighHuffman[i].symbols[j] = j;
+			state.bundles[i].data     = 0;
+			state.bundles[i].dataEnd  = 0;
+			state.bundles[i].curDec   = 0;
+			state.bundles[i].curPtr   = 0;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			state.colHighHuffman[i].index = 0;
+			for (int j = 0; j < 16; j++)
+				state.colHighHuffman[i].symbols[j] = j;
+		}
+
+		state.colLastVal = 0;
 	}
 
+	_workers = 0;
+	_idct = 0;
+	_chromaJob.track = this;
+	_chromaJob.bits  = 0;
+	_chromaJob.failed = false;
+
+	_chromaOffsetTypes  = kChromaOffsetAbsolute | kChromaOffsetField | kChromaOffsetLuma;
+	_chromaOffsetChecks = 0;
+
 	// Make the surface even-sized:
 	_surfaceHeight = height;
 	_surfaceWidth = width;
@@ -311,6 +343,8 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
 	}
 
+	delete _workers;
+
 	deinitBundles();
 
 	for (int i = 0; i < 16; i++) {
@@ -321,26 +355,91 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 	_surface.free();
 }
 
+void BinkDecoder::BinkVideoTrack::setThreadedDecoding(bool enable) {
+	delete _workers;
+	_workers = 0;
+
+	// Only BIKi videos tell where the chroma planes start
+	if (!enable || (_id != kBIKiID))
+		return;
+
+	// Without thread local storage, errors in the worker thread could not
+	// be caught, see runChromaJob()
+#ifdef SCUMMVM_THREAD_LOCAL
+	_workers = new Common::WorkerPool(1);
+	if (_workers->getThreadCount() == 0) {
+		delete _workers;
+		_workers = 0;
+	}
+#endif
+}
+
 void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
-	assert(frame.bits);
+	assert(frame.bits && frame.packet);
+
+	Common::BitStream &bits = *frame.bits;
+
+	_idct = &getBinkIDCT();
 
 	if (_hasAlpha) {
 		if (_id == kBIKiID)
-			frame.bits->skip(32);
+			bits.skip(32);
 
-		decodePlane(frame, 3, false);
+		decodePlane(bits, _planeStates[0], 3, false);
 	}
 
-	if (_id == kBIKiID)
-		frame.bits->skip(32);
+	if (_id == kBIKiID) {
+		// In BIKi videos, the planes are preceded by a field which says where
+		// the chroma planes start, so that they can be decoded independently of
+		// the luma plane. How exactly it's stored is checked in the first frames.
+		const uint32 fieldPos = bits.pos();
+		const uint32 offset   = bits.getBits(32);
 
-	for (int i = 0; i < 3; i++) {
-		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
+		const uint32 chromaOffset = _workers ? getChromaOffset(fieldPos, offset) : 0;
 
-		decodePlane(frame, planeIdx, i != 0);
+		if (chromaOffset > (fieldPos / 8 + 4) && chromaOffset < (uint32)frame.packet->size()) {
+			// Decode the chroma planes in the worker thread, while decoding the
+			// luma plane here. The chroma bit stream reads from the same memory.
+			Common::BitStream32LELSB chromaBits(*frame.packet);
+			chromaBits.skip(chromaOffset * 8);
 
-		if (frame.bits->pos() >= frame.bits->size())
-			break;
+			_chromaJob.bits = &chromaBits;
+			_workers->addJob(runChromaJob, &_chromaJob);
+
+			decodePlane(bits, _planeStates[0], 0, false);
+
+			_workers->wait();
+			_chromaJob.bits = 0;
+
+			const bool jobFailed = passChromaJobMessages();
+
+			if (jobFailed || bits.pos() != chromaOffset * 8) {
+				// The field didn't match after all. Do it again, the slow way.
+				if (jobFailed)
+					warning("Bink chroma plane decoding failed (%s), disabling threaded decoding", _chromaJob.error.c_str());
+				else
+					warning("Bink chroma plane offset mismatch (%d != %d), disabling threaded decoding", bits.pos() / 8, chromaOffset);
+
+				_chromaOffsetTypes = 0;
+				if (bits.pos() < bits.size())
+					decodeChromaPlanes(bits, _planeStates[0]);
+			}
+
+		} else {
+			decodePlane(bits, _planeStates[0], 0, false);
+
+			if (_workers)
+				checkChromaOffset(fieldPos, offset, bits.pos());
+
+			if (bits.pos() < bits.size())
+				decodeChromaPlanes(bits, _planeStates[0]);
+		}
+
+	} else {
+		decodePlane(bits, _planeStates[0], 0, false);
+
+		if (bits.pos() < bits.size())
+			decodeChromaPlanes(bits, _planeStates[0]);
 	}
 
 	// Convert the YUV data we have to our format
@@ -358,7 +457,97 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	_curFrame++;
 }
 
-void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+void BinkDecoder::BinkVideoTrack::decodeChromaPlanes(Common::BitStream &bits, PlaneState &state) {
+	for (int i = 1; i < 3; i++) {
+		int planeIdx = !_swapPlanes ? i : (i ^ 3);
+
+		decodePlane(bits, state, planeIdx, true);
+
+		if (bits.pos() >= bits.size())
+			break;
+	}
+}
+
+#ifdef SCUMMVM_THREAD_LOCAL
+// Where a chroma job continues after an error
+static SCUMMVM_THREAD_LOCAL jmp_buf *s_chromaJobExit = 0;
+#endif
+
+void BinkDecoder::BinkVideoTrack::ChromaJobMessages::threadWarning(const char *msg) {
+	_job->warnings.push_back(msg);
+}
+
+void BinkDecoder::BinkVideoTrack::ChromaJobMessages::threadError(const char *msg) {
+	_job->failed = true;
+	_job->error = msg;
+
+	// error() must not return, so end the job. The thread waiting for it
+	// then decodes the chroma planes itself.
+#ifdef SCUMMVM_THREAD_LOCAL
+	longjmp(*s_chromaJobExit, 1);
+#endif
+}
+
+void BinkDecoder::BinkVideoTrack::runChromaJob(void *job) {
+#ifdef SCUMMVM_THREAD_LOCAL
+	ChromaJob *chromaJob = (ChromaJob *)job;
+	ChromaJobMessages messages(chromaJob);
+	jmp_buf exitPoint;
+
+	s_chromaJobExit = &exitPoint;
+	Common::setThreadMessageHandler(&messages);
+
+	// The chroma offset is guessed, so the data may well be garbage. An
+	// error jumps back here, decodePlane() keeps nothing on the heap.
+	if (!setjmp(exitPoint))
+		chromaJob->track->decodeChromaPlanes(*chromaJob->bits, chromaJob->track->_planeStates[1]);
+
+	Common::setThreadMessageHandler(0);
+	s_chromaJobExit = 0;
+#endif
+}
+
+bool BinkDecoder::BinkVideoTrack::passChromaJobMessages() {
+	for (uint i = 0; i < _chromaJob.warnings.size(); i++)
+		warning("%s", _chromaJob.warnings[i].c_str());
+
+	_chromaJob.warnings.clear();
+
+	const bool failed = _chromaJob.failed;
+	_chromaJob.failed = false;
+	return failed;
+}
+
+uint32 BinkDecoder::BinkVideoTrack::getChromaOffset(uint32 fieldPos, uint32 offset) const {
+	// Only trust the field once it matched a few frames
+	if (_chromaOffsetChecks < 4)
+		return 0;
+
+	if (_chromaOffsetTypes & kChromaOffsetAbsolute)
+		return offset;
+	if (_chromaOffsetTypes & kChromaOffsetField)
+		return fieldPos / 8 + offset;
+	if (_chromaOffsetTypes & kChromaOffsetLuma)
+		return fieldPos / 8 + 4 + offset;
+
+	return 0;
+}
+
+void BinkDecoder::BinkVideoTrack::checkChromaOffset(uint32 fieldPos, uint32 offset, uint32 chromaPos) {
+	if (_chromaOffsetTypes == 0)
+		return;
+
+	if (offset * 8 != chromaPos)
+		_chromaOffsetTypes &= ~kChromaOffsetAbsolute;
+	if (fieldPos + offset * 8 != chromaPos)
+		_chromaOffsetTypes &= ~kChromaOffsetField;
+	if (fieldPos + 32 + offset * 8 != chromaPos)
+		_chromaOffsetTypes &= ~kChromaOffsetLuma;
+
+	_chromaOffsetChecks++;
+}
+
+void BinkDecoder::BinkVideoTrack::decodePlane(Common::BitStream &bits, PlaneState &state, int planeIdx, bool isChroma) {
 	uint32 blockWidth  = isChroma ? ((_surface.w  + 15) >> 4) : ((_surface.w  + 7) >> 3);
 	uint32 blockHeight = isChroma ? ((_surface.h + 15) >> 4) : ((_surface.h + 7) >> 3);
 	uint32 width       = isChroma ?  (_surface.w        >> 1) :   _surface.w;
@@ -366,7 +555,8 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 	DecodeContext ctx;
 
-	ctx.video     = &video;
+	ctx.bits      = &bits;
+	ctx.state     = &state;
 	ctx.planeIdx  = planeIdx;
 	ctx.destStart = _curPlanes[planeIdx];
 	ctx.destEnd   = _curPlanes[planeIdx] + width * height;
@@ -384,27 +574,27 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 	}
 
 	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = _bundles[i].countLengths[isChroma ? 1 : 0];
+		ctx.state->bundles[i].countLength = ctx.state->bundles[i].countLengths[isChroma ? 1 : 0];
 
-		readBundle(video, (Source) i);
+		readBundle(ctx, (Source) i);
 	}
 
 	for (ctx.blockY = 0; ctx.blockY < blockHeight; ctx.blockY++) {
-		readBlockTypes  (video, _bundles[kSourceBlockTypes]);
-		readBlockTypes  (video, _bundles[kSourceSubBlockTypes]);
-		readColors      (video, _bundles[kSourceColors]);
-		readPatterns    (video, _bundles[kSourcePattern]);
-		readMotionValues(video, _bundles[kSourceXOff]);
-		readMotionValues(video, _bundles[kSourceYOff]);
-		readDCS         (video, _bundles[kSourceIntraDC], kDCStartBits, false);
-		readDCS         (video, _bundles[kSourceInterDC], kDCStartBits, true);
-		readRuns        (video, _bundles[kSourceRun]);
+		readBlockTypes  (ctx, ctx.state->bundles[kSourceBlockTypes]);
+		readBlockTypes  (ctx, ctx.state->bundles[kSourceSubBlockTypes]);
+		readColors      (ctx, ctx.state->bundles[kSourceColors]);
+		readPatterns    (ctx, ctx.state->bundles[kSourcePattern]);
+		readMotionValues(ctx, ctx.state->bundles[kSourceXOff]);
+		readMotionValues(ctx, ctx.state->bundles[kSourceYOff]);
+		readDCS         (ctx, ctx.state->bundles[kSourceIntraDC], kDCStartBits, false);
+		readDCS         (ctx, ctx.state->bundles[kSourceInterDC], kDCStartBits, true);
+		readRuns        (ctx, ctx.state->bundles[kSourceRun]);
 
 		ctx.dest = ctx.destStart + 8 * ctx.blockY * ctx.pitch;
 		ctx.prev = ctx.prevStart + 8 * ctx.blockY * ctx.pitch;
 
 		for (ctx.blockX = 0; ctx.blockX < blockWidth; ctx.blockX++, ctx.dest += 8, ctx.prev += 8) {
-			BlockType blockType = (BlockType) getBundleValue(kSourceBlockTypes);
+			BlockType blockType = (BlockType) getBundleValue(ctx, kSourceBlockTypes);
 
 			// 16x16 block type on odd line means part of the already decoded block, so skip it
 			if ((ctx.blockY & 1) && (blockType == kBlockScaled)) {
@@ -453,28 +643,28 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 	}
 
-	if (video.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
-		video.bits->skip(32 - (video.bits->pos() & 0x1F));
+	if (ctx.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
+		ctx.bits->skip(32 - (ctx.bits->pos() & 0x1F));
 
 }
 
-void BinkDecoder::BinkVideoTrack::readBundle(VideoFrame &video, Source source) {
+void BinkDecoder::BinkVideoTrack::readBundle(DecodeContext &ctx, Source source) {
 	if (source == kSourceColors) {
 		for (int i = 0; i < 16; i++)
-			readHuffman(video, _colHighHuffman[i]);
+			readHuffman(ctx, ctx.state->colHighHuffman[i]);
 
-		_colLastVal = 0;
+		ctx.state->colLastVal = 0;
 	}
 
 	if ((source != kSourceIntraDC) && (source != kSourceInterDC))
-		readHuffman(video, _bundles[source].huffman);
+		readHuffman(ctx, ctx.state->bundles[source].huffman);
 
-	_bundles[source].curDec = _bundles[source].data;
-	_bundles[source].curPtr = _bundles[source].data;
+	ctx.state->bundles[source].curDec = ctx.state->bundles[source].data;
+	ctx.state->bundles[source].curPtr = ctx.state->bundles[source].data;
 }
 
-void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
-	huffman.index = video.bits->getBits(4);
+void BinkDecoder::BinkVideoTrack::readHuffman(DecodeContext &ctx, Huffman &huffman) {
+	huffman.index = ctx.bits->getBits(4);
 
 	if (huffman.index == 0) {
 		// The first tree always gives raw nibbles
@@ -486,13 +676,13 @@ void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffma
 
 	byte hasSymbol[16];
 
-	if (video.bits->getBit()) {
+	if (ctx.bits->getBit()) {
 		// Symbol selection
 		memset(hasSymbol, 0, 16);
 
-		uint8 length = video.bits->getBits(3);
+		uint8 length = ctx.bits->getBits(3);
 		for (int i = 0; i <= length; i++) {
-			huffman.symbols[i] = video.bits->getBits(4);
+			huffman.symbols[i] = ctx.bits->getBits(4);
 			hasSymbol[huffman.symbols[i]] = 1;
 		}
 
@@ -508,7 +698,7 @@ void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffma
 	byte tmp1[16], tmp2[16];
 	byte *in = tmp1, *out = tmp2;
 
-	uint8 depth = video.bits->getBits(2);
+	uint8 depth = ctx.bits->getBits(2);
 
 	for (int i = 0; i < 16; i++)
 		in[i] = i;
@@ -517,7 +707,7 @@ void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffma
 		int size = 1 << i;
 
 		for (int j = 0; j < 16; j += (size << 1))
-			mergeHuffmanSymbols(video, out + j, in + j, size);
+			mergeHuffmanSymbols(ctx, out + j, in + j, size);
 
 		SWAP(in, out);
 	}
@@ -525,12 +715,12 @@ void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffma
 	memcpy(huffman.symbols, in, 16);
 }
 
-void BinkDecoder::BinkVideoTrack::mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size) {
+void BinkDecoder::BinkVideoTrack::mergeHuffmanSymbols(DecodeContext &ctx, byte *dst, const byte *src, int size) {
 	const byte *src2  = src + size;
 	int size2 = size;
 
 	do {
-		if (!video.bits->getBit()) {
+		if (!ctx.bits->getBit()) {
 			*dst++ = *src++;
 			size--;
 		} else {
@@ -552,33 +742,41 @@ void BinkDecoder::BinkVideoTrack::initBundles() {
 	uint32 bh     = (_surface.h + 7) >> 3;
 	uint32 blocks = bw * bh;
 
-	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].data    = new byte[blocks * 64];
-		_bundles[i].dataEnd = _bundles[i].data + blocks * 64;
-	}
+	// The second state is only used for the chroma planes, which have a quarter of the blocks
+	uint32 stateBlocks[2] = { blocks, (uint32)(((_surface.w + 15) >> 4) * ((_surface.h + 15) >> 4)) };
 
 	uint32 cbw[2] = { (uint32)((_surface.w + 7) >> 3), (uint32)((_surface.w  + 15) >> 4) };
 	uint32 cw [2] = { (uint32)( _surface.w          ), (uint32)( _surface.w        >> 1) };
 
-	// Calculate the lengths of an element count in bits
-	for (int i = 0; i < 2; i++) {
-		int width = MAX<uint32>(cw[i], 8);
-
-		_bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
-		_bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
-		_bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
-		_bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
+	for (int s = 0; s < 2; s++) {
+		Bundle *bundles = _planeStates[s].bundles;
+
+		for (int i = 0; i < kSourceMAX; i++) {
+			bundles[i].data    = new byte[stateBlocks[s] * 64];
+			bundles[i].dataEnd = bundles[i].data + stateBlocks[s] * 64;
+		}
+
+		// Calculate the lengths of an element count in bits
+		for (int i = 0; i < 2; i++) {
+			int width = MAX<uint32>(cw[i], 8);
+
+			bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+			bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
+			bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
+			bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+			bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+			bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+			bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+			bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
+			bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
+		}
 	}
 }
 
 void BinkDecoder::BinkVideoTrack::deinitBundles() {
-	for (int i = 0; i < kSourceMAX; i++)
-		delete[] _bundles[i].data;
+	for (int s = 0; s < 2; s++)
+		for (int i = 0; i < kSourceMAX; i++)
+			delete[] _planeStates[s].bundles[i].data;
 }
 
 void BinkDecoder::BinkVideoTrack::initHuffman() {
@@ -586,29 +784,29 @@ void BinkDecoder::BinkVideoTrack::initHuffman() {
 		_huffman[i] = new Common::Huffman(binkHuffmanLengths[i][15], 16, binkHuffmanCodes[i], binkHuffmanLengths[i]);
 }
 
-byte BinkDecoder::BinkVideoTrack::getHuffmanSymbol(VideoFrame &video, Huffman &huffman) {
-	return huffman.symbols[_huffman[huffman.index]->getSymbol(*video.bits)];
+byte BinkDecoder::BinkVideoTrack::getHuffmanSymbol(DecodeContext &ctx, Huffman &huffman) {
+	return huffman.symbols[_huffman[huffman.index]->getSymbol(*ctx.bits)];
 }
 
-int32 BinkDecoder::BinkVideoTrack::getBundleValue(Source source) {
+int32 BinkDecoder::BinkVideoTrack::getBundleValue(DecodeContext &ctx, Source source) {
 	if ((source < kSourceXOff) || (source == kSourceRun))
-		return *_bundles[source].curPtr++;
+		return *ctx.state->bundles[source].curPtr++;
 
 	if ((source == kSourceXOff) || (source == kSourceYOff))
-		return (int8) *_bundles[source].curPtr++;
+		return (int8) *ctx.state->bundles[source].curPtr++;
 
-	int16 ret = *((int16 *) _bundles[source].curPtr);
+	int16 ret = *((int16 *) ctx.state->bundles[source].curPtr);
 
-	_bundles[source].curPtr += 2;
+	ctx.state->bundles[source].curPtr += 2;
 
 	return ret;
 }
 
-uint32 BinkDecoder::BinkVideoTrack::readBundleCount(VideoFrame &video, Bundle &bundle) {
+uint32 BinkDecoder::BinkVideoTrack::readBundleCount(DecodeContext &ctx, Bundle &bundle) {
 	if (!bundle.curDec || (bundle.curDec > bundle.curPtr))
 		return 0;
 
-	uint32 n = video.bits->getBits(bundle.countLength);
+	uint32 n = ctx.bits->getBits(bundle.countLength);
 	if (n == 0)
 		bundle.curDec = 0;
 
@@ -632,19 +830,19 @@ void BinkDecoder::BinkVideoTrack::blockScaledSkip(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
-	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
+	const uint8 *scan = binkPatterns[ctx.bits->getBits(4)];
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = getBundleValue(ctx, kSourceRun) + 1;
 
 		i += run;
 		if (i > 64)
 			error("Run went out of bounds");
 
-		if (ctx.video->bits->getBit()) {
+		if (ctx.bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = getBundleValue(ctx, kSourceColors);
 			for (int j = 0; j < run; j++, scan++)
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
@@ -656,7 +854,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
 				ctx.dest[ctx.coordScaledMap3[*scan]] =
-				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(ctx, kSourceColors);
 
 	} while (i < 63);
 
@@ -664,18 +862,18 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 		ctx.dest[ctx.coordScaledMap1[*scan]] =
 		ctx.dest[ctx.coordScaledMap2[*scan]] =
 		ctx.dest[ctx.coordScaledMap3[*scan]] =
-		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(ctx, kSourceColors);
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 	int16 block[64];
 	memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = getBundleValue(ctx, kSourceIntraDC);
 
-	readDCTCoeffs(*ctx.video, block, true);
+	readDCTCoeffs(ctx, block, true);
 
-	IDCT(block);
+	_idct->transform(block);
 
 	int16 *src   = block;
 	byte  *dest1 = ctx.dest;
@@ -689,7 +887,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 16; i++, dest += ctx.pitch)
@@ -700,12 +898,12 @@ void BinkDecoder::BinkVideoTrack::blockScaledPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = getBundleValue(ctx, kSourceColors);
 
 	byte *dest1 = ctx.dest;
 	byte *dest2 = ctx.dest + ctx.pitch;
 	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		byte v = getBundleValue(kSourcePattern);
+		byte v = getBundleValue(ctx, kSourcePattern);
 
 		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2, v >>= 1)
 			dest1[0] = dest1[1] = dest2[0] = dest2[1] = col[v & 1];
@@ -718,17 +916,17 @@ void BinkDecoder::BinkVideoTrack::blockScaledRaw(DecodeContext &ctx) {
 	byte *dest1 = ctx.dest;
 	byte *dest2 = ctx.dest + ctx.pitch;
 	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		memcpy(row, _bundles[kSourceColors].curPtr, 8);
+		memcpy(row, ctx.state->bundles[kSourceColors].curPtr, 8);
 
 		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
 			dest1[0] = dest1[1] = dest2[0] = dest2[1] = row[i];
 
-		_bundles[kSourceColors].curPtr += 8;
+		ctx.state->bundles[kSourceColors].curPtr += 8;
 	}
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
-	BlockType blockType = (BlockType) getBundleValue(kSourceSubBlockTypes);
+	BlockType blockType = (BlockType) getBundleValue(ctx, kSourceSubBlockTypes);
 
 	switch (blockType) {
 	case kBlockRun:
@@ -756,8 +954,8 @@ void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
-	int8 xOff = getBundleValue(kSourceXOff);
-	int8 yOff = getBundleValue(kSourceYOff);
+	int8 xOff = getBundleValue(ctx, kSourceXOff);
+	int8 yOff = getBundleValue(ctx, kSourceYOff);
 
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev + yOff * ((int32) ctx.pitch) + xOff;
@@ -769,41 +967,41 @@ void BinkDecoder::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockRun(DecodeContext &ctx) {
-	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
+	const uint8 *scan = binkPatterns[ctx.bits->getBits(4)];
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = getBundleValue(ctx, kSourceRun) + 1;
 
 		i += run;
 		if (i > 64)
 			error("Run went out of bounds");
 
-		if (ctx.video->bits->getBit()) {
+		if (ctx.bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = getBundleValue(ctx, kSourceColors);
 			for (int j = 0; j < run; j++)
 				ctx.dest[ctx.coordMap[*scan++]] = v;
 
 		} else
 			for (int j = 0; j < run; j++)
-				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(ctx, kSourceColors);
 
 	} while (i < 63);
 
 	if (i == 63)
-		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(ctx, kSourceColors);
 }
 
 void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 	blockMotion(ctx);
 
-	byte v = ctx.video->bits->getBits(7);
+	byte v = ctx.bits->getBits(7);
 
 	int16 block[64];
 	memset(block, 0, 64 * sizeof(int16));
 
-	readResidue(*ctx.video, block, v);
+	readResidue(ctx, block, v);
 
 	byte  *dst = ctx.dest;
 	int16 *src = block;
@@ -816,15 +1014,15 @@ void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
 	int16 block[64];
 	memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = getBundleValue(ctx, kSourceIntraDC);
 
-	readDCTCoeffs(*ctx.video, block, true);
+	readDCTCoeffs(ctx, block, true);
 
-	IDCTPut(ctx, block);
+	_idct->put(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch)
@@ -837,22 +1035,22 @@ void BinkDecoder::BinkVideoTrack::blockInter(DecodeContext &ctx) {
 	int16 block[64];
 	memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceInterDC);
+	block[0] = getBundleValue(ctx, kSourceInterDC);
 
-	readDCTCoeffs(*ctx.video, block, false);
+	readDCTCoeffs(ctx, block, false);
 
-	IDCTAdd(ctx, block);
+	_idct->add(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch - 8) {
-		byte v = getBundleValue(kSourcePattern);
+		byte v = getBundleValue(ctx, kSourcePattern);
 
 		for (int j = 0; j < 8; j++, v >>= 1)
 			*dest++ = col[v & 1];
@@ -861,15 +1059,15 @@ void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 
 void BinkDecoder::BinkVideoTrack::blockRaw(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
-	byte *data = _bundles[kSourceColors].curPtr;
+	byte *data = ctx.state->bundles[kSourceColors].curPtr;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch, data += 8)
 		memcpy(dest, data, 8);
 
-	_bundles[kSourceColors].curPtr += 64;
+	ctx.state->bundles[kSourceColors].curPtr += 64;
 }
 
-void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readRuns(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(ctx, bundle);
 	if (n == 0)
 		return;
 
@@ -877,19 +1075,19 @@ void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
 	if (decEnd > bundle.dataEnd)
 		error("Run value went out of bounds");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (ctx.bits->getBit()) {
+		byte v = ctx.bits->getBits(4);
 
 		memset(bundle.curDec, v, n);
 		bundle.curDec += n;
 
 	} else
 		while (bundle.curDec < decEnd)
-			*bundle.curDec++ = getHuffmanSymbol(video, bundle.huffman);
+			*bundle.curDec++ = getHuffmanSymbol(ctx, bundle.huffman);
 }
 
-void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readMotionValues(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(ctx, bundle);
 	if (n == 0)
 		return;
 
@@ -897,11 +1095,11 @@ void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bu
 	if (decEnd > bundle.dataEnd)
 		error("Too many motion values");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (ctx.bits->getBit()) {
+		byte v = ctx.bits->getBits(4);
 
 		if (v) {
-			int sign = -(int)video.bits->getBit();
+			int sign = -(int)ctx.bits->getBit();
 			v = (v ^ sign) - sign;
 		}
 
@@ -912,10 +1110,10 @@ void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bu
 	}
 
 	do {
-		byte v = getHuffmanSymbol(video, bundle.huffman);
+		byte v = getHuffmanSymbol(ctx, bundle.huffman);
 
 		if (v) {
-			int sign = -(int)video.bits->getBit();
+			int sign = -(int)ctx.bits->getBit();
 			v = (v ^ sign) - sign;
 		}
 
@@ -925,8 +1123,8 @@ void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bu
 }
 
 const uint8 rleLens[4] = { 4, 8, 12, 32 };
-void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readBlockTypes(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(ctx, bundle);
 	if (n == 0)
 		return;
 
@@ -934,8 +1132,8 @@ void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bund
 	if (decEnd > bundle.dataEnd)
 		error("Too many block type values");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (ctx.bits->getBit()) {
+		byte v = ctx.bits->getBits(4);
 
 		memset(bundle.curDec, v, n);
 
@@ -946,7 +1144,7 @@ void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bund
 	byte last = 0;
 	do {
 
-		byte v = getHuffmanSymbol(video, bundle.huffman);
+		byte v = getHuffmanSymbol(ctx, bundle.huffman);
 
 		if (v < 12) {
 			last = v;
@@ -962,8 +1160,8 @@ void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bund
 	} while (bundle.curDec < decEnd);
 }
 
-void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readPatterns(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(ctx, bundle);
 	if (n == 0)
 		return;
 
@@ -973,15 +1171,15 @@ void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle
 
 	byte v;
 	while (bundle.curDec < decEnd) {
-		v  = getHuffmanSymbol(video, bundle.huffman);
-		v |= getHuffmanSymbol(video, bundle.huffman) << 4;
+		v  = getHuffmanSymbol(ctx, bundle.huffman);
+		v |= getHuffmanSymbol(ctx, bundle.huffman) << 4;
 		*bundle.curDec++ = v;
 	}
 }
 
 
-void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readColors(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(ctx, bundle);
 	if (n == 0)
 		return;
 
@@ -989,12 +1187,12 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 	if (decEnd > bundle.dataEnd)
 		error("Too many color values");
 
-	if (video.bits->getBit()) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+	if (ctx.bits->getBit()) {
+		ctx.state->colLastVal = getHuffmanSymbol(ctx, ctx.state->colHighHuffman[ctx.state->colLastVal]);
 
 		byte v;
-		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = getHuffmanSymbol(ctx, bundle.huffman);
+		v = (ctx.state->colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1009,11 +1207,11 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 	}
 
 	while (bundle.curDec < decEnd) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+		ctx.state->colLastVal = getHuffmanSymbol(ctx, ctx.state->colHighHuffman[ctx.state->colLastVal]);
 
 		byte v;
-		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = getHuffmanSymbol(ctx, bundle.huffman);
+		v = (ctx.state->colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1024,16 +1222,16 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle, int startBits, bool hasSign) {
-	uint32 length = readBundleCount(video, bundle);
+void BinkDecoder::BinkVideoTrack::readDCS(DecodeContext &ctx, Bundle &bundle, int startBits, bool hasSign) {
+	uint32 length = readBundleCount(ctx, bundle);
 	if (length == 0)
 		return;
 
 	int16 *dest = (int16 *) bundle.curDec;
 
-	int32 v = video.bits->getBits(startBits - (hasSign ? 1 : 0));
+	int32 v = ctx.bits->getBits(startBits - (hasSign ? 1 : 0));
 	if (v && hasSign) {
-		int sign = -(int)video.bits->getBit();
+		int sign = -(int)ctx.bits->getBit();
 		v = (v ^ sign) - sign;
 	}
 
@@ -1043,14 +1241,14 @@ void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle, int
 	for (uint32 i = 0; i < length; i += 8) {
 		uint32 length2 = MIN<uint32>(length - i, 8);
 
-		byte bSize = video.bits->getBits(4);
+		byte bSize = ctx.bits->getBits(4);
 
 		if (bSize) {
 
 			for (uint32 j = 0; j < length2; j++) {
-				int16 v2 = video.bits->getBits(bSize);
+				int16 v2 = ctx.bits->getBits(bSize);
 				if (v2) {
-					int sign = -(int)video.bits->getBit();
+					int sign = -(int)ctx.bits->getBit();
 					v2 = (v2 ^ sign) - sign;
 				}
 
@@ -1070,7 +1268,7 @@ void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle, int
 }
 
 /** Reads 8x8 block of DCT coefficients. */
-void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool isIntra) {
+void BinkDecoder::BinkVideoTrack::readDCTCoeffs(DecodeContext &ctx, int16 *block, bool isIntra) {
 	int coefCount = 0;
 	int coefIdx[64];
 
@@ -1085,13 +1283,13 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block,
 	coefList[listEnd] = 2;  modeList[listEnd++] = 3;
 	coefList[listEnd] = 3;  modeList[listEnd++] = 3;
 
-	int bits = video.bits->getBits(4) - 1;
+	int bits = ctx.bits->getBits(4) - 1;
 	for (int mask = 1 << bits; bits >= 0; mask >>= 1, bits--) {
 		int listPos = listStart;
 
 		while (listPos < listEnd) {
 
-			if (!(modeList[listPos] | coefList[listPos]) || !video.bits->getBit()) {
+			if (!(modeList[listPos] | coefList[listPos]) || !ctx.bits->getBit()) {
 				listPos++;
 				continue;
 			}
@@ -1109,17 +1307,17 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block,
 					modeList[listPos++] = 0;
 				}
 				for (int i = 0; i < 4; i++, ccoef++) {
-					if (video.bits->getBit()) {
+					if (ctx.bits->getBit()) {
 						coefList[--listStart] = ccoef;
 						modeList[  listStart] = 3;
 					} else {
 						int t;
 						if (!bits) {
-							t = 1 - (video.bits->getBit() << 1);
+							t = 1 - (ctx.bits->getBit() << 1);
 						} else {
-							t = video.bits->getBits(bits) | mask;
+							t = ctx.bits->getBits(bits) | mask;
 
-							int sign = -(int)video.bits->getBit();
+							int sign = -(int)ctx.bits->getBit();
 							t = (t ^ sign) - sign;
 						}
 						block[binkScan[ccoef]] = t;
@@ -1140,11 +1338,11 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block,
 			case 3:
 				int t;
 				if (!bits) {
-					t = 1 - (video.bits->getBit() << 1);
+					t = 1 - (ctx.bits->getBit() << 1);
 				} else {
-					t = video.bits->getBits(bits) | mask;
+					t = ctx.bits->getBits(bits) | mask;
 
-					int sign = -(int)video.bits->getBit();
+					int sign = -(int)ctx.bits->getBit();
 					t = (t ^ sign) - sign;
 				}
 				block[binkScan[ccoef]] = t;
@@ -1156,7 +1354,7 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block,
 		}
 	}
 
-	uint8 quantIdx = video.bits->getBits(4);
+	uint8 quantIdx = ctx.bits->getBits(4);
 	const uint32 *quant = isIntra ? binkIntraQuant[quantIdx] : binkInterQuant[quantIdx];
 	block[0] = (block[0] * quant[0]) >> 11;
 
@@ -1168,7 +1366,7 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block,
 }
 
 /** Reads 8x8 block with residue after motion compensation. */
-void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int masksCount) {
+void BinkDecoder::BinkVideoTrack::readResidue(DecodeContext &ctx, int16 *block, int masksCount) {
 	int nzCoeff[64];
 	int nzCoeffCount = 0;
 
@@ -1181,10 +1379,10 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 	coefList[listEnd] = 44; modeList[listEnd++] = 0;
 	coefList[listEnd] =  0; modeList[listEnd++] = 2;
 
-	for (int mask = 1 << video.bits->getBits(3); mask; mask >>= 1) {
+	for (int mask = 1 << ctx.bits->getBits(3); mask; mask >>= 1) {
 
 		for (int i = 0; i < nzCoeffCount; i++) {
-			if (!video.bits->getBit())
+			if (!ctx.bits->getBit())
 				continue;
 			if (block[nzCoeff[i]] < 0)
 				block[nzCoeff[i]] -= mask;
@@ -1198,7 +1396,7 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 		int listPos = listStart;
 		while (listPos < listEnd) {
 
-			if (!(coefList[listPos] | modeList[listPos]) || !video.bits->getBit()) {
+			if (!(coefList[listPos] | modeList[listPos]) || !ctx.bits->getBit()) {
 				listPos++;
 				continue;
 			}
@@ -1217,13 +1415,13 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 				}
 
 				for (int i = 0; i < 4; i++, ccoef++) {
-					if (video.bits->getBit()) {
+					if (ctx.bits->getBit()) {
 						coefList[--listStart] = ccoef;
 						modeList[  listStart] = 3;
 					} else {
 						nzCoeff[nzCoeffCount++] = binkScan[ccoef];
 
-						int sign = -(int)video.bits->getBit();
+						int sign = -(int)ctx.bits->getBit();
 						block[binkScan[ccoef]] = (mask ^ sign) - sign;
 
 						masksCount--;
@@ -1245,7 +1443,7 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 			case 3:
 				nzCoeff[nzCoeffCount++] = binkScan[ccoef];
 
-				int sign = -(int)video.bits->getBit();
+				int sign = -(int)ctx.bits->getBit();
 				block[binkScan[ccoef]] = (mask ^ sign) - sign;
 
 				coefList[listPos]   = 0;
@@ -1259,88 +1457,6 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 	}
 }
 
-#define A1  2896 /* (1/sqrt(2))<<12 */
-#define A2  2217
-#define A3  3784
-#define A4 -5352
-
-#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
-    const int a0 = (src)[s0] + (src)[s4]; \
-    const int a1 = (src)[s0] - (src)[s4]; \
-    const int a2 = (src)[s2] + (src)[s6]; \
-    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
-    const int a4 = (src)[s5] + (src)[s3]; \
-    const int a5 = (src)[s5] - (src)[s3]; \
-    const int a6 = (src)[s1] + (src)[s7]; \
-    const int a7 = (src)[s1] - (src)[s7]; \
-    const int b0 = a4 + a6; \
-    const int b1 = (A3*(a5 + a7)) >> 11; \
-    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
-    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
-    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
-    (dest)[d0] = munge(a0+a2   +b0); \
-    (dest)[d1] = munge(a1+a3-a2+b2); \
-    (dest)[d2] = munge(a1-a3+a2+b3); \
-    (dest)[d3] = munge(a0-a2   -b4); \
-    (dest)[d4] = munge(a0-a2   +b4); \
-    (dest)[d5] = munge(a1-a3+a2-b3); \
-    (dest)[d6] = munge(a1+a3-a2-b2); \
-    (dest)[d7] = munge(a0+a2   -b0); \
-}
-/* end IDCT_TRANSFORM macro */
-
-#define MUNGE_NONE(x) (x)
-#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
-
-#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
-#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
-
-static inline void IDCTCol(int16 *dest, const int16 *src) {
-	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
-		dest[ 0] =
-		dest[ 8] =
-		dest[16] =
-		dest[24] =
-		dest[32] =
-		dest[40] =
-		dest[48] =
-		dest[56] = src[0];
-	} else {
-		IDCT_COL(dest, src);
-	}
-}
-
-void BinkDecoder::BinkVideoTrack::IDCT(int16 *block) {
-	int i;
-	int16 temp[64];
-
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
-	}
-}
-
-void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int16 *block) {
-	int i, j;
-
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
-void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int16 *block) {
-	int i;
-	int16 temp[64];
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
-	}
-}
-
 BinkDecoder::BinkAudioTrack::BinkAudioTrack(BinkDecoder::AudioInfo &audio) : _audioInfo(&audio) {
 	_audioStream = Audio::makeQueuingAudioStream(_audioInfo->outSampleRate, _audioInfo->outChannels == 2);
 }
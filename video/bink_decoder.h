@@ -33,6 +33,8 @@
 
 #include "common/array.h"
 #include "common/rational.h"
+#include "common/str-array.h"
+#include "common/textconsole.h"
 
 #include "video/video_decoder.h"
 
@@ -45,11 +47,13 @@ class QueuingAudioStream;
 
 namespace Common {
 class SeekableReadStream;
+class MemoryReadStream;
 class BitStream;
 class Huffman;
 
 class RDFT;
 class DCT;
+class WorkerPool;
 }
 
 namespace Graphics {
@@ -58,6 +62,8 @@ struct Surface;
 
 namespace Video {
 
+struct BinkIDCT;
+
 /**
  * Decoder for Bink videos.
  *
@@ -72,6 +78,15 @@ public:
 	bool loadStream(Common::SeekableReadStream *stream);
 	void close();
 
+	/**
+	 * Enable or disable decoding the chroma planes in a worker thread, in
+	 * parallel to the luma plane. This is only possible for BIKi videos and
+	 * on backends supporting threads, and only pays off on systems with
+	 * more than one CPU core. It's disabled by default. Takes effect with
+	 * the next loadStream().
+	 */
+	void setThreadedDecoding(bool enable) { _threadedDecoding = enable; }
+
 protected:
 	void readNextPacket();
 
@@ -131,7 +146,8 @@ private:
 		uint32 offset;
 		uint32 size;
 
-		Common::BitStream *bits;
+		Common::MemoryReadStream *packet; ///< The video packet, while it's decoded.
+		Common::BitStream *bits;          ///< Bit stream over the video packet.
 
 		VideoFrame();
 		~VideoFrame();
@@ -147,18 +163,25 @@ private:
 		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
+		bool canDecodeAhead() const { return true; }
 		const Graphics::Surface *decodeNextFrame() { return &_surface; }
 
 		/** Decode a video packet. */
 		void decodePacket(VideoFrame &frame);
 
+		/** Decode the chroma planes in a worker thread, if possible. */
+		void setThreadedDecoding(bool enable);
+
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
 	private:
+		struct PlaneState;
+
 		/** A decoder state. */
 		struct DecodeContext {
-			VideoFrame *video;
+			Common::BitStream *bits; ///< The plane's data.
+			PlaneState *state;       ///< The bundles to decode the plane with.
 
 			uint32 planeIdx;
 
@@ -229,6 +252,51 @@ private:
 			byte *curPtr; ///< Pointer to the data that wasn't yet read.
 		};
 
+		/**
+		 * Everything needed for decoding a plane, besides the plane data itself.
+		 * There is one of these for each plane that can be decoded at the same time.
+		 */
+		struct PlaneState {
+			Bundle bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+
+			/** Huffman codebooks to use for decoding high nibbles in color data types. */
+			Huffman colHighHuffman[16];
+			/** Value of the last decoded high nibble in color data types. */
+			int colLastVal;
+		};
+
+		/** The data a worker thread needs to decode the chroma planes. */
+		struct ChromaJob {
+			BinkVideoTrack *track;
+			Common::BitStream *bits;
+
+			Common::StringArray warnings; ///< Warnings to pass on after the job.
+			bool failed;                  ///< Did the job end with an error?
+			Common::String error;
+		};
+
+		/**
+		 * Collects the warnings and errors of a chroma job, to be passed on
+		 * by the thread waiting for it. An error ends the job.
+		 */
+		class ChromaJobMessages : public Common::ThreadMessageHandler {
+		public:
+			ChromaJobMessages(ChromaJob *job) : _job(job) {}
+
+			void threadWarning(const char *msg);
+			void threadError(const char *msg);
+
+		private:
+			ChromaJob *_job;
+		};
+
+		/** Ways in which the BIKi chroma plane offset may be stored, see decodePacket(). */
+		enum ChromaOffsetType {
+			kChromaOffsetAbsolute = 1 << 0, ///< Bytes from the start of the video packet.
+			kChromaOffsetField    = 1 << 1, ///< Bytes from the start of the offset field.
+			kChromaOffsetLuma     = 1 << 2  ///< Bytes from the end of the offset field, i.e. the luma size.
+		};
+
 		int _curFrame;
 		int _frameCount;
 
@@ -243,14 +311,24 @@ private:
 
 		Common::Rational _frameRate;
 
-		Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+		/**
+		 * The states for decoding planes. The first one is used for the luma and
+		 * alpha planes, the second one for the chroma planes when decoding them
+		 * in a worker thread.
+		 */
+		PlaneState _planeStates[2];
 
 		Common::Huffman *_huffman[16]; ///< The 16 Huffman codebooks used in Bink decoding.
 
-		/** Huffman codebooks to use for decoding high nibbles in color data types. */
-		Huffman _colHighHuffman[16];
-		/** Value of the last decoded high nibble in color data types. */
-		int _colLastVal;
+		Common::WorkerPool *_workers; ///< Thread for decoding the chroma planes, if enabled.
+		ChromaJob _chromaJob;
+
+		const BinkIDCT *_idct; ///< The IDCT for decoding the current frame.
+
+		/** The ChromaOffsetType values that matched all frames decoded so far. */
+		uint32 _chromaOffsetTypes;
+		/** Number of frames the chroma offset types were checked against. */
+		uint32 _chromaOffsetChecks;
 
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
@@ -264,23 +342,38 @@ private:
 		void initHuffman();
 
 		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+		void decodePlane(Common::BitStream &bits, PlaneState &state, int planeIdx, bool isChroma);
+		/** Decode the chroma planes, until the data runs out. */
+		void decodeChromaPlanes(Common::BitStream &bits, PlaneState &state);
+		/** Worker thread job calling decodeChromaPlanes(). */
+		static void runChromaJob(void *job);
+		/** Pass on the warnings of the chroma job, return whether it failed. */
+		bool passChromaJobMessages();
+
+		/**
+		 * Return the start of the chroma planes in the video packet in bytes, as
+		 * given by the offset field read at the bit position fieldPos, or 0 if
+		 * the field's meaning hasn't been determined (yet).
+		 */
+		uint32 getChromaOffset(uint32 fieldPos, uint32 offset) const;
+		/** Update the possible meanings of the chroma offset field, after decoding the luma plane. */
+		void checkChromaOffset(uint32 fieldPos, uint32 offset, uint32 chromaPos);
 
 		/** Read/Initialize a bundle for decoding a plane. */
-		void readBundle(VideoFrame &video, Source source);
+		void readBundle(DecodeContext &ctx, Source source);
 
 		/** Read the symbols for a Huffman code. */
-		void readHuffman(VideoFrame &video, Huffman &huffman);
+		void readHuffman(DecodeContext &ctx, Huffman &huffman);
 		/** Merge two Huffman symbol lists. */
-		void mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size);
+		void mergeHuffmanSymbols(DecodeContext &ctx, byte *dst, const byte *src, int size);
 
 		/** Read and translate a symbol out of a Huffman code. */
-		byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
+		byte getHuffmanSymbol(DecodeContext &ctx, Huffman &huffman);
 
 		/** Get a direct value out of a bundle. */
-		int32 getBundleValue(Source source);
+		int32 getBundleValue(DecodeContext &ctx, Source source);
 		/** Read a count value out of a bundle. */
-		uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
+		uint32 readBundleCount(DecodeContext &ctx, Bundle &bundle);
 
 		// Handle the block types
 		void blockSkip         (DecodeContext &ctx);
@@ -301,19 +394,14 @@ private:
 		void blockRaw          (DecodeContext &ctx);
 
 		// Read the bundles
-		void readRuns        (VideoFrame &video, Bundle &bundle);
-		void readMotionValues(VideoFrame &video, Bundle &bundle);
-		void readBlockTypes  (VideoFrame &video, Bundle &bundle);
-		void readPatterns    (VideoFrame &video, Bundle &bundle);
-		void readColors      (VideoFrame &video, Bundle &bundle);
-		void readDCS         (VideoFrame &video, Bundle &bundle, int startBits, bool hasSign);
-		void readDCTCoeffs   (VideoFrame &video, int16 *block, bool isIntra);
-		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int16 *block);
-		void IDCTPut(DecodeContext &ctx, int16 *block);
-		void IDCTAdd(DecodeContext &ctx, int16 *block);
+		void readRuns        (DecodeContext &ctx, Bundle &bundle);
+		void readMotionValues(DecodeContext &ctx, Bundle &bundle);
+		void readBlockTypes  (DecodeContext &ctx, Bundle &bundle);
+		void readPatterns    (DecodeContext &ctx, Bundle &bundle);
+		void readColors      (DecodeContext &ctx, Bundle &bundle);
+		void readDCS         (DecodeContext &ctx, Bundle &bundle, int startBits, bool hasSign);
+		void readDCTCoeffs   (DecodeContext &ctx, int16 *block, bool isIntra);
+		void readResidue     (DecodeContext &ctx, int16 *block, int masksCount);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
@@ -347,6 +435,8 @@ private:
 
 	Common::SeekableReadStream *_bink;
 
+	bool _threadedDecoding; ///< Decode the chroma planes in a worker thread?
+
 	Common::Array<AudioInfo> _audioTracks; ///< All audio tracks.
 	Common::Array<VideoFrame> _frames;      ///< All video frames.
 
@@ -0,0 +1,404 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Based on eos' Bink decoder which is in turn
+// based quite heavily on the Bink decoder found in FFmpeg.
+// Many thanks to Kostya Shishkov for doing the hard work.
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#include "common/cpudetect.h"
+
+#include "video/bink_idct.h"
+
+#ifdef SCUMMVM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace Video {
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+static inline void IDCTCol(int16 *dest, const int16 *src) {
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+#ifdef SCUMMVM_SIMD_X86
+
+/** Multiply each 32-bit lane by the constant c, keeping the lower 32 bits of the result. */
+SCUMMVM_TARGET_SSE2 static inline __m128i mulConstSSE2(__m128i x, int32 c) {
+	const __m128i constant = _mm_set1_epi32(c);
+
+	const __m128i even = _mm_mul_epu32(x, constant);
+	const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(x, 32), constant);
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd , _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** IDCT_TRANSFORM on four columns or rows at once, one per 32-bit lane. */
+SCUMMVM_TARGET_SSE2 static inline void idctTransformSSE2(__m128i *d, const __m128i *s) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = _mm_srai_epi32(mulConstSSE2(_mm_sub_epi32(s[2], s[6]), A1), 11);
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(mulConstSSE2(_mm_add_epi32(a5, a7), A3), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(mulConstSSE2(a5, A4), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(mulConstSSE2(_mm_sub_epi32(a6, a4), A1), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(mulConstSSE2(a7, A2), 11), b3), b1);
+
+	const __m128i a02p = _mm_add_epi32(a0, a2);
+	const __m128i a02m = _mm_sub_epi32(a0, a2);
+	const __m128i a132 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i a123 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm_add_epi32(a02p, b0);
+	d[1] = _mm_add_epi32(a132, b2);
+	d[2] = _mm_add_epi32(a123, b3);
+	d[3] = _mm_sub_epi32(a02m, b4);
+	d[4] = _mm_add_epi32(a02m, b4);
+	d[5] = _mm_sub_epi32(a123, b3);
+	d[6] = _mm_sub_epi32(a132, b2);
+	d[7] = _mm_sub_epi32(a02p, b0);
+}
+
+/** Transpose 8 rows of 8 16-bit values. */
+SCUMMVM_TARGET_SSE2 static inline void transpose8x8SSE2(__m128i *r) {
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/** Truncate the 32-bit lanes of lo and hi to 16 bits, like storing them in an int16 does. */
+SCUMMVM_TARGET_SSE2 static inline __m128i truncate16SSE2(__m128i lo, __m128i hi) {
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+	return _mm_packs_epi32(lo, hi);
+}
+
+/**
+ * The whole IDCT of an 8x8 block, giving the 8 result rows as 16-bit
+ * values. Bit-exact with the IDCT_COL and IDCT_ROW macros.
+ */
+SCUMMVM_TARGET_SSE2 static void idctSSE2(const int16 *block, __m128i *rows) {
+	__m128i lo[8], hi[8], outLo[8], outHi[8];
+
+	// Columns, with one column per lane
+	for (int i = 0; i < 8; i++) {
+		const __m128i row = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+		lo[i] = _mm_srai_epi32(_mm_unpacklo_epi16(row, row), 16);
+		hi[i] = _mm_srai_epi32(_mm_unpackhi_epi16(row, row), 16);
+	}
+
+	idctTransformSSE2(outLo, lo);
+	idctTransformSSE2(outHi, hi);
+
+	for (int i = 0; i < 8; i++)
+		rows[i] = truncate16SSE2(outLo[i], outHi[i]);
+
+	// Rows, with one row per lane
+	transpose8x8SSE2(rows);
+
+	for (int i = 0; i < 8; i++) {
+		lo[i] = _mm_srai_epi32(_mm_unpacklo_epi16(rows[i], rows[i]), 16);
+		hi[i] = _mm_srai_epi32(_mm_unpackhi_epi16(rows[i], rows[i]), 16);
+	}
+
+	idctTransformSSE2(outLo, lo);
+	idctTransformSSE2(outHi, hi);
+
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++) {
+		outLo[i] = _mm_srai_epi32(_mm_add_epi32(outLo[i], round), 8);
+		outHi[i] = _mm_srai_epi32(_mm_add_epi32(outHi[i], round), 8);
+
+		rows[i] = truncate16SSE2(outLo[i], outHi[i]);
+	}
+
+	transpose8x8SSE2(rows);
+}
+
+/** IDCT_TRANSFORM on all eight columns or rows at once, one per 32-bit lane. */
+SCUMMVM_TARGET_AVX2 static inline void idctTransformAVX2(__m256i *d, const __m256i *s) {
+	const __m256i a0 = _mm256_add_epi32(s[0], s[4]);
+	const __m256i a1 = _mm256_sub_epi32(s[0], s[4]);
+	const __m256i a2 = _mm256_add_epi32(s[2], s[6]);
+	const __m256i a3 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(s[2], s[6]), _mm256_set1_epi32(A1)), 11);
+	const __m256i a4 = _mm256_add_epi32(s[5], s[3]);
+	const __m256i a5 = _mm256_sub_epi32(s[5], s[3]);
+	const __m256i a6 = _mm256_add_epi32(s[1], s[7]);
+	const __m256i a7 = _mm256_sub_epi32(s[1], s[7]);
+	const __m256i b0 = _mm256_add_epi32(a4, a6);
+	const __m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_add_epi32(a5, a7), _mm256_set1_epi32(A3)), 11);
+	const __m256i b2 = _mm256_add_epi32(_mm256_sub_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(a5, _mm256_set1_epi32(A4)), 11), b0), b1);
+	const __m256i b3 = _mm256_sub_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(a6, a4), _mm256_set1_epi32(A1)), 11), b2);
+	const __m256i b4 = _mm256_sub_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(a7, _mm256_set1_epi32(A2)), 11), b3), b1);
+
+	const __m256i a02p = _mm256_add_epi32(a0, a2);
+	const __m256i a02m = _mm256_sub_epi32(a0, a2);
+	const __m256i a132 = _mm256_sub_epi32(_mm256_add_epi32(a1, a3), a2);
+	const __m256i a123 = _mm256_add_epi32(_mm256_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm256_add_epi32(a02p, b0);
+	d[1] = _mm256_add_epi32(a132, b2);
+	d[2] = _mm256_add_epi32(a123, b3);
+	d[3] = _mm256_sub_epi32(a02m, b4);
+	d[4] = _mm256_add_epi32(a02m, b4);
+	d[5] = _mm256_sub_epi32(a123, b3);
+	d[6] = _mm256_sub_epi32(a132, b2);
+	d[7] = _mm256_sub_epi32(a02p, b0);
+}
+
+/** Truncate the eight 32-bit lanes to 16 bits, like storing them in an int16 does. */
+SCUMMVM_TARGET_AVX2 static inline __m128i truncate16AVX2(__m256i x) {
+	x = _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+
+	return _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+/** Same as idctSSE2(), using AVX2's 32-bit multiplications. */
+SCUMMVM_TARGET_AVX2 static void idctAVX2(const int16 *block, __m128i *rows) {
+	__m256i in[8], out[8];
+
+	for (int i = 0; i < 8; i++)
+		in[i] = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(block + 8 * i)));
+
+	idctTransformAVX2(out, in);
+
+	for (int i = 0; i < 8; i++)
+		rows[i] = truncate16AVX2(out[i]);
+
+	transpose8x8SSE2(rows);
+
+	for (int i = 0; i < 8; i++)
+		in[i] = _mm256_cvtepi16_epi32(rows[i]);
+
+	idctTransformAVX2(out, in);
+
+	const __m256i round = _mm256_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++)
+		rows[i] = truncate16AVX2(_mm256_srai_epi32(_mm256_add_epi32(out[i], round), 8));
+
+	transpose8x8SSE2(rows);
+}
+
+/** The lower 8 bits of each 16-bit value, like storing them in a byte does. */
+SCUMMVM_TARGET_SSE2 static inline __m128i truncate8SSE2(__m128i row) {
+	return _mm_packus_epi16(_mm_and_si128(row, _mm_set1_epi16(0xFF)), _mm_setzero_si128());
+}
+
+typedef void (*IDCTKernel)(const int16 *block, __m128i *rows);
+
+SCUMMVM_TARGET_SSE2 static void idctBlockSSE2(IDCTKernel idct, int16 *block) {
+	__m128i rows[8];
+	idct(block, rows);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8 * i), rows[i]);
+}
+
+SCUMMVM_TARGET_SSE2 static void idctPutSSE2(IDCTKernel idct, byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8];
+	idct(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, truncate8SSE2(rows[i]));
+}
+
+SCUMMVM_TARGET_SSE2 static void idctAddSSE2(IDCTKernel idct, byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8];
+	idct(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, truncate8SSE2(rows[i])));
+	}
+}
+
+#endif
+
+static void transformC(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+static void putC(byte *dest, uint32 pitch, int16 *block) {
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+static void addC(byte *dest, uint32 pitch, int16 *block) {
+	int i, j;
+
+	transformC(block);
+	for (i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (j = 0; j < 8; j++)
+			 dest[j] += block[j];
+}
+
+static const BinkIDCT binkIDCTC = { transformC, putC, addC };
+
+#ifdef SCUMMVM_SIMD_X86
+
+SCUMMVM_TARGET_SSE2 static void transformSSE2(int16 *block) {
+	idctBlockSSE2(idctSSE2, block);
+}
+
+SCUMMVM_TARGET_SSE2 static void putSSE2(byte *dest, uint32 pitch, int16 *block) {
+	idctPutSSE2(idctSSE2, dest, pitch, block);
+}
+
+SCUMMVM_TARGET_SSE2 static void addSSE2(byte *dest, uint32 pitch, int16 *block) {
+	idctAddSSE2(idctSSE2, dest, pitch, block);
+}
+
+SCUMMVM_TARGET_AVX2 static void transformAVX2(int16 *block) {
+	idctBlockSSE2(idctAVX2, block);
+}
+
+SCUMMVM_TARGET_AVX2 static void putAVX2(byte *dest, uint32 pitch, int16 *block) {
+	idctPutSSE2(idctAVX2, dest, pitch, block);
+}
+
+SCUMMVM_TARGET_AVX2 static void addAVX2(byte *dest, uint32 pitch, int16 *block) {
+	idctAddSSE2(idctAVX2, dest, pitch, block);
+}
+
+static const BinkIDCT binkIDCTSSE2 = { transformSSE2, putSSE2, addSSE2 };
+static const BinkIDCT binkIDCTAVX2 = { transformAVX2, putAVX2, addAVX2 };
+
+#endif
+
+const BinkIDCT *getBinkIDCT(BinkIDCTType type) {
+	switch (type) {
+	case kBinkIDCTC:
+		return &binkIDCTC;
+#ifdef SCUMMVM_SIMD_X86
+	case kBinkIDCTSSE2:
+		return Common::hasCPUFeature(Common::kCPUFeatureSSE2) ? &binkIDCTSSE2 : 0;
+	case kBinkIDCTAVX2:
+		return Common::hasCPUFeature(Common::kCPUFeatureAVX2) ? &binkIDCTAVX2 : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+const BinkIDCT &getBinkIDCT() {
+	const BinkIDCT *idct = getBinkIDCT(kBinkIDCTAVX2);
+	if (!idct)
+		idct = getBinkIDCT(kBinkIDCTSSE2);
+
+	return idct ? *idct : binkIDCTC;
+}
+
+} // End of namespace Video
+
+#endif // USE_BINK
@@ -0,0 +1,66 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Based on eos' Bink decoder which is in turn
+// based quite heavily on the Bink decoder found in FFmpeg.
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#ifndef VIDEO_BINK_IDCT_H
+#define VIDEO_BINK_IDCT_H
+
+namespace Video {
+
+/**
+ * An implementation of the IDCT Bink videos use for their 8x8 blocks of
+ * DCT coefficients. All implementations give bit-exact the same results.
+ */
+struct BinkIDCT {
+	/** Transform the block in place. */
+	void (*transform)(int16 *block);
+
+	/** Transform the block into 8 rows of pixels at dest. The block is clobbered. */
+	void (*put)(byte *dest, uint32 pitch, int16 *block);
+
+	/** Transform the block and add it to the 8 rows of pixels at dest. The block is clobbered. */
+	void (*add)(byte *dest, uint32 pitch, int16 *block);
+};
+
+enum BinkIDCTType {
+	kBinkIDCTC,
+	kBinkIDCTSSE2,
+	kBinkIDCTAVX2
+};
+
+/** The IDCT of the given type, or 0 if this build or CPU can't run it. */
+const BinkIDCT *getBinkIDCT(BinkIDCTType type);
+
+/** The fastest IDCT this CPU can run. */
+const BinkIDCT &getBinkIDCT();
+
+} // End of namespace Video
+
+#endif // VIDEO_BINK_IDCT_H
+
+#endif // USE_BINK
@@ -23,7 +23,8 @@ MODULE_OBJS := \
 
 ifdef USE_BINK
 MODULE_OBJS += \
-	bink_decoder.o
+	bink_decoder.o \
+	bink_idct.o
 endif
 
 ifdef USE_THEORADEC
@@ -85,6 +85,7 @@ protected:
 		Graphics::PixelFormat getPixelFormat() const;
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
+		bool canDecodeAhead() const { return true; }
 		const Graphics::Surface *decodeNextFrame() { return _surface; }
 		const byte *getPalette() const { _dirtyPalette = false; return _palette; }
 		bool hasDirtyPalette() const { return _dirtyPalette; }
@@ -20,6 +20,10 @@
  *
  */
 
+// The read-ahead thread leaves the decoder with longjmp() on errors
+#define FORBIDDEN_SYMBOL_EXCEPTION_setjmp
+#define FORBIDDEN_SYMBOL_EXCEPTION_longjmp
+
 #include "video/video_decoder.h"
 
 #include "audio/audiostream.h"
@@ -30,6 +34,9 @@
 #include "common/system.h"
 
 #include "graphics/palette.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include <setjmp.h>
 
 namespace Video {
 
@@ -47,6 +54,19 @@ VideoDecoder::VideoDecoder() {
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
 
+	_readAheadFrames = 0;
+	_readAheadActive = false;
+	_readAheadRead = _readAheadWrite = 0;
+	_readAheadShown = false;
+	_readAheadCurFrame = -1;
+	_readAheadLateFrames = 0;
+	_readAheadThread = 0;
+	_readAheadFree = _readAheadReady = 0;
+	_readAheadQueued = 0;
+	_readAheadDone = false;
+	_readAheadFailed = false;
+	_readAheadStop = false;
+
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
 
@@ -55,6 +75,14 @@ VideoDecoder::VideoDecoder() {
 }
 
 void VideoDecoder::close() {
+	resetReadAhead();
+
+	for (uint i = 0; i < _readAheadQueue.size(); i++)
+		_readAheadQueue[i].surface.free();
+
+	_readAheadQueue.clear();
+	_readAheadLateFrames = 0;
+
 	if (isPlaying())
 		stop();
 
@@ -104,6 +132,9 @@ void VideoDecoder::pauseVideo(bool pause) {
 	}
 
 	if (_pauseLevel == 1 && pause) {
+		// Frames are decoded ahead again by the next decodeNextFrame() call
+		stopReadAheadThread();
+
 		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -168,6 +199,15 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 
+	if (startReadAhead()) {
+		const Graphics::Surface *frame = getQueuedFrame();
+
+		// If the queue ran dry for good, the tracks are back in sync
+		// with the frames returned and are decoded directly again.
+		if (_readAheadActive)
+			return frame;
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -193,6 +233,12 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// Frames decoded ahead are dropped when changing direction
+	stopReadAheadThread();
+
+	if (reverse)
+		resetReadAhead();
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -213,6 +259,9 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (_readAheadActive)
+		return _readAheadCurFrame;
+
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -254,6 +303,21 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
+	if (_readAheadActive) {
+		if (endOfVideo() || _needsUpdate)
+			return 0;
+
+		Common::StackLock lock(_readAheadMutex);
+
+		// The frame is late already if it still needs to be decoded
+		if (!_readAheadQueued)
+			return 0;
+
+		uint32 currentTime = getTime();
+		uint32 nextFrameStartTime = _readAheadQueue[_readAheadRead].startTime;
+		return (nextFrameStartTime <= currentTime) ? 0 : nextFrameStartTime - currentTime;
+	}
+
 	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
 		return 0;
 
@@ -276,9 +340,18 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
-	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		// The video track is ahead of the frames returned so far
+		if (_readAheadActive && (*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (hasQueuedFrames())
+				return false;
+
+			continue;
+		}
+
 		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
 			return false;
+	}
 
 	return true;
 }
@@ -298,6 +371,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	resetReadAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -332,6 +407,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	resetReadAhead();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -358,6 +435,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 bool VideoDecoder::seekToFrame(uint frame) {
 	VideoTrack *track = 0;
 
+	stopReadAheadThread();
+
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if (!(*it)->isSeekable())
 			return false;
@@ -393,6 +472,8 @@ void VideoDecoder::stop() {
 	if (!isPlaying())
 		return;
 
+	stopReadAheadThread();
+
 	// Stop audio here so we don't have it affect getTime()
 	stopAudio();
 
@@ -773,6 +854,9 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
+	if (_readAheadActive)
+		return hasQueuedFrames();
+
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
 			return true;
@@ -788,4 +872,305 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+VideoDecoder::ReadAheadStats VideoDecoder::getReadAheadStats() const {
+	ReadAheadStats stats;
+
+	{
+		Common::StackLock lock(_readAheadMutex);
+		stats.queuedFrames = _readAheadActive ? _readAheadQueued : 0;
+	}
+
+	stats.lateFrames = _readAheadLateFrames;
+	return stats;
+}
+
+bool VideoDecoder::canReadAhead() const {
+	const VideoTrack *videoTrack = 0;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (videoTrack)
+				return false;
+
+			videoTrack = (const VideoTrack *)*it;
+		}
+	}
+
+	return videoTrack && videoTrack->canDecodeAhead() && !videoTrack->isReversed();
+}
+
+bool VideoDecoder::startReadAhead() {
+	if (!_readAheadActive) {
+		if (!_readAheadFrames || !canReadAhead())
+			return false;
+
+		// One slot more than requested holds the frame returned last
+		const uint slots = _readAheadFrames + 1;
+		for (uint i = slots; i < _readAheadQueue.size(); i++)
+			_readAheadQueue[i].surface.free();
+
+		_readAheadQueue.resize(slots);
+		_readAheadCurFrame = getCurFrame();
+		_readAheadActive = true;
+	}
+
+	if (_readAheadThread || _readAheadDone || !_readAheadFrames)
+		return true;
+
+#ifdef SCUMMVM_THREAD_LOCAL
+	// Start (again) with the slots and frames the queue has now
+	const uint free = _readAheadQueue.size() - _readAheadQueued - (_readAheadShown ? 1 : 0);
+	_readAheadFree = g_system->createSemaphore(free);
+	_readAheadReady = g_system->createSemaphore(_readAheadQueued);
+	_readAheadStop = false;
+
+	// The YUV to RGB converter starts its own threads when it is created,
+	// which has to happen in the main thread.
+	if (getPixelFormat().bytesPerPixel > 1)
+		Graphics::YUVToRGBManager::instance();
+
+	if (_readAheadFree && _readAheadReady)
+		_readAheadThread = g_system->createThread(&runReadAhead, this);
+#endif
+
+	// Without a thread, the frames still queued are used up first. The
+	// thread is not used without thread local storage either, since its
+	// warnings and errors could not be passed to the main thread.
+	if (!_readAheadThread) {
+		if (_readAheadFree)
+			g_system->deleteSemaphore(_readAheadFree);
+		if (_readAheadReady)
+			g_system->deleteSemaphore(_readAheadReady);
+		_readAheadFree = _readAheadReady = 0;
+		_readAheadFrames = 0;
+	}
+
+	return true;
+}
+
+void VideoDecoder::stopReadAheadThread() {
+	if (!_readAheadThread)
+		return;
+
+	_readAheadStop = true;
+	g_system->postSemaphore(_readAheadFree);
+
+	g_system->waitThread(_readAheadThread);
+
+	g_system->deleteSemaphore(_readAheadFree);
+	g_system->deleteSemaphore(_readAheadReady);
+	_readAheadThread = 0;
+	_readAheadFree = _readAheadReady = 0;
+
+	passReadAheadMessages();
+}
+
+void VideoDecoder::resetReadAhead() {
+	stopReadAheadThread();
+
+	_readAheadActive = false;
+	_readAheadRead = _readAheadWrite = 0;
+	_readAheadShown = false;
+	_readAheadQueued = 0;
+	_readAheadDone = false;
+}
+
+const Graphics::Surface *VideoDecoder::getQueuedFrame() {
+	// The frame returned last is not needed anymore
+	if (_readAheadShown) {
+		_readAheadShown = false;
+
+		if (_readAheadThread)
+			g_system->postSemaphore(_readAheadFree);
+	}
+
+	uint queued;
+	bool done;
+
+	{
+		Common::StackLock lock(_readAheadMutex);
+		queued = _readAheadQueued;
+		done = _readAheadDone;
+	}
+
+	if (!queued && !done && _readAheadThread) {
+		_readAheadLateFrames++;
+		g_system->waitSemaphore(_readAheadReady);
+
+		Common::StackLock lock(_readAheadMutex);
+		queued = _readAheadQueued;
+	} else if (queued && _readAheadThread) {
+		g_system->waitSemaphore(_readAheadReady);
+	}
+
+	if (_readAheadThread)
+		passReadAheadMessages();
+
+	// Nothing left to wait for, so the tracks are where the frames
+	// returned so far ended.
+	if (!queued) {
+		resetReadAhead();
+		return 0;
+	}
+
+	QueuedFrame &frame = _readAheadQueue[_readAheadRead];
+	_readAheadRead = (_readAheadRead + 1) % _readAheadQueue.size();
+	_readAheadShown = true;
+
+	{
+		Common::StackLock lock(_readAheadMutex);
+		_readAheadQueued--;
+	}
+
+	_readAheadCurFrame = frame.frameNumber;
+
+	if (frame.dirtyPalette) {
+		memcpy(_readAheadPalette, frame.palette, sizeof(_readAheadPalette));
+		_palette = _readAheadPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame.hasSurface ? &frame.surface : 0;
+}
+
+bool VideoDecoder::hasQueuedFrames() const {
+	Common::StackLock lock(_readAheadMutex);
+
+	if (!_readAheadQueued)
+		return !_readAheadDone;
+
+	return !isPlaying() || !_endTimeSet || _readAheadQueue[_readAheadRead].startTime < (uint)_endTime.msecs();
+}
+
+void VideoDecoder::decodeAhead() {
+	for (;;) {
+		// The thread only ends by itself when there is nothing left to decode
+		if (!_nextVideoTrack) {
+			Common::StackLock lock(_readAheadMutex);
+			_readAheadDone = true;
+			break;
+		}
+
+		g_system->waitSemaphore(_readAheadFree);
+
+		if (_readAheadStop)
+			return;
+
+		// This is what decodeNextFrame() does without read-ahead
+		QueuedFrame &frame = _readAheadQueue[_readAheadWrite];
+		frame.startTime = _nextVideoTrack->getNextFrameStartTime();
+
+		readNextPacket();
+
+		if (!_nextVideoTrack) {
+			Common::StackLock lock(_readAheadMutex);
+			_readAheadDone = true;
+			break;
+		}
+
+		const Graphics::Surface *surface = _nextVideoTrack->decodeNextFrame();
+		frame.hasSurface = (surface != 0);
+
+		if (surface) {
+			// Reuse the queue's surfaces as long as the frame size stays the same
+			if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+				frame.surface.free();
+				frame.surface.create(surface->w, surface->h, surface->format);
+			}
+
+			for (int y = 0; y < surface->h; y++)
+				memcpy(frame.surface.getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+		}
+
+		frame.dirtyPalette = _nextVideoTrack->hasDirtyPalette();
+		if (frame.dirtyPalette)
+			memcpy(frame.palette, _nextVideoTrack->getPalette(), sizeof(frame.palette));
+
+		frame.frameNumber = _nextVideoTrack->getCurFrame();
+
+		// Tell endOfVideo() about the end together with the last frame
+		findNextVideoTrack();
+
+		_readAheadWrite = (_readAheadWrite + 1) % _readAheadQueue.size();
+
+		{
+			Common::StackLock lock(_readAheadMutex);
+			_readAheadQueued++;
+			_readAheadDone = !_nextVideoTrack;
+		}
+
+		g_system->postSemaphore(_readAheadReady);
+	}
+
+	// Wake up decodeNextFrame() if it waits for a frame
+	g_system->postSemaphore(_readAheadReady);
+}
+
+void VideoDecoder::passReadAheadMessages() {
+	Common::StringArray warnings;
+	bool failed;
+	Common::String errorMessage;
+
+	{
+		Common::StackLock lock(_readAheadMutex);
+		warnings = _readAheadWarnings;
+		_readAheadWarnings.clear();
+		failed = _readAheadFailed;
+		errorMessage = _readAheadError;
+	}
+
+	for (uint i = 0; i < warnings.size(); i++)
+		warning("%s", warnings[i].c_str());
+
+	if (failed)
+		error("%s", errorMessage.c_str());
+}
+
+#ifdef SCUMMVM_THREAD_LOCAL
+// Where the read-ahead thread continues after an error
+static SCUMMVM_THREAD_LOCAL jmp_buf *s_readAheadExit = 0;
+#endif
+
+void VideoDecoder::ReadAheadMessages::threadWarning(const char *msg) {
+	Common::StackLock lock(_decoder->_readAheadMutex);
+	_decoder->_readAheadWarnings.push_back(msg);
+}
+
+void VideoDecoder::ReadAheadMessages::threadError(const char *msg) {
+	{
+		Common::StackLock lock(_decoder->_readAheadMutex);
+		_decoder->_readAheadFailed = true;
+		_decoder->_readAheadError = msg;
+	}
+
+	// error() must not return, so end the thread. The main thread raises
+	// the error once it waits for the next frame or stops the thread.
+#ifdef SCUMMVM_THREAD_LOCAL
+	longjmp(*s_readAheadExit, 1);
+#endif
+}
+
+void VideoDecoder::runReadAhead(void *decoder) {
+#ifdef SCUMMVM_THREAD_LOCAL
+	VideoDecoder *videoDecoder = (VideoDecoder *)decoder;
+	ReadAheadMessages messages(videoDecoder);
+	jmp_buf exitPoint;
+
+	s_readAheadExit = &exitPoint;
+	Common::setThreadMessageHandler(&messages);
+
+	// An error jumps back here. The objects the decoder had on the stack
+	// are not destroyed then, but the program ends with the error anyway.
+	if (!setjmp(exitPoint)) {
+		videoDecoder->decodeAhead();
+	} else {
+		// Wake up decodeNextFrame() if it waits for a frame
+		g_system->postSemaphore(videoDecoder->_readAheadReady);
+	}
+
+	Common::setThreadMessageHandler(0);
+	s_readAheadExit = 0;
+#endif
+}
+
 } // End of namespace Video
@@ -26,9 +26,14 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
+#include "common/str-array.h"
+#include "common/system.h"
+#include "common/textconsole.h"
 #include "graphics/pixelformat.h"
+#include "graphics/surface.h"
 
 namespace Audio {
 class AudioStream;
@@ -40,10 +45,6 @@ namespace Common {
 class SeekableReadStream;
 }
 
-namespace Graphics {
-struct Surface;
-}
-
 namespace Video {
 
 /**
@@ -353,6 +354,32 @@ public:
 	 */
 	void setDefaultHighColorFormat(const Graphics::PixelFormat &format) { _defaultHighColorFormat = format; }
 
+	/**
+	 * Decode up to the given number of frames ahead of time, in a background
+	 * thread, so that a frame which takes long to decode does not stall
+	 * playback. decodeNextFrame() then returns the oldest decoded frame,
+	 * waiting for it only if the thread did not keep up. Passing 0, the
+	 * default, makes decodeNextFrame() decode each frame when it is called.
+	 *
+	 * Frames are only decoded ahead in videos with a single video track
+	 * which supports it, see VideoTrack::canDecodeAhead(), and not while
+	 * playing in reverse. On backends without threads, or if the video can
+	 * not be decoded ahead, frames are simply decoded synchronously.
+	 *
+	 * A changed number of frames takes effect once all frames decoded
+	 * ahead have been used up, e.g. after seeking.
+	 */
+	void setReadAhead(uint frameCount) { _readAheadFrames = frameCount; }
+
+	/** Statistics about decoding frames ahead, see setReadAhead(). */
+	struct ReadAheadStats {
+		uint queuedFrames;  ///< frames decoded ahead which were not returned yet
+		uint32 lateFrames;  ///< frames which decodeNextFrame() had to wait for
+	};
+
+	/** Get the statistics about decoding frames ahead since the video was loaded. */
+	ReadAheadStats getReadAheadStats() const;
+
 	/**
 	 * Set the video to decode frames in reverse.
 	 *
@@ -577,6 +604,18 @@ protected:
 		 * Is the video track set to play in reverse?
 		 */
 		virtual bool isReversed() const { return false; }
+
+		/**
+		 * Can the frames of this track be decoded ahead of time, in another
+		 * thread? See VideoDecoder::setReadAhead().
+		 *
+		 * If so, decodeNextFrame(), the decoder's readNextPacket() and the
+		 * functions of the decoder's other tracks called by it must work in
+		 * any thread, and only access data of the decoder and its tracks.
+		 * None of them are called concurrently, and while the video is
+		 * paused or being seeked, no frames are decoded ahead.
+		 */
+		virtual bool canDecodeAhead() const { return false; }
 	};
 
 	/**
@@ -850,6 +889,63 @@ private:
 	uint32 _pauseStartTime;
 	byte _audioVolume;
 	int8 _audioBalance;
+
+	// Decoding frames ahead, see setReadAhead()
+	struct QueuedFrame {
+		Graphics::Surface surface;
+		bool hasSurface;        ///< whether the track returned a frame at all
+		uint32 startTime;       ///< the time the frame should be shown
+		int frameNumber;        ///< getCurFrame() after decoding the frame
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	uint _readAheadFrames;
+	bool _readAheadActive;      ///< whether the tracks are ahead of the frames returned so far
+	Common::Array<QueuedFrame> _readAheadQueue;
+	uint _readAheadRead, _readAheadWrite;
+	bool _readAheadShown;       ///< whether the last frame returned is still held in the queue
+	int _readAheadCurFrame;
+	uint32 _readAheadLateFrames;
+	byte _readAheadPalette[256 * 3];
+
+	// These are shared with the decoding thread
+	OSystem::ThreadRef _readAheadThread;
+	OSystem::SemaphoreRef _readAheadFree;   ///< posted for each slot freed in the queue
+	OSystem::SemaphoreRef _readAheadReady;  ///< posted for each frame decoded, and at the end
+	mutable Common::Mutex _readAheadMutex;  ///< protects the members below
+	uint _readAheadQueued;
+	bool _readAheadDone;        ///< whether the thread stopped at the end of the video
+	Common::StringArray _readAheadWarnings;
+	bool _readAheadFailed;      ///< whether the thread called error()
+	Common::String _readAheadError;
+	volatile bool _readAheadStop;
+
+	/**
+	 * Collects the warnings and errors of the decoding thread, which are
+	 * then passed on by passReadAheadMessages() in the main thread. An
+	 * error ends the thread.
+	 */
+	class ReadAheadMessages : public Common::ThreadMessageHandler {
+	public:
+		ReadAheadMessages(VideoDecoder *decoder) : _decoder(decoder) {}
+
+		void threadWarning(const char *msg);
+		void threadError(const char *msg);
+
+	private:
+		VideoDecoder *_decoder;
+	};
+
+	bool canReadAhead() const;
+	bool startReadAhead();
+	void stopReadAheadThread();
+	void resetReadAhead();
+	const Graphics::Surface *getQueuedFrame();
+	bool hasQueuedFrames() const;
+	void decodeAhead();
+	void passReadAheadMessages();
+	static void runReadAhead(void *decoder);
 };
 
 } // End of namespace Video